@@ -20,9 +20,11 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QCoreApplication>
+#include <QMutexLocker>
 #include <QDebug>
 #include <QFile>
 
+#include "audiopreloadcache.h"
 #include "audiodecoder.h"
 #include "audiorenderer.h"
 #include "audioplugincache.h"
@@ -41,12 +43,14 @@
  #include "audiorenderer_qt6.h"
 #endif
 
+#include "qlcfile.h"
 #include "audio.h"
 #include "doc.h"
 
-#define KXMLQLCAudioSource QStringLiteral("Source")
-#define KXMLQLCAudioDevice QStringLiteral("Device")
-#define KXMLQLCAudioVolume QStringLiteral("Volume")
+#define KXMLQLCAudioSource  QStringLiteral("Source")
+#define KXMLQLCAudioDevice  QStringLiteral("Device")
+#define KXMLQLCAudioVolume  QStringLiteral("Volume")
+#define KXMLQLCAudioPreload QStringLiteral("Preload")
 
 /*****************************************************************************
  * Initialization
@@ -56,11 +60,16 @@ Audio::Audio(Doc* doc)
   : Function(doc, Function::AudioType)
   , m_doc(doc)
   , m_decoder(NULL)
+  , m_preloadDecoder(NULL)
+  , m_playbackDecoder(NULL)
   , m_audio_out(NULL)
   , m_audioDevice(QString())
   , m_sourceFileName("")
   , m_audioDuration(0)
   , m_volume(1.0)
+  , m_preload(false)
+  , m_preloadAcquired(false)
+  , m_playbackOffset(0)
 {
     setName(tr("New Audio"));
     setRunOrder(Audio::SingleShot);
@@ -72,13 +81,19 @@ Audio::Audio(Doc* doc)
 
 Audio::~Audio()
 {
-    if (m_audio_out != NULL)
     {
-        m_audio_out->stop();
-        delete m_audio_out;
+        QMutexLocker locker(&m_audioOutMutex);
+        if (m_audio_out != NULL)
+        {
+            m_audio_out->stop();
+            delete m_audio_out;
+            m_audio_out = NULL;
+        }
     }
     if (m_decoder != NULL)
         delete m_decoder;
+
+    releasePreload();
 }
 
 QIcon Audio::getIcon() const
@@ -117,6 +132,7 @@ bool Audio::copyFrom(const Function* function)
 
     setSourceFileName(aud->m_sourceFileName);
     m_audioDuration = aud->m_audioDuration;
+    setPreload(aud->m_preload);
 
     return Function::copyFrom(function);
 }
@@ -152,6 +168,7 @@ bool Audio::setSourceFileName(QString filename)
             delete m_decoder;
             m_decoder = NULL;
         }
+        releasePreload();
     }
 
     m_sourceFileName = filename;
@@ -178,6 +195,10 @@ bool Audio::setSourceFileName(QString filename)
     setDuration(m_decoder->totalTime());
     setTotalDuration(m_decoder->totalTime());
 
+    // during workspace loading, decoding starts on postLoad
+    if (m_doc->loadStatus() != Doc::Loading)
+        requestPreload();
+
     emit changed(id());
 
     return true;
@@ -213,6 +234,82 @@ QString Audio::audioDevice()
     return m_audioDevice;
 }
 
+bool Audio::preload() const
+{
+    return m_preload;
+}
+
+void Audio::setPreload(bool enable)
+{
+    if (enable == m_preload)
+        return;
+
+    m_preload = enable;
+
+    if (m_preload)
+    {
+        // during workspace loading, decoding starts on postLoad
+        if (m_doc->loadStatus() != Doc::Loading)
+            requestPreload();
+    }
+    else
+    {
+        releasePreload();
+    }
+}
+
+void Audio::requestPreload()
+{
+    if (m_preload == false || m_preloadAcquired || m_decoder == NULL)
+        return;
+
+    AudioDecoder *decoder = m_doc->audioPluginCache()->getDecoderForFile(m_sourceFileName);
+    m_preloadAcquired = m_doc->audioPreloadCache()->acquire(m_sourceFileName, decoder);
+}
+
+void Audio::releasePreload()
+{
+    // the decoder shares the data, but it must not outlive the reference
+    if (m_preloadDecoder != NULL)
+    {
+        if (m_playbackDecoder == m_preloadDecoder)
+        {
+            QMutexLocker locker(&m_audioOutMutex);
+            if (m_audio_out != NULL)
+            {
+                m_audio_out->stop();
+                delete m_audio_out;
+                m_audio_out = NULL;
+            }
+            m_playbackDecoder = NULL;
+        }
+        delete m_preloadDecoder;
+        m_preloadDecoder = NULL;
+    }
+
+    if (m_preloadAcquired == false)
+        return;
+
+    m_doc->audioPreloadCache()->release(m_sourceFileName);
+    m_preloadAcquired = false;
+}
+
+AudioDecoder *Audio::playbackDecoder()
+{
+    if (m_preload)
+    {
+        QSharedPointer<PreloadedAudio> pcm = m_doc->audioPreloadCache()->buffer(m_sourceFileName);
+        if (pcm.isNull() == false)
+        {
+            if (m_preloadDecoder == NULL)
+                m_preloadDecoder = new PreloadedAudioDecoder(pcm);
+            return m_preloadDecoder;
+        }
+    }
+
+    return m_decoder;
+}
+
 int Audio::adjustAttribute(qreal fraction, int attributeId)
 {
     int attrIndex = Function::adjustAttribute(fraction, attributeId);
@@ -228,13 +325,21 @@ void Audio::slotEndOfStream()
     if (!stopped())
         stop(FunctionParent::master());
 
-    if (m_audio_out != NULL)
+    AudioRenderer *audioOut;
     {
-        m_audio_out->stop();
-        m_audio_out->deleteLater();
+        // playbackPosition() may be reading it from the MasterTimer thread
+        QMutexLocker locker(&m_audioOutMutex);
+        audioOut = m_audio_out;
         m_audio_out = NULL;
     }
-    m_decoder->seek(0);
+
+    if (audioOut != NULL)
+    {
+        audioOut->stop();
+        audioOut->deleteLater();
+    }
+    if (m_playbackDecoder != NULL)
+        m_playbackDecoder->seek(0);
 }
 
 void Audio::slotFunctionRemoved(quint32 fid)
@@ -270,6 +375,9 @@ bool Audio::saveXML(QXmlStreamWriter *doc) const
     if (m_volume != 1.0)
         doc->writeAttribute(KXMLQLCAudioVolume, QString::number(m_volume));
 
+    if (m_preload)
+        doc->writeAttribute(KXMLQLCAudioPreload, KXMLQLCTrue);
+
     doc->writeCharacters(m_doc->normalizeComponentPath(m_sourceFileName));
 
     doc->writeEndElement();
@@ -307,6 +415,8 @@ bool Audio::loadXML(QXmlStreamReader &root)
                 setAudioDevice(attrs.value(KXMLQLCAudioDevice).toString());
             if (attrs.hasAttribute(KXMLQLCAudioVolume))
                 setVolume(attrs.value(KXMLQLCAudioVolume).toString().toDouble());
+            if (attrs.value(KXMLQLCAudioPreload).toString() == KXMLQLCTrue)
+                setPreload(true);
 
             setSourceFileName(m_doc->denormalizeComponentPath(root.readElementText()));
         }
@@ -332,6 +442,8 @@ bool Audio::loadXML(QXmlStreamReader &root)
 
 void Audio::postLoad()
 {
+    // decode flagged sources in background once the workspace is loaded
+    requestPreload();
 }
 
 /*********************************************************************
@@ -339,18 +451,23 @@ void Audio::postLoad()
  *********************************************************************/
 void Audio::preRun(MasterTimer* timer)
 {
-    if (m_decoder != NULL)
+    m_playbackDecoder = playbackDecoder();
+
+    if (m_playbackDecoder != NULL)
     {
         uint fadeIn = overrideFadeInSpeed() == defaultSpeed() ? fadeInSpeed() : overrideFadeInSpeed();
 
+        QMutexLocker locker(&m_audioOutMutex);
+
         if (m_audio_out != NULL && m_audio_out->isRunning())
         {
             delete m_audio_out;
             m_audio_out = NULL;
         }
 
-        m_decoder->seek(elapsed());
-        AudioParameters ap = m_decoder->audioParameters();
+        m_playbackOffset = elapsed();
+        m_playbackDecoder->seek(m_playbackOffset);
+        AudioParameters ap = m_playbackDecoder->audioParameters();
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
  #if defined(__APPLE__) || defined(Q_OS_MAC)
         //m_audio_out = new AudioRendererCoreAudio();
@@ -366,7 +483,7 @@ void Audio::preRun(MasterTimer* timer)
 #else
         m_audio_out = new AudioRendererQt6(m_audioDevice, doc());
 #endif
-        m_audio_out->setDecoder(m_decoder);
+        m_audio_out->setDecoder(m_playbackDecoder);
         m_audio_out->initialize(ap.sampleRate(), ap.channels(), ap.format());
         m_audio_out->adjustIntensity(m_volume * getAttributeValue(Intensity));
         m_audio_out->setFadeIn(elapsed() ? 0 : fadeIn);
@@ -378,6 +495,20 @@ void Audio::preRun(MasterTimer* timer)
     Function::preRun(timer);
 }
 
+qint64 Audio::playbackPosition()
+{
+    QMutexLocker locker(&m_audioOutMutex);
+
+    if (m_audio_out == NULL || m_audio_out->isRunning() == false)
+        return -1;
+
+    qint64 played = m_audio_out->playbackTime();
+    if (played < 0)
+        return -1;
+
+    return qint64(m_playbackOffset) + played / 1000;
+}
+
 void Audio::setPause(bool enable)
 {
     if (isRunning())
@@ -21,6 +21,7 @@
 #define AUDIO_H
 
 #include <QColor>
+#include <QMutex>
 
 #include "audiorenderer.h"
 #include "audiodecoder.h"
@@ -118,6 +119,13 @@ public:
      */
     QString audioDevice();
 
+    /**
+     * Get/Set the preload flag. When enabled, the source file is decoded
+     * in memory in background, so playback starts instantly from RAM
+     */
+    bool preload() const;
+    void setPreload(bool enable);
+
     int adjustAttribute(qreal fraction, int attributeId) override;
 
 signals:
@@ -126,11 +134,27 @@ signals:
 protected slots:
     void slotEndOfStream();
 
+private:
+    /** Request the decoding of the source file in memory, if needed */
+    void requestPreload();
+
+    /** Release the in-memory data of the source file, if requested */
+    void releasePreload();
+
+    /** Return the decoder to be used for the next playback */
+    AudioDecoder *playbackDecoder();
+
 private:
     /** Instance of an AudioDecoder to perform actual audio decoding */
     AudioDecoder *m_decoder;
+    /** Decoder of the in-memory PCM data, when preloaded */
+    AudioDecoder *m_preloadDecoder;
+    /** The decoder currently feeding m_audio_out */
+    AudioDecoder *m_playbackDecoder;
     /** output interface to render audio data got from m_decoder */
     AudioRenderer *m_audio_out;
+    /** Guards m_audio_out replacement against playbackPosition() */
+    QMutex m_audioOutMutex;
     /** Audio device to use for rendering */
     QString m_audioDevice;
     /** Name of the source audio file */
@@ -139,6 +163,12 @@ private:
     qint64 m_audioDuration;
     /** Startup volume of the audio file */
     qreal m_volume;
+    /** Flag to decode the source file in memory */
+    bool m_preload;
+    /** True when this function holds a reference to the preloaded data */
+    bool m_preloadAcquired;
+    /** Source time in milliseconds the current playback started from */
+    quint32 m_playbackOffset;
 
     /*********************************************************************
      * Save & Load
@@ -160,6 +190,14 @@ public:
     /** @reimpl */
     void preRun(MasterTimer*) override;
 
+    /**
+     * Return the time in milliseconds, relative to the function start,
+     * of the audio currently heard from the output device, or -1 if
+     * there is no playback clock available.
+     * Loops are not folded, so the value keeps growing with the playback.
+     */
+    qint64 playbackPosition();
+
     /** @reimpl */
     void setPause(bool enable) override;
 
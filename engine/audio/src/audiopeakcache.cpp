@@ -0,0 +1,401 @@
+/*
+  Q Light Controller Plus
+  audiopeakcache.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDebug>
+#include <QDir>
+
+#include <cstring>
+
+#include "audiopeakcache.h"
+#include "audiodecoder.h"
+
+#define PEAK_FILE_MAGIC     "QLCPEAKS"
+#define PEAK_FILE_VERSION   1
+#define PEAK_BYTE_ORDER     0x01020304
+#define PEAK_FILE_EXT       ".peaks"
+
+/** Audio frames summarized by a single peak of the finest level */
+#define PEAK_BASE_FRAMES    256
+/** Number of peaks of a level merged into one peak of the next level */
+#define PEAK_LEVEL_FACTOR   4
+
+struct PeakFileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 sampleRate;
+    quint32 channels;
+    quint32 levels;
+    quint32 reserved;
+    quint64 frames;
+    qint64 sourceSize;
+    qint64 sourceModified;
+};
+
+struct PeakFileLevel
+{
+    quint64 offset;
+    quint64 count;
+    quint32 blockFrames;
+    quint32 reserved;
+};
+
+AudioPeakCache::AudioPeakCache()
+    : m_map(NULL)
+    , m_channels(0)
+    , m_sampleRate(0)
+    , m_frames(0)
+{
+}
+
+AudioPeakCache::~AudioPeakCache()
+{
+    close();
+}
+
+QString AudioPeakCache::peakFilePath(const QString &audioFile)
+{
+    QString absPath = QFileInfo(audioFile).absoluteFilePath();
+    QByteArray hash = QCryptographicHash::hash(absPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+
+    return dir.absoluteFilePath(QString("peaks/%1%2").arg(QString(hash)).arg(PEAK_FILE_EXT));
+}
+
+bool AudioPeakCache::open(const QString &audioFile)
+{
+    close();
+
+    QFileInfo source(audioFile);
+    if (source.exists() == false)
+        return false;
+
+    m_file.setFileName(peakFilePath(audioFile));
+    if (m_file.open(QIODevice::ReadOnly) == false)
+        return false;
+
+    qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(PeakFileHeader)))
+    {
+        close();
+        return false;
+    }
+
+    m_map = m_file.map(0, fileSize);
+    if (m_map == NULL)
+    {
+        close();
+        return false;
+    }
+
+    const PeakFileHeader *header = reinterpret_cast<const PeakFileHeader *>(m_map);
+    qint64 tableEnd = sizeof(PeakFileHeader) + qint64(header->levels) * sizeof(PeakFileLevel);
+
+    if (memcmp(header->magic, PEAK_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != PEAK_FILE_VERSION ||
+        header->byteOrder != PEAK_BYTE_ORDER ||
+        header->channels == 0 || header->levels == 0 ||
+        header->sourceSize != source.size() ||
+        header->sourceModified != source.lastModified().toMSecsSinceEpoch() ||
+        tableEnd > fileSize)
+    {
+        close();
+        return false;
+    }
+
+    const PeakFileLevel *table = reinterpret_cast<const PeakFileLevel *>(m_map + sizeof(PeakFileHeader));
+    for (quint32 i = 0; i < header->levels; i++)
+    {
+        quint64 levelSize = table[i].count * header->channels * sizeof(Peak);
+        if (table[i].blockFrames == 0 || table[i].offset + levelSize > quint64(fileSize))
+        {
+            close();
+            return false;
+        }
+
+        Level level;
+        level.data = reinterpret_cast<const Peak *>(m_map + table[i].offset);
+        level.count = table[i].count;
+        level.blockFrames = table[i].blockFrames;
+        m_levels.append(level);
+    }
+
+    m_channels = int(header->channels);
+    m_sampleRate = header->sampleRate;
+    m_frames = header->frames;
+
+    return true;
+}
+
+static qint16 sampleToPeak(const char *data, AudioFormat format)
+{
+    switch (format)
+    {
+        case PCM_S8:
+            return qint16(qint8(*data) * 256);
+        case PCM_S24LE:
+        {
+            qint32 value;
+            memcpy(&value, data, sizeof(value));
+            return qint16(value >> 8);
+        }
+        case PCM_S32LE:
+        {
+            qint32 value;
+            memcpy(&value, data, sizeof(value));
+            return qint16(value >> 16);
+        }
+        default:
+        {
+            qint16 value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+    }
+}
+
+bool AudioPeakCache::build(AudioDecoder *decoder, const QString &audioFile)
+{
+    if (decoder == NULL)
+        return false;
+
+    AudioParameters ap = decoder->audioParameters();
+    int channels = ap.channels();
+    int sampleSize = ap.sampleSize();
+    int frameBytes = channels * sampleSize;
+
+    if (channels <= 0 || sampleSize <= 0)
+        return false;
+
+    const Peak emptyPeak = { 32767, -32768 };
+    QVector<QVector<Peak>> levels(1);
+    QVector<Peak> block(channels, emptyPeak);
+    quint32 blockFill = 0;
+    quint64 frames = 0;
+
+    QByteArray buffer(frameBytes * 4096, 0);
+    int pending = 0;
+
+    decoder->seek(0);
+
+    while (true)
+    {
+        qint64 read = decoder->read(buffer.data() + pending, buffer.size() - pending);
+        if (read <= 0)
+            break;
+
+        int available = pending + int(read);
+        int frameCount = available / frameBytes;
+        const char *ptr = buffer.constData();
+
+        for (int f = 0; f < frameCount; f++)
+        {
+            for (int c = 0; c < channels; c++, ptr += sampleSize)
+            {
+                qint16 value = sampleToPeak(ptr, ap.format());
+                block[c].min = qMin(block[c].min, value);
+                block[c].max = qMax(block[c].max, value);
+            }
+
+            if (++blockFill == PEAK_BASE_FRAMES)
+            {
+                levels[0] += block;
+                block.fill(emptyPeak);
+                blockFill = 0;
+            }
+        }
+
+        frames += frameCount;
+
+        // keep a trailing partial frame for the next read
+        pending = available - frameCount * frameBytes;
+        if (pending > 0)
+            memmove(buffer.data(), ptr, pending);
+    }
+
+    if (blockFill > 0)
+        levels[0] += block;
+
+    decoder->seek(0);
+
+    if (frames == 0)
+        return false;
+
+    // build the coarser levels by merging the peaks of the previous one
+    quint32 blockFrames = PEAK_BASE_FRAMES;
+    while (levels.last().count() / channels > 1)
+    {
+        const QVector<Peak> &prev = levels.last();
+        int prevCount = prev.count() / channels;
+        QVector<Peak> next;
+        next.reserve(((prevCount + PEAK_LEVEL_FACTOR - 1) / PEAK_LEVEL_FACTOR) * channels);
+
+        for (int i = 0; i < prevCount; i += PEAK_LEVEL_FACTOR)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                Peak peak = emptyPeak;
+                for (int j = i; j < qMin(i + PEAK_LEVEL_FACTOR, prevCount); j++)
+                {
+                    peak.min = qMin(peak.min, prev.at(j * channels + c).min);
+                    peak.max = qMax(peak.max, prev.at(j * channels + c).max);
+                }
+                next.append(peak);
+            }
+        }
+        levels.append(next);
+        blockFrames *= PEAK_LEVEL_FACTOR;
+    }
+
+    QFileInfo source(audioFile);
+    QString path = peakFilePath(audioFile);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) == false)
+    {
+        qWarning() << "[AudioPeakCache] cannot write peak file" << path;
+        return false;
+    }
+
+    PeakFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PEAK_FILE_MAGIC, sizeof(header.magic));
+    header.version = PEAK_FILE_VERSION;
+    header.byteOrder = PEAK_BYTE_ORDER;
+    header.sampleRate = ap.sampleRate();
+    header.channels = quint32(channels);
+    header.levels = quint32(levels.count());
+    header.frames = frames;
+    header.sourceSize = source.size();
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // level data is kept 8-bytes aligned, so it can be used straight from the map
+    QVector<PeakFileLevel> table(levels.count());
+    quint64 offset = sizeof(PeakFileHeader) + table.count() * sizeof(PeakFileLevel);
+    blockFrames = PEAK_BASE_FRAMES;
+    for (int i = 0; i < levels.count(); i++)
+    {
+        table[i].offset = offset;
+        table[i].count = levels.at(i).count() / channels;
+        table[i].blockFrames = blockFrames;
+        table[i].reserved = 0;
+        offset += (levels.at(i).count() * sizeof(Peak) + 7) & ~quint64(7);
+        blockFrames *= PEAK_LEVEL_FACTOR;
+    }
+    file.write(reinterpret_cast<const char *>(table.constData()), table.count() * sizeof(PeakFileLevel));
+
+    const char padding[8] = { 0 };
+    for (int i = 0; i < levels.count(); i++)
+    {
+        qint64 size = levels.at(i).count() * sizeof(Peak);
+        file.write(reinterpret_cast<const char *>(levels.at(i).constData()), size);
+        if (size % 8)
+            file.write(padding, 8 - (size % 8));
+    }
+
+    return file.commit();
+}
+
+void AudioPeakCache::close()
+{
+    if (m_map != NULL)
+    {
+        m_file.unmap(m_map);
+        m_map = NULL;
+    }
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_levels.clear();
+    m_channels = 0;
+    m_sampleRate = 0;
+    m_frames = 0;
+}
+
+bool AudioPeakCache::isValid() const
+{
+    return m_map != NULL && m_levels.isEmpty() == false;
+}
+
+int AudioPeakCache::channels() const
+{
+    return m_channels;
+}
+
+quint32 AudioPeakCache::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+quint64 AudioPeakCache::frames() const
+{
+    return m_frames;
+}
+
+bool AudioPeakCache::peaks(quint64 startFrame, quint64 frameCount, int columns, QVector<Peak> &peaks) const
+{
+    if (isValid() == false || columns <= 0 || frameCount == 0)
+        return false;
+
+    double framesPerColumn = double(frameCount) / double(columns);
+
+    int lvl = 0;
+    while (lvl + 1 < m_levels.count() && m_levels.at(lvl + 1).blockFrames <= framesPerColumn)
+        lvl++;
+
+    const Level &level = m_levels.at(lvl);
+    peaks.resize(columns * m_channels);
+
+    for (int col = 0; col < columns; col++)
+    {
+        quint64 from = startFrame + quint64(col * framesPerColumn);
+        quint64 to = startFrame + quint64((col + 1) * framesPerColumn);
+        quint64 first = from / level.blockFrames;
+        quint64 last = qMin(qMax(first + 1, (to + level.blockFrames - 1) / level.blockFrames), level.count);
+
+        for (int c = 0; c < m_channels; c++)
+        {
+            Peak &peak = peaks[col * m_channels + c];
+
+            if (first >= last)
+            {
+                peak.min = peak.max = 0;
+                continue;
+            }
+
+            peak = level.data[first * m_channels + c];
+            for (quint64 b = first + 1; b < last; b++)
+            {
+                const Peak &p = level.data[b * m_channels + c];
+                peak.min = qMin(peak.min, p.min);
+                peak.max = qMax(peak.max, p.max);
+            }
+        }
+    }
+
+    return true;
+}
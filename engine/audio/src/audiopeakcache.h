@@ -0,0 +1,107 @@
+/*
+  Q Light Controller Plus
+  audiopeakcache.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef AUDIOPEAKCACHE_H
+#define AUDIOPEAKCACHE_H
+
+#include <QVector>
+#include <QString>
+#include <QFile>
+
+class AudioDecoder;
+
+/** @addtogroup engine_audio Audio
+ * @{
+ */
+
+/**
+ * AudioPeakCache handles a persistent, multi-resolution min/max peak file
+ * of an audio source. The file is built once by decoding the whole source,
+ * then it is memory mapped, so drawing a waveform at any zoom level only
+ * reads a few precomputed peaks instead of decoding the audio again.
+ *
+ * Level 0 holds one min/max pair per channel every PEAK_BASE_FRAMES frames,
+ * each following level merges PEAK_LEVEL_FACTOR peaks of the previous one.
+ * A peak file is considered outdated when the size or the modification time
+ * of its source file don't match the ones it was built from.
+ */
+class AudioPeakCache final
+{
+public:
+    struct Peak
+    {
+        qint16 min;
+        qint16 max;
+    };
+
+    AudioPeakCache();
+    ~AudioPeakCache();
+
+    /** Return the peak file path used for $audioFile in the user cache directory */
+    static QString peakFilePath(const QString &audioFile);
+
+    /**
+     * Open and map the peak file of $audioFile, if there is
+     * an up to date one. Returns false if the file must be (re)built.
+     */
+    bool open(const QString &audioFile);
+
+    /**
+     * Decode the whole audio stream of $decoder and write the peak file
+     * of $audioFile. The decoder is rewound but not deleted.
+     */
+    static bool build(AudioDecoder *decoder, const QString &audioFile);
+
+    /** Unmap and close the current peak file */
+    void close();
+
+    /** Return true if a peak file is currently mapped */
+    bool isValid() const;
+
+    int channels() const;
+    quint32 sampleRate() const;
+    quint64 frames() const;
+
+    /**
+     * Fill $peaks with $columns min/max pairs per channel, covering
+     * $frameCount audio frames starting at $startFrame.
+     * Data is arranged as [column][channel]. The coarsest level with
+     * a resolution finer than a column is used to compute the result.
+     */
+    bool peaks(quint64 startFrame, quint64 frameCount, int columns, QVector<Peak> &peaks) const;
+
+private:
+    struct Level
+    {
+        const Peak *data;
+        quint64 count;
+        quint32 blockFrames;
+    };
+
+    QFile m_file;
+    uchar *m_map;
+    int m_channels;
+    quint32 m_sampleRate;
+    quint64 m_frames;
+    QVector<Level> m_levels;
+};
+
+/** @} */
+
+#endif
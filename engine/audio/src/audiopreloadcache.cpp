@@ -0,0 +1,326 @@
+/*
+  Q Light Controller Plus
+  audiopreloadcache.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QSettings>
+#include <QDebug>
+
+#include <climits>
+#include <cstring>
+
+#include "audiopreloadcache.h"
+
+/** Default memory budget in megabytes */
+#define DEFAULT_PRELOAD_BUDGET  1024
+/** Size of a single decoding chunk */
+#define PRELOAD_CHUNK_SIZE      (64 * 1024)
+
+/*****************************************************************************
+ * PreloadedAudioDecoder
+ *****************************************************************************/
+
+PreloadedAudioDecoder::PreloadedAudioDecoder(QSharedPointer<PreloadedAudio> audio)
+    : m_audio(audio)
+    , m_position(0)
+{
+    AudioParameters ap = m_audio->parameters;
+    m_frameBytes = qMax(1, ap.channels() * ap.sampleSize());
+    configure(ap.sampleRate(), ap.channels(), ap.format());
+}
+
+PreloadedAudioDecoder::~PreloadedAudioDecoder()
+{
+}
+
+AudioDecoder *PreloadedAudioDecoder::createCopy()
+{
+    return new PreloadedAudioDecoder(m_audio);
+}
+
+int PreloadedAudioDecoder::priority() const
+{
+    return 0;
+}
+
+QStringList PreloadedAudioDecoder::supportedFormats()
+{
+    return QStringList();
+}
+
+bool PreloadedAudioDecoder::initialize(const QString &path)
+{
+    Q_UNUSED(path)
+    return true;
+}
+
+qint64 PreloadedAudioDecoder::totalTime()
+{
+    quint32 sampleRate = m_audio->parameters.sampleRate();
+    if (sampleRate == 0)
+        return 0;
+
+    return (qint64(m_audio->pcm.size()) / m_frameBytes) * 1000 / sampleRate;
+}
+
+void PreloadedAudioDecoder::seek(qint64 time)
+{
+    // position on the exact frame of the requested time
+    qint64 frame = time * m_audio->parameters.sampleRate() / 1000;
+    m_position = qBound(qint64(0), frame * m_frameBytes, qint64(m_audio->pcm.size()));
+}
+
+qint64 PreloadedAudioDecoder::read(char *data, qint64 maxSize)
+{
+    qint64 length = qMin(maxSize, qint64(m_audio->pcm.size()) - m_position);
+    if (length <= 0)
+        return 0;
+
+    memcpy(data, m_audio->pcm.constData() + m_position, length);
+    m_position += length;
+
+    return length;
+}
+
+int PreloadedAudioDecoder::bitrate()
+{
+    return int(qint64(m_audio->parameters.sampleRate()) * m_frameBytes * 8 / 1000);
+}
+
+/*****************************************************************************
+ * AudioPreloadCache
+ *****************************************************************************/
+
+AudioPreloadCache::AudioPreloadCache(QObject *parent)
+    : QThread(parent)
+    , m_cancelCurrent(false)
+    , m_memoryUsage(0)
+    , m_running(true)
+{
+    QSettings settings;
+    QVariant var = settings.value(SETTINGS_AUDIO_PRELOAD_BUDGET);
+    qint64 budgetMB = var.isValid() ? var.toLongLong() : DEFAULT_PRELOAD_BUDGET;
+    m_memoryBudget = budgetMB * 1024 * 1024;
+}
+
+AudioPreloadCache::~AudioPreloadCache()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_running = false;
+        m_cancelCurrent = true;
+        m_requestCondition.wakeAll();
+    }
+    wait();
+
+    clear();
+}
+
+qint64 AudioPreloadCache::memoryBudget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_memoryBudget;
+}
+
+void AudioPreloadCache::setMemoryBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_memoryBudget = bytes;
+}
+
+qint64 AudioPreloadCache::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_memoryUsage;
+}
+
+bool AudioPreloadCache::acquire(const QString &filename, AudioDecoder *decoder)
+{
+    if (decoder == NULL)
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_refCounts[filename]++ > 0)
+    {
+        delete decoder;
+        return true;
+    }
+
+    m_queue.append(qMakePair(filename, decoder));
+
+    // nothing to decode until the first request
+    if (isRunning() == false)
+        start(QThread::LowPriority);
+
+    m_requestCondition.wakeOne();
+
+    return true;
+}
+
+QSharedPointer<PreloadedAudio> AudioPreloadCache::buffer(const QString &filename) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_buffers.value(filename);
+}
+
+void AudioPreloadCache::release(const QString &filename)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<QString, int>::iterator it = m_refCounts.find(filename);
+    if (it == m_refCounts.end())
+        return;
+
+    if (--it.value() > 0)
+        return;
+
+    m_refCounts.erase(it);
+
+    if (m_current == filename)
+        m_cancelCurrent = true;
+
+    for (int i = m_queue.count() - 1; i >= 0; i--)
+    {
+        if (m_queue.at(i).first == filename)
+            delete m_queue.takeAt(i).second;
+    }
+
+    // playing decoders keep a reference to the data until they're done
+    QSharedPointer<PreloadedAudio> audio = m_buffers.take(filename);
+    if (audio.isNull() == false)
+        m_memoryUsage -= audio->pcm.size();
+}
+
+void AudioPreloadCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_current.isEmpty() == false)
+        m_cancelCurrent = true;
+
+    while (m_queue.isEmpty() == false)
+        delete m_queue.takeFirst().second;
+
+    m_buffers.clear();
+    m_refCounts.clear();
+    m_memoryUsage = 0;
+}
+
+QSharedPointer<PreloadedAudio> AudioPreloadCache::decode(const QString &filename, AudioDecoder *decoder)
+{
+    AudioParameters ap = decoder->audioParameters();
+    qint64 frameBytes = ap.channels() * ap.sampleSize();
+    qint64 estimated = decoder->totalTime() * ap.sampleRate() / 1000 * frameBytes;
+    qint64 available;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        available = m_memoryBudget - m_memoryUsage;
+    }
+
+    if (frameBytes <= 0 || estimated > available || estimated > INT_MAX)
+    {
+        qWarning() << "[AudioPreloadCache]" << filename << "doesn't fit in the preload memory budget";
+        return QSharedPointer<PreloadedAudio>();
+    }
+
+    QSharedPointer<PreloadedAudio> audio(new PreloadedAudio);
+    audio->parameters = ap;
+    audio->pcm.reserve(int(estimated));
+
+    QByteArray chunk(PRELOAD_CHUNK_SIZE, 0);
+    decoder->seek(0);
+
+    while (true)
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_cancelCurrent)
+                return QSharedPointer<PreloadedAudio>();
+        }
+
+        qint64 read = decoder->read(chunk.data(), chunk.size());
+        if (read <= 0)
+            break;
+
+        if (audio->pcm.size() + read > qMin(available, qint64(INT_MAX)))
+        {
+            qWarning() << "[AudioPreloadCache]" << filename << "exceeded the preload memory budget";
+            return QSharedPointer<PreloadedAudio>();
+        }
+
+        audio->pcm.append(chunk.constData(), int(read));
+    }
+
+    audio->pcm.squeeze();
+
+    return audio;
+}
+
+void AudioPreloadCache::run()
+{
+    while (true)
+    {
+        QString filename;
+        AudioDecoder *decoder = NULL;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_running && m_queue.isEmpty())
+                m_requestCondition.wait(&m_mutex);
+
+            if (m_running == false)
+                break;
+
+            QPair<QString, AudioDecoder *> request = m_queue.takeFirst();
+            filename = request.first;
+            decoder = request.second;
+            m_current = filename;
+            m_cancelCurrent = false;
+        }
+
+        QSharedPointer<PreloadedAudio> audio = decode(filename, decoder);
+        delete decoder;
+
+        bool done = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (audio.isNull() == false && m_cancelCurrent == false &&
+                m_memoryUsage + audio->pcm.size() <= m_memoryBudget)
+            {
+                m_buffers.insert(filename, audio);
+                m_memoryUsage += audio->pcm.size();
+                done = true;
+            }
+            m_current.clear();
+            m_cancelCurrent = false;
+        }
+
+        if (done)
+        {
+            qDebug() << "[AudioPreloadCache]" << filename << "preloaded," << audio->pcm.size() << "bytes";
+            emit preloaded(filename);
+        }
+    }
+
+    // drop any request left in the queue
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.isEmpty() == false)
+        delete m_queue.takeFirst().second;
+}
@@ -0,0 +1,166 @@
+/*
+  Q Light Controller Plus
+  audiopreloadcache.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef AUDIOPRELOADCACHE_H
+#define AUDIOPRELOADCACHE_H
+
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QByteArray>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QPair>
+#include <QList>
+
+#include "audiodecoder.h"
+
+/** @addtogroup engine_audio Audio
+ * @{
+ */
+
+#define SETTINGS_AUDIO_PRELOAD_BUDGET "audio/preloadbudget"
+
+/** Fully decoded PCM data of an audio source */
+struct PreloadedAudio
+{
+    AudioParameters parameters;
+    QByteArray pcm;
+};
+
+/**
+ * A decoder that plays PCM data already decoded in memory.
+ * Seeking is sample accurate and reading never touches the disk.
+ */
+class PreloadedAudioDecoder final : public AudioDecoder
+{
+    Q_OBJECT
+
+public:
+    PreloadedAudioDecoder(QSharedPointer<PreloadedAudio> audio);
+    ~PreloadedAudioDecoder();
+
+    /** @reimp */
+    AudioDecoder *createCopy() override;
+
+    /** @reimp */
+    int priority() const override;
+
+    /** @reimp */
+    QStringList supportedFormats() override;
+
+    /** @reimp */
+    bool initialize(const QString &path) override;
+
+    /** @reimp */
+    qint64 totalTime() override;
+
+    /** @reimp */
+    void seek(qint64 time) override;
+
+    /** @reimp */
+    qint64 read(char *data, qint64 maxSize) override;
+
+    /** @reimp */
+    int bitrate() override;
+
+private:
+    QSharedPointer<PreloadedAudio> m_audio;
+    int m_frameBytes;
+    qint64 m_position;
+};
+
+/**
+ * AudioPreloadCache decodes audio sources to PCM in a background thread,
+ * so that flagged Audio functions can start playing from RAM without any
+ * decoder startup latency. The total amount of decoded data is limited
+ * by a memory budget: sources that don't fit are simply played from disk.
+ *
+ * Several Audio functions can use the same source file, so the decoded
+ * data is reference counted. The decoding thread is started on the first
+ * acquire().
+ */
+class AudioPreloadCache final : public QThread
+{
+    Q_OBJECT
+
+public:
+    AudioPreloadCache(QObject *parent);
+    ~AudioPreloadCache();
+
+    /** Get/Set the maximum amount of memory in bytes used by decoded data */
+    qint64 memoryBudget() const;
+    void setMemoryBudget(qint64 bytes);
+
+    /** Get the amount of memory in bytes currently used by decoded data */
+    qint64 memoryUsage() const;
+
+    /**
+     * Add a reference to the decoded data of $filename, queueing it for
+     * background decoding using $decoder if nobody requested it yet.
+     * The cache takes ownership of $decoder.
+     *
+     * @return false if no reference was added ($decoder is NULL)
+     */
+    bool acquire(const QString &filename, AudioDecoder *decoder);
+
+    /** Return the decoded data of $filename, or a null pointer if not ready */
+    QSharedPointer<PreloadedAudio> buffer(const QString &filename) const;
+
+    /** Remove a reference to the decoded data of $filename. The data is
+     *  dropped, or its decoding canceled, when no reference is left */
+    void release(const QString &filename);
+
+    /** Drop every decoded data and pending request */
+    void clear();
+
+signals:
+    /** Emitted when $filename has been completely decoded */
+    void preloaded(const QString &filename);
+
+protected:
+    /** @reimp */
+    void run() override;
+
+private:
+    /** Decode $decoder data, returning a null pointer on failure or cancellation */
+    QSharedPointer<PreloadedAudio> decode(const QString &filename, AudioDecoder *decoder);
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_requestCondition;
+
+    /** Sources waiting to be decoded */
+    QList<QPair<QString, AudioDecoder *>> m_queue;
+    /** Decoded sources */
+    QHash<QString, QSharedPointer<PreloadedAudio>> m_buffers;
+    /** Number of references to each requested source */
+    QHash<QString, int> m_refCounts;
+    /** The source currently being decoded */
+    QString m_current;
+    bool m_cancelCurrent;
+
+    qint64 m_memoryBudget;
+    qint64 m_memoryUsage;
+    bool m_running;
+};
+
+/** @} */
+
+#endif
@@ -23,6 +23,11 @@
 #include "audiorenderer.h"
 #include "qlcmacros.h"
 
+/** Max time in ms the playback clock is extrapolated between two device updates */
+#define CLOCK_EXTRAPOLATION_LIMIT   100
+/** Time in ms after which a device clock that doesn't advance is considered stalled */
+#define CLOCK_STALL_TIMEOUT         500
+
 AudioRenderer::AudioRenderer (QObject* parent)
     : QThread (parent)
     , m_looped(false)
@@ -32,6 +37,9 @@ AudioRenderer::AudioRenderer (QObject* parent)
     , m_isEos(false)
     , m_intensity(1.0)
     , m_currentIntensity(1.0)
+    , m_bytesWritten(0)
+    , m_bytesPerSecond(0)
+    , m_clockTime(-1)
     , m_adec(NULL)
     , audioDataRead(0)
     , pendingAudioBytes(0)
@@ -63,6 +71,53 @@ bool AudioRenderer::isEos()
     return m_isEos;
 }
 
+/*********************************************************************
+ * Playback clock
+ *********************************************************************/
+
+qint64 AudioRenderer::playbackTime()
+{
+    QMutexLocker locker(&m_clockMutex);
+
+    if (m_clockTime < 0 || m_clockTimer.isValid() == false)
+        return -1;
+
+    if (m_pause)
+        return m_clockTime;
+
+    // devices update their clock once per period: fill the gaps in between
+    qint64 elapsed = m_clockTimer.elapsed();
+    if (elapsed > CLOCK_STALL_TIMEOUT && m_isEos == false)
+        return -1;
+
+    return m_clockTime + qMin(elapsed, qint64(CLOCK_EXTRAPOLATION_LIMIT)) * 1000;
+}
+
+qint64 AudioRenderer::processedTime()
+{
+    if (m_bytesPerSecond == 0)
+        return 0;
+
+    return qMax(qint64(0), (m_bytesWritten * 1000000 / m_bytesPerSecond) - (latency() * 1000));
+}
+
+void AudioRenderer::updatePlaybackClock()
+{
+    qint64 processed = processedTime();
+
+    QMutexLocker locker(&m_clockMutex);
+
+    // nothing has been played yet
+    if (processed <= 0)
+        return;
+
+    if (processed != m_clockTime || m_pause)
+    {
+        m_clockTime = processed;
+        m_clockTimer.restart();
+    }
+}
+
 /*********************************************************************
  * Fade sequences
  *********************************************************************/
@@ -121,12 +176,23 @@ void AudioRenderer::run()
     qint64 audioDataWritten;
     audioDataRead = 0;
 
-    int sampleSize = m_adec->audioParameters().sampleSize();
+    AudioParameters ap = m_adec->audioParameters();
+    {
+        QMutexLocker locker(&m_clockMutex);
+        m_bytesWritten = 0;
+        m_bytesPerSecond = qint64(ap.sampleRate()) * ap.channels() * ap.sampleSize();
+        m_clockTime = -1;
+        m_clockTimer.invalidate();
+    }
+
+    int sampleSize = ap.sampleSize();
     if (sampleSize > 2)
         sampleSize = 2;
 
     while (!m_userStop)
     {
+        updatePlaybackClock();
+
         QMutexLocker locker(&m_mutex);
 
         if (m_pause == false && m_isEos == false)
@@ -194,6 +260,8 @@ void AudioRenderer::run()
                     }
                 }
                 audioDataWritten = writeAudio(audioData, audioDataRead);
+                if (audioDataWritten > 0)
+                    m_bytesWritten += audioDataWritten;
                 if (audioDataWritten < audioDataRead)
                 {
                     pendingAudioBytes = audioDataRead - audioDataWritten;
@@ -205,7 +273,11 @@ void AudioRenderer::run()
             else
             {
                 audioDataWritten = writeAudio(audioData + (audioDataRead - pendingAudioBytes), pendingAudioBytes);
-                pendingAudioBytes -= audioDataWritten;
+                if (audioDataWritten > 0)
+                {
+                    pendingAudioBytes -= audioDataWritten;
+                    m_bytesWritten += audioDataWritten;
+                }
                 if (audioDataWritten == 0)
                     usleep(15000);
             }
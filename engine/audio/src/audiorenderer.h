@@ -20,6 +20,7 @@
 #ifndef AUDIORENDERER_H
 #define AUDIORENDERER_H
 
+#include <QElapsedTimer>
 #include <QThread>
 #include <QMutex>
 
@@ -102,6 +103,42 @@ public:
 private:
     bool m_looped;
 
+    /*********************************************************************
+     * Playback clock
+     *********************************************************************/
+public:
+    /*!
+     * Returns the time in microseconds of audio actually played by the
+     * output device since the renderer started, or -1 if the device
+     * is not playing yet or it is stalled.
+     * This method can be called from any thread.
+     */
+    qint64 playbackTime();
+
+protected:
+    /*!
+     * Returns the time in microseconds of audio processed by the output
+     * device. It is called only by the renderer thread.
+     * The default implementation derives it from the amount of data
+     * written to the device, minus the device latency.
+     */
+    virtual qint64 processedTime();
+
+private:
+    /** Sample the device clock. Called on every renderer cycle */
+    void updatePlaybackClock();
+
+private:
+    QMutex m_clockMutex;
+    /** Bytes of audio data written to the device since start */
+    qint64 m_bytesWritten;
+    /** Bytes of audio data played in one second */
+    qint64 m_bytesPerSecond;
+    /** Last processed time sampled from the device */
+    qint64 m_clockTime;
+    /** Time elapsed since m_clockTime last changed */
+    QElapsedTimer m_clockTimer;
+
     /*********************************************************************
      * Fade sequences
      *********************************************************************/
@@ -176,6 +176,14 @@ void AudioRendererQt5::resume()
     m_audioOutput->resume();
 }
 
+qint64 AudioRendererQt5::processedTime()
+{
+    if (m_audioOutput == NULL)
+        return 0;
+
+    return m_audioOutput->processedUSecs();
+}
+
 void AudioRendererQt5::run()
 {
     if (m_audioOutput == NULL)
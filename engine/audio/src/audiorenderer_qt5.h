@@ -62,6 +62,9 @@ protected:
     /** @reimpl */
     void resume() override;
 
+    /** @reimpl */
+    qint64 processedTime() override;
+
     /*********************************************************************
      * Thread functions
      *********************************************************************/
@@ -179,6 +179,14 @@ void AudioRendererQt6::resume()
     m_audioSink->resume();
 }
 
+qint64 AudioRendererQt6::processedTime()
+{
+    if (m_audioSink == NULL)
+        return 0;
+
+    return m_audioSink->processedUSecs();
+}
+
 void AudioRendererQt6::run()
 {
     if (m_audioSink == NULL)
@@ -0,0 +1,187 @@
+/*
+  Q Light Controller Plus
+  beatphasetracker.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtMath>
+
+#include "beatphasetracker.h"
+
+/** Shortest accepted beat period (300 BPM) */
+#define MIN_BEAT_PERIOD     200000000.0
+/** Longest accepted beat period (30 BPM) */
+#define MAX_BEAT_PERIOD     2000000000.0
+
+/** Maximum onset distance from the predicted beat, as a fraction of period */
+#define PHASE_TOLERANCE     0.25
+/** Out of tolerance onsets (each hit pays one back) before the loop is re-seeded */
+#define MAX_MISSES          3
+/** Matching onsets required before the loop is considered locked */
+#define LOCK_HITS           4
+/** Minimum confidence of a locked loop */
+#define LOCK_CONFIDENCE     0.5
+/** Number of beats the loop keeps running without onsets */
+#define FREEWHEEL_BEATS     8
+
+BeatPhaseTracker::BeatPhaseTracker()
+    : m_phaseGain(0.5)
+    , m_periodGain(0.1)
+{
+    reset();
+}
+
+BeatPhaseTracker::~BeatPhaseTracker()
+{
+}
+
+void BeatPhaseTracker::reset()
+{
+    m_reference = -1;
+    m_period = 0;
+    m_lastOnset = -1;
+    m_confidence = 0;
+    m_hits = 0;
+    m_misses = 0;
+}
+
+void BeatPhaseTracker::seed(qint64 timestamp, qint64 interval)
+{
+    m_reference = timestamp;
+    m_period = (interval >= MIN_BEAT_PERIOD && interval <= MAX_BEAT_PERIOD) ? interval : 0;
+    m_confidence = 0;
+    m_hits = m_period > 0 ? 1 : 0;
+    m_misses = 0;
+}
+
+void BeatPhaseTracker::addOnset(qint64 timestamp)
+{
+    if (m_lastOnset < 0)
+    {
+        m_reference = timestamp;
+        m_lastOnset = timestamp;
+        return;
+    }
+
+    qint64 interval = timestamp - m_lastOnset;
+    if (interval <= 0)
+        return;
+
+    // no tempo yet, or the source went quiet for too long:
+    // start over from the interval of the last two onsets
+    if (m_period == 0 || interval > FREEWHEEL_BEATS * m_period)
+    {
+        seed(timestamp, interval);
+        m_lastOnset = timestamp;
+        return;
+    }
+
+    qint64 beats = qMax(qint64(0), qRound64(double(timestamp - m_reference) / m_period));
+    qint64 predicted = m_reference + qint64(beats * m_period);
+    double error = double(timestamp - predicted);
+    double tolerance = PHASE_TOLERANCE * m_period;
+
+    if (qAbs(error) <= tolerance)
+    {
+        // move the reference grid towards the onset and
+        // distribute the residual error over the elapsed beats
+        m_reference = predicted + qint64(m_phaseGain * error);
+        if (beats > 0)
+            m_period = qBound(MIN_BEAT_PERIOD, m_period + m_periodGain * error / beats, MAX_BEAT_PERIOD);
+
+        double quality = 1.0 - qAbs(error) / tolerance;
+        m_confidence = 0.8 * m_confidence + 0.2 * quality;
+        m_hits++;
+        m_misses = qMax(0, m_misses - 1);
+    }
+    else
+    {
+        m_confidence *= 0.7;
+        m_misses++;
+
+        if (m_misses >= MAX_MISSES)
+            seed(timestamp, interval);
+    }
+
+    m_lastOnset = timestamp;
+}
+
+bool BeatPhaseTracker::isLocked(qint64 now) const
+{
+    if (m_period == 0 || m_hits < LOCK_HITS || m_confidence < LOCK_CONFIDENCE)
+        return false;
+
+    return (now - m_lastOnset) < FREEWHEEL_BEATS * m_period;
+}
+
+double BeatPhaseTracker::confidence() const
+{
+    return m_confidence;
+}
+
+double BeatPhaseTracker::bpm() const
+{
+    if (m_period == 0)
+        return 0;
+
+    return 60000000000.0 / m_period;
+}
+
+qint64 BeatPhaseTracker::period() const
+{
+    return qint64(m_period);
+}
+
+double BeatPhaseTracker::phase(qint64 now) const
+{
+    if (m_period == 0)
+        return 0;
+
+    double beats = double(now - m_reference) / m_period;
+    double ph = beats - qFloor(beats);
+
+    return ph >= 1.0 ? 0.0 : ph;
+}
+
+qint64 BeatPhaseTracker::predictBeat(qint64 from, int ahead) const
+{
+    if (m_period == 0)
+        return -1;
+
+    double beats = qCeil(double(from - m_reference) / m_period);
+
+    return m_reference + qint64((beats + qMax(0, ahead)) * m_period);
+}
+
+void BeatPhaseTracker::setPhaseGain(double gain)
+{
+    m_phaseGain = qBound(0.0, gain, 1.0);
+}
+
+double BeatPhaseTracker::phaseGain() const
+{
+    return m_phaseGain;
+}
+
+void BeatPhaseTracker::setPeriodGain(double gain)
+{
+    m_periodGain = qBound(0.0, gain, 1.0);
+}
+
+double BeatPhaseTracker::periodGain() const
+{
+    return m_periodGain;
+}
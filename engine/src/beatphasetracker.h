@@ -0,0 +1,115 @@
+/*
+  Q Light Controller Plus
+  beatphasetracker.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef BEATPHASETRACKER_H
+#define BEATPHASETRACKER_H
+
+#include <QtGlobal>
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/**
+ * BeatPhaseTracker is a software phase-locked loop that follows a stream
+ * of beat onsets (audio beat detection, MIDI beat plugins...) and keeps
+ * a continuous estimation of the beat period and of the beat phase.
+ *
+ * Onsets are fed with addOnset() using timestamps (in nanoseconds) taken
+ * from a monotonic clock. Once the loop is locked, the tracker can predict
+ * upcoming beats, so MasterTimer can fire them on the tick closest to the
+ * real beat, instead of reacting to each onset up to a tick late.
+ *
+ * The tracker is not thread safe: callers must serialize the access.
+ */
+class BeatPhaseTracker final
+{
+public:
+    BeatPhaseTracker();
+    ~BeatPhaseTracker();
+
+    /** Forget any tempo/phase information */
+    void reset();
+
+    /**
+     * Feed a detected onset into the loop
+     *
+     * @param timestamp onset time in nanoseconds on a monotonic clock
+     */
+    void addOnset(qint64 timestamp);
+
+    /** Return true if the loop is locked on a tempo at the given time */
+    bool isLocked(qint64 now) const;
+
+    /** Return a confidence value between 0.0 and 1.0 of the current lock */
+    double confidence() const;
+
+    /** Return the estimated tempo in beats per minute, or 0 if unknown */
+    double bpm() const;
+
+    /** Return the estimated beat period in nanoseconds, or 0 if unknown */
+    qint64 period() const;
+
+    /** Return the beat phase at the given time, in the range [0.0, 1.0) */
+    double phase(qint64 now) const;
+
+    /**
+     * Predict the time of an upcoming beat
+     *
+     * @param from the time from which the prediction starts
+     * @param ahead the number of beats to skip after the first one
+     *              following (or at) @a from
+     * @return the predicted beat time in nanoseconds, or -1 if the
+     *         tracker has no valid tempo estimation
+     */
+    qint64 predictBeat(qint64 from, int ahead = 0) const;
+
+    /** Set the phase correction gain (0.0 - 1.0) */
+    void setPhaseGain(double gain);
+    double phaseGain() const;
+
+    /** Set the period correction gain (0.0 - 1.0) */
+    void setPeriodGain(double gain);
+    double periodGain() const;
+
+private:
+    /** Seed the loop with a new period, measured between two onsets */
+    void seed(qint64 timestamp, qint64 interval);
+
+private:
+    /** Time of the last beat of the loop reference grid */
+    qint64 m_reference;
+    /** Estimated beat period in nanoseconds */
+    double m_period;
+    /** Time of the last onset received */
+    qint64 m_lastOnset;
+    /** Lock confidence */
+    double m_confidence;
+    /** Number of onsets matching the loop prediction since the last seed */
+    int m_hits;
+    /** Number of recent onsets out of the loop tolerance */
+    int m_misses;
+
+    double m_phaseGain;
+    double m_periodGain;
+};
+
+/** @} */
+
+#endif
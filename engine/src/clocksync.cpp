@@ -0,0 +1,285 @@
+/*
+  Q Light Controller Plus
+  clocksync.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QtMath>
+
+#include "clocksync.h"
+
+/** Clock pulses per quarter note */
+#define CLOCK_PPQN              24
+/** Shortest accepted pulse period (300 BPM) */
+#define MIN_PULSE_PERIOD        (60000000000.0 / (300 * CLOCK_PPQN))
+/** Longest accepted pulse period (30 BPM) */
+#define MAX_PULSE_PERIOD        (60000000000.0 / (30 * CLOCK_PPQN))
+/** Bandwidth of the clock loop in Hz */
+#define CLOCK_BANDWIDTH         1.0
+/** Maximum pulse distance from the prediction, as a fraction of period */
+#define CLOCK_TOLERANCE         0.5
+/** Matching pulses required before the loop is considered locked */
+#define CLOCK_LOCK_PULSES       CLOCK_PPQN
+/** Number of missing pulses after which the clock is considered gone */
+#define CLOCK_TIMEOUT_PULSES    12
+
+/** Position correction gain of the timecode tracker */
+#define TIMECODE_ALPHA          0.25
+/** Speed correction gain of the timecode tracker */
+#define TIMECODE_BETA           0.02
+/** Position error in ms above which the tracker relocks (e.g. a locate) */
+#define TIMECODE_JUMP           100.0
+/** Time in ns without timecode after which it is considered stopped */
+#define TIMECODE_TIMEOUT        200000000LL
+/** Consistent updates required before the tracker is considered locked */
+#define TIMECODE_LOCK_UPDATES   8
+
+ClockSync::ClockSync()
+{
+    reset();
+}
+
+ClockSync::~ClockSync()
+{
+}
+
+qint64 ClockSync::now()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+void ClockSync::reset()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_lastPulse = -1;
+    m_pulseTime = 0;
+    m_nextPulse = 0;
+    m_pulsePeriod = 0;
+    m_clockHits = 0;
+    m_pulseCount = 0;
+    m_songPulses = 0;
+    m_clockRunning = false;
+
+    m_lastTimecode = -1;
+    m_tcPosition = 0;
+    m_tcRate = 1.0;
+    m_tcUpdates = 0;
+}
+
+/*********************************************************************
+ * Clock
+ *********************************************************************/
+
+void ClockSync::seedClock(qint64 timestamp, qint64 interval)
+{
+    m_pulsePeriod = (interval >= MIN_PULSE_PERIOD && interval <= MAX_PULSE_PERIOD) ? interval : 0;
+    m_pulseTime = timestamp;
+    m_nextPulse = double(timestamp) + m_pulsePeriod;
+    m_clockHits = 0;
+}
+
+qint64 ClockSync::clockPulse(qint64 timestamp)
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 interval = m_lastPulse < 0 ? 0 : timestamp - m_lastPulse;
+    if (m_lastPulse >= 0 && interval <= 0)
+        return -1;
+
+    if (m_lastPulse < 0 || (m_pulsePeriod > 0 && interval > CLOCK_TIMEOUT_PULSES * m_pulsePeriod))
+    {
+        // first pulse, or the clock came back after a dropout:
+        // the period is measured on the next pulse
+        seedClock(timestamp, 0);
+    }
+    else if (m_pulsePeriod == 0)
+    {
+        seedClock(timestamp, interval);
+    }
+    else
+    {
+        double error = double(timestamp) - m_nextPulse;
+
+        if (qAbs(error) > CLOCK_TOLERANCE * m_pulsePeriod)
+        {
+            // tempo jump: start over from the last interval
+            seedClock(timestamp, interval);
+        }
+        else
+        {
+            // second order delay-locked loop, with a bandwidth
+            // normalized on the current pulse period
+            double omega = 2.0 * M_PI * CLOCK_BANDWIDTH * m_pulsePeriod / 1000000000.0;
+
+            m_pulseTime = m_nextPulse;
+            m_nextPulse += M_SQRT2 * omega * error + m_pulsePeriod;
+            m_pulsePeriod = qBound(MIN_PULSE_PERIOD, m_pulsePeriod + omega * omega * error, MAX_PULSE_PERIOD);
+            m_clockHits++;
+        }
+    }
+
+    m_lastPulse = timestamp;
+
+    if (m_clockRunning)
+        m_songPulses++;
+
+    return (m_pulseCount++ % CLOCK_PPQN) == 0 ? qint64(m_pulseTime) : -1;
+}
+
+void ClockSync::clockStart(qint64 timestamp)
+{
+    Q_UNUSED(timestamp)
+    QMutexLocker locker(&m_mutex);
+
+    m_pulseCount = 0;
+    m_songPulses = 0;
+    m_clockRunning = true;
+}
+
+void ClockSync::clockContinue(qint64 timestamp)
+{
+    Q_UNUSED(timestamp)
+    QMutexLocker locker(&m_mutex);
+
+    // realign the beats to the song position
+    m_pulseCount = m_songPulses;
+    m_clockRunning = true;
+}
+
+void ClockSync::clockStop(qint64 timestamp)
+{
+    Q_UNUSED(timestamp)
+    QMutexLocker locker(&m_mutex);
+
+    m_clockRunning = false;
+}
+
+bool ClockSync::isClockLocked(qint64 now) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pulsePeriod == 0 || m_clockHits < CLOCK_LOCK_PULSES)
+        return false;
+
+    return (now - m_lastPulse) < CLOCK_TIMEOUT_PULSES * m_pulsePeriod;
+}
+
+bool ClockSync::isClockRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_clockRunning;
+}
+
+double ClockSync::clockBpm() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pulsePeriod == 0)
+        return 0;
+
+    return 60000000000.0 / (m_pulsePeriod * CLOCK_PPQN);
+}
+
+double ClockSync::clockPosition(qint64 now) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_songPulses == 0)
+        return 0;
+
+    if (m_clockRunning == false || m_pulsePeriod == 0)
+        return double(m_songPulses) / CLOCK_PPQN;
+
+    // interpolate between pulses, without going past the next one
+    double fraction = qBound(0.0, (double(now) - m_pulseTime) / m_pulsePeriod, 1.0);
+
+    return (double(m_songPulses - 1) + fraction) / CLOCK_PPQN;
+}
+
+/*********************************************************************
+ * Timecode
+ *********************************************************************/
+
+void ClockSync::relockTimecode(qint64 position)
+{
+    m_tcPosition = position;
+    m_tcRate = 1.0;
+    m_tcUpdates = 0;
+}
+
+void ClockSync::timecode(qint64 position, qint64 timestamp)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_lastTimecode >= 0 && timestamp <= m_lastTimecode)
+        return;
+
+    if (m_lastTimecode < 0 || timestamp - m_lastTimecode > TIMECODE_TIMEOUT)
+    {
+        relockTimecode(position);
+    }
+    else
+    {
+        double dt = double(timestamp - m_lastTimecode) / 1000000.0;
+        double predicted = m_tcPosition + m_tcRate * dt;
+        double error = double(position) - predicted;
+
+        if (qAbs(error) > TIMECODE_JUMP)
+        {
+            relockTimecode(position);
+        }
+        else
+        {
+            m_tcPosition = predicted + TIMECODE_ALPHA * error;
+            m_tcRate = qBound(0.5, m_tcRate + TIMECODE_BETA * error / dt, 2.0);
+            m_tcUpdates++;
+        }
+    }
+
+    m_lastTimecode = timestamp;
+}
+
+bool ClockSync::isTimecodeLocked(qint64 now) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_lastTimecode < 0 || m_tcUpdates < TIMECODE_LOCK_UPDATES)
+        return false;
+
+    return (now - m_lastTimecode) < TIMECODE_TIMEOUT;
+}
+
+qint64 ClockSync::timecodePosition(qint64 now) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_lastTimecode < 0)
+        return -1;
+
+    if (m_tcUpdates < TIMECODE_LOCK_UPDATES || (now - m_lastTimecode) >= TIMECODE_TIMEOUT)
+        return qRound64(m_tcPosition);
+
+    return qRound64(m_tcPosition + m_tcRate * double(now - m_lastTimecode) / 1000000.0);
+}
+
+double ClockSync::timecodeRate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_tcRate;
+}
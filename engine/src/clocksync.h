@@ -0,0 +1,148 @@
+/*
+  Q Light Controller Plus
+  clocksync.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <QMutex>
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/**
+ * ClockSync follows the external clock and timecode sources received by
+ * input plugins (e.g. MIDI beat clock and MIDI Time Code).
+ *
+ * Clock pulses (24 per quarter note) are filtered by a second order
+ * delay-locked loop, which removes the transport and scheduling jitter
+ * of the single pulses and gives a stable tempo and beat phase.
+ *
+ * Timecode positions are filtered by an alpha-beta tracker, so that the
+ * position can be extrapolated between the quarter frames with a
+ * resolution much finer than a MasterTimer tick.
+ *
+ * All the timestamps are in nanoseconds on the clock returned by now().
+ * The class is thread safe: plugins feed it from the main thread, while
+ * functions read it from the MasterTimer thread.
+ */
+class ClockSync final
+{
+public:
+    ClockSync();
+    ~ClockSync();
+
+    /** Return the current time in nanoseconds of the monotonic clock
+     *  used by the plugins to timestamp clock and timecode events */
+    static qint64 now();
+
+    /** Forget any clock and timecode information */
+    void reset();
+
+    /*********************************************************************
+     * Clock
+     *********************************************************************/
+public:
+    /**
+     * Feed a clock pulse received at $timestamp into the loop
+     *
+     * @return the filtered time of the beat, if the pulse is the
+     *         first one of a quarter note, otherwise -1
+     */
+    qint64 clockPulse(qint64 timestamp);
+
+    /** Transport start: the next pulse is the first one of the song */
+    void clockStart(qint64 timestamp);
+
+    /** Transport continue: the song position resumes from where it stopped */
+    void clockContinue(qint64 timestamp);
+
+    /** Transport stop: the song position is frozen, pulses keep the tempo */
+    void clockStop(qint64 timestamp);
+
+    /** Return true if the loop is locked on the incoming pulses */
+    bool isClockLocked(qint64 now) const;
+
+    /** Return true if the clock transport is running */
+    bool isClockRunning() const;
+
+    /** Return the filtered tempo in beats per minute, or 0 if unknown */
+    double clockBpm() const;
+
+    /** Return the song position in quarter notes since the last start */
+    double clockPosition(qint64 now) const;
+
+private:
+    /** Seed the loop with the period measured between two pulses */
+    void seedClock(qint64 timestamp, qint64 interval);
+
+private:
+    /** Time of the last pulse received */
+    qint64 m_lastPulse;
+    /** Filtered time of the last pulse and prediction of the next one */
+    double m_pulseTime;
+    double m_nextPulse;
+    /** Filtered pulse period in nanoseconds */
+    double m_pulsePeriod;
+    /** Number of pulses matching the loop prediction since the last seed */
+    int m_clockHits;
+    /** Pulses since the last start, used for the beat boundaries */
+    qint64 m_pulseCount;
+    /** Pulses received while the transport was running */
+    qint64 m_songPulses;
+    bool m_clockRunning;
+
+    /*********************************************************************
+     * Timecode
+     *********************************************************************/
+public:
+    /** Feed a timecode $position in milliseconds received at $timestamp */
+    void timecode(qint64 position, qint64 timestamp);
+
+    /** Return true if the timecode is running and the tracker is locked */
+    bool isTimecodeLocked(qint64 now) const;
+
+    /** Return the timecode position in milliseconds at $now, or -1 if unknown.
+     *  A locked timecode is extrapolated, otherwise the last position is held */
+    qint64 timecodePosition(qint64 now) const;
+
+    /** Return the timecode speed estimated against the local clock */
+    double timecodeRate() const;
+
+private:
+    /** Restart the tracker from $position */
+    void relockTimecode(qint64 position);
+
+private:
+    /** Time of the last timecode received */
+    qint64 m_lastTimecode;
+    /** Filtered position in milliseconds at m_lastTimecode */
+    double m_tcPosition;
+    /** Filtered position speed (1.0 = real time) */
+    double m_tcRate;
+    /** Number of consistent updates since the last relock */
+    int m_tcUpdates;
+
+private:
+    mutable QMutex m_mutex;
+};
+
+/** @} */
+
+#endif
@@ -34,6 +34,7 @@
 #include "qlcfixturedef.h"
 
 #include "monitorproperties.h"
+#include "audiopreloadcache.h"
 #include "audioplugincache.h"
 #include "rgbscriptscache.h"
 #include "channelsgroup.h"
@@ -64,6 +65,7 @@ Doc::Doc(QObject* parent, int universes)
     , m_rgbScriptsCache(new RGBScriptsCache(this))
     , m_ioPluginCache(new IOPluginCache(this))
     , m_audioPluginCache(new AudioPluginCache(this))
+    , m_audioPreloadCache(new AudioPreloadCache(this))
     , m_masterTimer(new MasterTimer(this))
     , m_ioMap(new InputOutputMap(this, universes))
     , m_monitorProps(NULL)
@@ -262,6 +264,11 @@ AudioPluginCache *Doc::audioPluginCache() const
     return m_audioPluginCache;
 }
 
+AudioPreloadCache *Doc::audioPreloadCache() const
+{
+    return m_audioPreloadCache;
+}
+
 InputOutputMap* Doc::inputOutputMap() const
 {
     return m_ioMap;
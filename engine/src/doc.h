@@ -42,6 +42,7 @@
 class AudioCapture;
 class RGBScriptsCache;
 class AudioPluginCache;
+class AudioPreloadCache;
 class MonitorProperties;
 
 /** @addtogroup engine Engine
@@ -141,6 +142,9 @@ public:
     /** Get the audio decoder plugin cache object */
     AudioPluginCache *audioPluginCache() const;
 
+    /** Get the cache of audio sources decoded in memory */
+    AudioPreloadCache *audioPreloadCache() const;
+
     /** Get the DMX output map object */
     InputOutputMap *inputOutputMap() const;
 
@@ -159,6 +163,7 @@ private:
     RGBScriptsCache *m_rgbScriptsCache;
     IOPluginCache *m_ioPluginCache;
     AudioPluginCache *m_audioPluginCache;
+    AudioPreloadCache *m_audioPreloadCache;
     MasterTimer *m_masterTimer;
     InputOutputMap *m_ioMap;
     mutable QSharedPointer<AudioCapture> m_inputCapture;
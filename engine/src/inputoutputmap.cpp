@@ -34,10 +34,12 @@
 #include "qlcinputchannel.h"
 #include "qlcinputsource.h"
 #include "audiocapture.h"
+#include "latencyprobe.h"
 #include "qlcioplugin.h"
 #include "outputpatch.h"
 #include "inputpatch.h"
 #include "qlcconfig.h"
+#include "clocksync.h"
 #include "universe.h"
 #include "qlcfile.h"
 #include "doc.h"
@@ -50,21 +52,35 @@ InputOutputMap::InputOutputMap(const Doc *doc, quint32 universes)
     , m_localProfilesLoaded(false)
     , m_currentBPM(0)
     , m_beatTime(new QElapsedTimer())
+    , m_clockSync(new ClockSync())
 {
     m_grandMaster = new GrandMaster(this);
+    m_latencyProbe = new LatencyProbe(this);
     for (quint32 i = 0; i < universes; i++)
         addUniverse();
 
     connect(doc->ioPluginCache(), SIGNAL(pluginConfigurationChanged(QLCIOPlugin*)),
             this, SLOT(slotPluginConfigurationChanged(QLCIOPlugin*)));
     connect(doc->masterTimer(), SIGNAL(beat()), this, SLOT(slotMasterTimerBeat()));
+    connect(doc->masterTimer(), SIGNAL(tickReady()), this, SLOT(slotMasterTimerTickReady()),
+            Qt::DirectConnection);
+
+    QSettings settings;
+    QVariant var = settings.value(SETTINGS_FEEDBACK_INTERVAL);
+    m_feedbackInterval = var.isValid() ? var.toInt() : DEFAULT_FEEDBACK_INTERVAL;
+
+    m_feedbackTimer.setSingleShot(true);
+    m_feedbackTimer.setInterval(m_feedbackInterval);
+    connect(&m_feedbackTimer, SIGNAL(timeout()), this, SLOT(slotFlushFeedback()));
 }
 
 InputOutputMap::~InputOutputMap()
 {
+    delete m_latencyProbe;
     removeAllUniverses();
     delete m_grandMaster;
     delete m_beatTime;
+    delete m_clockSync;
     qDeleteAll(m_profiles);
 }
 
@@ -155,15 +171,15 @@ bool InputOutputMap::addUniverse(quint32 id)
             while (id > universesCount())
             {
                 uni = new Universe(universesCount(), m_grandMaster);
-                connect(m_doc->masterTimer(), SIGNAL(tickReady()), uni, SLOT(tick()), Qt::QueuedConnection);
                 connect(uni, SIGNAL(universeWritten(quint32,QByteArray)), this, SIGNAL(universeWritten(quint32,QByteArray)));
+                connect(uni, SIGNAL(frameProcessed(quint32,quint32)), this, SLOT(slotUniverseFrameProcessed(quint32,quint32)), Qt::DirectConnection);
                 m_universeArray.append(uni);
             }
         }
 
         uni = new Universe(id, m_grandMaster);
-        connect(m_doc->masterTimer(), SIGNAL(tickReady()), uni, SLOT(tick()), Qt::QueuedConnection);
         connect(uni, SIGNAL(universeWritten(quint32,QByteArray)), this, SIGNAL(universeWritten(quint32,QByteArray)));
+        connect(uni, SIGNAL(frameProcessed(quint32,quint32)), this, SLOT(slotUniverseFrameProcessed(quint32,quint32)), Qt::DirectConnection);
         m_universeArray.append(uni);
     }
 
@@ -318,6 +334,83 @@ void InputOutputMap::resetUniverses()
     m_localProfilesLoaded = false;
 }
 
+/*********************************************************************
+ * Frame completion
+ *********************************************************************/
+
+void InputOutputMap::slotMasterTimerTickReady()
+{
+    QMutexLocker locker(&m_universeMutex);
+
+    // hold the barrier while ticking, so that a universe thread
+    // can't report its frame before it has been registered
+    QMutexLocker frameLocker(&m_frameMutex);
+
+    // a universe that didn't complete the previous tick is simply
+    // dropped from the barrier: its late frame won't match the new
+    // serial and a stopped thread can't block the following ticks
+    m_pendingFrames.clear();
+
+    foreach (Universe *universe, m_universeArray)
+    {
+        quint32 frame = universe->tick();
+        if (universe->isRunning())
+            m_pendingFrames[universe->id()] = frame;
+    }
+}
+
+void InputOutputMap::slotUniverseFrameProcessed(quint32 universe, quint32 frame)
+{
+    {
+        QMutexLocker locker(&m_frameMutex);
+        QHash<quint32, quint32>::iterator it = m_pendingFrames.find(universe);
+
+        // ignore frames of a previous tick
+        if (it == m_pendingFrames.end() || it.value() != frame)
+            return;
+
+        m_pendingFrames.erase(it);
+
+        // the last universe completing the tick flushes the plugin outputs
+        if (m_pendingFrames.isEmpty() == false)
+            return;
+    }
+
+    foreach (QLCIOPlugin *plugin, m_doc->ioPluginCache()->plugins())
+        plugin->flushOutputs();
+}
+
+/*********************************************************************
+ * Latency probe
+ *********************************************************************/
+
+bool InputOutputMap::startLatencyProbe(quint32 inputUniverse, quint32 inputChannel,
+                                       quint32 outputUniverse, quint32 outputChannel,
+                                       int samples, int interval)
+{
+    QMutexLocker locker(&m_universeMutex);
+
+    if (inputUniverse >= quint32(m_universeArray.count()) ||
+        outputUniverse >= quint32(m_universeArray.count()))
+        return false;
+
+    InputPatch *ip = m_universeArray.at(inputUniverse)->inputPatch();
+    if (ip == NULL)
+        return false;
+
+    Universe *universe = m_universeArray.at(outputUniverse);
+    QList<OutputPatch *> patches;
+    for (int i = 0; i < universe->outputPatchesCount(); i++)
+        patches.append(universe->outputPatch(i));
+
+    return m_latencyProbe->start(ip, inputChannel, patches, outputChannel, samples, interval);
+}
+
+LatencyProbe *InputOutputMap::latencyProbe() const
+{
+    return m_latencyProbe;
+}
+
 /*********************************************************************
  * Grand Master
  *********************************************************************/
@@ -411,10 +504,14 @@ bool InputOutputMap::setInputPatch(quint32 universe, const QString &pluginName,
         currProfile = currInPatch->profile();
         disconnect(currInPatch, SIGNAL(inputValueChanged(quint32,quint32,uchar,const QString&)),
                 this, SIGNAL(inputValueChanged(quint32,quint32,uchar,const QString&)));
+        disconnect(currInPatch, SIGNAL(timecodeChanged(quint32,qint64,qint64)),
+                   this, SLOT(slotPluginTimecode(quint32,qint64,qint64)));
         if (currInPatch->plugin()->capabilities() & QLCIOPlugin::Beats)
         {
             disconnect(currInPatch, SIGNAL(inputValueChanged(quint32,quint32,uchar,const QString&)),
                        this, SLOT(slotPluginBeat(quint32,quint32,uchar,const QString&)));
+            disconnect(currInPatch, SIGNAL(clockEvent(quint32,int,qint64)),
+                       this, SLOT(slotPluginClock(quint32,int,qint64)));
         }
     }
     InputPatch *ip = NULL;
@@ -444,10 +541,14 @@ bool InputOutputMap::setInputPatch(quint32 universe, const QString &pluginName,
         {
             connect(ip, SIGNAL(inputValueChanged(quint32,quint32,uchar,const QString&)),
                     this, SIGNAL(inputValueChanged(quint32,quint32,uchar,const QString&)));
+            connect(ip, SIGNAL(timecodeChanged(quint32,qint64,qint64)),
+                    this, SLOT(slotPluginTimecode(quint32,qint64,qint64)));
             if (ip->plugin()->capabilities() & QLCIOPlugin::Beats)
             {
                 connect(ip, SIGNAL(inputValueChanged(quint32,quint32,uchar,const QString&)),
                         this, SLOT(slotPluginBeat(quint32,quint32,uchar,const QString&)));
+                connect(ip, SIGNAL(clockEvent(quint32,int,qint64)),
+                        this, SLOT(slotPluginClock(quint32,int,qint64)));
             }
         }
     }
@@ -759,14 +860,104 @@ bool InputOutputMap::sendFeedBack(quint32 universe, quint32 channel, uchar value
 
     OutputPatch* patch = m_universeArray.at(universe)->feedbackPatch();
 
-    if (patch != NULL && patch->isPatched())
+    if (patch == NULL || patch->isPatched() == false)
+        return false;
+
+    if (m_feedbackInterval <= 0)
     {
         patch->plugin()->sendFeedBack(universe, patch->output(), channel, value, params);
         return true;
     }
+
+    QMutexLocker locker(&m_feedbackMutex);
+    quint64 key = (quint64(universe) << 32) | channel;
+    bool wasEmpty = m_pendingFeedback.isEmpty();
+
+    QHash<quint64, PendingFeedback>::iterator it = m_pendingFeedback.find(key);
+    if (it == m_pendingFeedback.end())
+    {
+        PendingFeedback fb;
+        fb.value = value;
+        fb.params = params;
+        m_pendingFeedback.insert(key, fb);
+        m_pendingFeedbackOrder.append(key);
+    }
     else
     {
-        return false;
+        // the same value is already waiting to be delivered
+        if (it.value().value == value && it.value().params == params)
+            return false;
+
+        it.value().value = value;
+        it.value().params = params;
+    }
+
+    // the first value of a burst arms the timer, the others just get coalesced
+    if (wasEmpty)
+        QMetaObject::invokeMethod(&m_feedbackTimer, "start", Qt::AutoConnection);
+
+    return true;
+}
+
+int InputOutputMap::feedbackInterval() const
+{
+    return m_feedbackInterval;
+}
+
+void InputOutputMap::setFeedbackInterval(int ms)
+{
+    m_feedbackInterval = ms;
+
+    QSettings settings;
+    if (ms == DEFAULT_FEEDBACK_INTERVAL)
+        settings.remove(SETTINGS_FEEDBACK_INTERVAL);
+    else
+        settings.setValue(SETTINGS_FEEDBACK_INTERVAL, ms);
+
+    m_feedbackTimer.setInterval(qMax(0, ms));
+
+    // deliver what's left straight away
+    if (ms <= 0)
+        slotFlushFeedback();
+}
+
+void InputOutputMap::slotFlushFeedback()
+{
+    QHash<quint64, PendingFeedback> pending;
+    QList<quint64> order;
+
+    {
+        QMutexLocker locker(&m_feedbackMutex);
+        pending.swap(m_pendingFeedback);
+        order.swap(m_pendingFeedbackOrder);
+    }
+
+    if (order.isEmpty())
+        return;
+
+    // group the values per universe, so each feedback line gets a single batch
+    QMap<quint32, QList<QLCFeedbackValue> > batches;
+
+    foreach (quint64 key, order)
+    {
+        const PendingFeedback &fb = pending[key];
+        QLCFeedbackValue value;
+        value.channel = quint32(key & 0xFFFFFFFF);
+        value.value = fb.value;
+        value.params = fb.params;
+        batches[quint32(key >> 32)].append(value);
+    }
+
+    QMapIterator<quint32, QList<QLCFeedbackValue> > it(batches);
+    while (it.hasNext())
+    {
+        it.next();
+        if (it.key() >= universesCount())
+            continue;
+
+        OutputPatch* patch = m_universeArray.at(it.key())->feedbackPatch();
+        if (patch != NULL && patch->isPatched())
+            patch->plugin()->sendFeedBackBatch(it.key(), patch->output(), it.value());
     }
 }
 
@@ -1038,6 +1229,7 @@ void InputOutputMap::setBeatGeneratorType(InputOutputMap::BeatGeneratorType type
             // reset the current BPM number and detect it from the MIDI beats
             setBpmNumber(0);
             m_beatTime->restart();
+            m_clockSync->reset();
         }
         break;
         case Audio:
@@ -1112,6 +1304,11 @@ int InputOutputMap::bpmNumber() const
     return m_currentBPM;
 }
 
+ClockSync *InputOutputMap::clockSync() const
+{
+    return m_clockSync;
+}
+
 void InputOutputMap::slotProcessBeat()
 {
     // process the timer as first thing, to avoid wasting time
@@ -1119,24 +1316,41 @@ void InputOutputMap::slotProcessBeat()
     qint64 elapsed = m_beatTime->elapsed();
     m_beatTime->restart();
 
-    int bpm = qRound(60000.0 / (float)elapsed);
-    float currBpmTime = 60000.0 / (float)m_currentBPM;
-    // here we check if the difference between the current BPM duration
-    // and the current time elapsed is within a range of +/-1ms.
-    // If it isn't, then the BPM number has really changed, otherwise
-    // it's just a tiny time drift
-    if (qAbs((float)elapsed - currBpmTime) > 1)
-        setBpmNumber(bpm);
+    MasterTimer *timer = m_doc->masterTimer();
+    bool wasLocked = timer->isBeatPhaseLocked();
 
-    m_doc->masterTimer()->requestBeat();
-    emit beat();
+    timer->requestBeat();
+    bool isLocked = timer->isBeatPhaseLocked();
+
+    if (isLocked)
+    {
+        // the phase-locked loop filters the onsets jitter,
+        // so take the tempo from its estimation
+        setBpmNumber(qRound(timer->estimatedBpm()));
+    }
+    else
+    {
+        int bpm = qRound(60000.0 / (float)elapsed);
+        float currBpmTime = 60000.0 / (float)m_currentBPM;
+        // here we check if the difference between the current BPM duration
+        // and the current time elapsed is within a range of +/-1ms.
+        // If it isn't, then the BPM number has really changed, otherwise
+        // it's just a tiny time drift
+        if (qAbs((float)elapsed - currBpmTime) > 1)
+            setBpmNumber(bpm);
+    }
+
+    // when locked, beats are emitted by MasterTimer on the predicted time
+    if (wasLocked == false || isLocked == false)
+        emit beat();
 }
 
 void InputOutputMap::slotMasterTimerBeat()
 {
-    if (m_beatGeneratorType != Internal)
+    if (m_beatGeneratorType == Disabled)
         return;
 
+    // external beats are forwarded by MasterTimer only when phase locked
     emit beat();
 }
 
@@ -1148,11 +1362,63 @@ void InputOutputMap::slotPluginBeat(quint32 universe, quint32 channel, uchar val
     if (m_beatGeneratorType != Plugin || value == 0 || key != "beat")
         return;
 
+    // beats are already generated by the locked clock
+    if (m_clockSync->isClockLocked(ClockSync::now()))
+        return;
+
     qDebug() << "Plugin beat:" << channel << m_beatTime->elapsed();
 
     slotProcessBeat();
 }
 
+void InputOutputMap::slotPluginClock(quint32 universe, int event, qint64 timestamp)
+{
+    Q_UNUSED(universe)
+
+    if (m_beatGeneratorType != Plugin)
+        return;
+
+    switch (event)
+    {
+        case QLCIOPlugin::ClockStart:
+            m_clockSync->clockStart(timestamp);
+            return;
+        case QLCIOPlugin::ClockContinue:
+            m_clockSync->clockContinue(timestamp);
+            return;
+        case QLCIOPlugin::ClockStop:
+            m_clockSync->clockStop(timestamp);
+            return;
+        case QLCIOPlugin::ClockPulse:
+        default:
+        break;
+    }
+
+    qint64 beatTime = m_clockSync->clockPulse(timestamp);
+
+    // until the clock is locked, beats come from the plugin beat channel
+    if (beatTime < 0 || m_clockSync->isClockLocked(timestamp) == false)
+        return;
+
+    m_beatTime->restart();
+
+    MasterTimer *timer = m_doc->masterTimer();
+    bool wasLocked = timer->isBeatPhaseLocked();
+
+    timer->requestBeat(beatTime);
+    setBpmNumber(qRound(m_clockSync->clockBpm()));
+
+    if (wasLocked == false || timer->isBeatPhaseLocked() == false)
+        emit beat();
+}
+
+void InputOutputMap::slotPluginTimecode(quint32 universe, qint64 position, qint64 timestamp)
+{
+    Q_UNUSED(universe)
+
+    m_clockSync->timecode(position, timestamp);
+}
+
 /*********************************************************************
  * Defaults - !! FALLBACK !!
  *********************************************************************/
@@ -23,9 +23,12 @@
 #include <QSharedPointer>
 #include <QObject>
 #include <QMutex>
+#include <QTimer>
+#include <QHash>
 #include <QDir>
 
 #include "qlcinputprofile.h"
+#include "latencyprobe.h"
 #include "grandmaster.h"
 
 class QXmlStreamReader;
@@ -33,6 +36,8 @@ class QXmlStreamWriter;
 class QElapsedTimer;
 class QLCInputSource;
 class AudioCapture;
+class LatencyProbe;
+class ClockSync;
 class QLCIOPlugin;
 class OutputPatch;
 class InputPatch;
@@ -48,6 +53,11 @@ class Doc;
 #define KXMLIOBeatType          QStringLiteral("BeatType")
 #define KXMLIOBeatsPerMinute    QStringLiteral("BPM")
 
+#define SETTINGS_FEEDBACK_INTERVAL "inputmanager/feedbackinterval"
+
+/** Default interval in milliseconds between two feedback flushes */
+#define DEFAULT_FEEDBACK_INTERVAL  20
+
 class InputOutputMap final : public QObject
 {
     Q_OBJECT
@@ -277,6 +287,55 @@ private:
     /** Mutex guarding m_universeArray */
     QMutex m_universeMutex;
 
+    /*********************************************************************
+     * Frame completion
+     *********************************************************************/
+private slots:
+    /** Called in the MasterTimer thread when a new tick is ready.
+     *  Wakes up the universe threads and arms the frame barrier */
+    void slotMasterTimerTickReady();
+
+    /** Called in a universe thread when its tick has been processed */
+    void slotUniverseFrameProcessed(quint32 universe, quint32 frame);
+
+private:
+    /** Universe threads that still have to process the current tick,
+     *  with the frame serial they have to report. When it gets empty,
+     *  plugins are flushed */
+    QHash<quint32, quint32> m_pendingFrames;
+
+    /** Mutex guarding m_pendingFrames */
+    QMutex m_frameMutex;
+
+    /*********************************************************************
+     * Latency probe
+     *********************************************************************/
+public:
+    /**
+     * Start measuring the latency from an input channel of $inputUniverse
+     * to an output channel of $outputUniverse. The probe values are
+     * injected in the input patch and observed on all the output patches.
+     * The patches must not change while the probe is running.
+     * This is an internal diagnostic, not exposed in the UI.
+     *
+     * @param inputUniverse The universe with the input patch to probe
+     * @param inputChannel The input channel receiving the probe values
+     * @param outputUniverse The universe with the output patches to observe
+     * @param outputChannel The output channel following the input channel
+     * @param samples The number of samples to take
+     * @param interval The time between two probe values, in milliseconds
+     * @return true if the probe has been started
+     */
+    bool startLatencyProbe(quint32 inputUniverse, quint32 inputChannel,
+                           quint32 outputUniverse, quint32 outputChannel,
+                           int samples, int interval = DEFAULT_PROBE_INTERVAL);
+
+    /** Get the probe, to stop it or read its report */
+    LatencyProbe *latencyProbe() const;
+
+private:
+    LatencyProbe *m_latencyProbe;
+
     /*********************************************************************
      * Grand Master
      *********************************************************************/
@@ -501,9 +560,42 @@ public:
     /**
      * Send feedback value to the input profile e.g. to move a motorized
      * sliders & knobs, set indicator leds etc.
+     * Values are queued and coalesced per universe/channel, keeping only
+     * the latest one, then delivered in batches every feedback interval.
+     *
+     * @return true if the value has been sent or queued, false if the
+     *         universe has no feedback line or the same value is already
+     *         waiting to be delivered
      */
     bool sendFeedBack(quint32 universe, quint32 channel, uchar value, const QVariant &params);
 
+    /** Get/Set the interval in milliseconds between two feedback flushes.
+     *  0 delivers feedback values immediately, without coalescing.
+     *  The interval is stored in the application settings */
+    int feedbackInterval() const;
+    void setFeedbackInterval(int ms);
+
+private slots:
+    /** Deliver the queued feedback values to the plugins */
+    void slotFlushFeedback();
+
+private:
+    typedef struct
+    {
+        uchar value;
+        QVariant params;
+    } PendingFeedback;
+
+    int m_feedbackInterval;
+    QTimer m_feedbackTimer;
+
+    /** Mutex guarding the feedback queue */
+    QMutex m_feedbackMutex;
+    /** Latest feedback value of each universe/channel pair */
+    QHash<quint64, PendingFeedback> m_pendingFeedback;
+    /** Pending universe/channel pairs, in the order they were first queued */
+    QList<quint64> m_pendingFeedbackOrder;
+
 private:
     /** In case of duplicate strings, append a number to make them unique */
     void removeDuplicates(QStringList &list);
@@ -598,9 +690,14 @@ public:
     void setBpmNumber(int bpm);
     int bpmNumber() const;
 
+    /** Return the tracker of the external clock and timecode received by plugins */
+    ClockSync *clockSync() const;
+
 protected slots:
     void slotMasterTimerBeat();
     void slotPluginBeat(quint32 universe, quint32 channel, uchar value, const QString &key);
+    void slotPluginClock(quint32 universe, int event, qint64 timestamp);
+    void slotPluginTimecode(quint32 universe, qint64 position, qint64 timestamp);
     void slotProcessBeat();
 
 signals:
@@ -613,6 +710,7 @@ private:
     int m_currentBPM;
     QElapsedTimer *m_beatTime;
     AudioCapture *m_inputCapture;
+    ClockSync *m_clockSync;
 
     /*********************************************************************
      * Defaults
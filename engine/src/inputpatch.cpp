@@ -24,6 +24,7 @@
 #endif
 
 #include <QDebug>
+#include <QtAlgorithms>
 
 #include "qlcinputchannel.h"
 #include "qlcioplugin.h"
@@ -81,6 +82,12 @@ bool InputPatch::set(QLCIOPlugin* plugin, quint32 input, QLCInputProfile* profil
     {
         disconnect(m_plugin, SIGNAL(valueChanged(quint32,quint32,quint32,uchar,QString)),
                    this, SLOT(slotValueChanged(quint32,quint32,quint32,uchar,QString)));
+        disconnect(m_plugin, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)),
+                   this, SLOT(slotUniverseDataChanged(quint32,quint32,QByteArray)));
+        disconnect(m_plugin, SIGNAL(clockEventReceived(quint32,quint32,int,qint64)),
+                   this, SLOT(slotClockEventReceived(quint32,quint32,int,qint64)));
+        disconnect(m_plugin, SIGNAL(timecodeReceived(quint32,quint32,qint64,qint64)),
+                   this, SLOT(slotTimecodeReceived(quint32,quint32,qint64,qint64)));
         m_plugin->closeInput(m_pluginLine, m_universe);
     }
 
@@ -102,6 +109,13 @@ bool InputPatch::set(QLCIOPlugin* plugin, quint32 input, QLCInputProfile* profil
     {
         connect(m_plugin, SIGNAL(valueChanged(quint32,quint32,quint32,uchar,QString)),
                 this, SLOT(slotValueChanged(quint32,quint32,quint32,uchar,QString)));
+        connect(m_plugin, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)),
+                this, SLOT(slotUniverseDataChanged(quint32,quint32,QByteArray)),
+                Qt::DirectConnection);
+        connect(m_plugin, SIGNAL(clockEventReceived(quint32,quint32,int,qint64)),
+                this, SLOT(slotClockEventReceived(quint32,quint32,int,qint64)));
+        connect(m_plugin, SIGNAL(timecodeReceived(quint32,quint32,qint64,qint64)),
+                this, SLOT(slotTimecodeReceived(quint32,quint32,qint64,qint64)));
         result = m_plugin->openInput(m_pluginLine, m_universe);
 
         if (m_profile != NULL)
@@ -220,6 +234,12 @@ void InputPatch::slotValueChanged(quint32 universe, quint32 input, quint32 chann
     {
         if (universe == UINT_MAX || universe == m_universe)
         {
+            if (channel < INPUT_BUFFER_SIZE && key.isEmpty())
+            {
+                bufferValue(channel, value, false);
+                return;
+            }
+
             QMutexLocker inputBufferLocker(&m_inputBufferMutex);
             InputValue val(value, key);
             if (m_inputBuffer.contains(channel))
@@ -243,6 +263,55 @@ void InputPatch::slotValueChanged(quint32 universe, quint32 input, quint32 chann
     }
 }
 
+void InputPatch::slotUniverseDataChanged(quint32 universe, quint32 input, const QByteArray &data)
+{
+    if (input != m_pluginLine || (universe != UINT_MAX && universe != m_universe))
+        return;
+
+    const uchar *values = reinterpret_cast<const uchar *>(data.constData());
+    int length = qMin(data.size(), INPUT_BUFFER_SIZE);
+
+    for (int i = 0; i < length; i++)
+        bufferValue(quint32(i), values[i], true);
+}
+
+void InputPatch::slotClockEventReceived(quint32 universe, quint32 input, int event, qint64 timestamp)
+{
+    if (input != m_pluginLine || (universe != UINT_MAX && universe != m_universe))
+        return;
+
+    emit clockEvent(m_universe, event, timestamp);
+}
+
+void InputPatch::slotTimecodeReceived(quint32 universe, quint32 input, qint64 position, qint64 timestamp)
+{
+    if (input != m_pluginLine || (universe != UINT_MAX && universe != m_universe))
+        return;
+
+    emit timecodeChanged(m_universe, position, timestamp);
+}
+
+void InputPatch::bufferValue(quint32 channel, uchar value, bool changedOnly)
+{
+    QAtomicInt &slot = m_inputValues[channel];
+
+    if (changedOnly && slot.loadAcquire() == value)
+        return;
+
+    int prevValue = slot.fetchAndStoreOrdered(value);
+    int bit = 1 << (channel & 31);
+    int prevWord = m_inputDirty[channel >> 5].fetchAndOrRelease(bit);
+
+    // Every ON/OFF changes must pass through
+    if ((prevWord & bit) && prevValue != value && (prevValue == 0 || value == 0))
+        emit inputValueChanged(m_universe, channel, uchar(prevValue));
+}
+
+void InputPatch::injectValue(quint32 channel, uchar value)
+{
+    slotValueChanged(m_universe, m_pluginLine, channel, value);
+}
+
 void InputPatch::setProfilePageControls()
 {
     if (m_profile != NULL)
@@ -282,6 +351,18 @@ void InputPatch::flush(quint32 universe)
 {
     if (universe == UINT_MAX || universe == m_universe)
     {
+        for (int w = 0; w < INPUT_BUFFER_SIZE / 32; w++)
+        {
+            quint32 word = quint32(m_inputDirty[w].fetchAndStoreAcquire(0));
+
+            while (word)
+            {
+                quint32 channel = w * 32 + qCountTrailingZeroBits(word);
+                emit inputValueChanged(m_universe, channel, uchar(m_inputValues[channel].loadAcquire()));
+                word &= word - 1;
+            }
+        }
+
         QMutexLocker inputBufferLocker(&m_inputBufferMutex);
         for (QHash<quint32, InputValue>::const_iterator it = m_inputBuffer.begin(); it != m_inputBuffer.end(); ++it)
         {
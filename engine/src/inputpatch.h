@@ -20,6 +20,8 @@
 #ifndef INPUTPATCH_H
 #define INPUTPATCH_H
 
+#include <QByteArray>
+#include <QAtomicInt>
 #include <QObject>
 #include <QMap>
 #include <QMutex>
@@ -41,6 +43,9 @@ class QLCIOPlugin;
 #define KXMLQLCInputPatchInput         QStringLiteral("Input")
 #define KXMLQLCInputPatch              QStringLiteral("Patch")
 
+/** Number of channels buffered in the dense, lock-free input buffer */
+#define INPUT_BUFFER_SIZE  512
+
 /**
  * An InputPatch represents one input universe. One input universe can have
  * exactly one input line from exactly one input plugin (or none at all)
@@ -127,6 +132,12 @@ signals:
     void inputValueChanged(quint32 inputUniverse, quint32 channel,
                            uchar value, const QString& key = 0);
 
+    /** An external clock event (QLCIOPlugin::ClockEvent) received at $timestamp */
+    void clockEvent(quint32 inputUniverse, int event, qint64 timestamp);
+
+    /** An external timecode $position in ms received at $timestamp */
+    void timecodeChanged(quint32 inputUniverse, qint64 position, qint64 timestamp);
+
     void inputNameChanged();
     void pluginNameChanged();
     void profileNameChanged();
@@ -135,6 +146,14 @@ private slots:
     void slotValueChanged(quint32 universe, quint32 input,
                           quint32 channel, uchar value, const QString& key = 0);
 
+    /** Receive a whole frame of values from the plugin. This is invoked
+     *  directly in the plugin thread, and only marks the channels
+     *  different from the last known values to be emitted by the next flush */
+    void slotUniverseDataChanged(quint32 universe, quint32 input, const QByteArray& data);
+
+    void slotClockEventReceived(quint32 universe, quint32 input, int event, qint64 timestamp);
+    void slotTimecodeReceived(quint32 universe, quint32 input, qint64 position, qint64 timestamp);
+
 private:
     /** The reference of the plugin associated by this Input patch */
     QLCIOPlugin* m_plugin;
@@ -157,6 +176,17 @@ private:
 public:
     void flush(quint32 universe);
 
+    /** Inject a value as if it was received by the patched plugin line.
+     *  Used by LatencyProbe to measure the input to output latency */
+    void injectValue(quint32 channel, uchar value);
+
+private:
+    /** Store a value in the dense buffer. Lock free, can be called
+     *  from any thread. When $changedOnly is true, a value equal to
+     *  the last known one is not marked for emission */
+    void bufferValue(quint32 channel, uchar value, bool changedOnly);
+
+public:
     struct InputValue
     {
         InputValue() {}
@@ -168,8 +198,15 @@ public:
         QString key;
     };
 
+    /** Buffer of the channels beyond INPUT_BUFFER_SIZE or identified
+     *  by a key (OSC paths, MIDI notes...) */
     QMutex m_inputBufferMutex;
     QHash<quint32, InputValue> m_inputBuffer;
+
+    /** Last known value of the first INPUT_BUFFER_SIZE channels */
+    QAtomicInt m_inputValues[INPUT_BUFFER_SIZE];
+    /** One bit per channel of m_inputValues to be emitted by the next flush */
+    QAtomicInt m_inputDirty[INPUT_BUFFER_SIZE / 32];
 };
 
 /** @} */
@@ -0,0 +1,219 @@
+/*
+  Q Light Controller Plus
+  latencyprobe.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+
+#include "latencyprobe.h"
+#include "outputpatch.h"
+#include "inputpatch.h"
+
+/** Time after which a probe value not seen at the output is lost */
+#define PROBE_TIMEOUT_NS    Q_INT64_C(1000000000)
+/** Output values at or above this are the high probe value */
+#define PROBE_THRESHOLD     128
+
+LatencyProbe::LatencyProbe(QObject *parent)
+    : QObject(parent)
+    , m_inputChannel(0)
+    , m_outputChannel(0)
+    , m_requested(0)
+    , m_pendingTime(0)
+    , m_expectHigh(false)
+    , m_lost(0)
+{
+    m_clock.start();
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+}
+
+LatencyProbe::~LatencyProbe()
+{
+    stop();
+}
+
+bool LatencyProbe::start(InputPatch *input, quint32 inputChannel,
+                         QList<OutputPatch *> const& outputs, quint32 outputChannel,
+                         int samples, int interval)
+{
+    if (isRunning() || input == NULL || outputs.isEmpty() || samples <= 0)
+        return false;
+
+    m_input = input;
+    m_inputChannel = inputChannel;
+    m_outputChannel = outputChannel;
+    m_requested = samples;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_samples.clear();
+        m_samples.reserve(samples);
+        m_lost = 0;
+    }
+
+    foreach (OutputPatch *patch, outputs)
+    {
+        m_outputs.append(QPointer<OutputPatch>(patch));
+        patch->setLatencyProbe(this);
+    }
+
+    qDebug() << "[LatencyProbe] started on input channel" << inputChannel
+             << "output channel" << outputChannel << "samples:" << samples;
+
+    // bring the channel to a known state, the first sample is the high value
+    m_expectHigh = false;
+    m_input->injectValue(m_inputChannel, 0);
+
+    m_timer.start(qMax(1, interval));
+
+    return true;
+}
+
+void LatencyProbe::stop()
+{
+    if (isRunning() == false)
+        return;
+
+    m_timer.stop();
+
+    foreach (QPointer<OutputPatch> patch, m_outputs)
+    {
+        if (patch.isNull() == false)
+            patch->setLatencyProbe(NULL);
+    }
+    m_outputs.clear();
+    m_pendingTime.storeRelease(0);
+
+    // release the input channel
+    if (m_input.isNull() == false && m_expectHigh)
+        m_input->injectValue(m_inputChannel, 0);
+    m_input.clear();
+}
+
+bool LatencyProbe::isRunning() const
+{
+    return m_timer.isActive();
+}
+
+LatencyProbe::Report LatencyProbe::report() const
+{
+    Report report;
+    QVector<qint64> sorted;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        sorted = m_samples;
+        report.lost = m_lost;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+
+    int count = sorted.count();
+    report.samples = count;
+
+    if (count == 0)
+    {
+        report.min = report.mean = report.median = 0;
+        report.p95 = report.p99 = report.max = 0;
+        return report;
+    }
+
+    qint64 total = 0;
+    foreach (qint64 latency, sorted)
+        total += latency;
+
+    // nearest rank percentiles
+    report.min = sorted.first();
+    report.mean = total / count;
+    report.median = sorted.at((count - 1) / 2);
+    report.p95 = sorted.at(qMax(0, (count * 95 + 99) / 100 - 1));
+    report.p99 = sorted.at(qMax(0, (count * 99 + 99) / 100 - 1));
+    report.max = sorted.last();
+
+    return report;
+}
+
+QVector<qint64> LatencyProbe::samples() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_samples;
+}
+
+void LatencyProbe::frameWritten(QByteArray const& data)
+{
+    qint64 sent = m_pendingTime.loadAcquire();
+    if (sent == 0 || m_outputChannel >= quint32(data.size()))
+        return;
+
+    bool high = uchar(data.at(m_outputChannel)) >= PROBE_THRESHOLD;
+    if (high != m_expectHigh)
+        return;
+
+    // several patches can see the same value: the first one takes it
+    if (m_pendingTime.testAndSetOrdered(sent, 0) == false)
+        return;
+
+    qint64 latency = m_clock.nsecsElapsed() - sent;
+
+    QMutexLocker locker(&m_mutex);
+    m_samples.append(latency);
+}
+
+void LatencyProbe::slotTimeout()
+{
+    qint64 sent = m_pendingTime.loadAcquire();
+
+    if (sent != 0)
+    {
+        if (m_clock.nsecsElapsed() - sent < PROBE_TIMEOUT_NS)
+            return;
+
+        if (m_pendingTime.testAndSetOrdered(sent, 0))
+        {
+            QMutexLocker locker(&m_mutex);
+            m_lost++;
+        }
+    }
+
+    int taken = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        taken = m_samples.count() + m_lost;
+    }
+
+    if (taken >= m_requested || m_input.isNull())
+    {
+        stop();
+        emit finished();
+        return;
+    }
+
+    inject(!m_expectHigh);
+}
+
+void LatencyProbe::inject(bool high)
+{
+    m_expectHigh = high;
+
+    // taken before the injection, so a value flushed right away isn't missed
+    m_pendingTime.storeRelease(qMax(Q_INT64_C(1), m_clock.nsecsElapsed()));
+
+    m_input->injectValue(m_inputChannel, high ? UCHAR_MAX : 0);
+}
@@ -0,0 +1,144 @@
+/*
+  Q Light Controller Plus
+  latencyprobe.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+#include <QMutex>
+#include <QList>
+
+class OutputPatch;
+class InputPatch;
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/** Default interval in milliseconds between two probe values */
+#define DEFAULT_PROBE_INTERVAL  100
+
+/**
+ * LatencyProbe measures the time taken by an input value to reach the
+ * output plugins.
+ *
+ * Probe values are injected in an input patch, as if they were received
+ * by its plugin line, alternating between 0 and 255. They then follow
+ * the usual path: the input patch buffer, the universe passthrough or
+ * the widgets and functions controlled by the channel, down to
+ * OutputPatch::dump. A sample is taken when the observed output channel
+ * crosses half scale in the expected direction, so the output doesn't
+ * need to match the input value exactly (e.g. a slider scaling it).
+ *
+ * Only one probe value is in flight at a time. Values not seen at the
+ * output within a second are counted as lost.
+ */
+class LatencyProbe final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(LatencyProbe)
+
+public:
+    LatencyProbe(QObject *parent = NULL);
+    ~LatencyProbe();
+
+    /** Latency distribution of the samples taken, in nanoseconds */
+    struct Report
+    {
+        int samples;
+        int lost;
+        qint64 min;
+        qint64 mean;
+        qint64 median;
+        qint64 p95;
+        qint64 p99;
+        qint64 max;
+    };
+
+    /**
+     * Start injecting probe values
+     *
+     * @param input The input patch to inject the values into
+     * @param inputChannel The input channel receiving the values
+     * @param outputs The output patches observed
+     * @param outputChannel The output channel expected to follow the input
+     * @param samples The number of samples to take
+     * @param interval The time between two probe values, in milliseconds
+     * @return false if the probe is already running or nothing can be observed
+     */
+    bool start(InputPatch *input, quint32 inputChannel,
+               QList<OutputPatch *> const& outputs, quint32 outputChannel,
+               int samples, int interval = DEFAULT_PROBE_INTERVAL);
+
+    /** Stop injecting probe values and release the patches */
+    void stop();
+
+    /** Return true if the probe is taking samples */
+    bool isRunning() const;
+
+    /** Return the distribution of the samples taken so far */
+    Report report() const;
+
+    /** Return the samples taken so far, in nanoseconds */
+    QVector<qint64> samples() const;
+
+    /** Called by the observed output patches, in the universe threads,
+     *  with every frame written to their plugin line */
+    void frameWritten(QByteArray const& data);
+
+signals:
+    /** Emitted when all the samples have been taken or lost */
+    void finished();
+
+private slots:
+    void slotTimeout();
+
+private:
+    /** Inject the next probe value in the input patch */
+    void inject(bool high);
+
+private:
+    QPointer<InputPatch> m_input;
+    quint32 m_inputChannel;
+    QList<QPointer<OutputPatch> > m_outputs;
+    quint32 m_outputChannel;
+    int m_requested;
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+
+    /** Injection time of the value in flight, 0 if none */
+    QAtomicInteger<qint64> m_pendingTime;
+    /** True if the value in flight is the high one */
+    bool m_expectHigh;
+
+    /** Samples and lost values, protected by m_mutex */
+    QVector<qint64> m_samples;
+    int m_lost;
+    mutable QMutex m_mutex;
+};
+
+/** @} */
+
+#endif
@@ -21,16 +21,17 @@
 #include <QDebug>
 #include <QSettings>
 #include <QMutexLocker>
+#include <QThread>
 
 #if defined(WIN32) || defined(Q_OS_WIN)
 #   include "mastertimer-win32.h"
 #else
-#   include <unistd.h>
 #   include "mastertimer-unix.h"
 #endif
 
 #include "inputoutputmap.h"
 #include "genericfader.h"
+#include "clocksync.h"
 #include "mastertimer.h"
 #include "dmxsource.h"
 #include "function.h"
@@ -39,6 +40,8 @@
 
 #define MASTERTIMER_FREQUENCY "mastertimer/frequency"
 #define LATE_TO_BEAT_THRESHOLD 25
+/** Maximum time in milliseconds stopAllFunctions() waits for the timer */
+#define STOP_ALL_TIMEOUT 2000
 
 /** The timer tick frequency in Hertz */
 uint MasterTimer::s_frequency = 50;
@@ -57,7 +60,10 @@ quint64 ticksCount = 0;
 MasterTimer::MasterTimer(Doc* doc)
     : QObject(doc)
     , d_ptr(new MasterTimerPrivate(this))
-    , m_stopAllFunctions(false)
+    , m_stopAllRequests(0)
+    , m_stopAllServed(0)
+    , m_tickThread(NULL)
+    , m_tickUniversesClaimed(false)
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
     , m_dmxSourceListMutex(QMutex::Recursive)
 #endif
@@ -66,10 +72,14 @@ MasterTimer::MasterTimer(Doc* doc)
     , m_beatTimeDuration(500)
     , m_beatRequested(false)
     , m_lastBeatOffset(0)
+    , m_beatPhaseLock(true)
+    , m_lastLockedBeat(-1)
 {
     Q_ASSERT(doc != NULL);
     Q_ASSERT(d_ptr != NULL);
 
+    m_beatClock.start();
+
     QSettings settings;
     QVariant var = settings.value(MASTERTIMER_FREQUENCY);
     if (var.isValid() == true)
@@ -109,6 +119,9 @@ void MasterTimer::timerTick()
     qDebug() << "[MasterTimer] *********** tick:" << ticksCount++ << "**********";
 #endif
 
+    // stopAllFunctions() may be called from this thread during the tick
+    m_tickThread.storeRelease(QThread::currentThread());
+
     switch (m_beatSourceType)
     {
         case Internal:
@@ -132,6 +145,28 @@ void MasterTimer::timerTick()
         }
         break;
         case External:
+        {
+            QMutexLocker locker(&m_beatPhaseMutex);
+            qint64 now = m_beatClock.nsecsElapsed();
+
+            if (m_beatPhaseLock && m_beatPhaseTracker.isLocked(now))
+            {
+                // fire the beat on the tick closest to the predicted beat time,
+                // unless it has already been generated by a request
+                qint64 halfTick = qint64(s_tick) * 500000;
+                qint64 nextBeat = m_beatPhaseTracker.predictBeat(now - halfTick);
+
+                if (nextBeat < now + halfTick &&
+                    (m_lastLockedBeat < 0 || nextBeat - m_lastLockedBeat > m_beatPhaseTracker.period() / 2))
+                {
+                    m_beatRequested = true;
+                    m_lastLockedBeat = nextBeat;
+                    locker.unlock();
+
+                    emit beat();
+                }
+            }
+        }
         break;
 
         case None:
@@ -141,16 +176,20 @@ void MasterTimer::timerTick()
     }
 
     QList<Universe *> universes = doc->inputOutputMap()->claimUniverses();
+    m_tickUniversesClaimed = true;
 
     timerTickFunctions(universes);
     timerTickDMXSources(universes);
 
+    m_tickUniversesClaimed = false;
     doc->inputOutputMap()->releaseUniverses();
 
     m_beatRequested = false;
 
     //qDebug() << ">>>>>>>> MASTERTIMER TICK";
     emit tickReady();
+
+    m_tickThread.storeRelease(NULL);
 }
 
 uint MasterTimer::frequency()
@@ -177,21 +216,66 @@ void MasterTimer::startFunction(Function* function)
         m_startQueue.append(function);
 }
 
-void MasterTimer::stopAllFunctions()
+bool MasterTimer::stopAllFunctions()
 {
-    m_stopAllFunctions = true;
+    QMutexLocker locker(&m_functionListMutex);
+    quint64 request = ++m_stopAllRequests;
+    bool tickThread = QThread::currentThread() == m_tickThread.loadAcquire();
+
+    /* Called by a running function: the functions can't be run again
+     * from here, so the request is left to the next tick */
+    if (tickThread && m_tickUniversesClaimed)
+        return false;
 
-    /* Wait until all functions have been stopped */
-    while (runningFunctions() > 0)
+    /* Nobody else can serve the request: the timer is not running,
+     * or this is the timer thread, that would wait for itself */
+    if (d_ptr->isRunning() == false || tickThread)
     {
-#if defined(WIN32) || defined(Q_OS_WIN)
-        Sleep(10);
-#else
-        usleep(10000);
-#endif
+        locker.unlock();
+        stopAllFunctionsDirect();
+        return true;
+    }
+
+    QElapsedTimer watchdog;
+    watchdog.start();
+
+    /* Wait until the next tick has stopped all functions */
+    while (m_stopAllServed < request)
+    {
+        qint64 remaining = STOP_ALL_TIMEOUT - watchdog.elapsed();
+        if (remaining <= 0)
+        {
+            qWarning() << Q_FUNC_INFO << "Timed out waiting for all functions to stop";
+            return false;
+        }
+
+        m_functionsStopped.wait(&m_functionListMutex, ulong(remaining));
     }
 
-    m_stopAllFunctions = false;
+    return true;
+}
+
+void MasterTimer::requestStopAllFunctions()
+{
+    QMutexLocker locker(&m_functionListMutex);
+    m_stopAllRequests++;
+
+    /* Don't leave the request pending until the timer is started */
+    if (d_ptr->isRunning() == false)
+    {
+        locker.unlock();
+        stopAllFunctionsDirect();
+    }
+}
+
+void MasterTimer::stopAllFunctionsDirect()
+{
+    Doc *doc = qobject_cast<Doc*> (parent());
+    Q_ASSERT(doc != NULL);
+
+    QList<Universe *> universes = doc->inputOutputMap()->claimUniverses();
+    timerTickFunctions(universes);
+    doc->inputOutputMap()->releaseUniverses();
 }
 
 void MasterTimer::fadeAndStopAll(int timeout)
@@ -209,7 +293,7 @@ void MasterTimer::fadeAndStopAll(int timeout)
     }
 
     // At last, stop all functions
-    stopAllFunctions();
+    requestStopAllFunctions();
 }
 
 int MasterTimer::runningFunctions() const
@@ -227,6 +311,15 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
     bool stoppedAFunction = true;
     bool firstIteration = true;
 
+    // Requests made from now on are served on the next tick
+    quint64 stopAllRequest;
+    bool stopAll;
+    {
+        QMutexLocker locker(&m_functionListMutex);
+        stopAllRequest = m_stopAllRequests;
+        stopAll = stopAllRequest != m_stopAllServed;
+    }
+
     while (stoppedAFunction)
     {
         stoppedAFunction = false;
@@ -239,7 +332,7 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
             if (function != NULL)
             {
                 /* Run the function unless it's supposed to be stopped */
-                if (function->stopped() == false && m_stopAllFunctions == false)
+                if (function->stopped() == false && stopAll == false)
                 {
                     if (firstIteration)
                         function->write(this, universes);
@@ -247,7 +340,7 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
                 else
                 {
                     // Clear function's parentList
-                    if (m_stopAllFunctions)
+                    if (stopAll)
                         function->stop(FunctionParent::master());
                     /* Function should be stopped instead */
                     function->postRun(this, universes);
@@ -286,6 +379,13 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
 
             foreach (Function* f, startQueue)
             {
+                if (stopAll)
+                {
+                    // Started before or while stopping all: never run it
+                    f->stop(FunctionParent::master());
+                    continue;
+                }
+
                 if (m_functionList.contains(f))
                 {
                     f->postRun(this, universes);
@@ -302,10 +402,19 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
 
             locker.relock();
         }
+
+        if (stopAll)
+        {
+            m_stopAllServed = stopAllRequest;
+            m_functionsStopped.wakeAll();
+        }
     }
 
     if (functionListHasChanged)
         emit functionListChanged();
+
+    if (stopAll)
+        emit allFunctionsStopped();
 }
 
 /****************************************************************************
@@ -362,6 +471,10 @@ void MasterTimer::setBeatSourceType(MasterTimer::BeatsSourceType type)
     m_beatTimer.restart();
 
     m_beatSourceType = type;
+
+    QMutexLocker locker(&m_beatPhaseMutex);
+    m_beatPhaseTracker.reset();
+    m_lastLockedBeat = -1;
 }
 
 MasterTimer::BeatsSourceType MasterTimer::beatSourceType() const
@@ -393,6 +506,13 @@ int MasterTimer::beatTimeDuration() const
 
 int MasterTimer::timeToNextBeat() const
 {
+    if (m_beatSourceType == External)
+    {
+        int predicted = predictedBeatTime();
+        if (predicted >= 0)
+            return predicted;
+    }
+
     return m_beatTimeDuration - m_beatTimer.elapsed();
 }
 
@@ -419,9 +539,89 @@ bool MasterTimer::isBeat() const
     return m_beatRequested;
 }
 
-void MasterTimer::requestBeat()
+void MasterTimer::requestBeat(qint64 timestamp)
 {
+    if (m_beatSourceType == External && m_beatPhaseLock)
+    {
+        QMutexLocker locker(&m_beatPhaseMutex);
+        qint64 now = m_beatClock.nsecsElapsed();
+        bool wasLocked = m_beatPhaseTracker.isLocked(now);
+
+        // move the onset on the beat clock time base
+        qint64 onset = now;
+        if (timestamp >= 0)
+            onset = qMin(now, now - (ClockSync::now() - timestamp));
+
+        m_beatPhaseTracker.addOnset(onset);
+
+        // a locked loop generates beats on its own: the onset
+        // just corrects its tempo and phase
+        if (wasLocked && m_beatPhaseTracker.isLocked(now))
+            return;
+
+        m_lastLockedBeat = onset;
+    }
+
     // forceful request of a beat, processed at
     // the next timerTick call
     m_beatRequested = true;
 }
+
+void MasterTimer::setBeatPhaseLockEnabled(bool enable)
+{
+    QMutexLocker locker(&m_beatPhaseMutex);
+    m_beatPhaseLock = enable;
+    m_beatPhaseTracker.reset();
+    m_lastLockedBeat = -1;
+}
+
+bool MasterTimer::beatPhaseLockEnabled() const
+{
+    return m_beatPhaseLock;
+}
+
+bool MasterTimer::isBeatPhaseLocked() const
+{
+    if (m_beatSourceType != External || m_beatPhaseLock == false)
+        return false;
+
+    QMutexLocker locker(&m_beatPhaseMutex);
+    return m_beatPhaseTracker.isLocked(m_beatClock.nsecsElapsed());
+}
+
+double MasterTimer::beatConfidence() const
+{
+    QMutexLocker locker(&m_beatPhaseMutex);
+    return m_beatPhaseTracker.confidence();
+}
+
+double MasterTimer::estimatedBpm() const
+{
+    QMutexLocker locker(&m_beatPhaseMutex);
+    return m_beatPhaseTracker.bpm();
+}
+
+double MasterTimer::beatPhase() const
+{
+    if (m_beatSourceType == External)
+    {
+        QMutexLocker locker(&m_beatPhaseMutex);
+        return m_beatPhaseTracker.phase(m_beatClock.nsecsElapsed());
+    }
+
+    if (m_beatTimeDuration <= 0)
+        return 0;
+
+    return qBound(0.0, double(m_beatTimer.elapsed()) / double(m_beatTimeDuration), 1.0);
+}
+
+int MasterTimer::predictedBeatTime(int ahead) const
+{
+    QMutexLocker locker(&m_beatPhaseMutex);
+    qint64 now = m_beatClock.nsecsElapsed();
+
+    if (m_beatPhaseLock == false || m_beatPhaseTracker.isLocked(now) == false)
+        return -1;
+
+    return int((m_beatPhaseTracker.predictBeat(now, ahead) - now) / 1000000);
+}
@@ -21,13 +21,18 @@
 #ifndef MASTERTIMER_H
 #define MASTERTIMER_H
 
+#include <QWaitCondition>
 #include <QElapsedTimer>
+#include <QAtomicPointer>
 #include <QHash>
 #include <QObject>
 #include <QMutex>
 #include <QList>
 
+#include "beatphasetracker.h"
+
 class MasterTimerPrivate;
+class QThread;
 class GenericFader;
 class FadeChannel;
 class DMXSource;
@@ -98,10 +103,28 @@ public:
     /** This should be called by the function itself */
     virtual void startFunction(Function* function);
 
-    /** Stop all functions. Doesn't affect registered DMX sources. */
-    void stopAllFunctions();
+    /**
+     * Stop all functions and wait until they have been stopped, which
+     * happens within the next tick. Doesn't affect registered DMX sources.
+     *
+     * When called from the timer thread (e.g. by a tickReady() handler),
+     * the functions are stopped right away instead. When called by a
+     * running function, they can't be, and are stopped by the next tick.
+     *
+     * @return false if the functions were not stopped in time, or
+     *         if they will be stopped by the next tick
+     */
+    bool stopAllFunctions();
+
+    /**
+     * Ask all functions to be stopped on the next tick and return
+     * immediately. allFunctionsStopped() is emitted once they are.
+     * Doesn't affect registered DMX sources.
+     */
+    void requestStopAllFunctions();
 
-    /** Fade all functions for a given time and then stop them all */
+    /** Fade all functions for a given time and then stop them all.
+     *  This doesn't wait for the functions to be stopped. */
     void fadeAndStopAll(int timeout);
 
     /** Get the number of currently running functions */
@@ -117,20 +140,42 @@ signals:
     /** Emitted when a Function has just been stopped */
     void functionStopped(quint32 id);
 
+    /** Emitted from the timer thread when a stop of all the functions,
+     *  requested by stopAllFunctions() or requestStopAllFunctions(),
+     *  has been completed */
+    void allFunctionsStopped();
+
 private:
     /** Execute one timer tick for each registered Function */
     void timerTickFunctions(QList<Universe *> universes);
 
+    /** Stop all the functions from the calling thread, when the timer
+     *  is not running to do it, or from the timer thread itself */
+    void stopAllFunctionsDirect();
+
 private:
     /** List of currently running functions */
     QList <Function*> m_functionList;
     QList <Function*> m_startQueue;
 
-    /** Mutex that guards access to m_startQueue */
+    /** Mutex that guards access to m_startQueue and the stop all counters */
     QMutex m_functionListMutex;
 
-    /** Flag for stopping all functions */
-    bool m_stopAllFunctions;
+    /** Number of stop all requests made and served so far. A request
+     *  is pending while they differ */
+    quint64 m_stopAllRequests;
+    quint64 m_stopAllServed;
+
+    /** Woken up, with m_functionListMutex, when a stop all is served */
+    QWaitCondition m_functionsStopped;
+
+    /** The thread running the current tick, NULL between ticks. It is not
+     *  always the same thread: the win32 timer runs on a thread pool */
+    QAtomicPointer<QThread> m_tickThread;
+
+    /** True while the tick holds the universes, to run the functions
+     *  and the DMX sources. Used only by the tick thread */
+    bool m_tickUniversesClaimed;
 
     /*************************************************************************
      * DMX Sources
@@ -222,8 +267,39 @@ public:
      *  not an immediate beat generation, since MasterTimer still works with ticks
      *  so the requested beat will happen in the worst case after a s_tick time, so typically 20ms
      *  unless otherwise specified by MASTERTIMER_FREQUENCY.
-     *  This is quite safe cause even 300bpm should happen every 200ms. */
-    void requestBeat();
+     *  This is quite safe cause even 300bpm should happen every 200ms.
+     *
+     *  When the beat source is External, each request is also fed as an onset
+     *  into a phase-locked loop. Once the loop is locked, beats are generated
+     *  by MasterTimer itself on the tick closest to the predicted beat time,
+     *  and requests only correct the loop tempo and phase.
+     *
+     *  $timestamp is the time of the beat in nanoseconds on the ClockSync::now()
+     *  clock, for sources that know it more precisely than the request time.
+     *  A negative value means now. */
+    void requestBeat(qint64 timestamp = -1);
+
+    /** Enable or disable phase locking on external beats */
+    void setBeatPhaseLockEnabled(bool enable);
+
+    /** Return true if phase locking on external beats is enabled */
+    bool beatPhaseLockEnabled() const;
+
+    /** Return true if the phase-locked loop is following an external tempo */
+    bool isBeatPhaseLocked() const;
+
+    /** Return the phase-locked loop confidence, in the range 0.0 - 1.0 */
+    double beatConfidence() const;
+
+    /** Return the tempo estimated by the phase-locked loop, or 0 if unknown */
+    double estimatedBpm() const;
+
+    /** Return the current beat phase, in the range 0.0 - 1.0 */
+    double beatPhase() const;
+
+    /** Return the time in milliseconds to the beat number $ahead following
+     *  the next predicted beat, or -1 if there is no prediction available */
+    int predictedBeatTime(int ahead = 0) const;
 
 signals:
     void bpmNumberChanged(int bpm);
@@ -242,6 +318,17 @@ private:
     QElapsedTimer m_beatTimer;
     /** Time offset in milliseconds when the last beat occurred */
     int m_lastBeatOffset;
+
+    /** Phase-locked loop tracking external beat onsets */
+    BeatPhaseTracker m_beatPhaseTracker;
+    /** Mutex that guards access to m_beatPhaseTracker */
+    mutable QMutex m_beatPhaseMutex;
+    /** Monotonic clock used to timestamp external beat onsets */
+    QElapsedTimer m_beatClock;
+    /** Flag to enable phase locking on external beats */
+    bool m_beatPhaseLock;
+    /** Time in nanoseconds of the last beat generated by the locked loop */
+    qint64 m_lastLockedBeat;
 };
 
 /** @} */
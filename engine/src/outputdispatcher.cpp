@@ -0,0 +1,130 @@
+/*
+  Q Light Controller Plus
+  outputdispatcher.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QDebug>
+
+#include "outputdispatcher.h"
+#include "qlcioplugin.h"
+
+OutputDispatcher::OutputDispatcher(QLCIOPlugin *plugin, quint32 line, QObject *parent)
+    : QThread(parent)
+    , m_plugin(plugin)
+    , m_line(line)
+    , m_pendingUniverse(0)
+    , m_pendingChanged(false)
+    , m_hasPending(false)
+    , m_droppedFrames(0)
+    , m_sentFrames(0)
+    , m_running(true)
+{
+    Q_ASSERT(plugin != NULL);
+
+    start(QThread::HighPriority);
+}
+
+OutputDispatcher::~OutputDispatcher()
+{
+    stop();
+}
+
+void OutputDispatcher::post(quint32 universe, const QByteArray &data, bool dataChanged)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_running == false)
+        return;
+
+    if (m_hasPending)
+    {
+        m_droppedFrames++;
+        // the replaced frame changes must not get lost
+        dataChanged |= m_pendingChanged;
+    }
+
+    m_pendingUniverse = universe;
+    m_pendingData = data;
+    m_pendingChanged = dataChanged;
+    m_hasPending = true;
+
+    m_frameCondition.wakeOne();
+}
+
+void OutputDispatcher::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_running = false;
+        m_frameCondition.wakeOne();
+    }
+    wait();
+}
+
+quint64 OutputDispatcher::droppedFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_droppedFrames;
+}
+
+quint64 OutputDispatcher::sentFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sentFrames;
+}
+
+void OutputDispatcher::run()
+{
+    qDebug() << "[OutputDispatcher] started on line" << m_line;
+
+    while (true)
+    {
+        quint32 universe;
+        QByteArray data;
+        bool dataChanged;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_running && m_hasPending == false)
+                m_frameCondition.wait(&m_mutex);
+
+            // a frame posted before stop() is still written
+            if (m_hasPending == false)
+                break;
+
+            universe = m_pendingUniverse;
+            data = m_pendingData;
+            dataChanged = m_pendingChanged;
+            m_pendingData.clear();
+            m_hasPending = false;
+        }
+
+        // the plugin may block here, the universe thread keeps posting
+        m_plugin->writeUniverse(universe, m_line, data, dataChanged);
+
+        /* The frame may arrive after the tick flush, and the next one
+         * might never come: plugins holding frames until flushOutputs()
+         * must not keep this one */
+        m_plugin->flushOutputs();
+
+        QMutexLocker locker(&m_mutex);
+        m_sentFrames++;
+    }
+
+    qDebug() << "[OutputDispatcher] stopped on line" << m_line;
+}
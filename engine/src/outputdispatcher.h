@@ -0,0 +1,89 @@
+/*
+  Q Light Controller Plus
+  outputdispatcher.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef OUTPUTDISPATCHER_H
+#define OUTPUTDISPATCHER_H
+
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QThread>
+#include <QMutex>
+
+class QLCIOPlugin;
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/**
+ * OutputDispatcher writes universe frames to a plugin line from its own
+ * thread, so that a slow plugin (blocking USB writes, network stalls...)
+ * never holds up the universe thread that produced the frame.
+ *
+ * The dispatcher holds a single pending frame: posting a new frame while
+ * the previous one has not been written yet replaces it, and the replaced
+ * frame is counted as dropped. Frames are implicitly shared QByteArrays,
+ * so posting never copies channel data.
+ */
+class OutputDispatcher final : public QThread
+{
+    Q_OBJECT
+
+public:
+    OutputDispatcher(QLCIOPlugin *plugin, quint32 line, QObject *parent = 0);
+    ~OutputDispatcher();
+
+    /** Queue $data to be written to $universe, replacing any pending frame */
+    void post(quint32 universe, const QByteArray &data, bool dataChanged);
+
+    /** Stop the sender thread, after writing the pending frame if any.
+     *  Frames posted after this call are ignored */
+    void stop();
+
+    /** Number of frames replaced before they could be written */
+    quint64 droppedFrames() const;
+
+    /** Number of frames written to the plugin */
+    quint64 sentFrames() const;
+
+protected:
+    /** @reimp */
+    void run() override;
+
+private:
+    QLCIOPlugin *m_plugin;
+    quint32 m_line;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_frameCondition;
+
+    /** The latest frame waiting to be written */
+    QByteArray m_pendingData;
+    quint32 m_pendingUniverse;
+    bool m_pendingChanged;
+    bool m_hasPending;
+
+    quint64 m_droppedFrames;
+    quint64 m_sentFrames;
+    bool m_running;
+};
+
+/** @} */
+
+#endif
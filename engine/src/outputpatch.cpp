@@ -24,6 +24,11 @@
 #   include <unistd.h>
 #endif
 
+#include <QMutexLocker>
+#include <QSettings>
+
+#include "outputdispatcher.h"
+#include "latencyprobe.h"
 #include "qlcioplugin.h"
 #include "outputpatch.h"
 
@@ -40,7 +45,19 @@ OutputPatch::OutputPatch(QObject* parent)
     , m_universe(UINT_MAX)
     , m_paused(false)
     , m_blackout(false)
+    , m_latencyProbe(NULL)
+    , m_asyncDispatch(false)
+    , m_dispatcher(NULL)
+    , m_droppedFrames(0)
+    , m_maxFrameRate(0)
+    , m_keepAliveInterval(0)
+    , m_burstSize(1)
+    , m_lastFrameTime(-1)
+    , m_lastRefillTime(0)
+    , m_frameTokens(1.0)
+    , m_pendingChanges(false)
 {
+    m_asyncDispatch = defaultAsyncDispatch();
 }
 
 OutputPatch::OutputPatch(quint32 universe, QObject* parent)
@@ -50,11 +67,25 @@ OutputPatch::OutputPatch(quint32 universe, QObject* parent)
     , m_universe(universe)
     , m_paused(false)
     , m_blackout(false)
+    , m_latencyProbe(NULL)
+    , m_asyncDispatch(false)
+    , m_dispatcher(NULL)
+    , m_droppedFrames(0)
+    , m_maxFrameRate(0)
+    , m_keepAliveInterval(0)
+    , m_burstSize(1)
+    , m_lastFrameTime(-1)
+    , m_lastRefillTime(0)
+    , m_frameTokens(1.0)
+    , m_pendingChanges(false)
 {
+    m_asyncDispatch = defaultAsyncDispatch();
 }
 
 OutputPatch::~OutputPatch()
 {
+    destroyDispatcher();
+
     if (m_plugin != NULL)
         m_plugin->closeOutput(m_pluginLine, m_universe);
 }
@@ -65,6 +96,9 @@ OutputPatch::~OutputPatch()
 
 bool OutputPatch::set(QLCIOPlugin* plugin, quint32 output)
 {
+    /* The sender thread must not write to a closed line */
+    destroyDispatcher();
+
     if (m_plugin != NULL && m_pluginLine != QLCIOPlugin::invalidLine())
         m_plugin->closeOutput(m_pluginLine, m_universe);
 
@@ -88,6 +122,7 @@ bool OutputPatch::reconnect()
 {
     if (m_plugin != NULL && m_pluginLine != QLCIOPlugin::invalidLine())
     {
+        destroyDispatcher();
         m_plugin->closeOutput(m_pluginLine, m_universe);
 #if defined(WIN32) || defined(Q_OS_WIN)
         Sleep(GRACE_MS);
@@ -197,16 +232,201 @@ void OutputPatch::dump(quint32 universe, const QByteArray& data, bool dataChange
     /* Don't do anything if there is no plugin and/or output line. */
     if (m_plugin != NULL && m_pluginLine != QLCIOPlugin::invalidLine())
     {
+        if (scheduleFrame(dataChanged) == false)
+            return;
+
         if (m_paused)
         {
             if (m_pauseBuffer.isNull())
                 m_pauseBuffer.append(data);
 
-            m_plugin->writeUniverse(universe, m_pluginLine, m_pauseBuffer, dataChanged);
+            write(universe, m_pauseBuffer, dataChanged);
         }
         else
         {
-            m_plugin->writeUniverse(universe, m_pluginLine, data, dataChanged);
+            write(universe, data, dataChanged);
         }
     }
 }
+
+void OutputPatch::setLatencyProbe(LatencyProbe *probe)
+{
+    m_latencyProbe.storeRelease(probe);
+}
+
+void OutputPatch::write(quint32 universe, const QByteArray &data, bool dataChanged)
+{
+    LatencyProbe *probe = m_latencyProbe.loadAcquire();
+    if (probe != NULL)
+        probe->frameWritten(data);
+
+    if (m_asyncDispatch == false)
+    {
+        m_plugin->writeUniverse(universe, m_pluginLine, data, dataChanged);
+        return;
+    }
+
+    QMutexLocker locker(&m_dispatcherMutex);
+
+    /* Dispatch might have been disabled in the meantime */
+    if (m_asyncDispatch == false)
+    {
+        locker.unlock();
+        m_plugin->writeUniverse(universe, m_pluginLine, data, dataChanged);
+        return;
+    }
+
+    if (m_dispatcher == NULL)
+        m_dispatcher = new OutputDispatcher(m_plugin, m_pluginLine);
+
+    m_dispatcher->post(universe, data, dataChanged);
+}
+
+/*****************************************************************************
+ * Asynchronous dispatch
+ *****************************************************************************/
+
+void OutputPatch::setAsyncDispatch(bool enable)
+{
+    {
+        QMutexLocker locker(&m_dispatcherMutex);
+        if (m_asyncDispatch == enable)
+            return;
+
+        m_asyncDispatch = enable;
+    }
+
+    if (enable == false)
+        destroyDispatcher();
+}
+
+bool OutputPatch::asyncDispatch() const
+{
+    return m_asyncDispatch;
+}
+
+bool OutputPatch::defaultAsyncDispatch()
+{
+    QSettings settings;
+    QVariant var = settings.value(SETTINGS_OUTPUT_ASYNC);
+    if (var.isValid())
+        return var.toBool();
+
+    return false;
+}
+
+quint64 OutputPatch::droppedFrames() const
+{
+    QMutexLocker locker(&m_dispatcherMutex);
+    if (m_dispatcher != NULL)
+        return m_droppedFrames + m_dispatcher->droppedFrames();
+
+    return m_droppedFrames;
+}
+
+void OutputPatch::destroyDispatcher()
+{
+    QMutexLocker locker(&m_dispatcherMutex);
+    if (m_dispatcher == NULL)
+        return;
+
+    m_droppedFrames += m_dispatcher->droppedFrames();
+    delete m_dispatcher;
+    m_dispatcher = NULL;
+}
+
+/*****************************************************************************
+ * Frame scheduling
+ *****************************************************************************/
+
+int OutputPatch::maxFrameRate() const
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    return m_maxFrameRate;
+}
+
+void OutputPatch::setMaxFrameRate(int fps)
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    m_maxFrameRate = qMax(0, fps);
+}
+
+int OutputPatch::keepAliveInterval() const
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    return m_keepAliveInterval;
+}
+
+void OutputPatch::setKeepAliveInterval(int ms)
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    m_keepAliveInterval = qMax(0, ms);
+}
+
+int OutputPatch::burstSize() const
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    return m_burstSize;
+}
+
+void OutputPatch::setBurstSize(int frames)
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    m_burstSize = qMax(1, frames);
+}
+
+bool OutputPatch::isScheduled() const
+{
+    QMutexLocker locker(&m_scheduleMutex);
+    return m_maxFrameRate > 0 || m_keepAliveInterval > 0;
+}
+
+bool OutputPatch::scheduleFrame(bool &dataChanged)
+{
+    QMutexLocker locker(&m_scheduleMutex);
+
+    if (m_maxFrameRate == 0 && m_keepAliveInterval == 0)
+    {
+        // flag the changes held back while scheduling was enabled
+        dataChanged |= m_pendingChanges;
+        m_pendingChanges = false;
+        return true;
+    }
+
+    if (m_frameClock.isValid() == false)
+    {
+        m_frameClock.start();
+        m_frameTokens = m_burstSize;
+        m_lastRefillTime = 0;
+        m_lastFrameTime = -1;
+    }
+
+    qint64 now = m_frameClock.nsecsElapsed();
+    m_pendingChanges |= dataChanged;
+
+    if (m_maxFrameRate > 0)
+    {
+        // refill the token bucket at the frame rate, up to the burst size
+        m_frameTokens += double(now - m_lastRefillTime) * m_maxFrameRate / 1000000000.0;
+        m_frameTokens = qMin(m_frameTokens, double(m_burstSize));
+    }
+    m_lastRefillTime = now;
+
+    // with keep-alive, unchanged data is written only when the interval expires
+    if (m_keepAliveInterval > 0 && m_pendingChanges == false && m_lastFrameTime >= 0 &&
+        now - m_lastFrameTime < qint64(m_keepAliveInterval) * 1000000)
+        return false;
+
+    if (m_maxFrameRate > 0)
+    {
+        if (m_frameTokens < 1.0)
+            return false;
+        m_frameTokens -= 1.0;
+    }
+
+    dataChanged = m_pendingChanges;
+    m_pendingChanges = false;
+    m_lastFrameTime = now;
+
+    return true;
+}
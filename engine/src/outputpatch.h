@@ -20,9 +20,14 @@
 #ifndef OUTPUTPATCH_H
 #define OUTPUTPATCH_H
 
+#include <QElapsedTimer>
+#include <QAtomicPointer>
 #include <QObject>
+#include <QMutex>
 #include <QMap>
 
+class OutputDispatcher;
+class LatencyProbe;
 class QLCIOPlugin;
 
 /** @addtogroup engine Engine
@@ -35,6 +40,12 @@ class QLCIOPlugin;
 #define KXMLQLCOutputPatchUniverse  QStringLiteral("Universe")
 #define KXMLQLCOutputPatchPlugin    QStringLiteral("Plugin")
 #define KXMLQLCOutputPatchOutput    QStringLiteral("Output")
+#define KXMLQLCOutputPatchFrameRate QStringLiteral("FrameRate")
+#define KXMLQLCOutputPatchKeepAlive QStringLiteral("KeepAlive")
+#define KXMLQLCOutputPatchBurst     QStringLiteral("Burst")
+#define KXMLQLCOutputPatchAsync     QStringLiteral("Async")
+
+#define SETTINGS_OUTPUT_ASYNC "outputmanager/asyncdispatch"
 
 class OutputPatch : public QObject
 {
@@ -120,15 +131,117 @@ public:
       * Called periodically by OutputMap. No need to call manually. */
     void dump(quint32 universe, const QByteArray &data, bool dataChanged);
 
+    /** Set the probe receiving every frame written to the plugin line
+     *  (NULL to unset). The probe must outlive the patch or unset itself */
+    void setLatencyProbe(LatencyProbe *probe);
+
 signals:
     void pausedChanged(bool paused);
     void blackoutChanged(bool blackout);
 
+private:
+    /** Write $data to the plugin line, directly or through the dispatcher */
+    void write(quint32 universe, const QByteArray &data, bool dataChanged);
+
 private:
     /** A buffer used when this output patch is paused */
     QByteArray m_pauseBuffer;
     bool m_paused;
     bool m_blackout;
+    /** The probe measuring the latency to this patch, if any */
+    QAtomicPointer<LatencyProbe> m_latencyProbe;
+
+    /********************************************************************
+     * Asynchronous dispatch
+     ********************************************************************/
+public:
+    /**
+     * Enable/disable the asynchronous dispatch of this patch. When enabled,
+     * dump() hands frames over to a dedicated sender thread and returns
+     * immediately, so a slow plugin line never stalls the universe thread.
+     * Only the latest frame is kept: frames produced faster than the line
+     * can write them are dropped.
+     * The default comes from the outputmanager/asyncdispatch setting, and
+     * each patch can override it with the Async attribute of its XML tag,
+     * which is saved only when the patch differs from the default.
+     */
+    void setAsyncDispatch(bool enable);
+    bool asyncDispatch() const;
+
+    /** Return the asynchronous dispatch default of new patches */
+    static bool defaultAsyncDispatch();
+
+    /** Number of frames dropped by the asynchronous dispatcher */
+    quint64 droppedFrames() const;
+
+    /********************************************************************
+     * Frame scheduling
+     ********************************************************************/
+public:
+    /**
+     * Get/Set the maximum number of frames per second written to the
+     * plugin line. 0 means no limit: a frame is written on every tick.
+     */
+    int maxFrameRate() const;
+    void setMaxFrameRate(int fps);
+
+    /**
+     * Get/Set the keep-alive interval in milliseconds. When set, frames
+     * are written only when data has changed, or when no frame has been
+     * written for the given interval. 0 writes a frame on every tick.
+     */
+    int keepAliveInterval() const;
+    void setKeepAliveInterval(int ms);
+
+    /**
+     * Get/Set the number of frames that can be written back to back
+     * when the line has been idle, before the frame rate limit applies
+     */
+    int burstSize() const;
+    void setBurstSize(int frames);
+
+    /** Returns true if any of the scheduling options is set */
+    bool isScheduled() const;
+
+private:
+    /**
+     * Decide if a frame should be written now. $dataChanged is updated
+     * with the changes accumulated since the last written frame.
+     * Always true when no scheduling option is set.
+     */
+    bool scheduleFrame(bool &dataChanged);
+
+private:
+    /** Protects the scheduling state between the universe thread,
+     *  running scheduleFrame, and the main thread setters */
+    mutable QMutex m_scheduleMutex;
+
+    int m_maxFrameRate;
+    int m_keepAliveInterval;
+    int m_burstSize;
+
+    QElapsedTimer m_frameClock;
+    /** Time of the last written frame, in nanoseconds */
+    qint64 m_lastFrameTime;
+    /** Time of the last token bucket refill, in nanoseconds */
+    qint64 m_lastRefillTime;
+    /** Frames that can be written before hitting the rate limit */
+    double m_frameTokens;
+    /** Data changes not written yet */
+    bool m_pendingChanges;
+
+private:
+    /** Stop and delete the sender thread, if any */
+    void destroyDispatcher();
+
+private:
+    bool m_asyncDispatch;
+    /** The sender thread, created on the first asynchronous dump */
+    OutputDispatcher *m_dispatcher;
+    /** Protects m_dispatcher between the universe and the main thread */
+    mutable QMutex m_dispatcherMutex;
+    /** Frames dropped by dispatchers already destroyed */
+    quint64 m_droppedFrames;
 };
 
 /** @} */
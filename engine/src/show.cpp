@@ -32,6 +32,9 @@
 #define KXMLQLCShowTimeDivision QStringLiteral("TimeDivision")
 #define KXMLQLCShowTimeType     QStringLiteral("Type")
 #define KXMLQLCShowTimeBPM      QStringLiteral("BPM")
+#define KXMLQLCShowAudioSync    QStringLiteral("AudioSync")
+#define KXMLQLCShowTimecodeSync QStringLiteral("TimecodeSync")
+#define KXMLQLCShowTimecodeOffset QStringLiteral("TimecodeOffset")
 
 /*****************************************************************************
  * Initialization
@@ -40,6 +43,11 @@
 Show::Show(Doc* doc) : Function(doc, Function::ShowType)
     , m_timeDivisionType(Time)
     , m_timeDivisionBPM(120)
+    , m_audioClockSync(false)
+    , m_timecodeSync(false)
+    , m_timecodeOffset(0)
+    , m_maxClockDrift(0)
+    , m_clockCorrections(0)
     , m_latestTrackId(0)
     , m_latestShowFunctionID(0)
     , m_runner(NULL)
@@ -108,6 +116,9 @@ bool Show::copyFrom(const Function* function)
 
     m_timeDivisionType = show->m_timeDivisionType;
     m_timeDivisionBPM = show->m_timeDivisionBPM;
+    m_audioClockSync = show->m_audioClockSync;
+    m_timecodeSync = show->m_timecodeSync;
+    m_timecodeOffset = show->m_timecodeOffset;
     m_latestTrackId = show->m_latestTrackId;
 
     // create a copy of each track
@@ -213,6 +224,50 @@ Show::TimeDivision Show::stringToTempo(QString tempo)
         return Invalid;
 }
 
+/*****************************************************************************
+ * Audio clock
+ *****************************************************************************/
+
+bool Show::audioClockSync() const
+{
+    return m_audioClockSync;
+}
+
+void Show::setAudioClockSync(bool enable)
+{
+    m_audioClockSync = enable;
+}
+
+bool Show::timecodeSync() const
+{
+    return m_timecodeSync;
+}
+
+void Show::setTimecodeSync(bool enable)
+{
+    m_timecodeSync = enable;
+}
+
+int Show::timecodeOffset() const
+{
+    return m_timecodeOffset;
+}
+
+void Show::setTimecodeOffset(int offset)
+{
+    m_timecodeOffset = offset;
+}
+
+int Show::maxClockDrift() const
+{
+    return m_maxClockDrift;
+}
+
+int Show::clockCorrections() const
+{
+    return m_clockCorrections;
+}
+
 /*****************************************************************************
  * Tracks
  *****************************************************************************/
@@ -372,6 +427,13 @@ bool Show::saveXML(QXmlStreamWriter *doc) const
     doc->writeStartElement(KXMLQLCShowTimeDivision);
     doc->writeAttribute(KXMLQLCShowTimeType, tempoToString(m_timeDivisionType));
     doc->writeAttribute(KXMLQLCShowTimeBPM, QString::number(m_timeDivisionBPM));
+    if (m_audioClockSync)
+        doc->writeAttribute(KXMLQLCShowAudioSync, KXMLQLCTrue);
+    if (m_timecodeSync)
+    {
+        doc->writeAttribute(KXMLQLCShowTimecodeSync, KXMLQLCTrue);
+        doc->writeAttribute(KXMLQLCShowTimecodeOffset, QString::number(m_timecodeOffset));
+    }
     doc->writeEndElement();
 
     foreach (Track *track, m_tracks)
@@ -405,6 +467,9 @@ bool Show::loadXML(QXmlStreamReader &root)
             QString type = root.attributes().value(KXMLQLCShowTimeType).toString();
             int bpm = root.attributes().value(KXMLQLCShowTimeBPM).toString().toInt();
             setTimeDivision(stringToTempo(type), bpm);
+            setAudioClockSync(root.attributes().value(KXMLQLCShowAudioSync).toString() == KXMLQLCTrue);
+            setTimecodeSync(root.attributes().value(KXMLQLCShowTimecodeSync).toString() == KXMLQLCTrue);
+            setTimecodeOffset(root.attributes().value(KXMLQLCShowTimecodeOffset).toString().toInt());
             root.skipCurrentElement();
         }
         else if (root.name() == KXMLQLCTrack)
@@ -474,12 +539,17 @@ void Show::preRun(MasterTimer* timer)
     }
 
     m_runner = new ShowRunner(doc(), this->id(), elapsed());
+    m_runner->setAudioClockSync(m_audioClockSync);
+    m_runner->setTimecodeSync(m_timecodeSync, m_timecodeOffset);
+    m_maxClockDrift = 0;
+    m_clockCorrections = 0;
     int i = 0;
     foreach (Track *track, m_tracks)
         m_runner->adjustIntensity(getAttributeValue(i++), track);
 
     connect(m_runner, SIGNAL(timeChanged(quint32)), this, SIGNAL(timeChanged(quint32)));
     connect(m_runner, SIGNAL(showFinished()), this, SIGNAL(showFinished()));
+    connect(m_runner, SIGNAL(clockDriftChanged(int)), this, SIGNAL(clockDriftChanged(int)));
     m_runner->start();
 }
 
@@ -498,6 +568,9 @@ void Show::write(MasterTimer* timer, QList<Universe *> universes)
         return;
 
     m_runner->write(timer);
+
+    m_maxClockDrift = m_runner->maxClockDrift();
+    m_clockCorrections = m_runner->clockCorrections();
 }
 
 void Show::postRun(MasterTimer* timer, QList<Universe *> universes)
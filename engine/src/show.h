@@ -93,6 +93,42 @@ private:
     TimeDivision m_timeDivisionType;
     int m_timeDivisionBPM;
 
+    /*********************************************************************
+     * Audio clock
+     *********************************************************************/
+public:
+    /**
+     * Get/Set the audio clock sync flag. When enabled, the show time
+     * follows the playback position of its first time-based Audio function
+     */
+    bool audioClockSync() const;
+    void setAudioClockSync(bool enable);
+
+    /**
+     * Get/Set the timecode sync flag. When enabled, the show time chases
+     * the external timecode received by the input plugins (e.g. MTC)
+     * and holds while the timecode is stopped
+     */
+    bool timecodeSync() const;
+    void setTimecodeSync(bool enable);
+
+    /** Get/Set the timecode position in ms corresponding to the show start */
+    int timecodeOffset() const;
+    void setTimecodeOffset(int offset);
+
+    /** Return the largest audio clock drift in ms of the current/last run */
+    int maxClockDrift() const;
+
+    /** Return the number of audio clock resyncs of the current/last run */
+    int clockCorrections() const;
+
+private:
+    bool m_audioClockSync;
+    bool m_timecodeSync;
+    int m_timecodeOffset;
+    int m_maxClockDrift;
+    int m_clockCorrections;
+
     /*********************************************************************
      * Tracks
      *********************************************************************/
@@ -201,6 +237,7 @@ protected slots:
 signals:
     void timeChanged(quint32);
     void showFinished();
+    void clockDriftChanged(int drift);
 
 protected:
     ShowRunner *m_runner;
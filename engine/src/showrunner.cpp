@@ -21,12 +21,20 @@
 #include <QDebug>
 
 #include "showrunner.h"
+#include "inputoutputmap.h"
+#include "clocksync.h"
 #include "function.h"
+#include "audio.h"
 #include "track.h"
 #include "show.h"
 
 #define TIMER_INTERVAL 50
 
+/** Drift in ms below which the show time is not corrected */
+#define CLOCK_DRIFT_DEADBAND    1
+/** Drift in ms above which the show time jumps to the clock master position */
+#define CLOCK_DRIFT_RESYNC      100
+
 static bool compareShowFunctions(const ShowFunction *sf1, const ShowFunction *sf2)
 {
     if (sf1->startTime() < sf2->startTime())
@@ -43,6 +51,15 @@ ShowRunner::ShowRunner(const Doc* doc, quint32 showID, quint32 startTime)
     , m_elapsedBeats(0)
     , beatSynced(false)
     , m_totalRunTime(0)
+    , m_audioClockSync(false)
+    , m_timecodeSync(false)
+    , m_timecodeOffset(0)
+    , m_clockMaster(NULL)
+    , m_clockMasterStartTime(0)
+    , m_clockDrift(0)
+    , m_maxClockDrift(0)
+    , m_clockCorrections(0)
+    , m_clockResyncing(false)
 {
     Q_ASSERT(m_doc != NULL);
     Q_ASSERT(showID != Show::invalidId());
@@ -125,6 +142,8 @@ void ShowRunner::stop()
     m_elapsedBeats = 0;
     m_currentTimeFunctionIndex = 0;
     m_currentBeatFunctionIndex = 0;
+    m_clockMaster = NULL;
+    m_clockResyncing = false;
 
     for (int i = 0; i < m_runningQueue.count(); i++)
     {
@@ -203,6 +222,12 @@ void ShowRunner::write(MasterTimer *timer)
             f->start(m_doc->masterTimer(), functionParent(), functionTimeOffset);
             m_runningQueue.append(QPair<Function *, quint32>(f, sf->startTime() + sf->duration(m_doc)));
             m_currentTimeFunctionIndex++;
+
+            if (m_audioClockSync && m_clockMaster == NULL && f->type() == Function::AudioType)
+            {
+                m_clockMaster = qobject_cast<Audio *>(f);
+                m_clockMasterStartTime = sf->startTime();
+            }
         }
         else
             startFunctionsDone = true;
@@ -261,6 +286,9 @@ void ShowRunner::write(MasterTimer *timer)
         // if we passed the function stop time
         if (currTime >= stopTime)
         {
+            if (func == m_clockMaster)
+                m_clockMaster = NULL;
+
             // stop the function
             func->stop(functionParent());
             // remove it from the running queue
@@ -277,10 +305,177 @@ void ShowRunner::write(MasterTimer *timer)
         return;
     }
 
-    m_elapsedTime += MasterTimer::tick();
+    m_elapsedTime += clockIncrement();
     emit timeChanged(m_elapsedTime);
 }
 
+/************************************************************************
+ * Audio clock
+ ************************************************************************/
+
+void ShowRunner::setAudioClockSync(bool enable)
+{
+    m_audioClockSync = enable;
+    if (enable == false)
+        m_clockMaster = NULL;
+}
+
+bool ShowRunner::audioClockSync() const
+{
+    return m_audioClockSync;
+}
+
+void ShowRunner::setTimecodeSync(bool enable, int offset)
+{
+    m_timecodeSync = enable;
+    m_timecodeOffset = offset;
+}
+
+bool ShowRunner::timecodeSync() const
+{
+    return m_timecodeSync;
+}
+
+int ShowRunner::clockDrift() const
+{
+    return m_clockDrift;
+}
+
+int ShowRunner::maxClockDrift() const
+{
+    return m_maxClockDrift;
+}
+
+int ShowRunner::clockCorrections() const
+{
+    return m_clockCorrections;
+}
+
+quint32 ShowRunner::clockIncrement()
+{
+    qint64 tick = MasterTimer::tick();
+    qint64 position = -1;
+
+    if (m_timecodeSync)
+    {
+        ClockSync *sync = m_doc->inputOutputMap()->clockSync();
+        qint64 now = ClockSync::now();
+
+        qint64 timecode = sync->timecodePosition(now);
+
+        // hold the show until a timecode is received
+        if (timecode < 0)
+            return 0;
+
+        position = timecode - m_timecodeOffset;
+
+        // a locate before the show time moves the show back there,
+        // even while the timecode is stopped
+        if (qint64(m_elapsedTime) - qMax(position, qint64(0)) >= CLOCK_DRIFT_RESYNC)
+        {
+            seekBackward(quint32(qMax(position, qint64(0))));
+            return 0;
+        }
+
+        // hold the show until the timecode runs
+        if (sync->isTimecodeLocked(now) == false || position < 0)
+            return 0;
+    }
+    else if (m_clockMaster != NULL)
+    {
+        position = m_clockMaster->playbackPosition();
+        if (position >= 0)
+            position += m_clockMasterStartTime;
+    }
+
+    if (position < 0)
+        return tick;
+
+    return followClock(position);
+}
+
+quint32 ShowRunner::followClock(qint64 position)
+{
+    qint64 tick = MasterTimer::tick();
+
+    // positive when the clock master is ahead of the show
+    qint64 drift = position - m_elapsedTime;
+    qint64 increment = tick;
+
+    if (qAbs(drift) >= CLOCK_DRIFT_RESYNC)
+    {
+        // the show may be held for several ticks: count the event once
+        if (m_clockResyncing == false)
+        {
+            qDebug() << "[ShowRunner] clock drift of" << drift << "ms, resyncing";
+            m_clockCorrections++;
+            m_clockResyncing = true;
+        }
+
+        // never move the show time backwards, just hold it
+        increment = qMax(qint64(0), tick + drift);
+    }
+    else
+    {
+        m_clockResyncing = false;
+
+        // slew the show time of at most a quarter of tick
+        if (qAbs(drift) > CLOCK_DRIFT_DEADBAND)
+            increment = tick + qBound(-tick / 4, drift, tick / 4);
+    }
+
+    if (int(drift) != m_clockDrift)
+    {
+        m_clockDrift = int(drift);
+        m_maxClockDrift = qMax(m_maxClockDrift, qAbs(m_clockDrift));
+        emit clockDriftChanged(m_clockDrift);
+    }
+
+    return quint32(increment);
+}
+
+void ShowRunner::seekBackward(quint32 time)
+{
+    qDebug() << "[ShowRunner] clock moved back to" << time << "ms, seeking";
+
+    // the running time-based Functions are removed by the MasterTimer
+    // within this tick, then started again from the next one
+    for (int i = m_runningQueue.count() - 1; i >= 0; i--)
+    {
+        Function *f = m_runningQueue.at(i).first;
+        if (f->tempoType() != Function::Time)
+            continue;
+
+        f->stop(functionParent());
+        m_runningQueue.removeAt(i);
+    }
+    m_clockMaster = NULL;
+
+    // consider again the Functions already played or skipped at start
+    m_timeFunctions.clear();
+    foreach (Track *track, m_show->tracks())
+    {
+        if (track == NULL || track->id() == Track::invalidId() || track->isMute())
+            continue;
+
+        foreach (ShowFunction *sfunc, track->showFunctions())
+        {
+            if (sfunc->startTime() + sfunc->duration(m_doc) <= time)
+                continue;
+
+            Function *f = m_doc->function(sfunc->functionID());
+            if (f != NULL && f->tempoType() == Function::Time)
+                m_timeFunctions.append(sfunc);
+        }
+    }
+    std::sort(m_timeFunctions.begin(), m_timeFunctions.end(), compareShowFunctions);
+
+    m_currentTimeFunctionIndex = 0;
+    m_elapsedTime = time;
+    m_clockCorrections++;
+    m_clockResyncing = false;
+}
+
 /************************************************************************
  * Intensity
  ************************************************************************/
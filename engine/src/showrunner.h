@@ -28,6 +28,7 @@
 
 class ShowFunction;
 class Function;
+class Audio;
 class Track;
 class Show;
 class Doc;
@@ -95,6 +96,71 @@ signals:
     void timeChanged(quint32 time);
     void showFinished();
 
+    /************************************************************************
+     * Audio clock
+     ************************************************************************/
+public:
+    /**
+     * Enable/disable the slaving of the show time to the playback position
+     * of the first time-based Audio function played by the show.
+     * Small drifts are corrected by slightly speeding up or slowing down
+     * the show time, large ones by jumping straight to the audio position.
+     */
+    void setAudioClockSync(bool enable);
+    bool audioClockSync() const;
+
+    /**
+     * Enable/disable the chase of the external timecode tracked by
+     * InputOutputMap. The show time follows the timecode position minus
+     * $offset with the same drift correction of the audio clock, and
+     * holds while the timecode is stopped. A timecode moving back (e.g.
+     * a locate) restarts the show from the new position. Timecode takes
+     * precedence over the audio clock when both are enabled.
+     */
+    void setTimecodeSync(bool enable, int offset = 0);
+    bool timecodeSync() const;
+
+    /** Return the last measured drift in ms between the clock master and the show time */
+    int clockDrift() const;
+
+    /** Return the largest absolute drift in ms measured since the runner start */
+    int maxClockDrift() const;
+
+    /** Return the number of times the show time had to be resynced to
+     *  the clock master. A resync held over several ticks counts once */
+    int clockCorrections() const;
+
+private:
+    /** Return the time increment of the current tick, corrected against the clock master */
+    quint32 clockIncrement();
+
+    /** Return the time increment of the current tick for a clock master
+     *  at $position, updating the drift statistics */
+    quint32 followClock(qint64 position);
+
+    /** Move the show time back to $time. The running time-based Functions
+     *  are stopped and the ones not ended at $time are played again */
+    void seekBackward(quint32 time);
+
+signals:
+    void clockDriftChanged(int drift);
+
+private:
+    bool m_audioClockSync;
+
+    bool m_timecodeSync;
+    int m_timecodeOffset;
+
+    /** The Audio function the show time follows, and its show start time */
+    Audio *m_clockMaster;
+    quint32 m_clockMasterStartTime;
+
+    int m_clockDrift;
+    int m_maxClockDrift;
+    int m_clockCorrections;
+    /** True while the drift is above the resync threshold */
+    bool m_clockResyncing;
+
     /************************************************************************
      * Intensity
      ************************************************************************/
@@ -55,6 +55,8 @@ Universe::Universe(quint32 id, GrandMaster *gm, QObject *parent)
     , m_fbPatch(NULL)
     , m_channelsMask(new QByteArray(UNIVERSE_SIZE, char(0)))
     , m_modifiedZeroValues(new QByteArray(UNIVERSE_SIZE, char(0)))
+    , m_tickSerial(0)
+    , m_frameSerial(0)
     , m_running(false)
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
     , m_fadersMutex(QMutex::Recursive)
@@ -303,9 +305,11 @@ void Universe::setFaderFadeOut(int fadeTime)
     }
 }
 
-void Universe::tick()
+quint32 Universe::tick()
 {
+    quint32 serial = quint32(m_tickSerial.fetchAndAddOrdered(1)) + 1;
     m_semaphore.release(1);
+    return serial;
 }
 
 void Universe::processFaders()
@@ -367,6 +371,10 @@ void Universe::run()
             qDebug() << "<<<<<<<< UNIVERSE TICK - id" << id() << "faders:" << m_faders.count();
 #endif
         processFaders();
+
+        // semaphore releases are consumed in order, so this is
+        // the serial returned by the matching tick() call
+        emit frameProcessed(id(), ++m_frameSerial);
     }
 
     qDebug() << "Universe thread stopped" << id();
@@ -1144,6 +1152,19 @@ bool Universe::loadXML(QXmlStreamReader &root, int index, InputOutputMap *ioMap)
             // apply the parameters just loaded
             ioMap->setOutputPatch(index, plugin, outputUID, outputLine, false, outputIndex);
 
+            OutputPatch *op = outputPatch(outputIndex);
+            if (op != NULL)
+            {
+                if (pAttrs.hasAttribute(KXMLQLCOutputPatchFrameRate))
+                    op->setMaxFrameRate(pAttrs.value(KXMLQLCOutputPatchFrameRate).toString().toInt());
+                if (pAttrs.hasAttribute(KXMLQLCOutputPatchKeepAlive))
+                    op->setKeepAliveInterval(pAttrs.value(KXMLQLCOutputPatchKeepAlive).toString().toInt());
+                if (pAttrs.hasAttribute(KXMLQLCOutputPatchBurst))
+                    op->setBurstSize(pAttrs.value(KXMLQLCOutputPatchBurst).toString().toInt());
+                if (pAttrs.hasAttribute(KXMLQLCOutputPatchAsync))
+                    op->setAsyncDispatch(pAttrs.value(KXMLQLCOutputPatchAsync).toString().toInt() != 0);
+            }
+
             QXmlStreamReader::TokenType tType = root.readNext();
             if (tType == QXmlStreamReader::Characters)
                 tType = root.readNext();
@@ -1251,7 +1272,7 @@ bool Universe::saveXML(QXmlStreamWriter *doc) const
     foreach (OutputPatch *op, m_outputPatchList)
     {
         savePatchXML(doc, KXMLQLCUniverseOutputPatch, op->pluginName(), op->outputName(),
-            op->output(), "", op->getPluginParameters());
+            op->output(), "", op->getPluginParameters(), op);
     }
     if (feedbackPatch() != NULL)
     {
@@ -1272,7 +1293,8 @@ void Universe::savePatchXML(
     const QString &lineName,
     quint32 line,
     QString profileName,
-    QMap<QString, QVariant> parameters) const
+    QMap<QString, QVariant> parameters,
+    const OutputPatch *outputPatch) const
 {
     // sanity check: don't save invalid data
     if (pluginName.isEmpty() || pluginName == KInputNone || line == QLCIOPlugin::invalidLine())
@@ -1285,6 +1307,16 @@ void Universe::savePatchXML(
     if (!profileName.isEmpty() && profileName != KInputNone)
         doc->writeAttribute(KXMLQLCUniverseProfileName, profileName);
 
+    if (outputPatch != NULL && outputPatch->isScheduled())
+    {
+        doc->writeAttribute(KXMLQLCOutputPatchFrameRate, QString::number(outputPatch->maxFrameRate()));
+        doc->writeAttribute(KXMLQLCOutputPatchKeepAlive, QString::number(outputPatch->keepAliveInterval()));
+        doc->writeAttribute(KXMLQLCOutputPatchBurst, QString::number(outputPatch->burstSize()));
+    }
+
+    if (outputPatch != NULL && outputPatch->asyncDispatch() != OutputPatch::defaultAsyncDispatch())
+        doc->writeAttribute(KXMLQLCOutputPatchAsync, outputPatch->asyncDispatch() ? "1" : "0");
+
     savePluginParametersXML(doc, parameters);
     doc->writeEndElement();
 }
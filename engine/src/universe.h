@@ -23,6 +23,7 @@
 
 #include <QScopedPointer>
 #include <QSemaphore>
+#include <QAtomicInt>
 #include <QByteArray>
 #include <QThread>
 #include <QSet>
@@ -360,7 +361,9 @@ public:
     void setFaderFadeOut(int fadeTime);
 
 public slots:
-    void tick();
+    /** Schedule the processing of a new frame. Returns the serial
+     *  number that frameProcessed will report for that frame */
+    quint32 tick();
 
 protected:
     void processFaders();
@@ -371,9 +374,17 @@ protected:
 signals:
     void universeWritten(quint32 universeID, const QByteArray& universeData);
 
+    /** Emitted from the writer thread once the data of a tick has been dumped.
+     *  @a frame is the serial number returned by the matching tick() call */
+    void frameProcessed(quint32 universe, quint32 frame);
+
 protected:
     QSemaphore m_semaphore;
 
+    /** Serial number of the last requested and the last processed frame */
+    QAtomicInt m_tickSerial;
+    quint32 m_frameSerial;
+
     /** Indicated if the DMX writer worker thread is running */
     bool m_running;
 
@@ -612,13 +623,15 @@ public:
      * @param line
      * @param profileName
      * @param parameters
+     * @param outputPatch the output patch to save the frame scheduling of, if any
      */
     void savePatchXML(QXmlStreamWriter *doc,
         QString const & tag,
         QString const & pluginName, const QString &lineName,
         quint32 line,
         QString profileName,
-        QMap<QString, QVariant>parameters) const;
+        QMap<QString, QVariant>parameters,
+        const OutputPatch *outputPatch = NULL) const;
 
     /**
      * Save a plugin custom parameters (if available) into a tag nested
@@ -0,0 +1,93 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiodecoder_stub.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <cstring>
+
+#include "audiodecoder_stub.h"
+
+AudioDecoder_Stub::AudioDecoder_Stub(quint32 sampleRate, int channels, AudioFormat format,
+                                     QByteArray const& pcm, int chunkSize)
+    : m_pcm(pcm)
+    , m_chunkSize(chunkSize)
+    , m_position(0)
+    , m_readCalls(0)
+{
+    configure(sampleRate, channels, format);
+}
+
+AudioDecoder_Stub::~AudioDecoder_Stub()
+{
+}
+
+AudioDecoder *AudioDecoder_Stub::createCopy()
+{
+    AudioParameters ap = audioParameters();
+    return new AudioDecoder_Stub(ap.sampleRate(), ap.channels(), ap.format(), m_pcm, m_chunkSize);
+}
+
+int AudioDecoder_Stub::priority() const
+{
+    return 0;
+}
+
+QStringList AudioDecoder_Stub::supportedFormats()
+{
+    return QStringList();
+}
+
+bool AudioDecoder_Stub::initialize(const QString &path)
+{
+    Q_UNUSED(path)
+    return true;
+}
+
+qint64 AudioDecoder_Stub::totalTime()
+{
+    AudioParameters ap = audioParameters();
+    qint64 frameBytes = ap.channels() * ap.sampleSize();
+
+    return (m_pcm.size() / frameBytes) * 1000 / ap.sampleRate();
+}
+
+void AudioDecoder_Stub::seek(qint64 time)
+{
+    AudioParameters ap = audioParameters();
+    qint64 frameBytes = ap.channels() * ap.sampleSize();
+
+    m_position = qBound(qint64(0), time * ap.sampleRate() / 1000 * frameBytes, qint64(m_pcm.size()));
+}
+
+qint64 AudioDecoder_Stub::read(char *data, qint64 maxSize)
+{
+    m_readCalls++;
+
+    qint64 length = qMin(qMin(maxSize, qint64(m_chunkSize)), qint64(m_pcm.size()) - m_position);
+    if (length <= 0)
+        return 0;
+
+    memcpy(data, m_pcm.constData() + m_position, length);
+    m_position += length;
+
+    return length;
+}
+
+int AudioDecoder_Stub::bitrate()
+{
+    return 0;
+}
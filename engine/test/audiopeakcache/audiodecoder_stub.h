@@ -0,0 +1,56 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiodecoder_stub.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef AUDIODECODER_STUB_H
+#define AUDIODECODER_STUB_H
+
+#include <QByteArray>
+
+#include "audiodecoder.h"
+
+/**
+ * A decoder returning the PCM data it has been given, in chunks
+ * of at most $chunkSize bytes, so that reads can end in the middle
+ * of an audio frame.
+ */
+class AudioDecoder_Stub final : public AudioDecoder
+{
+public:
+    AudioDecoder_Stub(quint32 sampleRate, int channels, AudioFormat format,
+                      QByteArray const& pcm, int chunkSize = 1000);
+    ~AudioDecoder_Stub();
+
+    AudioDecoder *createCopy() override;
+    int priority() const override;
+    QStringList supportedFormats() override;
+    bool initialize(const QString &path) override;
+    qint64 totalTime() override;
+    void seek(qint64 time) override;
+    qint64 read(char *data, qint64 maxSize) override;
+    int bitrate() override;
+
+    QByteArray m_pcm;
+    int m_chunkSize;
+    qint64 m_position;
+
+    /** Number of calls to read() */
+    int m_readCalls;
+};
+
+#endif
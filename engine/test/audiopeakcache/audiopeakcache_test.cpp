@@ -0,0 +1,230 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiopeakcache_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QStandardPaths>
+#include <QtTest>
+#include <cstring>
+
+#include "audiopeakcache_test.h"
+#include "audiodecoder_stub.h"
+#include "audiopeakcache.h"
+
+#define TEST_SAMPLE_RATE    44100
+#define TEST_CHANNELS       2
+/** 4 blocks of the finest peak level */
+#define TEST_FRAMES         1024
+#define TEST_BLOCK_FRAMES   256
+
+/** Offset of the version field in the peak file header */
+#define VERSION_OFFSET      8
+
+/** Peak amplitude of the left channel in block $b, 16 bit scale */
+static qint16 amplitude(int block)
+{
+    return qint16(2560 * (block + 1));
+}
+
+void AudioPeakCache_Test::initTestCase()
+{
+    // keep the peak files away from the user cache directory
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(m_dir.isValid());
+    m_source = m_dir.filePath("source.wav");
+}
+
+void AudioPeakCache_Test::init()
+{
+    QFile::remove(AudioPeakCache::peakFilePath(m_source));
+
+    QFile file(m_source);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("RIFF0000WAVE");
+    file.close();
+}
+
+QByteArray AudioPeakCache_Test::pcmData(AudioFormat format, int frames)
+{
+    int sampleSize = AudioParameters::sampleSize(format);
+    QByteArray pcm(frames * TEST_CHANNELS * sampleSize, 0);
+    char *ptr = pcm.data();
+
+    for (int f = 0; f < frames; f++)
+    {
+        qint16 amp = amplitude(f / TEST_BLOCK_FRAMES);
+
+        // left swings between -amp and amp, right between 0 and amp / 2
+        qint16 values[TEST_CHANNELS] = { qint16(f % 2 ? amp : -amp), qint16(f % 2 ? amp / 2 : 0) };
+
+        for (int c = 0; c < TEST_CHANNELS; c++, ptr += sampleSize)
+        {
+            switch (format)
+            {
+                case PCM_S8:
+                    *ptr = char(qint8(values[c] / 256));
+                break;
+                case PCM_S24LE:
+                {
+                    qint32 value = qint32(values[c]) * 256;
+                    memcpy(ptr, &value, sizeof(value));
+                }
+                break;
+                case PCM_S32LE:
+                {
+                    qint32 value = qint32(values[c]) * 65536;
+                    memcpy(ptr, &value, sizeof(value));
+                }
+                break;
+                default:
+                    memcpy(ptr, &values[c], sizeof(values[c]));
+                break;
+            }
+        }
+    }
+
+    return pcm;
+}
+
+bool AudioPeakCache_Test::buildS16()
+{
+    AudioDecoder_Stub decoder(TEST_SAMPLE_RATE, TEST_CHANNELS, PCM_S16LE,
+                              pcmData(PCM_S16LE, TEST_FRAMES));
+    return AudioPeakCache::build(&decoder, m_source);
+}
+
+void AudioPeakCache_Test::build_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("S8") << int(PCM_S8);
+    QTest::newRow("S16LE") << int(PCM_S16LE);
+    QTest::newRow("S24LE") << int(PCM_S24LE);
+    QTest::newRow("S32LE") << int(PCM_S32LE);
+}
+
+void AudioPeakCache_Test::build()
+{
+    QFETCH(int, format);
+
+    AudioDecoder_Stub decoder(TEST_SAMPLE_RATE, TEST_CHANNELS, AudioFormat(format),
+                              pcmData(AudioFormat(format), TEST_FRAMES));
+    QVERIFY(AudioPeakCache::build(&decoder, m_source) == true);
+    QVERIFY(decoder.m_readCalls > 1);
+    QCOMPARE(decoder.m_position, qint64(0)); // rewound
+
+    AudioPeakCache cache;
+    QVERIFY(cache.isValid() == false);
+    QVERIFY(cache.open(m_source) == true);
+    QVERIFY(cache.isValid() == true);
+    QCOMPARE(cache.channels(), TEST_CHANNELS);
+    QCOMPARE(cache.sampleRate(), quint32(TEST_SAMPLE_RATE));
+    QCOMPARE(cache.frames(), quint64(TEST_FRAMES));
+
+    // one column per block of the finest level
+    QVector<AudioPeakCache::Peak> peaks;
+    QVERIFY(cache.peaks(0, TEST_FRAMES, 4, peaks) == true);
+    QCOMPARE(peaks.count(), 4 * TEST_CHANNELS);
+    for (int b = 0; b < 4; b++)
+    {
+        QCOMPARE(peaks.at(b * TEST_CHANNELS).min, qint16(-amplitude(b)));
+        QCOMPARE(peaks.at(b * TEST_CHANNELS).max, amplitude(b));
+        QCOMPARE(peaks.at(b * TEST_CHANNELS + 1).min, qint16(0));
+        QCOMPARE(peaks.at(b * TEST_CHANNELS + 1).max, qint16(amplitude(b) / 2));
+    }
+
+    // a range in the middle
+    QVERIFY(cache.peaks(TEST_BLOCK_FRAMES, TEST_BLOCK_FRAMES * 2, 2, peaks) == true);
+    QCOMPARE(peaks.count(), 2 * TEST_CHANNELS);
+    QCOMPARE(peaks.at(0).max, amplitude(1));
+    QCOMPARE(peaks.at(TEST_CHANNELS).max, amplitude(2));
+
+    // a single column is read from the coarsest level
+    QVERIFY(cache.peaks(0, TEST_FRAMES, 1, peaks) == true);
+    QCOMPARE(peaks.count(), TEST_CHANNELS);
+    QCOMPARE(peaks.at(0).min, qint16(-amplitude(3)));
+    QCOMPARE(peaks.at(0).max, amplitude(3));
+    QCOMPARE(peaks.at(1).min, qint16(0));
+    QCOMPARE(peaks.at(1).max, qint16(amplitude(3) / 2));
+
+    QVERIFY(cache.peaks(0, TEST_FRAMES, 0, peaks) == false);
+    QVERIFY(cache.peaks(0, 0, 4, peaks) == false);
+
+    cache.close();
+    QVERIFY(cache.isValid() == false);
+    QCOMPARE(cache.channels(), 0);
+}
+
+void AudioPeakCache_Test::emptySource()
+{
+    AudioDecoder_Stub decoder(TEST_SAMPLE_RATE, TEST_CHANNELS, PCM_S16LE, QByteArray());
+    QVERIFY(AudioPeakCache::build(&decoder, m_source) == false);
+    QVERIFY(AudioPeakCache::build(NULL, m_source) == false);
+
+    AudioPeakCache cache;
+    QVERIFY(cache.open(m_source) == false);
+}
+
+void AudioPeakCache_Test::rejectVersion()
+{
+    QVERIFY(buildS16() == true);
+
+    QFile file(AudioPeakCache::peakFilePath(m_source));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(VERSION_OFFSET));
+    quint32 version = 99;
+    file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    file.close();
+
+    AudioPeakCache cache;
+    QVERIFY(cache.open(m_source) == false);
+    QVERIFY(cache.isValid() == false);
+}
+
+void AudioPeakCache_Test::rejectTruncated()
+{
+    QVERIFY(buildS16() == true);
+
+    QFile file(AudioPeakCache::peakFilePath(m_source));
+    QVERIFY(file.resize(file.size() / 2));
+
+    AudioPeakCache cache;
+    QVERIFY(cache.open(m_source) == false);
+
+    QVERIFY(file.resize(16));
+    QVERIFY(cache.open(m_source) == false);
+}
+
+void AudioPeakCache_Test::rejectSourceChanged()
+{
+    QVERIFY(buildS16() == true);
+
+    AudioPeakCache cache;
+    QVERIFY(cache.open(m_source) == true);
+    cache.close();
+
+    // a different size means the peaks are outdated
+    QFile file(m_source);
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("more data");
+    file.close();
+
+    QVERIFY(cache.open(m_source) == false);
+}
+
+QTEST_GUILESS_MAIN(AudioPeakCache_Test)
@@ -0,0 +1,55 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiopeakcache_test.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef AUDIOPEAKCACHE_TEST_H
+#define AUDIOPEAKCACHE_TEST_H
+
+#include <QTemporaryDir>
+#include <QObject>
+
+#include "audioparameters.h"
+
+class AudioPeakCache_Test final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void build_data();
+    void build();
+    void emptySource();
+    void rejectVersion();
+    void rejectTruncated();
+    void rejectSourceChanged();
+
+private:
+    /** Return $frames stereo frames of a known pattern in $format */
+    static QByteArray pcmData(AudioFormat format, int frames);
+
+    /** Build the peak file of m_source with S16LE data */
+    bool buildS16();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_source;
+};
+
+#endif
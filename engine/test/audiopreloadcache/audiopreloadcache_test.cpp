@@ -0,0 +1,153 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiopreloadcache_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#define private public
+#include "audiopreloadcache.h"
+#undef private
+
+#include "audiopreloadcache_test.h"
+#include "audiodecoder_stub.h"
+
+#define TEST_SAMPLE_RATE    1000
+#define TEST_CHANNELS       2
+
+/** Return $frames stereo S16LE frames, each byte being its offset */
+static QByteArray pcmData(int frames)
+{
+    QByteArray pcm(frames * TEST_CHANNELS * 2, 0);
+    for (int i = 0; i < pcm.size(); i++)
+        pcm[i] = char(i & 0xFF);
+    return pcm;
+}
+
+static AudioDecoder *newDecoder(int frames)
+{
+    return new AudioDecoder_Stub(TEST_SAMPLE_RATE, TEST_CHANNELS, PCM_S16LE, pcmData(frames));
+}
+
+void AudioPreloadCache_Test::lazyStart()
+{
+    AudioPreloadCache cache(NULL);
+    QVERIFY(cache.isRunning() == false);
+
+    QVERIFY(cache.acquire("a.wav", NULL) == false);
+    QVERIFY(cache.isRunning() == false);
+    QVERIFY(cache.m_refCounts.isEmpty() == true);
+
+    QVERIFY(cache.acquire("a.wav", newDecoder(100)) == true);
+    QVERIFY(cache.isRunning() == true);
+}
+
+void AudioPreloadCache_Test::acquireRelease()
+{
+    AudioPreloadCache cache(NULL);
+    QSignalSpy spy(&cache, SIGNAL(preloaded(QString)));
+
+    // two functions using the same file
+    QVERIFY(cache.acquire("a.wav", newDecoder(1000)) == true);
+    QVERIFY(cache.acquire("a.wav", newDecoder(1000)) == true);
+    QCOMPARE(cache.m_refCounts.value("a.wav"), 2);
+
+    QTRY_VERIFY(cache.buffer("a.wav").isNull() == false);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(cache.memoryUsage(), qint64(1000 * TEST_CHANNELS * 2));
+
+    // the first one goes away: the other one keeps the data
+    cache.release("a.wav");
+    QVERIFY(cache.buffer("a.wav").isNull() == false);
+    QCOMPARE(cache.memoryUsage(), qint64(1000 * TEST_CHANNELS * 2));
+
+    // data taken before the last release stays valid
+    QSharedPointer<PreloadedAudio> audio = cache.buffer("a.wav");
+
+    cache.release("a.wav");
+    QVERIFY(cache.buffer("a.wav").isNull() == true);
+    QCOMPARE(cache.memoryUsage(), qint64(0));
+    QVERIFY(cache.m_refCounts.contains("a.wav") == false);
+    QCOMPARE(audio->pcm, pcmData(1000));
+
+    // unbalanced releases are ignored
+    cache.release("a.wav");
+    QVERIFY(cache.m_refCounts.contains("a.wav") == false);
+
+    // acquiring again decodes again
+    QVERIFY(cache.acquire("a.wav", newDecoder(1000)) == true);
+    QTRY_VERIFY(cache.buffer("a.wav").isNull() == false);
+    QCOMPARE(spy.count(), 2);
+}
+
+void AudioPreloadCache_Test::releaseWhileQueued()
+{
+    AudioPreloadCache cache(NULL);
+
+    QVERIFY(cache.acquire("a.wav", newDecoder(1000)) == true);
+    QVERIFY(cache.acquire("b.wav", newDecoder(1000)) == true);
+    cache.release("b.wav");
+
+    QVERIFY(cache.acquire("c.wav", newDecoder(1000)) == true);
+
+    // requests are decoded in order, so b.wav has been dropped by then
+    QTRY_VERIFY(cache.buffer("c.wav").isNull() == false);
+    QVERIFY(cache.buffer("a.wav").isNull() == false);
+    QVERIFY(cache.buffer("b.wav").isNull() == true);
+    QCOMPARE(cache.memoryUsage(), qint64(2 * 1000 * TEST_CHANNELS * 2));
+}
+
+void AudioPreloadCache_Test::memoryBudget()
+{
+    AudioPreloadCache cache(NULL);
+    cache.setMemoryBudget(1000 * TEST_CHANNELS * 2);
+    QCOMPARE(cache.memoryBudget(), qint64(1000 * TEST_CHANNELS * 2));
+
+    QVERIFY(cache.acquire("big.wav", newDecoder(2000)) == true);
+    QVERIFY(cache.acquire("small.wav", newDecoder(500)) == true);
+
+    QTRY_VERIFY(cache.buffer("small.wav").isNull() == false);
+    QVERIFY(cache.buffer("big.wav").isNull() == true);
+    QCOMPARE(cache.memoryUsage(), qint64(500 * TEST_CHANNELS * 2));
+
+    // still referenced, even if played from disk
+    QCOMPARE(cache.m_refCounts.value("big.wav"), 1);
+}
+
+void AudioPreloadCache_Test::preloadedDecoder()
+{
+    AudioPreloadCache cache(NULL);
+
+    QVERIFY(cache.acquire("a.wav", newDecoder(1000)) == true);
+    QTRY_VERIFY(cache.buffer("a.wav").isNull() == false);
+
+    PreloadedAudioDecoder decoder(cache.buffer("a.wav"));
+    QCOMPARE(decoder.audioParameters().sampleRate(), quint32(TEST_SAMPLE_RATE));
+    QCOMPARE(decoder.audioParameters().channels(), TEST_CHANNELS);
+    QCOMPARE(decoder.totalTime(), qint64(1000));
+
+    // seek on the exact frame: 250 ms are 250 frames of 4 bytes
+    char data[8];
+    decoder.seek(250);
+    QCOMPARE(decoder.read(data, sizeof(data)), qint64(sizeof(data)));
+    QCOMPARE(uchar(data[0]), uchar((250 * 4) & 0xFF));
+
+    decoder.seek(2000);
+    QCOMPARE(decoder.read(data, sizeof(data)), qint64(0));
+}
+
+QTEST_GUILESS_MAIN(AudioPreloadCache_Test)
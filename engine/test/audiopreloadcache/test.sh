@@ -0,0 +1,4 @@
+#!/bin/sh
+export LD_LIBRARY_PATH=../../src
+export DYLD_FALLBACK_LIBRARY_PATH=../../src
+./audiopreloadcache_test
@@ -0,0 +1,175 @@
+/*
+  Q Light Controller Plus - Unit test
+  beatphasetracker_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#include "beatphasetracker_test.h"
+#include "beatphasetracker.h"
+
+#define MS 1000000LL
+
+void BeatPhaseTracker_Test::initial()
+{
+    BeatPhaseTracker bt;
+    QCOMPARE(bt.isLocked(0), false);
+    QCOMPARE(bt.confidence(), 0.0);
+    QCOMPARE(bt.bpm(), 0.0);
+    QCOMPARE(bt.period(), qint64(0));
+    QCOMPARE(bt.phase(1000 * MS), 0.0);
+    QCOMPARE(bt.predictBeat(1000 * MS), qint64(-1));
+}
+
+void BeatPhaseTracker_Test::lock()
+{
+    BeatPhaseTracker bt;
+    qint64 t = 1000 * MS;
+
+    bt.addOnset(t);
+    QCOMPARE(bt.isLocked(t), false);
+
+    // second onset seeds the period
+    t += 500 * MS;
+    bt.addOnset(t);
+    QCOMPARE(bt.period(), 500 * MS);
+    QCOMPARE(bt.bpm(), 120.0);
+    QCOMPARE(bt.isLocked(t), false);
+
+    for (int i = 0; i < 4; i++)
+    {
+        t += 500 * MS;
+        bt.addOnset(t);
+    }
+
+    QVERIFY(bt.isLocked(t) == true);
+    QVERIFY(bt.confidence() > 0.5);
+    QCOMPARE(bt.phase(t), 0.0);
+    QVERIFY(qAbs(bt.phase(t + 250 * MS) - 0.5) < 0.001);
+
+    bt.reset();
+    QCOMPARE(bt.isLocked(t), false);
+    QCOMPARE(bt.period(), qint64(0));
+}
+
+void BeatPhaseTracker_Test::jitter()
+{
+    BeatPhaseTracker bt;
+    qint64 t = 0;
+    // onsets quantised to audio blocks / event loop delivery
+    int jitter[] = { 0, 12, -8, 15, -3, 9, -14, 4, 11, -10, 6, -5, 13, -7, 2, -12 };
+
+    for (int i = 0; i < 64; i++)
+        bt.addOnset(t + i * 480 * MS + jitter[i % 16] * MS);
+
+    t = 63 * 480 * MS;
+    QVERIFY(bt.isLocked(t) == true);
+    QVERIFY(qAbs(bt.bpm() - 125.0) < 1.0);
+}
+
+void BeatPhaseTracker_Test::prediction()
+{
+    BeatPhaseTracker bt;
+
+    for (int i = 0; i < 8; i++)
+        bt.addOnset(i * 400 * MS);
+
+    qint64 last = 7 * 400 * MS;
+
+    // the first beat following (or at) a given time
+    QCOMPARE(bt.predictBeat(last), last);
+    QCOMPARE(bt.predictBeat(last + 1), last + 400 * MS);
+    QCOMPARE(bt.predictBeat(last + 100 * MS), last + 400 * MS);
+    QCOMPARE(bt.predictBeat(last + 100 * MS, 1), last + 800 * MS);
+    QCOMPARE(bt.predictBeat(last + 100 * MS, 3), last + 1600 * MS);
+}
+
+void BeatPhaseTracker_Test::outliers()
+{
+    BeatPhaseTracker bt;
+
+    for (int i = 0; i < 8; i++)
+        bt.addOnset(i * 500 * MS);
+
+    qint64 t = 7 * 500 * MS;
+    double confidence = bt.confidence();
+
+    // a single off-beat onset lowers the confidence but doesn't move the grid
+    bt.addOnset(t + 250 * MS);
+    QVERIFY(bt.confidence() < confidence);
+    QCOMPARE(bt.period(), 500 * MS);
+    QCOMPARE(bt.predictBeat(t + 300 * MS), t + 500 * MS);
+
+    // back on the beat, confidence rises again
+    confidence = bt.confidence();
+    bt.addOnset(t + 500 * MS);
+    QVERIFY(bt.confidence() > confidence);
+    QCOMPARE(bt.period(), 500 * MS);
+}
+
+void BeatPhaseTracker_Test::tempoChange()
+{
+    BeatPhaseTracker bt;
+    qint64 t = 0;
+
+    for (int i = 0; i < 8; i++, t += 500 * MS)
+        bt.addOnset(t);
+
+    QVERIFY(qAbs(bt.bpm() - 120.0) < 0.1);
+
+    // a sudden switch to 90 BPM makes the loop re-seed
+    for (int i = 0; i < 10; i++, t += 666 * MS)
+        bt.addOnset(t);
+
+    QVERIFY(qAbs(bt.bpm() - 90.0) < 1.0);
+    QVERIFY(bt.isLocked(t - 666 * MS) == true);
+
+    // a slow tempo drift is followed without losing the lock
+    qint64 period = 666 * MS;
+    for (int i = 0; i < 40; i++)
+    {
+        period -= 2 * MS;
+        t += period;
+        bt.addOnset(t);
+        QVERIFY(bt.isLocked(t) == true);
+    }
+    QVERIFY(qAbs(bt.period() - period) < 10 * MS);
+}
+
+void BeatPhaseTracker_Test::freewheel()
+{
+    BeatPhaseTracker bt;
+
+    for (int i = 0; i < 8; i++)
+        bt.addOnset(i * 500 * MS);
+
+    qint64 last = 7 * 500 * MS;
+
+    // the loop keeps running for a while without onsets
+    QVERIFY(bt.isLocked(last + 3000 * MS) == true);
+    QCOMPARE(bt.predictBeat(last + 3000 * MS), last + 3000 * MS);
+
+    // then gives up
+    QVERIFY(bt.isLocked(last + 4000 * MS) == false);
+
+    // an onset after a long silence starts over
+    bt.addOnset(last + 10000 * MS);
+    QVERIFY(bt.isLocked(last + 10000 * MS) == false);
+    QCOMPARE(bt.period(), qint64(0));
+}
+
+QTEST_APPLESS_MAIN(BeatPhaseTracker_Test)
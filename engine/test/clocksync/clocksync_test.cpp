@@ -0,0 +1,218 @@
+/*
+  Q Light Controller Plus - Unit test
+  clocksync_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#include "clocksync_test.h"
+#include "clocksync.h"
+
+#define MS 1000000LL
+
+/** Pulse period of a 120 BPM clock, in ns */
+#define PULSE_120 (500 * MS / 24)
+
+void ClockSync_Test::initial()
+{
+    ClockSync cs;
+    QCOMPARE(cs.isClockLocked(0), false);
+    QCOMPARE(cs.isClockRunning(), false);
+    QCOMPARE(cs.clockBpm(), 0.0);
+    QCOMPARE(cs.clockPosition(0), 0.0);
+    QCOMPARE(cs.isTimecodeLocked(0), false);
+    QCOMPARE(cs.timecodePosition(0), qint64(-1));
+    QVERIFY(ClockSync::now() > 0);
+}
+
+void ClockSync_Test::clockLock()
+{
+    ClockSync cs;
+    qint64 t = 1000 * MS;
+
+    // the first pulse is always a beat
+    QCOMPARE(cs.clockPulse(t), t);
+    QCOMPARE(cs.isClockLocked(t), false);
+
+    // beats every 24 pulses
+    for (int i = 1; i < 24; i++)
+        QCOMPARE(cs.clockPulse(t + i * PULSE_120), qint64(-1));
+    QVERIFY(qAbs(cs.clockBpm() - 120.0) < 0.001);
+    QCOMPARE(cs.isClockLocked(t + 23 * PULSE_120), false);
+
+    QCOMPARE(cs.clockPulse(t + 24 * PULSE_120), t + 24 * PULSE_120);
+
+    for (int i = 25; i < 48; i++)
+        cs.clockPulse(t + i * PULSE_120);
+    QCOMPARE(cs.isClockLocked(t + 47 * PULSE_120), true);
+
+    cs.reset();
+    QCOMPARE(cs.isClockLocked(t + 47 * PULSE_120), false);
+    QCOMPARE(cs.clockBpm(), 0.0);
+}
+
+void ClockSync_Test::clockJitter()
+{
+    ClockSync cs;
+    qint64 t = 0;
+    // pulses delayed by the USB transport and the event loop
+    int jitter[] = { 0, 900, -400, 700, -150, 450, -700, 200, 550, -500, 300, -250, 650, -350, 100, -600 };
+    double maxError = 0;
+
+    for (int i = 0; i < 24 * 32; i++)
+    {
+        qint64 pulse = t + i * PULSE_120;
+        qint64 beat = cs.clockPulse(pulse + jitter[i % 16] * 1000);
+
+        // once settled, filtered beats are far more accurate than single pulses
+        if (beat >= 0 && i >= 24 * 8)
+            maxError = qMax(maxError, qAbs(double(beat - pulse)));
+    }
+
+    QVERIFY(cs.isClockLocked(24 * 32 * PULSE_120) == true);
+    QVERIFY(qAbs(cs.clockBpm() - 120.0) < 0.5);
+    QVERIFY(maxError < 0.5 * MS);
+
+    // a tempo change makes the loop re-seed and lock again
+    t = 24 * 32 * PULSE_120;
+    qint64 period = 60000 * MS / (140 * 24);
+    for (int i = 0; i < 24 * 4; i++)
+        cs.clockPulse(t + i * period + jitter[i % 16] * 1000);
+
+    QVERIFY(cs.isClockLocked(t + 24 * 4 * period) == true);
+    QVERIFY(qAbs(cs.clockBpm() - 140.0) < 0.5);
+}
+
+void ClockSync_Test::clockTransport()
+{
+    ClockSync cs;
+    qint64 t = 0;
+
+    for (int i = 0; i < 10; i++, t += PULSE_120)
+        cs.clockPulse(t);
+
+    // pulses before start don't move the song position
+    QCOMPARE(cs.clockPosition(t), 0.0);
+
+    cs.clockStart(t);
+    QCOMPARE(cs.isClockRunning(), true);
+
+    // beats are realigned to the start
+    QCOMPARE(cs.clockPulse(t), t);
+    t += PULSE_120;
+    for (int i = 1; i < 48; i++, t += PULSE_120)
+        cs.clockPulse(t);
+
+    // two quarter notes received, the last pulse being the 48th
+    QVERIFY(qAbs(cs.clockPosition(t - PULSE_120) - 47.0 / 24.0) < 0.001);
+    // the position is interpolated between the pulses
+    QVERIFY(qAbs(cs.clockPosition(t - PULSE_120 / 2) - 47.5 / 24.0) < 0.001);
+
+    // pulses received while stopped keep the tempo, not the position
+    cs.clockStop(t);
+    QCOMPARE(cs.isClockRunning(), false);
+    for (int i = 0; i < 5; i++, t += PULSE_120)
+        cs.clockPulse(t);
+    QCOMPARE(cs.clockPosition(t), 2.0);
+
+    // continue resumes the song and the beats from the stop position
+    cs.clockContinue(t);
+    QCOMPARE(cs.isClockRunning(), true);
+    QCOMPARE(cs.clockPulse(t), t);
+    t += PULSE_120;
+    for (int i = 1; i < 24; i++, t += PULSE_120)
+        QCOMPARE(cs.clockPulse(t), qint64(-1));
+    QCOMPARE(cs.clockPulse(t), t);
+    QVERIFY(qAbs(cs.clockPosition(t) - 3.0) < 0.001);
+}
+
+void ClockSync_Test::clockDropout()
+{
+    ClockSync cs;
+    qint64 t = 0;
+
+    for (int i = 0; i < 48; i++, t += PULSE_120)
+        cs.clockPulse(t);
+    t -= PULSE_120;
+
+    QVERIFY(cs.isClockLocked(t + 5 * PULSE_120) == true);
+    QVERIFY(cs.isClockLocked(t + 12 * PULSE_120) == false);
+
+    // the clock comes back after a while: start over
+    t += 1000 * MS;
+    cs.clockPulse(t);
+    QVERIFY(cs.isClockLocked(t) == false);
+    QCOMPARE(cs.clockBpm(), 0.0);
+}
+
+void ClockSync_Test::timecodeLock()
+{
+    ClockSync cs;
+    // 25 fps MTC quarter frames
+    qint64 qf = 10 * MS;
+    qint64 t = 5000 * MS;
+    int jitter[] = { 0, 800, -300, 500, -900, 200, 600, -100 };
+
+    for (int i = 0; i < 100; i++)
+        cs.timecode(60000 + i * 10, t + i * qf + jitter[i % 8] * 1000);
+
+    qint64 last = t + 99 * qf;
+    QCOMPARE(cs.isTimecodeLocked(last), true);
+    QVERIFY(qAbs(cs.timecodeRate() - 1.0) < 0.01);
+
+    // extrapolated between the quarter frames, with sub-ms accuracy
+    QVERIFY(qAbs(cs.timecodePosition(last + 5 * MS) - (60990 + 5)) <= 1);
+}
+
+void ClockSync_Test::timecodeLocate()
+{
+    ClockSync cs;
+    qint64 qf = 10 * MS;
+    qint64 t = 0;
+
+    for (int i = 0; i < 20; i++, t += qf)
+        cs.timecode(1000 + i * 10, t);
+    QCOMPARE(cs.isTimecodeLocked(t), true);
+
+    // a jump to another position relocks the tracker on it
+    cs.timecode(30000, t);
+    QCOMPARE(cs.isTimecodeLocked(t), false);
+    QCOMPARE(cs.timecodePosition(t), qint64(30000));
+
+    for (int i = 1; i < 10; i++)
+        cs.timecode(30000 + i * 10, t + i * qf);
+    QCOMPARE(cs.isTimecodeLocked(t + 9 * qf), true);
+    QVERIFY(qAbs(cs.timecodePosition(t + 9 * qf) - 30090) <= 1);
+}
+
+void ClockSync_Test::timecodeStop()
+{
+    ClockSync cs;
+    qint64 qf = 10 * MS;
+    qint64 t = 0;
+
+    for (int i = 0; i < 20; i++, t += qf)
+        cs.timecode(1000 + i * 10, t);
+    t -= qf;
+
+    // the position is held once the timecode stops
+    QCOMPARE(cs.isTimecodeLocked(t + 100 * MS), true);
+    QCOMPARE(cs.isTimecodeLocked(t + 300 * MS), false);
+    QCOMPARE(cs.timecodePosition(t + 300 * MS), qint64(1190));
+}
+
+QTEST_APPLESS_MAIN(ClockSync_Test)
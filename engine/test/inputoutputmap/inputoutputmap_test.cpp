@@ -16,7 +16,9 @@
   See the License for the specific language governing permissions and
   limitations under the License.
 */
+#include <QStandardPaths>
 #include <QSignalSpy>
+#include <QSettings>
 #include <QtTest>
 
 #define private public
@@ -47,6 +49,9 @@ static QDir testPluginDir()
 
 void InputOutputMap_Test::initTestCase()
 {
+    // keep the settings written by the tests away from the user ones
+    QStandardPaths::setTestModeEnabled(true);
+
     m_doc = new Doc(this);
     m_doc->ioPluginCache()->load(testPluginDir());
     QVERIFY(m_doc->ioPluginCache()->plugins().size() != 0);
@@ -860,4 +865,155 @@ void InputOutputMap_Test::grandMaster()
     QVERIFY(iom.grandMasterValueMode() == GrandMaster::Limit);
 }
 
+void InputOutputMap_Test::feedback()
+{
+    // native settings (macOS, Windows) ignore the test mode
+    QVariant savedInterval = QSettings().value(SETTINGS_FEEDBACK_INTERVAL);
+
+    InputOutputMap iom(m_doc, 4);
+    iom.setFeedbackInterval(20);
+
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    stub->m_feedbackBatches.clear();
+
+    // no feedback line patched
+    QVERIFY(iom.sendFeedBack(0, 1, 42, QVariant()) == false);
+    QVERIFY(iom.sendFeedBack(42, 1, 42, QVariant()) == false);
+
+    QVERIFY(iom.setOutputPatch(0, stub->name(), stub->outputs().at(0), 0, true) == true);
+    QVERIFY(iom.setOutputPatch(1, stub->name(), stub->outputs().at(1), 1, true) == true);
+
+    // values are queued and coalesced until the next flush
+    QVERIFY(iom.sendFeedBack(0, 5, 10, QVariant()) == true);
+    QVERIFY(iom.sendFeedBack(0, 3, 20, QVariant()) == true);
+    QVERIFY(iom.sendFeedBack(1, 3, 30, QVariant()) == true);
+    QVERIFY(iom.sendFeedBack(0, 5, 40, QVariant()) == true);
+    QCOMPARE(stub->m_feedbackBatches.count(), 0);
+
+    // a value already queued is not queued again
+    QVERIFY(iom.sendFeedBack(0, 5, 40, QVariant()) == false);
+
+    iom.slotFlushFeedback();
+    QCOMPARE(stub->m_feedbackBatches.count(), 2);
+
+    QList<QLCFeedbackValue> batch = stub->m_feedbackBatches.at(0);
+    QCOMPARE(batch.count(), 2);
+    QCOMPARE(batch.at(0).channel, quint32(5));
+    QCOMPARE(batch.at(0).value, uchar(40));
+    QCOMPARE(batch.at(1).channel, quint32(3));
+    QCOMPARE(batch.at(1).value, uchar(20));
+
+    batch = stub->m_feedbackBatches.at(1);
+    QCOMPARE(batch.count(), 1);
+    QCOMPARE(batch.at(0).channel, quint32(3));
+    QCOMPARE(batch.at(0).value, uchar(30));
+
+    // nothing left to flush
+    iom.slotFlushFeedback();
+    QCOMPARE(stub->m_feedbackBatches.count(), 2);
+
+    // a queued value is delivered when coalescing is disabled
+    QVERIFY(iom.sendFeedBack(0, 7, 70, QVariant()) == true);
+    iom.setFeedbackInterval(0);
+    QCOMPARE(iom.feedbackInterval(), 0);
+    QCOMPARE(stub->m_feedbackBatches.count(), 3);
+
+    // the interval is persisted
+    {
+        QSettings settings;
+        QCOMPARE(settings.value(SETTINGS_FEEDBACK_INTERVAL).toInt(), 0);
+    }
+    iom.setFeedbackInterval(DEFAULT_FEEDBACK_INTERVAL);
+    {
+        QSettings settings;
+        QVERIFY(settings.contains(SETTINGS_FEEDBACK_INTERVAL) == false);
+        if (savedInterval.isValid())
+            settings.setValue(SETTINGS_FEEDBACK_INTERVAL, savedInterval);
+    }
+
+    stub->m_feedbackBatches.clear();
+}
+
+void InputOutputMap_Test::frameBarrier()
+{
+    InputOutputMap iom(m_doc, 4);
+
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    stub->m_flushCount = 0;
+
+    // universes that are not running are not waited for
+    iom.slotMasterTimerTickReady();
+    QVERIFY(iom.m_pendingFrames.isEmpty());
+
+    // a tick waiting for universes 0 and 1
+    iom.m_pendingFrames[0] = 1;
+    iom.m_pendingFrames[1] = 1;
+
+    iom.slotUniverseFrameProcessed(0, 1);
+    QCOMPARE(int(stub->m_flushCount), 0);
+
+    // a duplicate frame doesn't complete the tick
+    iom.slotUniverseFrameProcessed(0, 1);
+    QCOMPARE(int(stub->m_flushCount), 0);
+
+    // an unknown universe is ignored
+    iom.slotUniverseFrameProcessed(3, 1);
+    QCOMPARE(int(stub->m_flushCount), 0);
+
+    iom.slotUniverseFrameProcessed(1, 1);
+    QCOMPARE(int(stub->m_flushCount), 1);
+
+    // universe 1 doesn't complete tick 2 before tick 3 is armed
+    iom.m_pendingFrames[0] = 2;
+    iom.m_pendingFrames[1] = 2;
+    iom.slotUniverseFrameProcessed(0, 2);
+
+    iom.m_pendingFrames.clear();
+    iom.m_pendingFrames[0] = 3;
+    iom.m_pendingFrames[1] = 3;
+
+    // its late frame must not be accounted to tick 3
+    iom.slotUniverseFrameProcessed(1, 2);
+    iom.slotUniverseFrameProcessed(0, 3);
+    QCOMPARE(int(stub->m_flushCount), 1);
+
+    iom.slotUniverseFrameProcessed(1, 3);
+    QCOMPARE(int(stub->m_flushCount), 2);
+    QVERIFY(iom.m_pendingFrames.isEmpty());
+}
+
+void InputOutputMap_Test::frameFlush()
+{
+    InputOutputMap iom(m_doc, 4);
+
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    stub->m_flushCount = 0;
+
+    iom.startUniverses();
+    for (int i = 0; i < 100; i++)
+    {
+        bool running = true;
+        foreach (Universe *uni, iom.m_universeArray)
+            running = running && uni->m_running;
+        if (running)
+            break;
+        QTest::qSleep(10);
+    }
+
+    // plugins are flushed once per tick, after every universe wrote its data
+    for (int tick = 1; tick <= 3; tick++)
+    {
+        iom.slotMasterTimerTickReady();
+        for (int i = 0; i < 100 && int(stub->m_flushCount) < tick; i++)
+            QTest::qSleep(10);
+        QCOMPARE(int(stub->m_flushCount), tick);
+    }
+}
+
 QTEST_APPLESS_MAIN(InputOutputMap_Test)
@@ -54,6 +54,9 @@ private slots:
     void claimReleaseDumpReset();
     void blackout();
     void grandMaster();
+    void feedback();
+    void frameBarrier();
+    void frameFlush();
 
 private:
     Doc* m_doc;
@@ -158,4 +158,96 @@ void InputPatch_Test::parameters()
     delete ip;
 }
 
+void InputPatch_Test::universeData()
+{
+    InputPatch* ip = new InputPatch(0, this);
+    IOPluginStub* stub = static_cast<IOPluginStub*> (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    QVERIFY(ip->set(stub, 0, NULL) == true);
+
+    QSignalSpy spy(ip, SIGNAL(inputValueChanged(quint32,quint32,uchar,QString)));
+
+    QByteArray frame(512, 0);
+    frame[3] = 42;
+    frame[300] = 255;
+
+    // data of another line/universe is ignored
+    stub->emitUniverseDataChanged(0, 1, frame);
+    stub->emitUniverseDataChanged(1, 0, frame);
+    ip->flush(0);
+    QCOMPARE(spy.count(), 0);
+
+    stub->emitUniverseDataChanged(0, 0, frame);
+    QCOMPARE(spy.count(), 0);
+    ip->flush(0);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(1).toUInt(), quint32(3));
+    QCOMPARE(spy.at(0).at(2).toUInt(), uint(42));
+    QCOMPARE(spy.at(1).at(1).toUInt(), quint32(300));
+    QCOMPARE(spy.at(1).at(2).toUInt(), uint(255));
+
+    // an identical frame doesn't produce any value
+    spy.clear();
+    stub->emitUniverseDataChanged(0, 0, frame);
+    ip->flush(0);
+    QCOMPARE(spy.count(), 0);
+
+    // only the last value is emitted on flush, but ON/OFF changes pass through
+    frame[3] = 50;
+    stub->emitUniverseDataChanged(0, 0, frame);
+    frame[3] = 60;
+    stub->emitUniverseDataChanged(0, 0, frame);
+    frame[3] = 0;
+    stub->emitUniverseDataChanged(0, 0, frame);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(2).toUInt(), uint(60));
+    ip->flush(0);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(1).toUInt(), quint32(3));
+    QCOMPARE(spy.at(1).at(2).toUInt(), uint(0));
+
+    delete ip;
+}
+
+void InputPatch_Test::inputBuffer()
+{
+    InputPatch* ip = new InputPatch(0, this);
+    IOPluginStub* stub = static_cast<IOPluginStub*> (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    QVERIFY(ip->set(stub, 0, NULL) == true);
+
+    QSignalSpy spy(ip, SIGNAL(inputValueChanged(quint32,quint32,uchar,QString)));
+
+    // dense channels are emitted once per flush, in channel order
+    stub->emitValueChanged(0, 0, 500, 1);
+    stub->emitValueChanged(0, 0, 5, 10);
+    stub->emitValueChanged(0, 0, 5, 20);
+    // channels out of the dense buffer go through the hash
+    stub->emitValueChanged(0, 0, 1000, 30);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(ip->m_inputBuffer.count(), 1);
+
+    ip->flush(0);
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy.at(0).at(1).toUInt(), quint32(5));
+    QCOMPARE(spy.at(0).at(2).toUInt(), uint(20));
+    QCOMPARE(spy.at(1).at(1).toUInt(), quint32(500));
+    QCOMPARE(spy.at(1).at(2).toUInt(), uint(1));
+    QCOMPARE(spy.at(2).at(1).toUInt(), quint32(1000));
+    QCOMPARE(spy.at(2).at(2).toUInt(), uint(30));
+    QCOMPARE(ip->m_inputBuffer.count(), 0);
+
+    // single values are emitted even if unchanged (i.e. button presses)
+    spy.clear();
+    stub->emitValueChanged(0, 0, 5, 20);
+    ip->flush(0);
+    QCOMPARE(spy.count(), 1);
+
+    spy.clear();
+    ip->flush(0);
+    QCOMPARE(spy.count(), 0);
+
+    delete ip;
+}
+
 QTEST_APPLESS_MAIN(InputPatch_Test)
@@ -34,6 +34,8 @@ private slots:
     void defaults();
     void patch();
     void parameters();
+    void universeData();
+    void inputBuffer();
 
 private:
     Doc* m_doc;
@@ -32,6 +32,7 @@ void IOPluginStub::init()
 {
     m_configureCalled = 0;
     m_canConfigure = false;
+    m_flushCount = 0;
     m_universe = QByteArray(int(4 * 512), char(0));
 }
 
@@ -21,6 +21,7 @@
 #define IOPLUGINSTUB_H
 
 #include <QStringList>
+#include <QAtomicInt>
 #include <QString>
 #include <QList>
 
@@ -70,6 +71,12 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
 
+    /** @reimp */
+    void flushOutputs() override
+    {
+        m_flushCount.fetchAndAddOrdered(1);
+    }
+
 public:
     /** List of outputs that have been opened */
     QList <quint32> m_openOutputs;
@@ -77,6 +84,9 @@ public:
     /** Fake universe buffer */
     QByteArray m_universe;
 
+    /** Number of flushOutputs calls */
+    QAtomicInt m_flushCount;
+
     /*********************************************************************
      * Inputs
      *********************************************************************/
@@ -99,10 +109,28 @@ public:
         emit valueChanged(universe, input, channel, value);
     }
 
+    /** Tell the plugin to emit universeDataChanged signal */
+    void emitUniverseDataChanged(quint32 universe, quint32 input, const QByteArray &data)
+    {
+        emit universeDataChanged(universe, input, data);
+    }
+
+    /** @reimp */
+    void sendFeedBackBatch(quint32 universe, quint32 inputLine,
+                           const QList<QLCFeedbackValue> &values) override
+    {
+        Q_UNUSED(universe)
+        Q_UNUSED(inputLine)
+        m_feedbackBatches.append(values);
+    }
+
 public:
     /** List of inputs that have been opened */
     QList <quint32> m_openInputs;
 
+    /** Feedback batches received */
+    QList <QList<QLCFeedbackValue> > m_feedbackBatches;
+
     /*********************************************************************
      * Configuration
      *********************************************************************/
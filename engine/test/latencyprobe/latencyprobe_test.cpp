@@ -0,0 +1,215 @@
+/*
+  Q Light Controller Plus - Unit test
+  latencyprobe_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QSignalSpy>
+#include <QtTest>
+
+#define protected public
+#define private public
+#include "latencyprobe_test.h"
+#include "inputoutputmap.h"
+#include "latencyprobe.h"
+#include "iopluginstub.h"
+#include "outputpatch.h"
+#include "inputpatch.h"
+#include "universe.h"
+#include "qlcfile.h"
+#include "doc.h"
+#undef private
+#undef protected
+
+#define TESTPLUGINDIR "../iopluginstub"
+
+static QDir testPluginDir()
+{
+    QDir dir(TESTPLUGINDIR);
+    dir.setFilter(QDir::Files);
+    dir.setNameFilters(QStringList() << QString("*%1").arg(KExtPlugin));
+    return dir;
+}
+
+void LatencyProbe_Test::initTestCase()
+{
+    m_doc = new Doc(this);
+    m_doc->ioPluginCache()->load(testPluginDir());
+    QVERIFY(m_doc->ioPluginCache()->plugins().size() != 0);
+}
+
+void LatencyProbe_Test::cleanupTestCase()
+{
+    delete m_doc;
+    m_doc = NULL;
+}
+
+void LatencyProbe_Test::report()
+{
+    LatencyProbe probe;
+
+    LatencyProbe::Report report = probe.report();
+    QCOMPARE(report.samples, 0);
+    QCOMPARE(report.lost, 0);
+    QCOMPARE(report.max, qint64(0));
+
+    /* Samples in random order, from 1 to 100 us */
+    for (int i = 0; i < 100; i++)
+        probe.m_samples.append(qint64((i * 37) % 100 + 1) * 1000);
+    probe.m_lost = 3;
+
+    report = probe.report();
+    QCOMPARE(report.samples, 100);
+    QCOMPARE(report.lost, 3);
+    QCOMPARE(report.min, qint64(1000));
+    QCOMPARE(report.mean, qint64(50500));
+    QCOMPARE(report.median, qint64(50000));
+    QCOMPARE(report.p95, qint64(95000));
+    QCOMPARE(report.p99, qint64(99000));
+    QCOMPARE(report.max, qint64(100000));
+}
+
+void LatencyProbe_Test::samples()
+{
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+
+    InputPatch ip(0, NULL);
+    OutputPatch op(0, NULL);
+    op.set(stub, 0);
+
+    QByteArray low(512, char(0));
+    QByteArray high(512, char(0));
+    high[10] = char(200);
+
+    LatencyProbe probe;
+    QSignalSpy spy(&probe, SIGNAL(finished()));
+
+    /* Nothing to observe */
+    QVERIFY(probe.start(&ip, 5, QList<OutputPatch *>(), 10, 2) == false);
+    QVERIFY(probe.start(NULL, 5, QList<OutputPatch *>() << &op, 10, 2) == false);
+
+    /* The timer never fires by itself: the test drives the probe */
+    QVERIFY(probe.start(&ip, 5, QList<OutputPatch *>() << &op, 10, 2, 1000000) == true);
+    QVERIFY(probe.isRunning() == true);
+    QVERIFY(op.m_latencyProbe.loadAcquire() == &probe);
+    QVERIFY(probe.start(&ip, 5, QList<OutputPatch *>() << &op, 10, 2) == false);
+
+    /* The channel is brought to zero, without taking a sample */
+    QCOMPARE(ip.m_inputValues[5].loadAcquire(), 0);
+    QCOMPARE(probe.m_pendingTime.loadAcquire(), qint64(0));
+    op.dump(0, low, true);
+    QCOMPARE(probe.samples().count(), 0);
+
+    /* The high value is taken only when it reaches the output */
+    probe.slotTimeout();
+    QCOMPARE(ip.m_inputValues[5].loadAcquire(), 255);
+    QVERIFY(probe.m_pendingTime.loadAcquire() != 0);
+    op.dump(0, low, true);
+    QCOMPARE(probe.samples().count(), 0);
+    op.dump(0, high, true);
+    QCOMPARE(probe.samples().count(), 1);
+    QVERIFY(probe.samples().at(0) >= 0);
+    QCOMPARE(probe.m_pendingTime.loadAcquire(), qint64(0));
+
+    /* The same value seen again isn't a new sample */
+    op.dump(0, high, true);
+    QCOMPARE(probe.samples().count(), 1);
+
+    /* A short frame can't hold the output channel */
+    probe.slotTimeout();
+    QCOMPARE(ip.m_inputValues[5].loadAcquire(), 0);
+    op.dump(0, QByteArray(4, char(0)), true);
+    QCOMPARE(probe.samples().count(), 1);
+    op.dump(0, low, true);
+    QCOMPARE(probe.samples().count(), 2);
+
+    /* All the samples taken: the probe stops and releases the patch */
+    QCOMPARE(spy.count(), 0);
+    probe.slotTimeout();
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(probe.isRunning() == false);
+    QVERIFY(op.m_latencyProbe.loadAcquire() == NULL);
+    QCOMPARE(probe.report().samples, 2);
+    QCOMPARE(probe.report().lost, 0);
+
+    /* A value never seen at the output is lost after the timeout */
+    QVERIFY(probe.start(&ip, 5, QList<OutputPatch *>() << &op, 10, 1, 1000000) == true);
+    probe.slotTimeout();
+    qint64 sent = probe.m_pendingTime.loadAcquire();
+    QVERIFY(sent != 0);
+    probe.slotTimeout();
+    QCOMPARE(probe.m_pendingTime.loadAcquire(), sent);
+
+    probe.m_pendingTime.storeRelease(1);
+    probe.slotTimeout();
+    QCOMPARE(probe.report().samples, 0);
+    QCOMPARE(probe.report().lost, 1);
+    QCOMPARE(spy.count(), 2);
+
+    /* Stopping releases the input channel */
+    QCOMPARE(ip.m_inputValues[5].loadAcquire(), 0);
+}
+
+void LatencyProbe_Test::passthrough()
+{
+    InputOutputMap im(m_doc, 1);
+
+    QVERIFY(im.setInputPatch(0, "I/O Plugin Stub", "", 0) == true);
+    QVERIFY(im.setOutputPatch(0, "I/O Plugin Stub", "", 0) == true);
+    im.setUniversePassthrough(0, true);
+
+    /* The universe threads are not started: the test processes the
+     * universe frames itself, one per tick, so the latency is counted
+     * in ticks whatever the load of the machine */
+    Universe *universe = im.universe(0);
+    QVERIFY(universe != NULL);
+
+    /* Input channel 3 goes through the universe passthrough to output channel 3.
+     * The timer never fires by itself: the test drives the probe */
+    QVERIFY(im.startLatencyProbe(0, 3, 0, 3, 20, 1000000) == true);
+    LatencyProbe *probe = im.latencyProbe();
+    QVERIFY(probe->isRunning() == true);
+
+    for (int i = 0; i < 20; i++)
+    {
+        probe->slotTimeout();
+        QVERIFY(probe->m_pendingTime.loadAcquire() != 0);
+
+        /* A value injected before a tick reaches the output in that tick */
+        universe->processFaders();
+        QCOMPARE(probe->samples().count(), i + 1);
+        QCOMPARE(probe->m_pendingTime.loadAcquire(), qint64(0));
+
+        /* The following ticks don't sample it again */
+        universe->processFaders();
+        QCOMPARE(probe->samples().count(), i + 1);
+    }
+
+    probe->slotTimeout();
+    QVERIFY(probe->isRunning() == false);
+
+    LatencyProbe::Report report = probe->report();
+    QCOMPARE(report.samples, 20);
+    QCOMPARE(report.lost, 0);
+    QVERIFY(report.min >= 0);
+    QVERIFY(report.min <= report.median);
+    QVERIFY(report.median <= report.p99);
+    QVERIFY(report.p99 <= report.max);
+}
+
+QTEST_MAIN(LatencyProbe_Test)
@@ -70,7 +70,7 @@ void MasterTimer_Test::initial()
     mt->m_dmxSourceListMutex.unlock();
 
     //QVERIFY(mt->m_running == false);
-    QVERIFY(mt->m_stopAllFunctions == false);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
 }
 
 void MasterTimer_Test::startStop()
@@ -84,7 +84,7 @@ void MasterTimer_Test::startStop()
     QVERIFY(mt->m_functionList.size() == 0);
     QVERIFY(mt->m_dmxSourceList.size() == 0);
     // QVERIFY(mt->m_running == true);
-    QVERIFY(mt->m_stopAllFunctions == false);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
 
     mt->stop();
     QTest::qWait(100);
@@ -93,7 +93,7 @@ void MasterTimer_Test::startStop()
     QVERIFY(mt->m_functionList.size() == 0);
     QVERIFY(mt->m_dmxSourceList.size() == 0);
     // QVERIFY(mt->m_running == false);
-    QVERIFY(mt->m_stopAllFunctions == false);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
 }
 
 void MasterTimer_Test::startStopFunction()
@@ -293,7 +293,7 @@ void MasterTimer_Test::stopAllFunctions()
     QVERIFY(mt->runningFunctions() == 3);
     QVERIFY(mt->m_dmxSourceList.size() == 2);
 
-    mt->stopAllFunctions();
+    QVERIFY(mt->stopAllFunctions() == true);
     QVERIFY(mt->runningFunctions() == 0);
     QVERIFY(mt->m_dmxSourceList.size() == 2); // Shouldn't stop
 
@@ -301,6 +301,37 @@ void MasterTimer_Test::stopAllFunctions()
     mt->unregisterDMXSource(&s2);
 }
 
+void MasterTimer_Test::requestStopAllFunctions()
+{
+    MasterTimer* mt = m_doc->masterTimer();
+    mt->start();
+
+    Function_Stub fs1(m_doc);
+    fs1.start(mt, FunctionParent::master());
+
+    Function_Stub fs2(m_doc);
+    fs2.start(mt, FunctionParent::master());
+
+    QTest::qWait(60);
+    QVERIFY(mt->runningFunctions() == 2);
+
+    QSignalSpy spy(mt, SIGNAL(allFunctionsStopped()));
+
+    // Queued right before the request: it must not survive it
+    Function_Stub fs3(m_doc);
+    fs3.start(mt, FunctionParent::master());
+
+    mt->requestStopAllFunctions();
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, int(MasterTimer::tick()) * 5);
+
+    QVERIFY(mt->runningFunctions() == 0);
+    QVERIFY(fs1.stopped() == true);
+    QVERIFY(fs2.stopped() == true);
+    QVERIFY(fs3.stopped() == true);
+    QVERIFY(mt->m_startQueue.isEmpty() == true);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
+}
+
 void MasterTimer_Test::stop()
 {
     MasterTimer* mt = m_doc->masterTimer();
@@ -348,7 +379,7 @@ void MasterTimer_Test::restart()
     QVERIFY(mt->m_functionListMutex.tryLock() == true);
     mt->m_functionListMutex.unlock();
     // QVERIFY(mt->m_running == false);
-    QVERIFY(mt->m_stopAllFunctions == false);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
 
     mt->start();
     QVERIFY(mt->runningFunctions() == 0);
@@ -356,7 +387,7 @@ void MasterTimer_Test::restart()
     QVERIFY(mt->m_functionListMutex.tryLock() == true);
     mt->m_functionListMutex.unlock();
     // QVERIFY(mt->m_running == true);
-    QVERIFY(mt->m_stopAllFunctions == false);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
 
     fs1.start(mt, FunctionParent::master());
     fs2.start(mt, FunctionParent::master());
@@ -367,4 +398,100 @@ void MasterTimer_Test::restart()
     mt->stopAllFunctions();
 }
 
+void MasterTimer_Test::stopAllFunctionsIdle()
+{
+    MasterTimer* mt = m_doc->masterTimer();
+    mt->stop();
+
+    Function_Stub fs1(m_doc);
+    fs1.start(mt, FunctionParent::master());
+    mt->timerTick();
+    QVERIFY(mt->runningFunctions() == 1);
+
+    Function_Stub fs2(m_doc);
+    fs2.start(mt, FunctionParent::master());
+
+    // Nothing ticks: the functions are stopped right away
+    QVERIFY(mt->stopAllFunctions() == true);
+    QVERIFY(mt->runningFunctions() == 0);
+    QVERIFY(fs1.stopped() == true);
+    QVERIFY(fs2.stopped() == true);
+    QVERIFY(mt->m_startQueue.isEmpty() == true);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
+}
+
+void MasterTimer_Test::stopAllFunctionsFromTimer()
+{
+    MasterTimer* mt = m_doc->masterTimer();
+    mt->start();
+
+    Function_Stub fs1(m_doc);
+    fs1.start(mt, FunctionParent::master());
+
+    Function_Stub fs2(m_doc);
+    fs2.start(mt, FunctionParent::master());
+
+    QTest::qWait(60);
+    QVERIFY(mt->runningFunctions() == 2);
+
+    QAtomicInt called(0);
+    bool result = false;
+    qint64 elapsed = -1;
+
+    // tickReady is emitted from the timer thread
+    QMetaObject::Connection conn = connect(mt, &MasterTimer::tickReady, this, [&]()
+    {
+        if (called.loadAcquire())
+            return;
+
+        QElapsedTimer timer;
+        timer.start();
+        result = mt->stopAllFunctions();
+        elapsed = timer.elapsed();
+        called.storeRelease(1);
+    }, Qt::DirectConnection);
+
+    QTRY_VERIFY_WITH_TIMEOUT(called.loadAcquire() == 1, 5000);
+    disconnect(conn);
+    // make sure no handler is still running with the locals
+    mt->stop();
+
+    // served right away, without waiting for a tick that can't come
+    QVERIFY(result == true);
+    QVERIFY(elapsed < 1000);
+    QVERIFY(mt->runningFunctions() == 0);
+    QVERIFY(fs1.stopped() == true);
+    QVERIFY(fs2.stopped() == true);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
+}
+
+void MasterTimer_Test::stopAllFunctionsDuringTick()
+{
+    MasterTimer* mt = m_doc->masterTimer();
+    mt->stop();
+
+    Function_Stub fs1(m_doc);
+    fs1.start(mt, FunctionParent::master());
+    mt->timerTick();
+    QVERIFY(mt->runningFunctions() == 1);
+
+    // as if a running function asked to stop all the functions
+    mt->m_tickThread.storeRelease(QThread::currentThread());
+    mt->m_tickUniversesClaimed = true;
+
+    QVERIFY(mt->stopAllFunctions() == false);
+    QVERIFY(mt->runningFunctions() == 1);
+    QVERIFY(mt->m_stopAllServed != mt->m_stopAllRequests);
+
+    mt->m_tickUniversesClaimed = false;
+    mt->m_tickThread.storeRelease(NULL);
+
+    // the request is served by the next tick
+    mt->timerTick();
+    QVERIFY(mt->runningFunctions() == 0);
+    QVERIFY(fs1.stopped() == true);
+    QVERIFY(mt->m_stopAllServed == mt->m_stopAllRequests);
+    QVERIFY(mt->m_tickThread.loadAcquire() == NULL);
+}
+
 QTEST_MAIN(MasterTimer_Test)
@@ -41,8 +41,12 @@ private slots:
     void functionInitiatedStop();
     void runMultipleFunctions();
     void stopAllFunctions();
+    void requestStopAllFunctions();
     void stop();
     void restart();
+    void stopAllFunctionsIdle();
+    void stopAllFunctionsFromTimer();
+    void stopAllFunctionsDuringTick();
 
 private:
     Doc* m_doc;
@@ -20,6 +20,7 @@
 #include <QtTest>
 
 #define private public
+#include "outputdispatcher.h"
 #include "iopluginstub.h"
 #include "outputpatch_test.h"
 #include "outputpatch.h"
@@ -144,4 +145,132 @@ void OutputPatch_Test::dump()
     delete op;
 }
 
+void OutputPatch_Test::asyncDump()
+{
+    QByteArray uni(512, char(0));
+
+    OutputPatch* op = new OutputPatch(0, this);
+    op->setAsyncDispatch(false);
+    QVERIFY(op->asyncDispatch() == false);
+
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+
+    op->set(stub, 0);
+    uni[0] = 10;
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 10);
+    QVERIFY(op->m_dispatcher == NULL);
+
+    op->setAsyncDispatch(true);
+    QVERIFY(op->asyncDispatch() == true);
+    int flushes = stub->m_flushCount.loadAcquire();
+
+    /* Frames are written by the dispatcher thread */
+    for (int i = 1; i <= 3; i++)
+    {
+        uni[0] = 20 + i;
+        op->dump(0, uni, true);
+    }
+    QVERIFY(op->m_dispatcher != NULL);
+    QTRY_COMPARE(op->m_dispatcher->sentFrames() + op->droppedFrames(), quint64(3));
+    QTRY_VERIFY(stub->m_universe[0] == (char) 23);
+
+    /* and flushed right away, since no tick flush covers them */
+    QCOMPARE(quint64(stub->m_flushCount.loadAcquire() - flushes), op->m_dispatcher->sentFrames());
+
+    /* Disabling the dispatch keeps the dropped frames count */
+    quint64 dropped = op->droppedFrames();
+    op->setAsyncDispatch(false);
+    QVERIFY(op->m_dispatcher == NULL);
+    QCOMPARE(op->droppedFrames(), dropped);
+
+    /* A frame still pending when the dispatch stops is written */
+    op->setAsyncDispatch(true);
+    uni[0] = 40;
+    op->dump(0, uni, true);
+    op->setAsyncDispatch(false);
+    QVERIFY(stub->m_universe[0] == (char) 40);
+
+    uni[0] = 30;
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 30);
+
+    delete op;
+}
+
+void OutputPatch_Test::schedule()
+{
+    QByteArray uni(512, char(0));
+
+    OutputPatch* op = new OutputPatch(0, this);
+    op->setAsyncDispatch(false);
+    QCOMPARE(op->maxFrameRate(), 0);
+    QCOMPARE(op->keepAliveInterval(), 0);
+    QCOMPARE(op->burstSize(), 1);
+    QVERIFY(op->isScheduled() == false);
+
+    op->setBurstSize(0);
+    QCOMPARE(op->burstSize(), 1);
+    op->setMaxFrameRate(-5);
+    QCOMPARE(op->maxFrameRate(), 0);
+
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    op->set(stub, 0);
+
+    /* Send on change: unchanged data waits for the keep-alive */
+    op->setKeepAliveInterval(60000);
+    QVERIFY(op->isScheduled() == true);
+
+    uni[0] = 1;
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 1);
+
+    uni[0] = 2;
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 1);
+
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 2);
+
+    /* Rate limit: one frame per second with a burst of two */
+    op->setKeepAliveInterval(0);
+    op->setMaxFrameRate(1);
+    op->setBurstSize(2);
+    op->m_frameClock.invalidate();
+
+    uni[0] = 3;
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 3);
+
+    uni[0] = 4;
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 4);
+
+    uni[0] = 5;
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 4);
+    QVERIFY(op->m_pendingChanges == true);
+
+    /* Back to writing every tick, the held back change is still flagged */
+    op->setMaxFrameRate(0);
+    QVERIFY(op->isScheduled() == false);
+    bool dataChanged = false;
+    QVERIFY(op->scheduleFrame(dataChanged) == true);
+    QVERIFY(dataChanged == true);
+    QVERIFY(op->m_pendingChanges == false);
+
+    dataChanged = false;
+    QVERIFY(op->scheduleFrame(dataChanged) == true);
+    QVERIFY(dataChanged == false);
+
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 5);
+
+    delete op;
+}
+
 QTEST_APPLESS_MAIN(OutputPatch_Test)
@@ -35,6 +35,8 @@ private slots:
     void defaults();
     void patch();
     void dump();
+    void asyncDump();
+    void schedule();
 
 private:
     Doc* m_doc;
@@ -43,6 +43,9 @@ void Show_Test::defaults()
     QCOMPARE(s.id(), Function::invalidId());
     QCOMPARE(s.name(), "New Show");
     QCOMPARE(s.attributes().count(), 0);
+    QCOMPARE(s.audioClockSync(), false);
+    QCOMPARE(s.timecodeSync(), false);
+    QCOMPARE(s.timecodeOffset(), 0);
 }
 
 void Show_Test::copy()
@@ -50,6 +53,8 @@ void Show_Test::copy()
     Show show(m_doc);
     show.setID(123);
     show.setTimeDivision(Show::BPM_3_4, 123);
+    show.setTimecodeSync(true);
+    show.setTimecodeOffset(3600000);
 
     Scene *scene = new Scene(m_doc);
     m_doc->addFunction(scene);
@@ -76,6 +81,8 @@ void Show_Test::copy()
     QVERIFY(show.timeDivisionType() == Show::BPM_3_4);
     QVERIFY(show.timeDivisionBPM() == 123);
     QVERIFY(show.totalDuration() == 3000);
+    QVERIFY(showCopy.timecodeSync() == true);
+    QVERIFY(showCopy.timecodeOffset() == 3600000);
 
     QVERIFY(showCopy.getTracksCount() == show.getTracksCount());
 
@@ -223,6 +230,9 @@ void Show_Test::load()
     xmlWriter.writeStartElement("TimeDivision");
     xmlWriter.writeAttribute("Type", "BPM_2_4");
     xmlWriter.writeAttribute("BPM", "222");
+    xmlWriter.writeAttribute("AudioSync", "True");
+    xmlWriter.writeAttribute("TimecodeSync", "True");
+    xmlWriter.writeAttribute("TimecodeOffset", "5000");
     xmlWriter.writeEndElement();
 
     xmlWriter.writeStartElement("Track");
@@ -254,6 +264,9 @@ void Show_Test::load()
 
     QCOMPARE(s.timeDivisionType(), Show::BPM_2_4);
     QCOMPARE(s.timeDivisionBPM(), 222);
+    QCOMPARE(s.audioClockSync(), true);
+    QCOMPARE(s.timecodeSync(), true);
+    QCOMPARE(s.timecodeOffset(), 5000);
 
     QCOMPARE(s.getTracksCount(), 2);
 
@@ -279,6 +292,9 @@ void Show_Test::save()
     s.setID(123);
     s.setName("Test Show");
     s.setTimeDivision(Show::BPM_3_4, 111);
+    s.setAudioClockSync(true);
+    s.setTimecodeSync(true);
+    s.setTimecodeOffset(3600000);
 
     Track *t = new Track(456, &s);
     t->setName("First track");
@@ -312,6 +328,9 @@ void Show_Test::save()
     QVERIFY(xmlReader.name().toString() == "TimeDivision");
     QVERIFY(xmlReader.attributes().value("Type").toString() == "BPM_3_4");
     QVERIFY(xmlReader.attributes().value("BPM").toString() == "111");
+    QVERIFY(xmlReader.attributes().value("AudioSync").toString() == "True");
+    QVERIFY(xmlReader.attributes().value("TimecodeSync").toString() == "True");
+    QVERIFY(xmlReader.attributes().value("TimecodeOffset").toString() == "3600000");
     xmlReader.skipCurrentElement();
 
     xmlReader.readNextStartElement();
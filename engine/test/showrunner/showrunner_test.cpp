@@ -21,6 +21,9 @@
 #define private public
 #include "showrunner.h"
 #undef private
+#include "inputoutputmap.h"
+#include "mastertimer.h"
+#include "clocksync.h"
 #include "show.h"
 #include "track.h"
 #include "scene.h"
@@ -72,4 +75,77 @@ void ShowRunner_Test::stopRunner()
     QCOMPARE(runner.m_runningQueue.count(), 0);
 }
 
+void ShowRunner_Test::followClock()
+{
+    ShowRunner runner(m_doc, m_show->id());
+    quint32 tick = MasterTimer::tick();
+
+    // within the deadband nothing changes
+    runner.m_elapsedTime = 1000;
+    QCOMPARE(runner.followClock(1001), tick);
+    QCOMPARE(runner.clockDrift(), 1);
+
+    // small drifts are slewed by a quarter of tick at most
+    QCOMPARE(runner.followClock(1003), tick + 3);
+    QCOMPARE(runner.followClock(1050), tick + tick / 4);
+    QCOMPARE(runner.followClock(990), tick - tick / 4);
+    QCOMPARE(runner.clockCorrections(), 0);
+
+    // a large drift ahead makes the show jump
+    QCOMPARE(runner.followClock(1500), tick + 500);
+    QCOMPARE(runner.clockCorrections(), 1);
+    QCOMPARE(runner.maxClockDrift(), 500);
+    QCOMPARE(runner.followClock(1000), tick);
+
+    // a large drift behind holds the show, counted once for all the held ticks
+    QCOMPARE(runner.followClock(500), quint32(0));
+    QCOMPARE(runner.followClock(510), quint32(0));
+    QCOMPARE(runner.followClock(520), quint32(0));
+    QCOMPARE(runner.clockCorrections(), 2);
+    QCOMPARE(runner.clockDrift(), -480);
+
+    // back in range, then a new resync is a new correction
+    QCOMPARE(runner.followClock(1000), tick);
+    QCOMPARE(runner.followClock(1200), tick + 200);
+    QCOMPARE(runner.clockCorrections(), 3);
+    QCOMPARE(runner.maxClockDrift(), 500);
+}
+
+void ShowRunner_Test::timecodeSeek()
+{
+    // started after the end of the scene, so it isn't queued
+    ShowRunner runner(m_doc, m_show->id(), 5000);
+    QCOMPARE(runner.m_timeFunctions.count(), 0);
+    runner.setTimecodeSync(true, 100);
+
+    // no timecode received yet: the show holds
+    QCOMPARE(runner.clockIncrement(), quint32(0));
+    QCOMPARE(runner.m_elapsedTime, quint32(5000));
+
+    // 25 fps quarter frames up to now, the last one at 690 ms
+    ClockSync *sync = m_doc->inputOutputMap()->clockSync();
+    qint64 qf = 10 * 1000000LL;
+    qint64 now = ClockSync::now();
+    for (int i = 0; i < 20; i++)
+        sync->timecode(500 + i * 10, now - (19 - i) * qf);
+
+    // the timecode is before the show time: the show moves back
+    // to the timecode position minus the offset
+    runner.m_runningQueue.append(QPair<Function*,quint32>(m_scene, 6000));
+    QCOMPARE(runner.clockIncrement(), quint32(0));
+    QVERIFY(runner.m_elapsedTime >= 590 && runner.m_elapsedTime < 650);
+    QCOMPARE(runner.clockCorrections(), 1);
+    QCOMPARE(runner.m_runningQueue.count(), 0);
+
+    // the scene isn't over at the new position, so it's played again
+    QCOMPARE(runner.m_timeFunctions.count(), 1);
+    QCOMPARE(runner.m_currentTimeFunctionIndex, 0);
+
+    // from there on the timecode is followed
+    QVERIFY(runner.clockIncrement() > 0);
+    QCOMPARE(runner.clockCorrections(), 1);
+
+    runner.stop();
+}
+
 QTEST_APPLESS_MAIN(ShowRunner_Test)
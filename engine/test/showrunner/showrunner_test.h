@@ -37,6 +37,8 @@ private slots:
     void initRunner();
     void intensity();
     void stopRunner();
+    void followClock();
+    void timecodeSeek();
 
 private:
     Doc *m_doc;
@@ -134,12 +134,14 @@ desktop-file-validate %{buildroot}/%{_datadir}/applications/*.desktop
 %_libdir/qt5/plugins/qlcplus/libos2l.so
 %_libdir/qt5/plugins/qlcplus/libosc.so
 %_libdir/qt5/plugins/qlcplus/libpeperoni.so
+%_libdir/qt5/plugins/qlcplus/libshmplugin.so
 %_libdir/qt5/plugins/qlcplus/libspi.so
 %_libdir/qt5/plugins/qlcplus/libudmx.so
 %if "%{ui}" != "qmlui"
 %_mandir/*/*
 %doc /usr/share/qlcplus/documents
 %endif
+/usr/include/qlcplus/qlcshm.h
 /usr/lib/udev/rules.d/z65-anyma-udmx.rules
 /usr/lib/udev/rules.d/z65-dmxusb.rules
 /usr/lib/udev/rules.d/z65-fx5-hid.rules
@@ -191,6 +191,94 @@ if [ $RESULT != 0 ]; then
 fi
 popd
 
+#############################################################################
+# E1.31 tests
+#############################################################################
+
+$SLEEPCMD
+pushd plugins/E1.31/test
+eval $TESTPREFIX ./test.sh
+RESULT=$?
+if [ $RESULT != 0 ]; then
+	echo "${RESULT} E1.31 unit tests failed. Please fix before commit."
+	exit $RESULT
+fi
+popd
+
+#############################################################################
+# OSC tests
+#############################################################################
+
+$SLEEPCMD
+pushd plugins/osc/test
+eval $TESTPREFIX ./test.sh
+RESULT=$?
+if [ $RESULT != 0 ]; then
+	echo "${RESULT} OSC unit tests failed. Please fix before commit."
+	exit $RESULT
+fi
+popd
+
+#############################################################################
+# DMX USB tests
+#############################################################################
+
+$SLEEPCMD
+pushd plugins/dmxusb/test
+eval $TESTPREFIX ./test.sh
+RESULT=$?
+if [ $RESULT != 0 ]; then
+	echo "${RESULT} DMX USB unit tests failed. Please fix before commit."
+	exit $RESULT
+fi
+popd
+
+#############################################################################
+# Dummy tests
+#############################################################################
+
+$SLEEPCMD
+pushd plugins/dummy/test
+eval $TESTPREFIX ./test.sh
+RESULT=$?
+if [ $RESULT != 0 ]; then
+	echo "${RESULT} Dummy unit tests failed. Please fix before commit."
+	exit $RESULT
+fi
+popd
+
+#############################################################################
+# SPI tests
+#############################################################################
+
+if [[ "$OSTYPE" == "darwin"* ]]; then
+  echo "Skip SPI test (not supported on OSX)"
+else
+  $SLEEPCMD
+  pushd plugins/spi/test
+  eval $TESTPREFIX ./test.sh
+  RESULT=$?
+  if [ $RESULT != 0 ]; then
+    echo "${RESULT} SPI unit tests failed. Please fix before commit."
+    exit $RESULT
+  fi
+  popd
+fi
+
+#############################################################################
+# Shared memory tests
+#############################################################################
+
+$SLEEPCMD
+pushd plugins/shm/test
+eval $TESTPREFIX ./test.sh
+RESULT=$?
+if [ $RESULT != 0 ]; then
+	echo "${RESULT} Shared memory unit tests failed. Please fix before commit."
+	exit $RESULT
+fi
+popd
+
 #############################################################################
 # Final judgment
 #############################################################################
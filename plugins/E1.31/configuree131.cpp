@@ -40,6 +40,7 @@
 #define KMapColumnE131Uni       5
 #define KMapColumnTransmitMode  6
 #define KMapColumnPriority      7
+#define KMapColumnSyncUni       8
 
 #define PROP_UNIVERSE (Qt::UserRole + 0)
 #define PROP_LINE (Qt::UserRole + 1)
@@ -197,6 +198,12 @@ void ConfigureE131::fillMappingTree()
                 prioritySpin->setValue(info->outputPriority);
                 prioritySpin->setToolTip(tr("%1 - min, %2 - default, %3 - max").arg(E131_PRIORITY_MIN).arg(E131_PRIORITY_DEFAULT).arg(E131_PRIORITY_MAX));
                 m_uniMapTree->setItemWidget(item, KMapColumnPriority, prioritySpin);
+
+                QSpinBox *syncSpin = new QSpinBox(this);
+                syncSpin->setRange(0, 63999);
+                syncSpin->setValue(info->outputSyncUniverse);
+                syncSpin->setSpecialValueText(tr("None"));
+                m_uniMapTree->setItemWidget(item, KMapColumnSyncUni, syncSpin);
             }
         }
     }
@@ -419,6 +426,13 @@ void ConfigureE131::accept()
                 QSpinBox* prioSpin = qobject_cast<QSpinBox*>(m_uniMapTree->itemWidget(item, KMapColumnPriority));
                 m_plugin->setParameter(universe, line, QLCIOPlugin::Output,
                         E131_PRIORITY, prioSpin->value());
+
+                QSpinBox* syncSpin = qobject_cast<QSpinBox*>(m_uniMapTree->itemWidget(item, KMapColumnSyncUni));
+                if (syncSpin->value() == 0)
+                    m_plugin->unSetParameter(universe, line, QLCIOPlugin::Output, E131_SYNCUNIVERSE);
+                else
+                    m_plugin->setParameter(universe, line, QLCIOPlugin::Output,
+                            E131_SYNCUNIVERSE, syncSpin->value());
             }
         }
     }
@@ -23,6 +23,13 @@
 #include <QVariant>
 #include <QDebug>
 
+#if defined(Q_OS_LINUX)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
 #define TRANSMIT_FULL    "Full"
 #define TRANSMIT_PARTIAL "Partial"
 
@@ -43,12 +50,26 @@ E131Controller::E131Controller(QNetworkInterface const& iface, QNetworkAddressEn
     m_UdpSocket->setMulticastInterface(m_interface);
     // Don't send multicast to self
     m_UdpSocket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, false);
+
+    m_sourceClock.start();
+    m_sourceLossTimer.setInterval(E131_SOURCE_LOSS_TIMEOUT / 5);
+    connect(&m_sourceLossTimer, SIGNAL(timeout()),
+            this, SLOT(slotCheckSourcesLoss()));
 }
 
 E131Controller::~E131Controller()
 {
     qDebug() << Q_FUNC_INFO;
-    qDeleteAll(m_dmxValuesMap);
+
+    // stop the input receivers before deleting what they use
+    QMap<quint32, UniverseInfo> universeMap;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        universeMap.swap(m_universeMap);
+    }
+    universeMap.clear();
+
+    qDeleteAll(m_mergersMap);
 }
 
 QString E131Controller::getNetworkIP()
@@ -59,6 +80,10 @@ QString E131Controller::getNetworkIP()
 void E131Controller::addUniverse(quint32 universe, E131Controller::Type type)
 {
     qDebug() << "[E1.31] addUniverse - universe" << universe << ", type" << type;
+    // a replaced socket must be released unlocked, since it stops its receiver
+    QSharedPointer<QUdpSocket> prevSocket;
+    QMutexLocker locker(&m_dataMutex);
+
     if (m_universeMap.contains(universe))
     {
         m_universeMap[universe].type |= (int)type;
@@ -81,6 +106,7 @@ void E131Controller::addUniverse(quint32 universe, E131Controller::Type type)
         info.outputUniverse = universe + 1;
         info.outputTransmissionMode = Full;
         info.outputPriority = E131_PRIORITY_DEFAULT;
+        info.outputSyncUniverse = 0;
         info.type = type;
         m_universeMap[universe] = info;
     }
@@ -88,18 +114,26 @@ void E131Controller::addUniverse(quint32 universe, E131Controller::Type type)
     if (type == Input)
     {
         UniverseInfo& info = m_universeMap[universe];
-        info.inputSocket.clear();
+        prevSocket.swap(info.inputSocket);
         info.inputSocket = getInputSocket(true, info.inputMcastAddress, E131_DEFAULT_PORT);
     }
 }
 
 void E131Controller::removeUniverse(quint32 universe, E131Controller::Type type)
 {
+    QSharedPointer<QUdpSocket> prevSocket;
+    QMutexLocker locker(&m_dataMutex);
+
     if (m_universeMap.contains(universe))
     {
         UniverseInfo& info = m_universeMap[universe];
         if (type == Input)
-            info.inputSocket.clear();
+        {
+            prevSocket.swap(info.inputSocket);
+            delete m_mergersMap.take(universe);
+            if (m_mergersMap.isEmpty())
+                m_sourceLossTimer.stop();
+        }
 
         if (info.type == type)
             m_universeMap.take(universe);
@@ -113,6 +147,7 @@ void E131Controller::setInputMulticast(quint32 universe, bool multicast)
     if (m_universeMap.contains(universe) == false)
         return;
 
+    QSharedPointer<QUdpSocket> prevSocket;
     QMutexLocker locker(&m_dataMutex);
     UniverseInfo& info = m_universeMap[universe];
 
@@ -120,7 +155,7 @@ void E131Controller::setInputMulticast(quint32 universe, bool multicast)
         return;
     info.inputMulticast = multicast;
 
-    info.inputSocket.clear();
+    prevSocket.swap(info.inputSocket);
     if (multicast)
         info.inputSocket = getInputSocket(true, info.inputMcastAddress, E131_DEFAULT_PORT);
     else
@@ -140,7 +175,7 @@ QSharedPointer<QUdpSocket> E131Controller::getInputSocket(bool multicast, QHostA
         }
     }
 
-    QSharedPointer<QUdpSocket> inputSocket(new QUdpSocket(this));
+    QSharedPointer<QUdpSocket> inputSocket(new QUdpSocket(this), UdpReceiver::deleteSocket);
 
     if (multicast)
     {
@@ -152,8 +187,16 @@ QSharedPointer<QUdpSocket> E131Controller::getInputSocket(bool multicast, QHostA
         inputSocket->bind(m_ipAddr, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
     }
 
-    connect(inputSocket.data(), SIGNAL(readyRead()),
-            this, SLOT(processPendingPackets()));
+    if (UdpReceiver::isSupported())
+    {
+        UdpReceiver *receiver = new UdpReceiver(inputSocket.data(), this);
+        receiver->start(QThread::HighPriority);
+    }
+    else
+    {
+        connect(inputSocket.data(), SIGNAL(readyRead()),
+                this, SLOT(processPendingPackets()));
+    }
 
     return inputSocket;
 }
@@ -163,6 +206,7 @@ void E131Controller::setInputMCastAddress(quint32 universe, QString address, boo
     if (m_universeMap.contains(universe) == false)
         return;
 
+    QSharedPointer<QUdpSocket> prevSocket;
     QMutexLocker locker(&m_dataMutex);
     UniverseInfo& info = m_universeMap[universe];
 
@@ -176,7 +220,7 @@ void E131Controller::setInputMCastAddress(quint32 universe, QString address, boo
 
     if (!info.inputMulticast)
     {
-        info.inputSocket.clear();
+        prevSocket.swap(info.inputSocket);
         info.inputSocket = getInputSocket(true, info.inputMcastAddress, E131_DEFAULT_PORT);
     }
 }
@@ -186,6 +230,7 @@ void E131Controller::setInputUCastPort(quint32 universe, quint16 port)
     if (m_universeMap.contains(universe) == false)
         return;
 
+    QSharedPointer<QUdpSocket> prevSocket;
     QMutexLocker locker(&m_dataMutex);
     UniverseInfo& info = m_universeMap[universe];
 
@@ -195,7 +240,7 @@ void E131Controller::setInputUCastPort(quint32 universe, quint16 port)
 
     if (!info.inputMulticast)
     {
-        info.inputSocket.clear();
+        prevSocket.swap(info.inputSocket);
         info.inputSocket = getInputSocket(false, m_ipAddr, info.inputUcastPort);
     }
 }
@@ -268,6 +313,15 @@ void E131Controller::setOutputPriority(quint32 universe, quint32 e131Priority)
     m_universeMap[universe].outputPriority = e131Priority;
 }
 
+void E131Controller::setOutputSyncUniverse(quint32 universe, quint32 syncUni)
+{
+    if (m_universeMap.contains(universe) == false)
+        return;
+
+    QMutexLocker locker(&m_dataMutex);
+    m_universeMap[universe].outputSyncUniverse = syncUni;
+}
+
 void E131Controller::setOutputTransmissionMode(quint32 universe, E131Controller::TransmissionMode mode)
 {
     if (m_universeMap.contains(universe) == false)
@@ -335,33 +389,38 @@ quint64 E131Controller::getPacketSentNumber()
 
 quint64 E131Controller::getPacketReceivedNumber()
 {
+    QMutexLocker locker(&m_dataMutex);
     return m_packetReceived;
 }
 
 void E131Controller::sendDmx(const quint32 universe, const QByteArray &data)
 {
     QMutexLocker locker(&m_dataMutex);
-    QByteArray dmxPacket;
-    QHostAddress outAddress = QHostAddress(QString("239.255.0.%1").arg(universe + 1));
-    quint16 outPort = E131_DEFAULT_PORT;
+    E131Datagram datagram;
+    datagram.address = QHostAddress(QString("239.255.0.%1").arg(universe + 1));
+    datagram.port = E131_DEFAULT_PORT;
     quint32 outUniverse = universe;
     quint32 outPriority = E131_PRIORITY_DEFAULT;
+    quint16 syncUniverse = 0;
+    bool multicast = true;
     TransmissionMode transmitMode = Full;
 
     if (m_universeMap.contains(universe))
     {
         UniverseInfo const& info = m_universeMap[universe];
+        multicast = info.outputMulticast;
         if (info.outputMulticast)
         {
-            outAddress = info.outputMcastAddress;
+            datagram.address = info.outputMcastAddress;
         }
         else
         {
-            outAddress = info.outputUcastAddress;
-            outPort = info.outputUcastPort;
+            datagram.address = info.outputUcastAddress;
+            datagram.port = info.outputUcastPort;
         }
         outUniverse = info.outputUniverse;
         outPriority = info.outputPriority;
+        syncUniverse = info.outputSyncUniverse;
         transmitMode = TransmissionMode(info.outputTransmissionMode);
     }
     else
@@ -371,21 +430,127 @@ void E131Controller::sendDmx(const quint32 universe, const QByteArray &data)
     {
         QByteArray wholeuniverse(512, 0);
         wholeuniverse.replace(0, data.length(), data);
-        m_packetizer->setupE131Dmx(dmxPacket, outUniverse, outPriority, wholeuniverse);
+        m_packetizer->setupE131Dmx(datagram.data, outUniverse, outPriority, wholeuniverse, syncUniverse);
     }
     else
-        m_packetizer->setupE131Dmx(dmxPacket, outUniverse, outPriority, data);
+        m_packetizer->setupE131Dmx(datagram.data, outUniverse, outPriority, data, syncUniverse);
+
+    m_pendingDatagrams.append(datagram);
 
-    qint64 sent = m_UdpSocket->writeDatagram(dmxPacket.data(), dmxPacket.size(),
-                                             outAddress, outPort);
-    if (sent < 0)
+    if (syncUniverse)
     {
-        qDebug() << "sendDmx failed";
-        qDebug() << "Errno: " << m_UdpSocket->error();
-        qDebug() << "Errmsg: " << m_UdpSocket->errorString();
+        // sync packets go to the sync universe multicast address,
+        // or to every unicast receiver of the synchronized universes
+        QPair<QHostAddress, quint16> syncDest(datagram.address, datagram.port);
+        if (multicast)
+            syncDest = qMakePair(QHostAddress(QString("239.255.%1.%2").arg(syncUniverse >> 8).arg(syncUniverse & 0xFF)),
+                                 quint16(E131_DEFAULT_PORT));
+
+        QList<QPair<QHostAddress, quint16> > &dests = m_pendingSyncs[syncUniverse];
+        if (dests.contains(syncDest) == false)
+            dests.append(syncDest);
     }
-    else
-        m_packetSent++;
+
+    // don't let the queue grow if nobody flushes it
+    if (m_pendingDatagrams.count() >= E131_MAX_BATCH_SIZE)
+        writePendingDatagrams();
+}
+
+void E131Controller::flush()
+{
+    QMutexLocker locker(&m_dataMutex);
+
+    if (m_pendingDatagrams.isEmpty() && m_pendingSyncs.isEmpty())
+        return;
+
+    // all the DMX data of the tick first, then the sync packets
+    QMapIterator<quint16, QList<QPair<QHostAddress, quint16> > > it(m_pendingSyncs);
+    while (it.hasNext())
+    {
+        it.next();
+        QByteArray syncPacket;
+        m_packetizer->setupE131Sync(syncPacket, it.key());
+
+        foreach (const QPair<QHostAddress, quint16> &dest, it.value())
+        {
+            E131Datagram datagram;
+            datagram.data = syncPacket;
+            datagram.address = dest.first;
+            datagram.port = dest.second;
+            m_pendingDatagrams.append(datagram);
+        }
+    }
+    m_pendingSyncs.clear();
+
+    writePendingDatagrams();
+}
+
+void E131Controller::writePendingDatagrams()
+{
+    int sentCount = 0;
+
+#if defined(Q_OS_LINUX)
+    // submit the whole batch with a single system call
+    int fd = int(m_UdpSocket->socketDescriptor());
+    int count = m_pendingDatagrams.count();
+
+    if (fd >= 0 && count > 1)
+    {
+        QVector<struct mmsghdr> messages(count);
+        QVector<struct iovec> iovecs(count);
+        QVector<struct sockaddr_in> addresses(count);
+
+        for (int i = 0; i < count; i++)
+        {
+            const E131Datagram &datagram = m_pendingDatagrams.at(i);
+
+            memset(&addresses[i], 0, sizeof(struct sockaddr_in));
+            addresses[i].sin_family = AF_INET;
+            addresses[i].sin_port = htons(datagram.port);
+            addresses[i].sin_addr.s_addr = htonl(datagram.address.toIPv4Address());
+
+            iovecs[i].iov_base = (void *)datagram.data.constData();
+            iovecs[i].iov_len = datagram.data.size();
+
+            memset(&messages[i], 0, sizeof(struct mmsghdr));
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        while (sentCount < count)
+        {
+            int ret = sendmmsg(fd, messages.data() + sentCount, count - sentCount, 0);
+            if (ret < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            sentCount += ret;
+        }
+        m_packetSent += sentCount;
+    }
+#endif
+
+    // send what's left one by one
+    for (int i = sentCount; i < m_pendingDatagrams.count(); i++)
+    {
+        const E131Datagram &datagram = m_pendingDatagrams.at(i);
+        qint64 sent = m_UdpSocket->writeDatagram(datagram.data.constData(), datagram.data.size(),
+                                                 datagram.address, datagram.port);
+        if (sent < 0)
+        {
+            qDebug() << "sendDmx failed";
+            qDebug() << "Errno: " << m_UdpSocket->error();
+            qDebug() << "Errmsg: " << m_UdpSocket->errorString();
+        }
+        else
+            m_packetSent++;
+    }
+
+    m_pendingDatagrams.clear();
 }
 
 void E131Controller::processPendingPackets()
@@ -393,50 +558,79 @@ void E131Controller::processPendingPackets()
     QUdpSocket* socket = qobject_cast<QUdpSocket*>(sender());
     Q_ASSERT(socket != NULL);
 
+    QByteArray datagram;
+    QHostAddress senderAddress;
     while (socket->hasPendingDatagrams())
     {
-        QByteArray datagram;
-        QHostAddress senderAddress;
         datagram.resize(socket->pendingDatagramSize());
         socket->readDatagram(datagram.data(), datagram.size(), &senderAddress);
+        handleDatagram(socket, datagram, senderAddress);
+    }
+}
 
-        QByteArray dmxData;
-        quint32 e131universe;
+bool E131Controller::handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                                    QHostAddress const& senderAddress)
+{
+    QByteArray dmxData;
+    quint32 e131universe;
+    QByteArray cid;
+    int priority;
+    uchar sequence, options;
+
+    if (m_packetizer->checkPacket(datagram) == false ||
+        m_packetizer->fillDMXdata(datagram, dmxData, e131universe) == false ||
+        m_packetizer->fillSourceInfo(datagram, cid, priority, sequence, options) == false)
+    {
+        qDebug() << "Received packet with size: " << datagram.size() << ", from: " << senderAddress.toString()
+            << ", that does not look like E1.31";
+        return true;
+    }
 
-        if (m_packetizer->checkPacket(datagram) &&
-            m_packetizer->fillDMXdata(datagram, dmxData, e131universe))
-        {
-            qDebug() << "Received packet with size: " << datagram.size() << ", from: " << senderAddress.toString()
-                << ", for E1.31 universe: " << e131universe;
-            ++m_packetReceived;
+    // this is usually called by the receiver thread of the socket
+    QList<QPair<quint32, QByteArray> > changes;
+    QMutexLocker locker(&m_dataMutex);
+    ++m_packetReceived;
 
-            for (QMap<quint32, UniverseInfo>::iterator it = m_universeMap.begin(); it != m_universeMap.end(); ++it)
+    for (QMap<quint32, UniverseInfo>::iterator it = m_universeMap.begin(); it != m_universeMap.end(); ++it)
+    {
+        quint32 universe = it.key();
+        UniverseInfo const& info = it.value();
+        if (info.inputSocket == socket && info.inputUniverse == e131universe)
+        {
+            E131SourceMerger *merger = m_mergersMap.value(universe, NULL);
+            if (merger == NULL)
             {
-                quint32 universe = it.key();
-                UniverseInfo const& info = it.value();
-                if (info.inputSocket == socket && info.inputUniverse == e131universe)
-                {
-                    QByteArray *dmxValues;
-                    if (m_dmxValuesMap.contains(universe) == false)
-                        m_dmxValuesMap[universe] = new QByteArray(512, 0);
-
-                    dmxValues = m_dmxValuesMap[universe];
-
-                    for (int i = 0; i < dmxData.length(); i++)
-                    {
-                        if (dmxValues->at(i) != dmxData.at(i))
-                        {
-                            dmxValues->replace(i, 1, (const char *)(dmxData.data() + i), 1);
-                            emit valueChanged(universe, m_line, i, (uchar)dmxData.at(i));
-                        }
-                    }
-                }
+                merger = new E131SourceMerger();
+                m_mergersMap[universe] = merger;
+                // the timer belongs to the controller thread
+                QMetaObject::invokeMethod(&m_sourceLossTimer, "start", Qt::QueuedConnection);
             }
-        }
-        else
-        {
-            qDebug() << "Received packet with size: " << datagram.size() << ", from: " << senderAddress.toString()
-                << ", that does not look like E1.31";
+
+            if (merger->processData(cid, priority, sequence, options, dmxData, m_sourceClock.elapsed()))
+                changes.append(qMakePair(universe, merger->output()));
         }
     }
+    locker.unlock();
+
+    for (int i = 0; i < changes.count(); i++)
+        emit universeDataChanged(changes.at(i).first, m_line, changes.at(i).second);
+
+    return true;
+}
+
+void E131Controller::slotCheckSourcesLoss()
+{
+    QList<QPair<quint32, QByteArray> > changes;
+    QMutexLocker locker(&m_dataMutex);
+    qint64 now = m_sourceClock.elapsed();
+
+    for (QMap<quint32, E131SourceMerger*>::iterator it = m_mergersMap.begin(); it != m_mergersMap.end(); ++it)
+    {
+        if (it.value()->removeExpiredSources(now))
+            changes.append(qMakePair(it.key(), it.value()->output()));
+    }
+    locker.unlock();
+
+    for (int i = 0; i < changes.count(); i++)
+        emit universeDataChanged(changes.at(i).first, m_line, changes.at(i).second);
 }
@@ -29,13 +29,19 @@
 #include <QNetworkInterface>
 #include <QHostAddress>
 #include <QUdpSocket>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QTimer>
 
+#include "e131sourcemerger.h"
 #include "e131packetizer.h"
+#include "udpreceiver.h"
 
 #define E131_DEFAULT_PORT     5568
 
+/** Max number of datagrams queued before they're sent anyway */
+#define E131_MAX_BATCH_SIZE   512
+
 typedef struct _uinfo
 {
     bool inputMulticast;
@@ -51,11 +57,20 @@ typedef struct _uinfo
     quint16 outputUniverse;
     int outputTransmissionMode;
     int outputPriority;
+    /** E1.31 universe used to synchronize the output. 0 means no sync */
+    quint16 outputSyncUniverse;
 
     int type;
 } UniverseInfo;
 
-class E131Controller final : public QObject
+typedef struct
+{
+    QByteArray data;
+    QHostAddress address;
+    quint16 port;
+} E131Datagram;
+
+class E131Controller final : public QObject, public UdpReceiverHandler
 {
     Q_OBJECT
 
@@ -73,9 +88,15 @@ public:
 
     ~E131Controller();
 
-    /** Send DMX data to a specific port/universe */
+    /** Queue DMX data for a specific port/universe. Data is actually
+     *  transmitted by flush(), which the engine calls at the end of every
+     *  tick and after every frame written asynchronously */
     void sendDmx(const quint32 universe, const QByteArray& data);
 
+    /** Send all the queued DMX data in a single batch, followed by
+     *  the sync packets of the synchronized universes */
+    void flush();
+
     /** Return the controller IP address */
     QString getNetworkIP();
 
@@ -115,6 +136,10 @@ public:
     /** Set a specific E1.31 output priority for the given QLC+ universe */
     void setOutputPriority(quint32 universe, quint32 e131Priority);
 
+    /** Set the E1.31 universe used to synchronize the output of the given
+     *  QLC+ universe. 0 disables the synchronization */
+    void setOutputSyncUniverse(quint32 universe, quint32 syncUni);
+
     /** Set the transmission mode of the ArtNet DMX packets over the network.
      *  It can be 'Full', which transmits always 512 channels, or
      *  'Partial', which transmits only the channels actually used in a
@@ -146,9 +171,16 @@ public:
     /** Get the number of packets received by this controller */
     quint64 getPacketReceivedNumber();
 
+    /** @reimp */
+    bool handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                        QHostAddress const& senderAddress) override;
+
 private:
     QSharedPointer<QUdpSocket> getInputSocket(bool multicast, QHostAddress const& address, quint16 port);
 
+    /** Send the queued datagrams with as few system calls as possible */
+    void writePendingDatagrams();
+
 private:
     /** The network interface associated to this controller */
     QNetworkInterface m_interface;
@@ -167,9 +199,14 @@ private:
     /** Helper class used to create or parse E131 packets */
     QScopedPointer<E131Packetizer> m_packetizer;
 
-    /** Keeps the current dmx values to send only the ones that changed */
-    /** It holds values for all the handled universes */
-    QMap<quint32, QByteArray*> m_dmxValuesMap;
+    /** Source tracking and merging of each input universe */
+    QMap<quint32, E131SourceMerger*> m_mergersMap;
+
+    /** Monotonic clock used to track the sources activity */
+    QElapsedTimer m_sourceClock;
+
+    /** Timer to detect the input sources loss */
+    QTimer m_sourceLossTimer;
 
     /** Map of the QLC+ universes transmitted/received by this
      *  controller, with the related, specific parameters */
@@ -179,12 +216,24 @@ private:
      *  variables that could be used to transmit/receive data */
     QMutex m_dataMutex;
 
+    /** DMX datagrams waiting to be sent with the next flush */
+    QList<E131Datagram> m_pendingDatagrams;
+
+    /** Destinations of the sync packets to be sent with the next flush,
+     *  mapped by sync universe */
+    QMap<quint16, QList<QPair<QHostAddress, quint16> > > m_pendingSyncs;
+
 private slots:
     /** Async event raised when new packets have been received */
     void processPendingPackets();
 
+    /** Remove the sources that stopped sending data */
+    void slotCheckSourcesLoss();
+
 signals:
     void valueChanged(quint32 universe, quint32 input, quint32 channel, uchar value);
+
+    void universeDataChanged(quint32 universe, quint32 input, const QByteArray& data);
 };
 
 #endif
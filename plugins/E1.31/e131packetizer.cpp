@@ -109,7 +109,7 @@ E131Packetizer::E131Packetizer(QString MACaddr)
     // Data priority if multiple sources (default to 100) (byte 108)
     m_commonHeader.append((char)E131_PRIORITY_DEFAULT);
 
-    // reserved
+    // Synchronization Address (bytes 109-110)
     m_commonHeader.append('\0');
     m_commonHeader.append('\0');
 
@@ -162,7 +162,8 @@ E131Packetizer::~E131Packetizer()
  * Sender functions
  *********************************************************************/
 
-void E131Packetizer::setupE131Dmx(QByteArray& data, const int &universe, const int &priority, const QByteArray &values)
+void E131Packetizer::setupE131Dmx(QByteArray& data, const int &universe, const int &priority,
+                                  const QByteArray &values, const int &syncUniverse)
 {
     data.clear();
     data.append(m_commonHeader);
@@ -182,6 +183,9 @@ void E131Packetizer::setupE131Dmx(QByteArray& data, const int &universe, const i
 
     data[108] = (char) priority;
 
+    data[109] = (char)(syncUniverse >> 8);
+    data[110] = (char)(syncUniverse & 0x00FF);
+
     data[111] = m_sequence[universe];
 
     data[113] = (char)(universe >> 8);
@@ -199,7 +203,53 @@ void E131Packetizer::setupE131Dmx(QByteArray& data, const int &universe, const i
         m_sequence[universe]++;
 }
 
-bool E131Packetizer::checkPacket(QByteArray &data)
+void E131Packetizer::setupE131Sync(QByteArray &data, const int &syncUniverse)
+{
+    data.clear();
+
+    // Preamble, post-amble and ACN packet identifier
+    data.append(m_commonHeader.left(16));
+
+    // Flags & PDU length (bytes 16-17)
+    int rootLayerSize = E131_SYNC_PACKET_SIZE - 16;
+    data.append((char)(0x70 | (rootLayerSize >> 8)));
+    data.append((char)(rootLayerSize & 0x00FF));
+
+    // Identifies RLP Data as 1.31 Extended Protocol PDU
+    data.append((char)0x00);
+    data.append((char)0x00);
+    data.append((char)0x00);
+    data.append((char)0x08);
+
+    // Sender's CID (bytes 22-37)
+    data.append(m_commonHeader.mid(22, 16));
+
+    // Flags & PDU length (bytes 38-39)
+    int syncLayerSize = E131_SYNC_PACKET_SIZE - 38;
+    data.append((char)(0x70 | (syncLayerSize >> 8)));
+    data.append((char)(syncLayerSize & 0x00FF));
+
+    // Identifies the framing layer as Synchronization
+    data.append((char)0x00);
+    data.append((char)0x00);
+    data.append((char)0x00);
+    data.append((char)0x01);
+
+    // Sequence number (byte 44)
+    uchar &sequence = m_syncSequence[syncUniverse];
+    data.append((char)sequence);
+    sequence++;
+
+    // Synchronization Address (bytes 45-46)
+    data.append((char)(syncUniverse >> 8));
+    data.append((char)(syncUniverse & 0x00FF));
+
+    // reserved
+    data.append('\0');
+    data.append('\0');
+}
+
+bool E131Packetizer::checkPacket(QByteArray const& data)
 {
     /* An E1.31 packet must be at least 125 bytes long */
     if (data.length() < 125)
@@ -223,7 +273,7 @@ bool E131Packetizer::checkPacket(QByteArray &data)
  * Receiver functions
  *********************************************************************/
 
-bool E131Packetizer::fillDMXdata(QByteArray& data, QByteArray &dmx, quint32 &universe)
+bool E131Packetizer::fillDMXdata(QByteArray const& data, QByteArray &dmx, quint32 &universe)
 {
     if (data.isNull())
         return false;
@@ -235,9 +285,21 @@ bool E131Packetizer::fillDMXdata(QByteArray& data, QByteArray &dmx, quint32 &uni
     universe = (uchar(data[113]) << 8) + uchar(data[114]);
     int length = (uchar(data[123]) << 8) + uchar(data[124]);
 
-    qDebug() << "[E1.31 fillDMXdata] universe:" << universe << ", length:" << length - 1;
-
     dmx.clear();
     dmx.append(data.mid(126, length - 1));
     return true;
 }
+
+bool E131Packetizer::fillSourceInfo(QByteArray const& data, QByteArray &cid, int &priority,
+                                    uchar &sequence, uchar &options)
+{
+    if (data.length() < 125)
+        return false;
+
+    cid = data.mid(22, 16);
+    priority = uchar(data[108]);
+    sequence = uchar(data[111]);
+    options = uchar(data[112]);
+
+    return true;
+}
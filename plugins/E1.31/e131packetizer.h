@@ -27,6 +27,9 @@
 
 #define E131_PRIORITY_DEFAULT 100
 
+/** Size of an E1.31 universe synchronization packet */
+#define E131_SYNC_PACKET_SIZE 49
+
 class E131Packetizer final
 {
     /*********************************************************************
@@ -41,21 +44,32 @@ public:
      * Sender functions
      *********************************************************************/
 
-    /** Prepare an E1.31 DMX packet */
-    void setupE131Dmx(QByteArray& data, const int& universe, const int& priority, const QByteArray &values);
+    /** Prepare an E1.31 DMX packet. If syncUniverse is not 0, receivers
+     *  hold the data until a sync packet is sent on that universe */
+    void setupE131Dmx(QByteArray& data, const int& universe, const int& priority,
+                      const QByteArray &values, const int& syncUniverse = 0);
+
+    /** Prepare an E1.31 universe synchronization packet */
+    void setupE131Sync(QByteArray& data, const int& syncUniverse);
 
     /*********************************************************************
      * Receiver functions
      *********************************************************************/
 
     /** Verify the validity of an E1.31 packet and store the opCode in 'code' */
-    bool checkPacket(QByteArray& data);
+    bool checkPacket(QByteArray const& data);
+
+    bool fillDMXdata(QByteArray const& data, QByteArray& dmx, quint32 &universe);
 
-    bool fillDMXdata(QByteArray& data, QByteArray& dmx, quint32 &universe);
+    /** Extract the source CID, priority, sequence number and options
+     *  of an E1.31 DMX packet */
+    bool fillSourceInfo(QByteArray const& data, QByteArray& cid, int &priority,
+                        uchar &sequence, uchar &options);
 
 private:
     QByteArray m_commonHeader;
     QHash<int, uchar> m_sequence;
+    QHash<int, uchar> m_syncSequence;
 };
 
 #endif
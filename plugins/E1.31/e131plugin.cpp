@@ -174,7 +174,9 @@ bool E131Plugin::openOutput(quint32 output, quint32 universe)
                                                         m_IOmapping.at(output).address,
                                                         output, this);
         connect(controller, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)),
-                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)));
+                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)), Qt::DirectConnection);
+        connect(controller, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)),
+                this, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)), Qt::DirectConnection);
         m_IOmapping[output].controller = controller;
     }
 
@@ -214,6 +216,15 @@ void E131Plugin::writeUniverse(quint32 universe, quint32 output, const QByteArra
         controller->sendDmx(universe, data);
 }
 
+void E131Plugin::flushOutputs()
+{
+    foreach (E131IO io, m_IOmapping)
+    {
+        if (io.controller != NULL)
+            io.controller->flush();
+    }
+}
+
 /*************************************************************************
   * Inputs
   *************************************************************************/
@@ -243,7 +254,9 @@ bool E131Plugin::openInput(quint32 input, quint32 universe)
                                                         m_IOmapping.at(input).address,
                                                         input, this);
         connect(controller, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)),
-                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)));
+                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)), Qt::DirectConnection);
+        connect(controller, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)),
+                this, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)), Qt::DirectConnection);
         m_IOmapping[input].controller = controller;
     }
 
@@ -359,6 +372,8 @@ void E131Plugin::setParameter(quint32 universe, quint32 line, Capability type,
             controller->setOutputTransmissionMode(universe, E131Controller::stringToTransmissionMode(value.toString()));
         else if (name == E131_PRIORITY)
             controller->setOutputPriority(universe, value.toUInt());
+        else if (name == E131_SYNCUNIVERSE)
+            controller->setOutputSyncUniverse(universe, value.toUInt());
         else
             qWarning() << Q_FUNC_INFO << name << "is not a valid E1.31 output parameter";
     }
@@ -366,6 +381,16 @@ void E131Plugin::setParameter(quint32 universe, quint32 line, Capability type,
     QLCIOPlugin::setParameter(universe, line, type, name, value);
 }
 
+void E131Plugin::unSetParameter(quint32 universe, quint32 line, Capability type, QString name)
+{
+    // a removed sync universe must also stop the running synchronization
+    if (type == Output && name == E131_SYNCUNIVERSE &&
+        line < (quint32)m_IOmapping.length() && m_IOmapping.at(line).controller != NULL)
+        m_IOmapping.at(line).controller->setOutputSyncUniverse(universe, 0);
+
+    QLCIOPlugin::unSetParameter(universe, line, type, name);
+}
+
 QList<E131IO> E131Plugin::getIOMapping() const
 {
     return m_IOmapping;
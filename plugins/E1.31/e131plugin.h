@@ -45,6 +45,7 @@ typedef struct _eio
 #define E131_UNIVERSE "universe"
 #define E131_TRANSMITMODE "transmitMode"
 #define E131_PRIORITY "priority"
+#define E131_SYNCUNIVERSE "syncUniverse"
 
 #define SETTINGS_IFACE_WAIT_TIME "E131Plugin/ifacewait"
 
@@ -95,6 +96,9 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
 
+    /** @reimp */
+    void flushOutputs() override;
+
     /*************************************************************************
      * Inputs
      *************************************************************************/
@@ -124,6 +128,9 @@ public:
     /** @reimp */
     void setParameter(quint32 universe, quint32 line, Capability type, QString name, QVariant value) override;
 
+    /** @reimp */
+    void unSetParameter(quint32 universe, quint32 line, Capability type, QString name) override;
+
     /** Get a list of the available Input/Output lines */
     QList<E131IO> getIOMapping() const;
 
@@ -0,0 +1,169 @@
+/*
+  Q Light Controller Plus
+  e131sourcemerger.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QDebug>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "e131sourcemerger.h"
+
+#define DMX_CHANNELS 512
+
+E131SourceMerger::E131SourceMerger()
+    : m_output(DMX_CHANNELS, 0)
+{
+}
+
+E131SourceMerger::~E131SourceMerger()
+{
+}
+
+int E131SourceMerger::sourceIndex(const QByteArray &cid) const
+{
+    for (int i = 0; i < m_sources.count(); i++)
+    {
+        if (m_sources.at(i).cid == cid)
+            return i;
+    }
+    return -1;
+}
+
+bool E131SourceMerger::processData(const QByteArray &cid, int priority, uchar sequence,
+                                   uchar options, const QByteArray &dmx, qint64 now)
+{
+    // preview data is not meant for live output
+    if (options & E131_OPTION_PREVIEW)
+        return false;
+
+    int idx = sourceIndex(cid);
+
+    if (options & E131_OPTION_TERMINATED)
+    {
+        if (idx < 0)
+            return false;
+
+        qDebug() << "[E1.31] source" << cid.toHex() << "terminated";
+        m_sources.removeAt(idx);
+        merge();
+        return true;
+    }
+
+    if (idx < 0)
+    {
+        E131Source source;
+        source.cid = cid;
+        source.values = QByteArray(DMX_CHANNELS, 0);
+        m_sources.append(source);
+        idx = m_sources.count() - 1;
+        qDebug() << "[E1.31] new source" << cid.toHex() << "priority" << priority;
+    }
+    else
+    {
+        // discard out of order packets (E1.31 6.7.2)
+        int diff = qint8(sequence - m_sources.at(idx).sequence);
+        if (diff <= 0 && diff > -20)
+            return false;
+    }
+
+    E131Source &source = m_sources[idx];
+    source.priority = priority;
+    source.sequence = sequence;
+    source.lastSeen = now;
+
+    // a shorter frame must not leave stale values in the upper channels
+    int length = qMin(dmx.length(), DMX_CHANNELS);
+    memcpy(source.values.data(), dmx.constData(), length);
+    memset(source.values.data() + length, 0, DMX_CHANNELS - length);
+
+    // a single source is copied as is
+    if (m_sources.count() == 1)
+    {
+        m_output = source.values;
+        return true;
+    }
+
+    merge();
+    return true;
+}
+
+bool E131SourceMerger::removeExpiredSources(qint64 now)
+{
+    bool removed = false;
+
+    for (int i = m_sources.count() - 1; i >= 0; i--)
+    {
+        if (now - m_sources.at(i).lastSeen > E131_SOURCE_LOSS_TIMEOUT)
+        {
+            qDebug() << "[E1.31] source" << m_sources.at(i).cid.toHex() << "lost";
+            m_sources.removeAt(i);
+            removed = true;
+        }
+    }
+
+    // the last values are held when every source is gone
+    if (removed && m_sources.isEmpty() == false)
+        merge();
+
+    return removed;
+}
+
+int E131SourceMerger::sourcesCount() const
+{
+    return m_sources.count();
+}
+
+const QByteArray &E131SourceMerger::output() const
+{
+    return m_output;
+}
+
+void E131SourceMerger::merge()
+{
+    if (m_sources.isEmpty())
+        return;
+
+    int topPriority = 0;
+    foreach (const E131Source &source, m_sources)
+        topPriority = qMax(topPriority, source.priority);
+
+    m_output.fill(0);
+    uchar *out = reinterpret_cast<uchar *>(m_output.data());
+
+    foreach (const E131Source &source, m_sources)
+    {
+        if (source.priority != topPriority)
+            continue;
+
+        const uchar *in = reinterpret_cast<const uchar *>(source.values.constData());
+        int i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= DMX_CHANNELS; i += 16)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_max_epu8(a, b));
+        }
+#endif
+        for (; i < DMX_CHANNELS; i++)
+            out[i] = qMax(out[i], in[i]);
+    }
+}
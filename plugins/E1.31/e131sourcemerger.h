@@ -0,0 +1,85 @@
+/*
+  Q Light Controller Plus
+  e131sourcemerger.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef E131SOURCEMERGER_H
+#define E131SOURCEMERGER_H
+
+#include <QByteArray>
+#include <QList>
+
+/** Time after which a silent source is considered lost (E1.31 6.7.1) */
+#define E131_SOURCE_LOSS_TIMEOUT  2500
+
+/** Options field flags of an E1.31 DMX packet */
+#define E131_OPTION_PREVIEW       0x80
+#define E131_OPTION_TERMINATED    0x40
+
+typedef struct
+{
+    QByteArray cid;
+    int priority;
+    uchar sequence;
+    qint64 lastSeen;
+    QByteArray values;
+} E131Source;
+
+/**
+ * E131SourceMerger tracks the sources (identified by their CID) sending
+ * data on a single E1.31 universe and merges them into one DMX frame.
+ * Only the sources with the highest priority contribute to the result,
+ * and equal priority sources are merged HTP.
+ */
+class E131SourceMerger final
+{
+public:
+    E131SourceMerger();
+    ~E131SourceMerger();
+
+    /**
+     * Feed a DMX packet received from the source $cid.
+     * $now is a monotonic time in milliseconds.
+     * Returns true if the merged output must be refreshed.
+     */
+    bool processData(const QByteArray &cid, int priority, uchar sequence,
+                     uchar options, const QByteArray &dmx, qint64 now);
+
+    /**
+     * Drop the sources not heard for more than E131_SOURCE_LOSS_TIMEOUT.
+     * Returns true if at least one source has been removed.
+     */
+    bool removeExpiredSources(qint64 now);
+
+    /** Return the number of sources currently tracked */
+    int sourcesCount() const;
+
+    /** Return the merged DMX frame (always 512 channels) */
+    const QByteArray &output() const;
+
+private:
+    int sourceIndex(const QByteArray &cid) const;
+
+    /** Recompute the merged frame from the active sources */
+    void merge();
+
+private:
+    QList<E131Source> m_sources;
+    QByteArray m_output;
+};
+
+#endif
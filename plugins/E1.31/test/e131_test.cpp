@@ -0,0 +1,312 @@
+/*
+  Q Light Controller Plus
+  e131_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QNetworkInterface>
+#include <QUdpSocket>
+#include <QTest>
+
+#define private public
+#include "e131_test.h"
+#include "e131controller.h"
+#include "e131packetizer.h"
+#include "e131sourcemerger.h"
+#undef private
+
+/****************************************************************************
+ * Packetizer tests
+ ****************************************************************************/
+
+void E131_Test::setupE131DmxSync()
+{
+    E131Packetizer ep("00:11:22:33:44:55");
+    QByteArray data;
+    QByteArray values(512, 10);
+
+    // not synchronized
+    ep.setupE131Dmx(data, 1, E131_PRIORITY_DEFAULT, values);
+    QCOMPARE(data.size(), 126 + 512);
+    QCOMPARE(data[109], char(0x00));
+    QCOMPARE(data[110], char(0x00));
+
+    // synchronized on universe 0x1234
+    ep.setupE131Dmx(data, 1, E131_PRIORITY_DEFAULT, values, 0x1234);
+    QCOMPARE(data.size(), 126 + 512);
+    QCOMPARE(data[109], char(0x12));
+    QCOMPARE(data[110], char(0x34));
+    QCOMPARE(data[113], char(0x00));
+    QCOMPARE(data[114], char(0x01));
+}
+
+void E131_Test::setupE131Sync()
+{
+    E131Packetizer ep("00:11:22:33:44:55");
+    QByteArray dmx;
+    QByteArray data;
+
+    ep.setupE131Dmx(dmx, 1, E131_PRIORITY_DEFAULT, QByteArray(512, 0));
+    ep.setupE131Sync(data, 7000);
+
+    QCOMPARE(data.size(), E131_SYNC_PACKET_SIZE);
+
+    // same ACN header and CID of the DMX packets
+    QCOMPARE(data.left(16), dmx.left(16));
+    QCOMPARE(data.mid(22, 16), dmx.mid(22, 16));
+
+    // root layer: flags & length, extended vector
+    QCOMPARE(uchar(data[16]), uchar(0x70));
+    QCOMPARE(uchar(data[17]), uchar(E131_SYNC_PACKET_SIZE - 16));
+    QCOMPARE(data.mid(18, 4), QByteArray("\x00\x00\x00\x08", 4));
+
+    // framing layer: flags & length, sync vector
+    QCOMPARE(uchar(data[38]), uchar(0x70));
+    QCOMPARE(uchar(data[39]), uchar(E131_SYNC_PACKET_SIZE - 38));
+    QCOMPARE(data.mid(40, 4), QByteArray("\x00\x00\x00\x01", 4));
+
+    // sequence, sync address, reserved
+    QCOMPARE(uchar(data[44]), uchar(0));
+    QCOMPARE(uchar(data[45]), uchar(7000 >> 8));
+    QCOMPARE(uchar(data[46]), uchar(7000 & 0xFF));
+    QCOMPARE(data.mid(47, 2), QByteArray(2, 0));
+
+    // each sync universe has its own sequence
+    ep.setupE131Sync(data, 7000);
+    QCOMPARE(uchar(data[44]), uchar(1));
+    ep.setupE131Sync(data, 8000);
+    QCOMPARE(uchar(data[44]), uchar(0));
+}
+
+/****************************************************************************
+ * Controller tests
+ ****************************************************************************/
+
+void E131_Test::flush()
+{
+    QNetworkInterface loopback;
+    QNetworkAddressEntry address;
+
+    foreach (QNetworkInterface iface, QNetworkInterface::allInterfaces())
+    {
+        if ((iface.flags() & QNetworkInterface::IsLoopBack) == 0)
+            continue;
+
+        foreach (QNetworkAddressEntry entry, iface.addressEntries())
+        {
+            if (entry.ip() == QHostAddress::LocalHost)
+            {
+                loopback = iface;
+                address = entry;
+            }
+        }
+    }
+
+    if (address.ip().isNull())
+        QSKIP("No IPv4 loopback interface available");
+
+    QUdpSocket receiver;
+    QVERIFY(receiver.bind(QHostAddress::LocalHost, 0));
+
+    E131Controller controller(loopback, address, 0);
+    controller.addUniverse(0, E131Controller::Output);
+    controller.setOutputMulticast(0, false);
+    controller.setOutputUCastAddress(0, "127.0.0.1");
+    controller.setOutputUCastPort(0, receiver.localPort());
+    controller.setOutputSyncUniverse(0, 42);
+
+    // data is queued until the next flush
+    controller.sendDmx(0, QByteArray(512, 20));
+    QCOMPARE(controller.m_pendingDatagrams.count(), 1);
+    QCOMPARE(controller.m_pendingSyncs.count(), 1);
+    QCOMPARE(controller.getPacketSentNumber(), quint64(0));
+    QVERIFY(receiver.waitForReadyRead(200) == false);
+
+    // DMX data first, then the sync packet to the unicast receiver
+    controller.flush();
+    QVERIFY(controller.m_pendingDatagrams.isEmpty());
+    QVERIFY(controller.m_pendingSyncs.isEmpty());
+    QCOMPARE(controller.getPacketSentNumber(), quint64(2));
+
+    QList<QByteArray> received;
+    while (received.count() < 2 && (receiver.hasPendingDatagrams() || receiver.waitForReadyRead(1000)))
+    {
+        QByteArray datagram(int(receiver.pendingDatagramSize()), 0);
+        receiver.readDatagram(datagram.data(), datagram.size());
+        received.append(datagram);
+    }
+
+    QCOMPARE(received.count(), 2);
+    QCOMPARE(received.at(0).size(), 126 + 512);
+    QCOMPARE(uchar(received.at(0)[110]), uchar(42));
+    QCOMPARE(received.at(1).size(), E131_SYNC_PACKET_SIZE);
+    QCOMPARE(uchar(received.at(1)[46]), uchar(42));
+
+    // nothing left to send
+    controller.flush();
+    QCOMPARE(controller.getPacketSentNumber(), quint64(2));
+
+    // clearing the sync universe stops the sync packets
+    controller.setOutputSyncUniverse(0, 0);
+    controller.sendDmx(0, QByteArray(512, 30));
+    QVERIFY(controller.m_pendingSyncs.isEmpty());
+    controller.flush();
+    QCOMPARE(controller.getPacketSentNumber(), quint64(3));
+}
+
+/****************************************************************************
+ * Source merger tests
+ ****************************************************************************/
+
+static const QByteArray cidA(16, 'A');
+static const QByteArray cidB(16, 'B');
+
+void E131_Test::mergerSingleSource()
+{
+    E131SourceMerger merger;
+    QCOMPARE(merger.sourcesCount(), 0);
+    QCOMPARE(merger.output(), QByteArray(512, 0));
+
+    QByteArray dmx(512, 0);
+    dmx[0] = char(10);
+    dmx[511] = char(200);
+
+    QVERIFY(merger.processData(cidA, 100, 1, 0, dmx, 0) == true);
+    QCOMPARE(merger.sourcesCount(), 1);
+    QCOMPARE(merger.output(), dmx);
+}
+
+void E131_Test::mergerShorterFrame()
+{
+    E131SourceMerger merger;
+
+    QVERIFY(merger.processData(cidA, 100, 1, 0, QByteArray(512, char(50)), 0) == true);
+    QCOMPARE(merger.output(), QByteArray(512, char(50)));
+
+    // the upper channels of a shorter frame are zeroed
+    QVERIFY(merger.processData(cidA, 100, 2, 0, QByteArray(24, char(60)), 10) == true);
+    QByteArray expected(512, 0);
+    expected.replace(0, 24, QByteArray(24, char(60)));
+    QCOMPARE(merger.output(), expected);
+
+    // the same applies when merging several sources
+    QVERIFY(merger.processData(cidB, 100, 1, 0, QByteArray(8, char(20)), 20) == true);
+    QVERIFY(merger.processData(cidA, 100, 3, 0, QByteArray(4, char(30)), 30) == true);
+    expected.fill(0);
+    expected.replace(0, 4, QByteArray(4, char(30)));
+    expected.replace(4, 4, QByteArray(4, char(20)));
+    QCOMPARE(merger.output(), expected);
+}
+
+void E131_Test::mergerPriority()
+{
+    E131SourceMerger merger;
+
+    QVERIFY(merger.processData(cidA, 100, 1, 0, QByteArray(512, char(10)), 0) == true);
+    QVERIFY(merger.processData(cidB, 150, 1, 0, QByteArray(512, char(5)), 0) == true);
+    QCOMPARE(merger.sourcesCount(), 2);
+
+    // only the highest priority source contributes
+    QCOMPARE(merger.output(), QByteArray(512, char(5)));
+
+    QVERIFY(merger.processData(cidB, 50, 2, 0, QByteArray(512, char(5)), 10) == true);
+    QCOMPARE(merger.output(), QByteArray(512, char(10)));
+}
+
+void E131_Test::mergerHTP()
+{
+    E131SourceMerger merger;
+
+    QByteArray a(512, 0);
+    QByteArray b(512, 0);
+    for (int i = 0; i < 512; i++)
+    {
+        a[i] = char(i % 256);
+        b[i] = char(255 - (i % 256));
+    }
+
+    QVERIFY(merger.processData(cidA, 100, 1, 0, a, 0) == true);
+    QVERIFY(merger.processData(cidB, 100, 1, 0, b, 0) == true);
+
+    const QByteArray &out = merger.output();
+    QCOMPARE(out.size(), 512);
+    for (int i = 0; i < 512; i++)
+        QCOMPARE(uchar(out[i]), qMax(uchar(a[i]), uchar(b[i])));
+}
+
+void E131_Test::mergerSequence()
+{
+    E131SourceMerger merger;
+
+    QVERIFY(merger.processData(cidA, 100, 10, 0, QByteArray(512, char(1)), 0) == true);
+
+    // repeated and out of order packets are discarded
+    QVERIFY(merger.processData(cidA, 100, 10, 0, QByteArray(512, char(2)), 1) == false);
+    QVERIFY(merger.processData(cidA, 100, 5, 0, QByteArray(512, char(2)), 2) == false);
+    QCOMPARE(merger.output(), QByteArray(512, char(1)));
+
+    // a big backward jump is a restarted source
+    QVERIFY(merger.processData(cidA, 100, 200, 0, QByteArray(512, char(3)), 3) == true);
+    QCOMPARE(merger.output(), QByteArray(512, char(3)));
+
+    // sequence wraps around
+    QVERIFY(merger.processData(cidA, 100, 255, 0, QByteArray(512, char(4)), 4) == true);
+    QVERIFY(merger.processData(cidA, 100, 0, 0, QByteArray(512, char(5)), 5) == true);
+    QCOMPARE(merger.output(), QByteArray(512, char(5)));
+}
+
+void E131_Test::mergerPreviewTerminated()
+{
+    E131SourceMerger merger;
+
+    // preview data is ignored
+    QVERIFY(merger.processData(cidA, 100, 1, E131_OPTION_PREVIEW, QByteArray(512, char(9)), 0) == false);
+    QCOMPARE(merger.sourcesCount(), 0);
+
+    QVERIFY(merger.processData(cidA, 100, 1, 0, QByteArray(512, char(10)), 0) == true);
+    QVERIFY(merger.processData(cidB, 200, 1, 0, QByteArray(512, char(20)), 0) == true);
+    QCOMPARE(merger.output(), QByteArray(512, char(20)));
+
+    // a terminated source is removed immediately
+    QVERIFY(merger.processData(cidB, 200, 2, E131_OPTION_TERMINATED, QByteArray(512, 0), 10) == true);
+    QCOMPARE(merger.sourcesCount(), 1);
+    QCOMPARE(merger.output(), QByteArray(512, char(10)));
+
+    // terminating an unknown source does nothing
+    QVERIFY(merger.processData(cidB, 200, 3, E131_OPTION_TERMINATED, QByteArray(512, 0), 20) == false);
+}
+
+void E131_Test::mergerSourceLoss()
+{
+    E131SourceMerger merger;
+
+    QVERIFY(merger.processData(cidA, 100, 1, 0, QByteArray(512, char(10)), 0) == true);
+    QVERIFY(merger.processData(cidB, 200, 1, 0, QByteArray(512, char(20)), 1000) == true);
+
+    QVERIFY(merger.removeExpiredSources(E131_SOURCE_LOSS_TIMEOUT) == false);
+
+    // the higher priority source is still alive
+    QVERIFY(merger.removeExpiredSources(E131_SOURCE_LOSS_TIMEOUT + 1) == true);
+    QCOMPARE(merger.sourcesCount(), 1);
+    QCOMPARE(merger.output(), QByteArray(512, char(20)));
+
+    // the last values are held when every source is lost
+    QVERIFY(merger.removeExpiredSources(E131_SOURCE_LOSS_TIMEOUT + 1001) == true);
+    QCOMPARE(merger.sourcesCount(), 0);
+    QCOMPARE(merger.output(), QByteArray(512, char(20)));
+}
+
+QTEST_MAIN(E131_Test)
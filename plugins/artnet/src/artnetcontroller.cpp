@@ -24,6 +24,8 @@
 #include <QStringList>
 #include <QDebug>
 
+#include <climits>
+
 #define POLL_INTERVAL_MS   3000
 #define SEND_INTERVAL_MS   2000
 
@@ -46,6 +48,8 @@ ArtNetController::ArtNetController(QNetworkInterface const& iface, QNetworkAddre
     , m_udpSocket(udpSocket)
     , m_packetizer(new ArtNetPacketizer())
     , m_pollTimer(NULL)
+    , m_syncEnabled(true)
+    , m_syncPending(false)
 {
     if (m_ipAddr == QHostAddress::LocalHost)
     {
@@ -58,6 +62,8 @@ ArtNetController::ArtNetController(QNetworkInterface const& iface, QNetworkAddre
         m_MACAddress = iface.hardwareAddress();
     }
 
+    m_packetizer->setupArtNetSync(m_syncPacket);
+
     qDebug() << "[ArtNetController] IP Address:" << m_ipAddr.toString() << " Broadcast address:" << m_broadcastAddr.toString() << "(MAC:" << m_MACAddress << ")";
 }
 
@@ -89,9 +95,16 @@ quint64 ArtNetController::getPacketSentNumber()
 
 quint64 ArtNetController::getPacketReceivedNumber()
 {
+    QMutexLocker locker(&m_dataMutex);
     return m_packetReceived;
 }
 
+void ArtNetController::countPacketReceived()
+{
+    QMutexLocker locker(&m_dataMutex);
+    ++m_packetReceived;
+}
+
 bool ArtNetController::socketBound() const
 {
     return m_udpSocket->state() == QAbstractSocket::BoundState;
@@ -102,27 +115,26 @@ QString ArtNetController::getNetworkIP()
     return m_ipAddr.toString();
 }
 
-QHash<QHostAddress, ArtNetNodeInfo> ArtNetController::getNodesList()
-{
-    return m_nodesList;
-}
-
 void ArtNetController::addUniverse(quint32 universe, ArtNetController::Type type)
 {
     qDebug() << "[ArtNet] addUniverse - universe" << universe << ", type" << type;
-    if (m_universeMap.contains(universe))
-    {
-        m_universeMap[universe].type |= (int)type;
-    }
-    else
     {
-        UniverseInfo info;
-        info.inputUniverse = universe;
-        info.outputAddress = m_broadcastAddr;
-        info.outputUniverse = universe;
-        info.outputTransmissionMode = Standard;
-        info.type = type;
-        m_universeMap[universe] = info;
+        QMutexLocker locker(&m_dataMutex);
+        if (m_universeMap.contains(universe))
+        {
+            m_universeMap[universe].type |= (int)type;
+        }
+        else
+        {
+            UniverseInfo info;
+            info.inputUniverse = universe;
+            info.outputAddress = m_broadcastAddr;
+            info.outputUniverse = universe;
+            info.outputTransmissionMode = Standard;
+            info.outputSync = false;
+            info.type = type;
+            m_universeMap[universe] = info;
+        }
     }
 
     if (type == Output)
@@ -150,10 +162,13 @@ void ArtNetController::removeUniverse(quint32 universe, ArtNetController::Type t
 {
     if (m_universeMap.contains(universe))
     {
-        if (m_universeMap[universe].type == type)
-            m_universeMap.take(universe);
-        else
-            m_universeMap[universe].type &= ~type;
+        {
+            QMutexLocker locker(&m_dataMutex);
+            if (m_universeMap[universe].type == type)
+                m_universeMap.take(universe);
+            else
+                m_universeMap[universe].type &= ~type;
+        }
 
         if (type == Output && ((this->type() & Output) == 0))
         {
@@ -217,6 +232,8 @@ bool ArtNetController::setOutputUniverse(quint32 universe, quint32 artnetUni)
 
     QMutexLocker locker(&m_dataMutex);
     m_universeMap[universe].outputUniverse = artnetUni;
+    // the packet template is rebuilt on the next transmission
+    m_universeMap[universe].outputPacket.clear();
 
     return universe == artnetUni;
 }
@@ -228,10 +245,56 @@ bool ArtNetController::setTransmissionMode(quint32 universe, ArtNetController::T
 
     QMutexLocker locker(&m_dataMutex);
     m_universeMap[universe].outputTransmissionMode = int(mode);
+    m_universeMap[universe].outputPacket.clear();
 
     return mode == ArtNetController::Standard;
 }
 
+bool ArtNetController::setOutputSync(quint32 universe, bool enable)
+{
+    if (!m_universeMap.contains(universe))
+        return false;
+
+    QMutexLocker locker(&m_dataMutex);
+    m_universeMap[universe].outputSync = enable;
+
+    return enable == false;
+}
+
+void ArtNetController::setSyncEnabled(bool enable)
+{
+    QMutexLocker locker(&m_dataMutex);
+    m_syncEnabled = enable;
+    m_syncPending = false;
+}
+
+bool ArtNetController::syncEnabled() const
+{
+    return m_syncEnabled;
+}
+
+void ArtNetController::sendSync()
+{
+    QMutexLocker locker(&m_dataMutex);
+
+    if (m_syncPending == false)
+        return;
+
+    m_syncPending = false;
+
+    qint64 sent = m_udpSocket->writeDatagram(m_syncPacket, m_broadcastAddr, ARTNET_PORT);
+    if (sent < 0)
+    {
+        qWarning() << "sendSync failed";
+        qWarning() << "Errno: " << m_udpSocket->error();
+        qWarning() << "Errmgs: " << m_udpSocket->errorString();
+    }
+    else
+    {
+        m_packetSent++;
+    }
+}
+
 QString ArtNetController::transmissionModeToString(ArtNetController::TransmissionMode mode)
 {
     switch (mode)
@@ -281,13 +344,17 @@ void ArtNetController::slotSendAllUniverses()
 
         if ((info.type & Output) && info.outputTransmissionMode == Standard)
         {
-            QByteArray dmxPacket;
-            if (info.outputData.size() == 0)
-                info.outputData.fill(0, 512);
-
-            m_packetizer->setupArtNetDmx(dmxPacket, info.outputUniverse, info.outputData);
+            if (info.outputPacket.isEmpty())
+            {
+                m_packetizer->setupArtNetDmxTemplate(info.outputPacket, info.outputUniverse);
+                m_packetizer->updateArtNetDmx(info.outputPacket, info.outputUniverse, NULL, 0, true);
+            }
+            else
+            {
+                m_packetizer->updateArtNetDmxSequence(info.outputPacket, info.outputUniverse);
+            }
 
-            qint64 sent = m_udpSocket->writeDatagram(dmxPacket, info.outputAddress, ARTNET_PORT);
+            qint64 sent = m_udpSocket->writeDatagram(info.outputPacket, info.outputAddress, ARTNET_PORT);
             if (sent < 0)
             {
                 qWarning() << "sendDmx failed";
@@ -297,6 +364,8 @@ void ArtNetController::slotSendAllUniverses()
             else
             {
                 m_packetSent++;
+                if (info.outputSync && m_syncEnabled)
+                    m_syncPending = true;
             }
         }
     }
@@ -305,10 +374,6 @@ void ArtNetController::slotSendAllUniverses()
 void ArtNetController::sendDmx(const quint32 universe, const QByteArray &data, bool dataChanged)
 {
     QMutexLocker locker(&m_dataMutex);
-    QByteArray dmxPacket;
-    QHostAddress outAddress = m_broadcastAddr;
-    quint32 outUniverse = universe;
-    TransmissionMode transmitMode = Standard;
     UniverseInfo *info = getUniverseInfo(universe);
 
     if (info == NULL)
@@ -317,29 +382,21 @@ void ArtNetController::sendDmx(const quint32 universe, const QByteArray &data, b
         return;
     }
 
-    outAddress = info->outputAddress;
-    outUniverse = info->outputUniverse;
-    transmitMode = TransmissionMode(info->outputTransmissionMode);
+    TransmissionMode transmitMode = TransmissionMode(info->outputTransmissionMode);
 
     // if data has not changed since previous tick don't do anything.
     // A timer will refresh all universes every N seconds
     if (transmitMode == Standard && !dataChanged)
         return;
 
-    if (transmitMode == Full || (transmitMode == Standard && dataChanged))
-    {
-        if (info->outputData.size() == 0)
-            info->outputData.fill(0, 512);
+    if (info->outputPacket.isEmpty())
+        m_packetizer->setupArtNetDmxTemplate(info->outputPacket, info->outputUniverse);
 
-        info->outputData.replace(0, data.length(), data);
-        m_packetizer->setupArtNetDmx(dmxPacket, outUniverse, info->outputData);
-    }
-    else
-    {
-        m_packetizer->setupArtNetDmx(dmxPacket, outUniverse, data);
-    }
+    // DMX values are written straight into the pre-built packet
+    m_packetizer->updateArtNetDmx(info->outputPacket, info->outputUniverse,
+                                  data.constData(), data.length(), transmitMode != Partial);
 
-    qint64 sent = m_udpSocket->writeDatagram(dmxPacket, outAddress, ARTNET_PORT);
+    qint64 sent = m_udpSocket->writeDatagram(info->outputPacket, info->outputAddress, ARTNET_PORT);
     if (sent < 0)
     {
         qWarning() << "sendDmx failed";
@@ -349,6 +406,9 @@ void ArtNetController::sendDmx(const quint32 universe, const QByteArray &data, b
     else
     {
         m_packetSent++;
+        // nodes will latch this universe on the next ArtSync
+        if (info->outputSync && m_syncEnabled)
+            m_syncPending = true;
     }
 }
 
@@ -401,32 +461,10 @@ bool ArtNetController::sendRDMCommand(const quint32 universe, uchar command, QVa
     return result;
 }
 
-bool ArtNetController::handleArtNetPollReply(QByteArray const& datagram, QHostAddress const& senderAddress)
+void ArtNetController::sendPollReply(QHostAddress const& address)
 {
-    ArtNetNodeInfo newNode;
-    if (!m_packetizer->fillArtPollReplyInfo(datagram, newNode))
-    {
-        qWarning() << "[ArtNet] Bad ArtPollReply received";
-        return false;
-    }
-
 #if _DEBUG_RECEIVED_PACKETS
-    qDebug() << "[ArtNet] ArtPollReply received";
-#endif
-
-    if (m_nodesList.contains(senderAddress) == false)
-        m_nodesList[senderAddress] = newNode;
-
-    ++m_packetReceived;
-    return true;
-}
-
-bool ArtNetController::handleArtNetPoll(QByteArray const& datagram, QHostAddress const& senderAddress)
-{
-    Q_UNUSED(datagram);
-
-#if _DEBUG_RECEIVED_PACKETS
-    qDebug() << "[ArtNet] ArtPoll received";
+    qDebug() << "[ArtNet] ArtPollReply to" << address.toString();
 #endif
     QByteArray pollReplyPacket;
     for (QMap<quint32, UniverseInfo>::iterator it = m_universeMap.begin(); it != m_universeMap.end(); ++it)
@@ -436,11 +474,9 @@ bool ArtNetController::handleArtNetPoll(QByteArray const& datagram, QHostAddress
         bool isInput = (info.type & Input) ? true : false;
 
         m_packetizer->setupArtNetPollReply(pollReplyPacket, m_ipAddr, m_MACAddress, universe, isInput);
-        m_udpSocket->writeDatagram(pollReplyPacket, senderAddress, ARTNET_PORT);
+        m_udpSocket->writeDatagram(pollReplyPacket, address, ARTNET_PORT);
         ++m_packetSent;
     }
-    ++m_packetReceived;
-    return true;
 }
 
 bool ArtNetController::handleArtNetDmx(QByteArray const& datagram, QHostAddress const& senderAddress)
@@ -461,36 +497,29 @@ bool ArtNetController::handleArtNetDmx(QByteArray const& datagram, QHostAddress
         << ", from=" << QHostAddress(senderAddress.toIPv4Address()).toString();
 #endif
 
-    for (QMap<quint32, UniverseInfo>::iterator it = m_universeMap.begin(); it != m_universeMap.end(); ++it)
+    // DMX data is received in the plugin receiver thread
+    quint32 universe = UINT_MAX;
     {
-        quint32 universe = it.key();
-        UniverseInfo &info = it.value();
-
-        if ((info.type & Input) && info.inputUniverse == artnetUniverse)
+        QMutexLocker locker(&m_dataMutex);
+        for (QMap<quint32, UniverseInfo>::const_iterator it = m_universeMap.constBegin(); it != m_universeMap.constEnd(); ++it)
         {
-            if (info.inputData.size() == 0)
-                info.inputData.fill(0, 512);
-
-#if _DEBUG_RECEIVED_PACKETS
-            qDebug() << "[ArtNet] -> universe" << (universe + 1);
-#endif
-
-            for (int i = 0; i < dmxData.length(); i++)
+            if ((it.value().type & Input) && it.value().inputUniverse == artnetUniverse)
             {
-                if (info.inputData.at(i) != dmxData.at(i))
-                {
-#if _DEBUG_RECEIVED_PACKETS
-                    qDebug() << "[ArtNet] a value differs";
-#endif
-                    info.inputData.replace(i, 1, (const char *)(dmxData.data() + i), 1);
-                    emit valueChanged(universe, m_line, i, (uchar)dmxData.at(i));
-                }
+                universe = it.key();
+                ++m_packetReceived;
+                break;
             }
-            ++m_packetReceived;
-            return true;
         }
     }
-    return false;
+
+    if (universe == UINT_MAX)
+        return false;
+
+#if _DEBUG_RECEIVED_PACKETS
+    qDebug() << "[ArtNet] -> universe" << (universe + 1);
+#endif
+    emit universeDataChanged(universe, m_line, dmxData);
+    return true;
 }
 
 bool ArtNetController::handleArtNetTodData(const QByteArray &datagram, const QHostAddress &senderAddress)
@@ -539,10 +568,6 @@ bool ArtNetController::handlePacket(QByteArray const& datagram, QHostAddress con
     {
         switch (opCode)
         {
-            case ARTNET_POLLREPLY:
-                return handleArtNetPollReply(datagram, senderAddress);
-            case ARTNET_POLL:
-                return handleArtNetPoll(datagram, senderAddress);
             case ARTNET_DMX:
                 return handleArtNetDmx(datagram, senderAddress);
             case ARTNET_TODDATA:
@@ -45,10 +45,6 @@ typedef struct _uinfo
      *  the controller will process */
     ushort inputUniverse;
 
-    /** Keeps the current dmx values to send only the ones that changed */
-    /** It holds values for all the handled universes */
-    QByteArray inputData;
-
     /** This is the destination IP address used when
      *  transmitting output data. Can be broadcast or unicast,
      *  including localhost. */
@@ -62,8 +58,14 @@ typedef struct _uinfo
      *  Enumerated in ArtNetController::TransmissionMode */
     int outputTransmissionMode;
 
-    /** Universe data to be sent depending on the transmission mode */
-    QByteArray outputData;
+    /** When true, nodes latch this universe output only when
+     *  an ArtSync packet is received */
+    bool outputSync;
+
+    /** Pre-built ArtDmx packet of the output universe. Only sequence,
+     *  length and DMX values are updated in place on each transmission.
+     *  In Standard and Full mode it also holds the last full frame sent */
+    QByteArray outputPacket;
 } UniverseInfo;
 
 class ArtNetController final : public QObject
@@ -91,9 +93,6 @@ public:
     /** Return the controller IP address */
     QString getNetworkIP();
 
-    /** Returns the map of Nodes discovered by ArtPoll */
-    QHash<QHostAddress, ArtNetNodeInfo> getNodesList();
-
     /** Add a universe to the map of this controller */
     void addUniverse(quint32 universe, Type type);
 
@@ -119,6 +118,18 @@ public:
      *  Return true if this restores default transmission mode */
     bool setTransmissionMode(quint32 universe, TransmissionMode mode);
 
+    /** Mark the given universe for synchronized output.
+     *  Return true if this restores default output sync */
+    bool setOutputSync(quint32 universe, bool enable);
+
+    /** Enable/disable ArtSync transmission for this controller */
+    void setSyncEnabled(bool enable);
+    bool syncEnabled() const;
+
+    /** Send an ArtSync packet if synchronized universes have been
+     *  sent since the last call */
+    void sendSync();
+
     /** Converts a TransmissionMode value into a human readable string */
     static QString transmissionModeToString(TransmissionMode mode);
 
@@ -150,6 +161,14 @@ public:
     /** Send a RDM command */
     bool sendRDMCommand(const quint32 universe, uchar command, QVariantList params);
 
+    /** Answer the ArtPoll received from $address, with a ArtPollReply
+     *  for each universe of this controller */
+    void sendPollReply(QHostAddress const& address);
+
+    /** Count a packet received for this controller but handled elsewhere,
+     *  like the ArtPoll and ArtPollReply processed by the discovery */
+    void countPacketReceived();
+
 private:
     /** The network interface associated to this controller */
     QNetworkInterface m_interface;
@@ -178,9 +197,6 @@ private:
     /** Helper class used to create or parse ArtNet packets */
     QScopedPointer<ArtNetPacketizer> m_packetizer;
 
-    /** Map of the ArtNet nodes discovered with ArtPoll */
-    QHash<QHostAddress, ArtNetNodeInfo> m_nodesList;
-
     /** Map of the QLC+ universes transmitted/received by this
      *  controller, with the related, specific parameters */
     QMap<quint32, UniverseInfo> m_universeMap;
@@ -197,9 +213,16 @@ private:
      *  when data is not changing */
     QTimer m_sendTimer;
 
+    /** Flag to enable ArtSync transmission */
+    bool m_syncEnabled;
+
+    /** True when synchronized universes are waiting for an ArtSync */
+    bool m_syncPending;
+
+    /** Pre-built ArtSync packet */
+    QByteArray m_syncPacket;
+
 private:
-    bool handleArtNetPollReply(QByteArray const& datagram, QHostAddress const& senderAddress);
-    bool handleArtNetPoll(QByteArray const& datagram, QHostAddress const& senderAddress);
     bool handleArtNetDmx(QByteArray const& datagram, QHostAddress const& senderAddress);
     bool handleArtNetTodData(QByteArray const& datagram, QHostAddress const& senderAddress);
     bool handleArtNetRDM(QByteArray const& datagram, QHostAddress const& senderAddress);
@@ -217,6 +240,8 @@ protected slots:
 signals:
     void valueChanged(quint32 universe, quint32 input, quint32 channel, uchar value);
 
+    void universeDataChanged(quint32 universe, quint32 input, const QByteArray& data);
+
     void rdmValueChanged(quint32 universe, quint32 line, QVariantMap data);
 };
 
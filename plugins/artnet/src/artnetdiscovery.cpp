@@ -0,0 +1,253 @@
+/*
+  Q Light Controller Plus
+  artnetdiscovery.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QDebug>
+
+#include "artnetdiscovery.h"
+
+/** Minimum interval between two replies to the same sender */
+#define POLL_REPLY_INTERVAL_MS  1000
+/** Poll replies sent per second, to all the senders */
+#define POLL_REPLY_RATE         20
+/** Poll replies that can be sent in a burst */
+#define POLL_REPLY_BURST        10
+/** Interval of the node statistics update */
+#define NODE_STATS_INTERVAL_MS  1000
+/** Time without packets after which a node is removed */
+#define NODE_EXPIRE_MS          30000
+/** Packets queued at most. Beyond that, a poll storm is going on */
+#define DISCOVERY_QUEUE_SIZE    1024
+
+ArtNetDiscovery::ArtNetDiscovery(QObject *parent)
+    : QThread(parent)
+    , m_running(true)
+    , m_replyTokens(POLL_REPLY_BURST)
+    , m_tokensTime(0)
+    , m_statsTime(0)
+{
+    qRegisterMetaType<QHostAddress>("QHostAddress");
+
+    m_clock.start();
+    start(QThread::LowPriority);
+}
+
+ArtNetDiscovery::~ArtNetDiscovery()
+{
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_running = false;
+        m_queueCondition.wakeAll();
+    }
+    wait();
+}
+
+void ArtNetDiscovery::enqueue(quint16 opCode, QByteArray const& datagram, QHostAddress const& sender)
+{
+    DiscoveryPacket packet;
+    packet.opCode = opCode;
+    packet.sender = sender;
+
+    QMutexLocker locker(&m_queueMutex);
+
+    if (m_queue.count() >= DISCOVERY_QUEUE_SIZE)
+        return;
+
+    // the receiver buffer is reused as soon as this returns
+    packet.datagram = QByteArray(datagram.constData(), datagram.size());
+    m_queue.append(packet);
+    m_queueCondition.wakeOne();
+}
+
+void ArtNetDiscovery::countPacket(QHostAddress const& sender)
+{
+    QMutexLocker locker(&m_nodesMutex);
+
+    QHash<QHostAddress, NodeEntry>::iterator it = m_nodes.find(sender);
+    if (it == m_nodes.end())
+        return;
+
+    it->info.packetsReceived++;
+    it->seen = m_clock.elapsed();
+}
+
+QHash<QHostAddress, ArtNetNodeInfo> ArtNetDiscovery::nodes(QNetworkAddressEntry const& address) const
+{
+    QHash<QHostAddress, ArtNetNodeInfo> nodesList;
+    qint64 epoch = QDateTime::currentMSecsSinceEpoch() - m_clock.elapsed();
+
+    QMutexLocker locker(&m_nodesMutex);
+
+    for (QHash<QHostAddress, NodeEntry>::const_iterator it = m_nodes.constBegin(); it != m_nodes.constEnd(); ++it)
+    {
+        if (it.key().isInSubnet(address.ip(), address.prefixLength()) == false)
+            continue;
+
+        ArtNetNodeInfo info = it->info;
+        info.lastSeen = epoch + it->seen;
+        nodesList.insert(it.key(), info);
+    }
+
+    return nodesList;
+}
+
+void ArtNetDiscovery::processPoll(QHostAddress const& sender, qint64 now)
+{
+    // a sender polling faster than the interval is answered once
+    if (m_pendingReplies.contains(sender))
+        return;
+
+    QHash<QHostAddress, qint64>::const_iterator it = m_lastReply.constFind(sender);
+    if (it != m_lastReply.constEnd() && now - it.value() < POLL_REPLY_INTERVAL_MS)
+        return;
+
+    m_pendingReplies.append(sender);
+}
+
+void ArtNetDiscovery::processPollReply(QByteArray const& datagram, QHostAddress const& sender, qint64 now)
+{
+    ArtNetNodeInfo info;
+    if (ArtNetPacketizer::fillArtPollReplyInfo(datagram, info) == false)
+    {
+        qWarning() << "[ArtNet] Bad ArtPollReply received from" << sender.toString();
+        return;
+    }
+
+    QMutexLocker locker(&m_nodesMutex);
+
+    QHash<QHostAddress, NodeEntry>::iterator it = m_nodes.find(sender);
+    if (it == m_nodes.end())
+    {
+        qDebug() << "[ArtNet] new node discovered:" << sender.toString() << info.shortName;
+
+        NodeEntry entry;
+        entry.info = info;
+        entry.info.lastSeen = 0;
+        entry.info.packetsReceived = 1;
+        entry.info.packetRate = 0;
+        entry.seen = now;
+        entry.statsPackets = 0;
+        m_nodes.insert(sender, entry);
+        return;
+    }
+
+    // refresh the node information, keeping its statistics
+    info.packetsReceived = it->info.packetsReceived;
+    info.packetRate = it->info.packetRate;
+    it->info = info;
+    it->seen = now;
+}
+
+void ArtNetDiscovery::sendPollReplies(qint64 now)
+{
+    m_replyTokens = qMin(double(POLL_REPLY_BURST),
+                         m_replyTokens + double(now - m_tokensTime) * POLL_REPLY_RATE / 1000.0);
+    m_tokensTime = now;
+
+    while (m_pendingReplies.isEmpty() == false && m_replyTokens >= 1.0)
+    {
+        QHostAddress sender = m_pendingReplies.takeFirst();
+        m_lastReply[sender] = now;
+        m_replyTokens -= 1.0;
+
+        emit pollReplyRequested(sender);
+    }
+}
+
+void ArtNetDiscovery::updateStatistics(qint64 now)
+{
+    double elapsed = double(now - m_statsTime) / 1000.0;
+
+    {
+        QMutexLocker locker(&m_nodesMutex);
+
+        QMutableHashIterator<QHostAddress, NodeEntry> it(m_nodes);
+        while (it.hasNext())
+        {
+            NodeEntry &entry = it.next().value();
+
+            if (now - entry.seen > NODE_EXPIRE_MS)
+            {
+                qDebug() << "[ArtNet] node" << it.key().toString() << "is gone";
+                it.remove();
+                continue;
+            }
+
+            if (elapsed > 0)
+                entry.info.packetRate = float((entry.info.packetsReceived - entry.statsPackets) / elapsed);
+            entry.statsPackets = entry.info.packetsReceived;
+        }
+    }
+
+    // forget the senders that can be answered again
+    QMutableHashIterator<QHostAddress, qint64> rit(m_lastReply);
+    while (rit.hasNext())
+    {
+        if (now - rit.next().value() >= POLL_REPLY_INTERVAL_MS)
+            rit.remove();
+    }
+
+    m_statsTime = now;
+}
+
+void ArtNetDiscovery::run()
+{
+    m_tokensTime = m_statsTime = m_clock.elapsed();
+
+    while (true)
+    {
+        QList<DiscoveryPacket> packets;
+
+        {
+            QMutexLocker locker(&m_queueMutex);
+
+            if (m_running && m_queue.isEmpty())
+            {
+                // wake up for the statistics, or for the next reply due
+                qint64 timeout = m_statsTime + NODE_STATS_INTERVAL_MS - m_clock.elapsed();
+                if (m_pendingReplies.isEmpty() == false)
+                    timeout = qMin(timeout, qint64(1000 / POLL_REPLY_RATE));
+
+                if (timeout > 0)
+                    m_queueCondition.wait(&m_queueMutex, (unsigned long)timeout);
+            }
+
+            if (m_running == false)
+                break;
+
+            packets.swap(m_queue);
+        }
+
+        qint64 now = m_clock.elapsed();
+
+        foreach (const DiscoveryPacket &packet, packets)
+        {
+            if (packet.opCode == ARTNET_POLL)
+                processPoll(packet.sender, now);
+            else if (packet.opCode == ARTNET_POLLREPLY)
+                processPollReply(packet.datagram, packet.sender, now);
+        }
+
+        sendPollReplies(now);
+
+        if (now - m_statsTime >= NODE_STATS_INTERVAL_MS)
+            updateStatistics(now);
+    }
+}
@@ -0,0 +1,122 @@
+/*
+  Q Light Controller Plus
+  artnetdiscovery.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef ARTNETDISCOVERY_H
+#define ARTNETDISCOVERY_H
+
+#include <QNetworkAddressEntry>
+#include <QElapsedTimer>
+#include <QWaitCondition>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+
+#include "artnetpacketizer.h"
+
+/**
+ * ArtNetDiscovery keeps the table of the Art-Net nodes present on the
+ * network, in a low priority thread of its own.
+ *
+ * ArtPoll and ArtPollReply packets are queued by the receiver and
+ * processed here, so that a network with hundreds of nodes doesn't
+ * delay the DMX input. Polls are answered at a limited rate: a sender
+ * is answered at most once per interval, and all the replies are
+ * spread over time, to not flood the network after a poll storm.
+ *
+ * The node table has its own lock, so it can be queried at any time
+ * without waiting for the controllers.
+ */
+class ArtNetDiscovery final : public QThread
+{
+    Q_OBJECT
+
+public:
+    ArtNetDiscovery(QObject *parent = NULL);
+    ~ArtNetDiscovery();
+
+    /** Queue an ArtPoll or ArtPollReply packet received from $sender.
+     *  The datagram is copied, so this can be called by the receiver */
+    void enqueue(quint16 opCode, QByteArray const& datagram, QHostAddress const& sender);
+
+    /** Account a valid Art-Net packet received from $sender
+     *  in the statistics of the node */
+    void countPacket(QHostAddress const& sender);
+
+    /** Return the nodes discovered in the subnet of $address */
+    QHash<QHostAddress, ArtNetNodeInfo> nodes(QNetworkAddressEntry const& address) const;
+
+signals:
+    /** Emitted when the ArtPoll received from $sender must be answered */
+    void pollReplyRequested(QHostAddress sender);
+
+protected:
+    /** @reimp */
+    void run() override;
+
+private:
+    void processPoll(QHostAddress const& sender, qint64 now);
+    void processPollReply(QByteArray const& datagram, QHostAddress const& sender, qint64 now);
+    void sendPollReplies(qint64 now);
+    void updateStatistics(qint64 now);
+
+private:
+    typedef struct
+    {
+        quint16 opCode;
+        QByteArray datagram;
+        QHostAddress sender;
+    } DiscoveryPacket;
+
+    typedef struct
+    {
+        ArtNetNodeInfo info;
+        /** Time of the last packet received, on m_clock */
+        qint64 seen;
+        /** Packets received at the last statistics update */
+        quint64 statsPackets;
+    } NodeEntry;
+
+    /** Monotonic clock of all the node and reply times */
+    QElapsedTimer m_clock;
+
+    /** Packets waiting to be processed, protected by m_queueMutex */
+    QList<DiscoveryPacket> m_queue;
+    QMutex m_queueMutex;
+    QWaitCondition m_queueCondition;
+    bool m_running;
+
+    /** The node table, protected by m_nodesMutex */
+    QHash<QHostAddress, NodeEntry> m_nodes;
+    mutable QMutex m_nodesMutex;
+
+    /** Senders waiting for a poll reply, in order of arrival */
+    QList<QHostAddress> m_pendingReplies;
+    /** Time of the last reply sent to each sender */
+    QHash<QHostAddress, qint64> m_lastReply;
+    /** Poll replies that can be sent right away, and time of their update */
+    double m_replyTokens;
+    qint64 m_tokensTime;
+    /** Time of the last statistics update */
+    qint64 m_statsTime;
+};
+
+#endif
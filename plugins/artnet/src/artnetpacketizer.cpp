@@ -23,6 +23,8 @@
 #include <QStringList>
 #include <QDebug>
 
+#include <cstring>
+
 ArtNetPacketizer::ArtNetPacketizer()
 {
     // Initialize a commond header.
@@ -141,7 +143,7 @@ void ArtNetPacketizer::setupArtNetDmx(QByteArray& data, const int &universe, con
     data.append(m_commonHeader);
     const char opCodeMSB = (ARTNET_DMX >> 8);
     data[9] = opCodeMSB;
-    data.append(m_sequence[universe]); // Sequence
+    data.append(nextSequence(universe)); // Sequence
     data.append('\0'); // Physical
     data.append((char)(universe & 0x00FF));
     data.append((char)(universe >> 8));
@@ -151,11 +153,73 @@ void ArtNetPacketizer::setupArtNetDmx(QByteArray& data, const int &universe, con
     data.append((char)(len & 0x00FF));
     data.append(values);
     data.append(QByteArray(padLength, 0));
+}
+
+void ArtNetPacketizer::setupArtNetDmxTemplate(QByteArray &data, const int &universe)
+{
+    data.clear();
+    data.reserve(ARTNET_DMX_HEADER_SIZE + ARTNET_DMX_MAX_LENGTH);
+    data.append(m_commonHeader);
+    data[9] = char(ARTNET_DMX >> 8);
+    data.append('\0'); // Sequence, set on update
+    data.append('\0'); // Physical
+    data.append((char)(universe & 0x00FF));
+    data.append((char)(universe >> 8));
+    data.append((char)(ARTNET_DMX_MAX_LENGTH >> 8));
+    data.append((char)(ARTNET_DMX_MAX_LENGTH & 0x00FF));
+    data.append(QByteArray(ARTNET_DMX_MAX_LENGTH, 0));
+}
+
+void ArtNetPacketizer::updateArtNetDmx(QByteArray &data, const int &universe,
+                                       const char *values, int length, bool fullFrame)
+{
+    length = qBound(0, length, ARTNET_DMX_MAX_LENGTH);
+
+    // length must be even in the range 2-512
+    int padLength = fullFrame ? 0 : (length == 0 ? 2 : (length % 2));
+    int len = fullFrame ? ARTNET_DMX_MAX_LENGTH : length + padLength;
+
+    // the template capacity always fits a full frame, so this never reallocates
+    data.resize(ARTNET_DMX_HEADER_SIZE + len);
+
+    char *packet = data.data();
+    packet[12] = char(nextSequence(universe));
+    packet[16] = char(len >> 8);
+    packet[17] = char(len & 0x00FF);
+    if (length)
+        memcpy(packet + ARTNET_DMX_HEADER_SIZE, values, length);
+    if (padLength)
+        memset(packet + ARTNET_DMX_HEADER_SIZE + length, 0, padLength);
+}
 
-    if (m_sequence[universe] == 0xff)
-        m_sequence[universe] = 1;
+void ArtNetPacketizer::updateArtNetDmxSequence(QByteArray &data, const int &universe)
+{
+    if (data.size() < ARTNET_DMX_HEADER_SIZE)
+        return;
+
+    data[12] = char(nextSequence(universe));
+}
+
+uchar ArtNetPacketizer::nextSequence(const int &universe)
+{
+    uchar &sequence = m_sequence[universe];
+    uchar current = sequence;
+
+    if (sequence == 0xff)
+        sequence = 1;
     else
-        m_sequence[universe]++;
+        sequence++;
+
+    return current;
+}
+
+void ArtNetPacketizer::setupArtNetSync(QByteArray &data)
+{
+    data.clear();
+    data.append(m_commonHeader);
+    data[9] = char(ARTNET_SYNC >> 8);
+    data.append('\0'); // Aux1
+    data.append('\0'); // Aux2
 }
 
 void ArtNetPacketizer::setupArtNetTodRequest(QByteArray &data, const int &universe)
@@ -229,7 +293,8 @@ bool ArtNetPacketizer::checkPacketAndCode(QByteArray const& data, quint16 &code)
 
 bool ArtNetPacketizer::fillArtPollReplyInfo(QByteArray const& data, ArtNetNodeInfo& info)
 {
-    if (data.isNull())
+    // the reply must reach at least SwOut[0]
+    if (data.size() < 187)
         return false;
 
     QByteArray shortName = data.mid(26, 18);
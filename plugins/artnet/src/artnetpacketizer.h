@@ -31,6 +31,7 @@
 #define ARTNET_COMMAND        0x2400
 #define ARTNET_DMX            0x5000
 #define ARTNET_NZS            0x5100
+#define ARTNET_SYNC           0x5200
 #define ARTNET_ADDRESS        0x6000
 #define ARTNET_INPUT          0x7000
 #define ARTNET_TODREQUEST     0x8000
@@ -62,6 +63,9 @@
 
 #define ARTNET_CODE_STR "Art-Net"
 
+#define ARTNET_DMX_HEADER_SIZE  18
+#define ARTNET_DMX_MAX_LENGTH   512
+
 typedef struct
 {
     QString shortName;
@@ -71,6 +75,11 @@ typedef struct
     bool isOutput;
     ushort universe;
     // ... can be extended with more info to be added by fillArtPollReplyInfo
+
+    /** Node statistics, maintained by ArtNetDiscovery */
+    qint64 lastSeen;        // ms since epoch of the last packet received
+    quint64 packetsReceived;
+    float packetRate;       // packets per second
 } ArtNetNodeInfo;
 
 class ArtNetPacketizer final
@@ -96,6 +105,25 @@ public:
     /** Prepare an ArtNetDmx packet */
     void setupArtNetDmx(QByteArray& data, const int& universe, const QByteArray &values);
 
+    /** Prepare a reusable ArtNetDmx packet for the given universe, with room
+     *  for a full DMX frame. It must be updated with updateArtNetDmx before
+     *  every transmission */
+    void setupArtNetDmxTemplate(QByteArray& data, const int& universe);
+
+    /** Write sequence number, length and DMX values in place into a packet
+     *  created with setupArtNetDmxTemplate, without any allocation.
+     *  If fullFrame is true the packet always carries 512 channels and the
+     *  channels beyond length retain the values of the previous update */
+    void updateArtNetDmx(QByteArray& data, const int& universe,
+                         const char *values, int length, bool fullFrame);
+
+    /** Only advance the sequence number of a packet created with
+     *  setupArtNetDmxTemplate, to transmit it again */
+    void updateArtNetDmxSequence(QByteArray& data, const int& universe);
+
+    /** Prepare an ArtSync packet */
+    void setupArtNetSync(QByteArray& data);
+
     /** Prepare an ArtTodRequest packet */
     void setupArtNetTodRequest(QByteArray& data, const int& universe);
 
@@ -107,9 +135,10 @@ public:
      *********************************************************************/
 
     /** Verify the validity of an ArtNet packet and store the opCode in 'code' */
-    bool checkPacketAndCode(QByteArray const& data, quint16 &code);
+    static bool checkPacketAndCode(QByteArray const& data, quint16 &code);
 
-    bool fillArtPollReplyInfo(QByteArray const& data, ArtNetNodeInfo& info);
+    /** Process a ArtPollReply packet and extract the node information */
+    static bool fillArtPollReplyInfo(QByteArray const& data, ArtNetNodeInfo& info);
 
     /** Process a ArtDmx packet and extract the relevant DMX data */
     bool fillDMXdata(QByteArray const& data, QByteArray& dmx, quint32 &universe);
@@ -120,6 +149,10 @@ public:
     /** Process a ArtRdm packet and extract the relevant information */
     bool processRDMdata(const QByteArray &data, quint32 &universe, QVariantMap &values);
 
+private:
+    /** Return the next ArtDmx sequence number of the given universe */
+    uchar nextSequence(const int& universe);
+
 private:
     QByteArray m_commonHeader;
     QHash<int, uchar> m_sequence;
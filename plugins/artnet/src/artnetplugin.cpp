@@ -17,6 +17,7 @@
   limitations under the License.
 */
 
+#include <QMutexLocker>
 #include <QSettings>
 #include <QDebug>
 
@@ -30,6 +31,11 @@ bool addressCompare(const ArtNetIO &v1, const ArtNetIO &v2)
 
 ArtNetPlugin::~ArtNetPlugin()
 {
+    // the controllers must not be used by the receiver while destroyed
+    if (m_udpReceiver)
+        m_udpReceiver->stop();
+
+    delete m_discovery;
 }
 
 void ArtNetPlugin::init()
@@ -41,6 +47,15 @@ void ArtNetPlugin::init()
     else
         m_ifaceWaitTime = 0;
 
+    if (m_discovery.isNull())
+    {
+        m_discovery = new ArtNetDiscovery(this);
+        connect(m_discovery, SIGNAL(pollReplyRequested(QHostAddress)),
+                this, SLOT(slotPollReplyRequested(QHostAddress)));
+    }
+
+    QMutexLocker locker(&m_IOmappingMutex);
+
     foreach (QNetworkInterface iface, QNetworkInterface::allInterfaces())
     {
         foreach (QNetworkAddressEntry entry, iface.addressEntries())
@@ -160,7 +175,7 @@ QString ArtNetPlugin::outputInfo(quint32 output)
         str += QString("<BR>");
 
         str += tr("Nodes discovered: ");
-        str += QString("%1").arg(ctrl->getNodesList().size());
+        str += QString("%1").arg(getNodesList(output).size());
         str += QString("<BR>");
         str += tr("Packets sent: ");
         str += QString("%1").arg(ctrl->getPacketSentNumber());
@@ -180,20 +195,29 @@ bool ArtNetPlugin::openOutput(quint32 output, quint32 universe)
     qDebug() << "[ArtNet] Open output on address :" << m_IOmapping.at(output).address.ip().toString();
 
     // if the controller doesn't exist, create it
-    if (m_IOmapping[output].controller == NULL)
+    if (m_IOmapping.at(output).controller == NULL)
     {
         ArtNetController *controller = new ArtNetController(m_IOmapping.at(output).iface,
                                                             m_IOmapping.at(output).address,
                                                             getUdpSocket(),
                                                             output, this);
         connect(controller, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)),
-                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)));
+                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)), Qt::DirectConnection);
+        connect(controller, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)),
+                this, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)), Qt::DirectConnection);
         connect(controller, SIGNAL(rdmValueChanged(quint32, quint32, QVariantMap)),
                 this , SIGNAL(rdmValueChanged(quint32, quint32, QVariantMap)));
+
+        QMutexLocker locker(&m_IOmappingMutex);
         m_IOmapping[output].controller = controller;
     }
 
-    m_IOmapping[output].controller->addUniverse(universe, ArtNetController::Output);
+    // ArtSync can be disabled per interface, listing its IP in the settings
+    QSettings settings;
+    QStringList noSync = settings.value(SETTINGS_SYNC_DISABLED).toStringList();
+    m_IOmapping.at(output).controller->setSyncEnabled(noSync.contains(m_IOmapping.at(output).address.ip().toString()) == false);
+
+    m_IOmapping.at(output).controller->addUniverse(universe, ArtNetController::Output);
     addToMap(universe, output, Output);
 
     return true;
@@ -211,8 +235,12 @@ void ArtNetPlugin::closeOutput(quint32 output, quint32 universe)
         controller->removeUniverse(universe, ArtNetController::Output);
         if (controller->universesList().count() == 0)
         {
-            delete m_IOmapping[output].controller;
-            m_IOmapping[output].controller = NULL;
+            {
+                QMutexLocker locker(&m_IOmappingMutex);
+                m_IOmapping[output].controller = NULL;
+            }
+            // deleted unlocked: it might release the socket, and stop the receiver
+            delete controller;
         }
     }
 }
@@ -227,6 +255,16 @@ void ArtNetPlugin::writeUniverse(quint32 universe, quint32 output, const QByteAr
         controller->sendDmx(universe, data, dataChanged);
 }
 
+void ArtNetPlugin::flushOutputs()
+{
+    // all the universes of this tick have been sent: latch them together
+    foreach (ArtNetIO io, m_IOmapping)
+    {
+        if (io.controller != NULL)
+            io.controller->sendSync();
+    }
+}
+
 /*************************************************************************
   * Inputs
   *************************************************************************/
@@ -249,18 +287,22 @@ bool ArtNetPlugin::openInput(quint32 input, quint32 universe)
 
     // if the controller doesn't exist, create it.
     // We need to have only one input controller.
-    if (m_IOmapping[input].controller == NULL)
+    if (m_IOmapping.at(input).controller == NULL)
     {
         ArtNetController *controller = new ArtNetController(m_IOmapping.at(input).iface,
                                                             m_IOmapping.at(input).address,
                                                             getUdpSocket(),
                                                             input, this);
         connect(controller, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)),
-                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)));
+                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar)), Qt::DirectConnection);
+        connect(controller, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)),
+                this, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)), Qt::DirectConnection);
+
+        QMutexLocker locker(&m_IOmappingMutex);
         m_IOmapping[input].controller = controller;
     }
 
-    m_IOmapping[input].controller->addUniverse(universe, ArtNetController::Input);
+    m_IOmapping.at(input).controller->addUniverse(universe, ArtNetController::Input);
     addToMap(universe, input, Input);
 
     return true;
@@ -278,8 +320,11 @@ void ArtNetPlugin::closeInput(quint32 input, quint32 universe)
         controller->removeUniverse(universe, ArtNetController::Input);
         if (controller->universesList().count() == 0)
         {
-            delete m_IOmapping[input].controller;
-            m_IOmapping[input].controller = NULL;
+            {
+                QMutexLocker locker(&m_IOmappingMutex);
+                m_IOmapping[input].controller = NULL;
+            }
+            delete controller;
         }
     }
 }
@@ -362,6 +407,8 @@ void ArtNetPlugin::setParameter(quint32 universe, quint32 line, Capability type,
             unset = controller->setOutputUniverse(universe, value.toUInt());
         else if (name == ARTNET_TRANSMITMODE)
             unset = controller->setTransmissionMode(universe, ArtNetController::stringToTransmissionMode(value.toString()));
+        else if (name == ARTNET_SYNC)
+            unset = controller->setOutputSync(universe, value.toBool());
         else
         {
             qWarning() << Q_FUNC_INFO << name << "is not a valid ArtNet output parameter";
@@ -380,6 +427,14 @@ QList<ArtNetIO> ArtNetPlugin::getIOMapping() const
     return m_IOmapping;
 }
 
+QHash<QHostAddress, ArtNetNodeInfo> ArtNetPlugin::getNodesList(quint32 line) const
+{
+    if (m_discovery.isNull() || line >= (quint32)m_IOmapping.count())
+        return QHash<QHostAddress, ArtNetNodeInfo>();
+
+    return m_discovery->nodes(m_IOmapping.at(line).address);
+}
+
 /********************************************************************
  * RDM
  ********************************************************************/
@@ -409,13 +464,23 @@ QSharedPointer<QUdpSocket> ArtNetPlugin::getUdpSocket()
         return udpSocket;
 
     // Create a new socket
-    udpSocket = QSharedPointer<QUdpSocket>(new QUdpSocket());
+    udpSocket = QSharedPointer<QUdpSocket>(new QUdpSocket(), UdpReceiver::deleteSocket);
     m_udpSocket = udpSocket.toWeakRef();
 
     if (udpSocket->bind(ARTNET_PORT, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
     {
-        connect(udpSocket.data(), SIGNAL(readyRead()),
-                this, SLOT(slotReadyRead()));
+        if (UdpReceiver::isSupported())
+        {
+            m_udpReceiver = new UdpReceiver(udpSocket.data(), this);
+            connect(m_udpReceiver, SIGNAL(datagramReceived(QByteArray,QHostAddress)),
+                    this, SLOT(slotDatagramReceived(QByteArray,QHostAddress)));
+            m_udpReceiver->start(QThread::HighPriority);
+        }
+        else
+        {
+            connect(udpSocket.data(), SIGNAL(readyRead()),
+                    this, SLOT(slotReadyRead()));
+        }
     }
     else
     {
@@ -439,8 +504,79 @@ void ArtNetPlugin::slotReadyRead()
     }
 }
 
+bool ArtNetPlugin::handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                                  QHostAddress const& senderAddress)
+{
+    Q_UNUSED(socket);
+
+    // RDM packets are rare and may need to reply on the socket: leave
+    // them to the plugin thread. Everything else, which is mostly DMX
+    // data, is handled straight away in the receiver thread.
+    quint16 opCode = 0;
+    if (ArtNetPacketizer::checkPacketAndCode(datagram, opCode))
+    {
+        switch (opCode)
+        {
+            case ARTNET_TODDATA:
+            case ARTNET_RDM:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    QMutexLocker locker(&m_IOmappingMutex);
+    handlePacket(datagram, senderAddress);
+
+    return true;
+}
+
+void ArtNetPlugin::slotDatagramReceived(QByteArray datagram, QHostAddress senderAddress)
+{
+    handlePacket(datagram, senderAddress);
+}
+
+void ArtNetPlugin::slotPollReplyRequested(QHostAddress senderAddress)
+{
+    ArtNetController *controller = senderController(senderAddress);
+    if (controller != NULL)
+        controller->sendPollReply(senderAddress);
+}
+
+ArtNetController *ArtNetPlugin::senderController(QHostAddress const& senderAddress) const
+{
+    foreach (ArtNetIO io, m_IOmapping)
+    {
+        if (senderAddress.isInSubnet(io.address.ip(), io.address.prefixLength()))
+            return io.controller;
+    }
+    foreach (ArtNetIO io, m_IOmapping)
+    {
+        if (io.controller != NULL)
+            return io.controller;
+    }
+    return NULL;
+}
+
 void ArtNetPlugin::handlePacket(QByteArray const& datagram, QHostAddress const& senderAddress)
 {
+    quint16 opCode = 0;
+    if (m_discovery && ArtNetPacketizer::checkPacketAndCode(datagram, opCode))
+    {
+        m_discovery->countPacket(senderAddress);
+
+        // discovery is processed by its own thread, at a low priority
+        if (opCode == ARTNET_POLL || opCode == ARTNET_POLLREPLY)
+        {
+            ArtNetController *controller = senderController(senderAddress);
+            if (controller != NULL)
+                controller->countPacketReceived();
+
+            m_discovery->enqueue(opCode, datagram, senderAddress);
+            return;
+        }
+    }
+
     // A first filter: look for a controller on the same subnet as the sender.
     // This allows having the same ArtNet Universe on 2 different network interfaces.
     foreach (ArtNetIO io, m_IOmapping)
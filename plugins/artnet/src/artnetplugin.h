@@ -23,14 +23,19 @@
 #include <QNetworkAddressEntry>
 #include <QNetworkInterface>
 #include <QHostAddress>
+#include <QPointer>
 #include <QString>
+#include <QMutex>
 #include <QHash>
 #include <QFile>
 
 #include "qlcioplugin.h"
+#include "udpreceiver.h"
 #include "artnetcontroller.h"
+#include "artnetdiscovery.h"
 
 #define SETTINGS_IFACE_WAIT_TIME "ArtNetPlugin/ifacewait"
+#define SETTINGS_SYNC_DISABLED "ArtNetPlugin/syncdisabled"
 
 typedef struct _aio
 {
@@ -43,8 +48,9 @@ typedef struct _aio
 #define ARTNET_OUTPUTIP "outputIP"
 #define ARTNET_OUTPUTUNI "outputUni"
 #define ARTNET_TRANSMITMODE "transmitMode"
+#define ARTNET_SYNC "artSync"
 
-class ArtNetPlugin final : public QLCIOPlugin
+class ArtNetPlugin final : public QLCIOPlugin, public UdpReceiverHandler
 {
     Q_OBJECT
     Q_INTERFACES(QLCIOPlugin)
@@ -91,6 +97,9 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
 
+    /** @reimp */
+    void flushOutputs() override;
+
     /*************************************************************************
      * Inputs
      *************************************************************************/
@@ -123,10 +132,16 @@ public:
     /** Get a list of the available Input/Output lines */
     QList<ArtNetIO> getIOMapping() const;
 
+    /** Get the ArtNet nodes discovered in the network of $line */
+    QHash<QHostAddress, ArtNetNodeInfo> getNodesList(quint32 line) const;
+
 private:
     /** Map of the ArtNet plugin Input/Output lines */
     QList<ArtNetIO> m_IOmapping;
 
+    /** Protects the controllers of m_IOmapping, used by the receiver thread */
+    QMutex m_IOmappingMutex;
+
     /** Time to wait (in seconds) for interfaces to be ready */
     int m_ifaceWaitTime;
 
@@ -143,15 +158,30 @@ signals:
     /*********************************************************************
      * ArtNet socket
      *********************************************************************/
+public:
+    /** @reimp */
+    bool handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                        QHostAddress const& senderAddress) override;
+
 private:
     QSharedPointer<QUdpSocket> getUdpSocket();
     void handlePacket(QByteArray const& datagram, QHostAddress const& senderAddress);
 
+    /** Return the controller handling the packets of $senderAddress: the one
+     *  on the sender subnet if any, otherwise the first available */
+    ArtNetController *senderController(QHostAddress const& senderAddress) const;
+
 private slots:
     void slotReadyRead();
+    void slotDatagramReceived(QByteArray datagram, QHostAddress senderAddress);
+    void slotPollReplyRequested(QHostAddress senderAddress);
 
 private:
     QWeakPointer<QUdpSocket> m_udpSocket;
+    /** Thread reading m_udpSocket, where supported */
+    QPointer<UdpReceiver> m_udpReceiver;
+    /** Thread keeping the table of the nodes and answering the polls */
+    QPointer<ArtNetDiscovery> m_discovery;
 };
 
 #endif
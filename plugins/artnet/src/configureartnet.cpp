@@ -18,8 +18,10 @@
 */
 
 #include <QTreeWidgetItem>
+#include <QListWidgetItem>
 #include <QMessageBox>
 #include <QSpacerItem>
+#include <QDateTime>
 #include <QSettings>
 #include <QComboBox>
 #include <QLineEdit>
@@ -33,12 +35,15 @@
 #define KNodesColumnIP          0
 #define KNodesColumnShortName   1
 #define KNodesColumnLongName    2
+#define KNodesColumnLastSeen    3
+#define KNodesColumnPacketRate  4
 
 #define KMapColumnInterface     0
 #define KMapColumnUniverse      1
 #define KMapColumnIPAddress     2
 #define KMapColumnArtNetUni     3
 #define KMapColumnTransmitMode  4
+#define KMapColumnArtSync       5
 
 #define PROP_UNIVERSE (Qt::UserRole + 0)
 #define PROP_LINE (Qt::UserRole + 1)
@@ -63,6 +68,7 @@ ConfigureArtNet::ConfigureArtNet(ArtNetPlugin* plugin, QWidget* parent)
 
     fillNodesTree();
     fillMappingTree();
+    fillSyncList();
 
     QSettings settings;
     QVariant value = settings.value(SETTINGS_IFACE_WAIT_TIME);
@@ -88,7 +94,7 @@ void ConfigureArtNet::fillNodesTree()
         {
             QTreeWidgetItem* pitem = new QTreeWidgetItem(m_nodesTree);
             pitem->setText(KNodesColumnIP, tr("%1 nodes").arg(controller->getNetworkIP()));
-            QHash<QHostAddress, ArtNetNodeInfo> nodesList = controller->getNodesList();
+            QHash<QHostAddress, ArtNetNodeInfo> nodesList = m_plugin->getNodesList(i);
             QHashIterator<QHostAddress, ArtNetNodeInfo> it(nodesList);
             while (it.hasNext())
             {
@@ -98,6 +104,8 @@ void ConfigureArtNet::fillNodesTree()
                 nitem->setText(KNodesColumnIP, QHostAddress(it.key().toIPv4Address()).toString());
                 nitem->setText(KNodesColumnShortName, nInfo.shortName);
                 nitem->setText(KNodesColumnLongName, nInfo.longName);
+                nitem->setText(KNodesColumnLastSeen, QDateTime::fromMSecsSinceEpoch(nInfo.lastSeen).toString("hh:mm:ss"));
+                nitem->setText(KNodesColumnPacketRate, QString::number(nInfo.packetRate, 'f', 1));
             }
             prevController = controller;
         }
@@ -190,6 +198,8 @@ void ConfigureArtNet::fillMappingTree()
                 if (info->outputTransmissionMode == ArtNetController::Partial)
                     combo->setCurrentIndex(2);
                 m_uniMapTree->setItemWidget(item, KMapColumnTransmitMode, combo);
+
+                item->setCheckState(KMapColumnArtSync, info->outputSync ? Qt::Checked : Qt::Unchecked);
             }
         }
     }
@@ -197,6 +207,22 @@ void ConfigureArtNet::fillMappingTree()
     m_uniMapTree->header()->resizeSections(QHeaderView::ResizeToContents);
 }
 
+void ConfigureArtNet::fillSyncList()
+{
+    QSettings settings;
+    QStringList noSync = settings.value(SETTINGS_SYNC_DISABLED).toStringList();
+
+    foreach (ArtNetIO io, m_plugin->getIOMapping())
+    {
+        QString ip = io.address.ip().toString();
+        if (m_syncIfaceList->findItems(ip, Qt::MatchExactly).isEmpty() == false)
+            continue;
+
+        QListWidgetItem *item = new QListWidgetItem(ip, m_syncIfaceList);
+        item->setCheckState(noSync.contains(ip) ? Qt::Unchecked : Qt::Checked);
+    }
+}
+
 void ConfigureArtNet::showIPAlert(QString ip)
 {
     QMessageBox::critical(this, tr("Invalid IP"), tr("%1 is not a valid IP.\nPlease fix it before confirming.").arg(ip));
@@ -264,10 +290,33 @@ void ConfigureArtNet::accept()
                 m_plugin->setParameter(universe, line, cap, ARTNET_TRANSMITMODE,
                         ArtNetController::transmissionModeToString(transmissionMode));
             }
+
+            if (cap == QLCIOPlugin::Output)
+                m_plugin->setParameter(universe, line, cap, ARTNET_SYNC,
+                                       item->checkState(KMapColumnArtSync) == Qt::Checked);
         }
     }
 
+    QStringList noSync;
+    for (int i = 0; i < m_syncIfaceList->count(); i++)
+    {
+        QListWidgetItem *item = m_syncIfaceList->item(i);
+        if (item->checkState() == Qt::Unchecked)
+            noSync.append(item->text());
+    }
+
+    foreach (ArtNetIO io, m_plugin->getIOMapping())
+    {
+        if (io.controller != NULL)
+            io.controller->setSyncEnabled(noSync.contains(io.address.ip().toString()) == false);
+    }
+
     QSettings settings;
+    if (noSync.isEmpty())
+        settings.remove(SETTINGS_SYNC_DISABLED);
+    else
+        settings.setValue(SETTINGS_SYNC_DISABLED, noSync);
+
     int waitTime = m_waitReadySpin->value();
     if (waitTime == 0)
         settings.remove(SETTINGS_IFACE_WAIT_TIME);
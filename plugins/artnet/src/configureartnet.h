@@ -44,6 +44,7 @@ public slots:
 private:
     void fillNodesTree();
     void fillMappingTree();
+    void fillSyncList();
     void showIPAlert(QString ip);
 
 private:
@@ -17,11 +17,14 @@
   limitations under the License.
 */
 
+#include <QSignalSpy>
+#include <QDateTime>
 #include <QTest>
 
 #define private public
 #include "artnet_test.h"
 #include "artnetpacketizer.h"
+#include "artnetdiscovery.h"
 #undef private
 
 /****************************************************************************
@@ -62,4 +65,134 @@ void ArtNet_Test::setupArtNetDmx()
     QCOMPARE(data.data(), "Art-Net");
 }
 
+void ArtNet_Test::updateArtNetDmx()
+{
+    ArtNetPacketizer ap;
+
+    QByteArray data;
+    const QByteArray fifty(50, 10);
+    const QByteArray fiftyone(51, 10);
+    const QByteArray full(512, 20);
+
+    ap.setupArtNetDmxTemplate(data, 0x0102);
+
+    QCOMPARE(data.size(), 18 + 512);
+    QCOMPARE(data.data(), "Art-Net");
+    QCOMPARE(data.at(14), char(0x02));
+    QCOMPARE(data.at(15), char(0x01));
+
+    const char *buffer = data.constData();
+
+    // full frame, the previous values are retained
+    ap.updateArtNetDmx(data, 0x0102, full.constData(), full.length(), true);
+    ap.updateArtNetDmx(data, 0x0102, fifty.constData(), fifty.length(), true);
+
+    QCOMPARE(data.size(), 18 + 512);
+    QCOMPARE(data.at(16), char(0x02));
+    QCOMPARE(data.at(17), char(0x00));
+    QCOMPARE(data.at(18 + 49), char(10));
+    QCOMPARE(data.at(18 + 50), char(20));
+    QCOMPARE(data.at(12), char(1));
+
+    // partial frames are padded to an even length
+    ap.updateArtNetDmx(data, 0x0102, fiftyone.constData(), fiftyone.length(), false);
+
+    QCOMPARE(data.size(), 18 + 52);
+    QCOMPARE(data.at(17), char(52));
+    QCOMPARE(data.at(18 + 51), char(0));
+    QCOMPARE(data.at(12), char(2));
+
+    ap.updateArtNetDmx(data, 0x0102, NULL, 0, false);
+
+    QCOMPARE(data.size(), 20);
+    QCOMPARE(data.at(17), char(2));
+
+    ap.updateArtNetDmxSequence(data, 0x0102);
+    QCOMPARE(data.at(12), char(4));
+
+    // the packet has never been reallocated
+    QVERIFY(data.constData() == buffer);
+}
+
+void ArtNet_Test::setupArtNetSync()
+{
+    ArtNetPacketizer ap;
+    QByteArray data;
+    quint16 opCode = 0;
+
+    ap.setupArtNetSync(data);
+
+    QCOMPARE(data.size(), 14);
+    QCOMPARE(data.data(), "Art-Net");
+    QVERIFY(ap.checkPacketAndCode(data, opCode) == true);
+    QCOMPARE(opCode, quint16(ARTNET_SYNC));
+}
+
+void ArtNet_Test::discoveryNodes()
+{
+    ArtNetPacketizer ap;
+    ArtNetDiscovery discovery;
+    QHostAddress node("192.168.1.10");
+    QByteArray data;
+
+    QNetworkAddressEntry lan;
+    lan.setIp(QHostAddress("192.168.1.1"));
+    lan.setPrefixLength(24);
+
+    QNetworkAddressEntry other;
+    other.setIp(QHostAddress("10.0.0.1"));
+    other.setPrefixLength(8);
+
+    // packets of unknown nodes are not accounted
+    discovery.countPacket(node);
+    QCOMPARE(discovery.nodes(lan).count(), 0);
+
+    ap.setupArtNetPollReply(data, node, "11:22:33:44:55:66", 3, false);
+    discovery.enqueue(ARTNET_POLLREPLY, data, node);
+
+    QTRY_COMPARE(discovery.nodes(lan).count(), 1);
+    QCOMPARE(discovery.nodes(other).count(), 0);
+
+    ArtNetNodeInfo info = discovery.nodes(lan).value(node);
+    QCOMPARE(info.shortName, QString("QLC+"));
+    QCOMPARE(info.packetsReceived, quint64(1));
+    QVERIFY(qAbs(info.lastSeen - QDateTime::currentMSecsSinceEpoch()) < 5000);
+
+    discovery.countPacket(node);
+    discovery.countPacket(node);
+    QCOMPARE(discovery.nodes(lan).value(node).packetsReceived, quint64(3));
+
+    // truncated replies are discarded
+    discovery.enqueue(ARTNET_POLLREPLY, data.left(100), QHostAddress("192.168.1.11"));
+    QTest::qWait(100);
+    QCOMPARE(discovery.nodes(lan).count(), 1);
+}
+
+void ArtNet_Test::discoveryPollRate()
+{
+    ArtNetPacketizer ap;
+    ArtNetDiscovery discovery;
+    QSignalSpy spy(&discovery, SIGNAL(pollReplyRequested(QHostAddress)));
+    QHostAddress controller("192.168.1.20");
+    QByteArray data;
+
+    ap.setupArtNetPoll(data);
+
+    // a sender polling repeatedly is answered once per interval
+    for (int i = 0; i < 10; i++)
+        discovery.enqueue(ARTNET_POLL, data, controller);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QHostAddress>(), controller);
+
+    QTest::qWait(200);
+    QCOMPARE(spy.count(), 1);
+
+    // many senders are all answered, at a limited rate
+    for (int i = 0; i < 40; i++)
+        discovery.enqueue(ARTNET_POLL, data, QHostAddress(QString("192.168.2.%1").arg(i + 1)));
+
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 41, 10000);
+}
+
 QTEST_MAIN(ArtNet_Test)
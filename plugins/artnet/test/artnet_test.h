@@ -28,6 +28,10 @@ class ArtNet_Test final : public QObject
 
 private slots:
     void setupArtNetDmx();
+    void updateArtNetDmx();
+    void setupArtNetSync();
+    void discoveryNodes();
+    void discoveryPollRate();
 };
 
 #endif
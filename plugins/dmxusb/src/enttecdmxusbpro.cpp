@@ -17,6 +17,7 @@
   limitations under the License.
 */
 
+#include <QMutexLocker>
 #include <QDebug>
 
 #include "enttecdmxusbpro.h"
@@ -57,6 +58,9 @@
 
 #define MAX_READ_ATTEMPTS   5
 
+/** Interval of the output statistics update, in nanoseconds */
+#define STATS_INTERVAL_NS   1000000000LL
+
 //#define DEBUG_RDM
 
 /****************************************************************************
@@ -67,6 +71,12 @@ EnttecDMXUSBPro::EnttecDMXUSBPro(DMXInterface *iface, quint32 outputLine, quint3
     : QThread(NULL)
     , DMXUSBWidget(iface, outputLine, DEFAULT_OUTPUT_FREQUENCY)
     , m_dmxKingMode(false)
+    , m_frameStats(FrameStats())
+    , m_statsFrames(0)
+    , m_statsWriteTime(0)
+    , m_statsMaxWriteTime(0)
+    , m_statsTime(0)
+    , m_nextFrame(0)
     , m_isThreadRunning(false)
     , m_rdm(NULL)
     , m_universe(UINT_MAX)
@@ -321,6 +331,22 @@ QString EnttecDMXUSBPro::additionalInfo() const
     info += QString("<B>%1:</B> %2").arg(tr("Serial number")).arg(m_proSerial);
     info += QString("</P>");
 
+    if (m_isThreadRunning)
+    {
+        FrameStats stats = frameStats();
+
+        info += QString("<P>");
+        info += QString("<B>%1:</B> %2 Hz").arg(tr("Output frame rate")).arg(stats.fps, 0, 'f', 1);
+        info += QString("<BR>");
+        info += QString("<B>%1:</B> %2 us (max %3 us)").arg(tr("Write latency"))
+                                                       .arg(stats.writeLatencyUs).arg(stats.maxWriteLatencyUs);
+        info += QString("<BR>");
+        info += QString("<B>%1:</B> %2").arg(tr("Dropped frames")).arg(stats.droppedFrames);
+        info += QString("<BR>");
+        info += QString("<B>%1:</B> %2").arg(tr("Late frames")).arg(stats.lateFrames);
+        info += QString("</P>");
+    }
+
     return info;
 }
 
@@ -659,16 +685,146 @@ bool EnttecDMXUSBPro::writeUniverse(quint32 universe, quint32 output, const QByt
     if (portIndex >= quint32(m_portsInfo.count()))
         return false;
 
-    if (m_portsInfo[portIndex].m_universeData.size() == 0)
+    QMutexLocker locker(&m_outputMutex);
+
+    if (m_pendingFrames.count() != m_portsInfo.count())
+        m_pendingFrames.resize(m_portsInfo.count());
+
+    PendingFrame &frame = m_pendingFrames[portIndex];
+
+    // unchanged data is written again from the output thread buffer
+    if (dataChanged == false && frame.data.isNull() == false)
+        return true;
+
+    // the output thread writes only the latest frame of each DMX frame
+    if (frame.pending)
+        m_frameStats.droppedFrames++;
+
+    // no copy here: the data is copied by the output thread when due
+    frame.data = data;
+    frame.pending = true;
+
+    return true;
+}
+
+EnttecDMXUSBPro::FrameStats EnttecDMXUSBPro::frameStats() const
+{
+    QMutexLocker locker(&m_outputMutex);
+    return m_frameStats;
+}
+
+void EnttecDMXUSBPro::takePendingFrames()
+{
+    QMutexLocker locker(&m_outputMutex);
+
+    for (int i = 0; i < m_pendingFrames.count() && i < m_portsInfo.count(); i++)
     {
-        m_portsInfo[portIndex].m_universeData.append(data);
-        m_portsInfo[portIndex].m_universeData.append(DMX_CHANNELS - data.size(), 0);
+        PendingFrame &frame = m_pendingFrames[i];
+        if (frame.pending == false)
+            continue;
+
+        QByteArray &universeData = m_portsInfo[i].m_universeData;
+        if (universeData.size() < frame.data.size() || universeData.size() < DMX_CHANNELS)
+            universeData.append(qMax(frame.data.size(), DMX_CHANNELS) - universeData.size(), 0);
+
+        universeData.replace(0, frame.data.size(), frame.data);
+        frame.pending = false;
     }
+}
 
-    if (dataChanged)
-        m_portsInfo[portIndex].m_universeData.replace(0, data.size(), data);
+qint64 EnttecDMXUSBPro::writeDMXFrame()
+{
+    // the buffer capacity is reserved: this doesn't allocate
+    m_outputFrame.resize(0);
 
-    return true;
+    for (int i = 0; i < m_portsInfo.count(); i++)
+    {
+        const DMXUSBLineInfo &port = m_portsInfo.at(i);
+
+        // consider only open DMX output ports
+        if (port.m_openDirection != DMXUSBWidget::Output || (port.m_portFlags & DMXUSBWidget::MIDI))
+            continue;
+
+        int dataLen = port.m_universeData.length();
+        if (dataLen == 0)
+            continue;
+
+        m_outputFrame.append(ENTTEC_PRO_START_OF_MSG); // Start byte
+
+        // Command - port selection
+        if (m_dmxKingMode)
+            m_outputFrame.append(DMXKING_SEND_DMX_PORT1 + i);
+        else
+            m_outputFrame.append(i == 0 ? ENTTEC_PRO_SEND_DMX_RQ : ENTTEC_PRO_SEND_DMX_RQ2);
+
+        m_outputFrame.append((dataLen + 1) & 0xff); // Data length LSB
+        m_outputFrame.append(((dataLen + 1) >> 8) & 0xff); // Data length MSB
+        m_outputFrame.append(char(ENTTEC_PRO_DMX_ZERO)); // DMX start code (Which constitutes the + 1 below)
+        m_outputFrame.append(port.m_universeData);
+        m_outputFrame.append(ENTTEC_PRO_END_OF_MSG); // Stop byte
+    }
+
+    if (m_outputFrame.isEmpty())
+        return -1;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    /* Write the "Output Only Send DMX Packet Request" messages of all
+     * the ports at once, so they travel in the same USB transfer */
+    if (iface()->write(m_outputFrame) == false)
+    {
+        qWarning() << Q_FUNC_INFO << name() << "will not accept DMX data";
+        return -1;
+    }
+
+    return timer.nsecsElapsed();
+}
+
+void EnttecDMXUSBPro::updateFrameStats(qint64 now, qint64 writeTime, bool late)
+{
+    QMutexLocker locker(&m_outputMutex);
+
+    if (late)
+        m_frameStats.lateFrames++;
+
+    if (writeTime >= 0)
+    {
+        m_frameStats.framesSent++;
+        m_statsFrames++;
+        m_statsWriteTime += writeTime;
+        m_statsMaxWriteTime = qMax(m_statsMaxWriteTime, writeTime);
+    }
+
+    if (now - m_statsTime < STATS_INTERVAL_NS)
+        return;
+
+    m_frameStats.fps = double(m_statsFrames) * 1000000000.0 / double(now - m_statsTime);
+    m_frameStats.writeLatencyUs = m_statsFrames ? m_statsWriteTime / qint64(m_statsFrames) / 1000 : 0;
+    m_frameStats.maxWriteLatencyUs = m_statsMaxWriteTime / 1000;
+
+    m_statsFrames = 0;
+    m_statsWriteTime = 0;
+    m_statsMaxWriteTime = 0;
+    m_statsTime = now;
+}
+
+qint64 EnttecDMXUSBPro::scheduleNextFrame(qint64 now, qint64 writeTime)
+{
+    qint64 frameTime = qint64(m_frameTimeUs) * 1000;
+    m_nextFrame += frameTime;
+    bool late = now > m_nextFrame;
+
+    updateFrameStats(now, writeTime, late);
+
+    if (late == false)
+        return m_nextFrame - now;
+
+    // more than a frame behind: don't try to catch up
+    if (now - m_nextFrame > frameTime)
+        m_nextFrame = now;
+
+    return 0;
 }
 
 /************************************************************************
@@ -678,17 +834,32 @@ bool EnttecDMXUSBPro::writeUniverse(quint32 universe, quint32 output, const QByt
 void EnttecDMXUSBPro::run()
 {
     qDebug() << "ENTTEC PRO: INPUT/OUTPUT thread started";
-    QElapsedTimer timer;
 
     /** Flag that indicates if the IO thread
      *  should read input data as well */
     bool readInput = false;
 
+    // frames are paced on absolute deadlines of a monotonic clock, so
+    // that the time spent in the loop doesn't make the frame rate drift
+    QElapsedTimer clock;
+    clock.start();
+    m_nextFrame = 0;
+
+    {
+        QMutexLocker locker(&m_outputMutex);
+        m_frameStats = FrameStats();
+        m_statsFrames = 0;
+        m_statsWriteTime = 0;
+        m_statsMaxWriteTime = 0;
+        m_statsTime = 0;
+    }
+    m_outputFrame.reserve(m_portsInfo.count() * (DMX_CHANNELS + 6));
+
     m_isThreadRunning = true;
 
     while (m_isThreadRunning == true)
     {
-        timer.restart();
+        qint64 writeTime = -1;
 
         /* **************************************************************
          *                       CHECK PENDING ACTIONS
@@ -860,6 +1031,9 @@ void EnttecDMXUSBPro::run()
         /* **************************************************************
          *               SEND DMX OR MIDI DATA TO OUTPUT PORTS
          * ************************************************************ */
+        // only the latest data posted for each port is written
+        takePendingFrames();
+
         for (int i = 0; i < m_portsInfo.count(); i++)
         {
             // consider only open output ports
@@ -915,35 +1089,10 @@ void EnttecDMXUSBPro::run()
                     }
                 }
             }
-            else
-            {
-                QByteArray request;
-                request.append(ENTTEC_PRO_START_OF_MSG); // Start byte
-
-                // Command - port selection
-                if (m_dmxKingMode)
-                    request.append(DMXKING_SEND_DMX_PORT1 + i);
-                else
-                    request.append(i == 0 ? ENTTEC_PRO_SEND_DMX_RQ : ENTTEC_PRO_SEND_DMX_RQ2);
-
-                request.append((dataLen + 1) & 0xff); // Data length LSB
-                request.append(((dataLen + 1) >> 8) & 0xff); // Data length MSB
-                request.append(char(ENTTEC_PRO_DMX_ZERO)); // DMX start code (Which constitutes the + 1 below)
-                request.append(m_portsInfo[i].m_universeData);
-                request.append(ENTTEC_PRO_END_OF_MSG); // Stop byte
-
-                //qDebug() << "OUTPUT" << request.length() << "bytes on line" << i;
-                //qDebug() << "DATA" << QString::number(request.at(5)) << QString::number(request.at(6)) << QString::number(request.at(7));
-
-                /* Write "Output Only Send DMX Packet Request" message */
-                if (iface()->write(request) == false)
-                {
-                    qWarning() << Q_FUNC_INFO << name() << "will not accept DMX data";
-                    continue;
-                }
-            }
         }
 
+        writeTime = writeDMXFrame();
+
         /* **************************************************************
          *                  READ DMX OR MIDI INPUT DATA
          * ************************************************************ */
@@ -1020,11 +1169,9 @@ void EnttecDMXUSBPro::run()
         }
 
 framesleep:
-        int timetoSleep = m_frameTimeUs - (timer.nsecsElapsed() / 1000);
-        if (timetoSleep < 0)
-            qWarning() << "DMX output is running late!";
-        else
-            usleep(timetoSleep);
+        qint64 sleepTime = scheduleNextFrame(clock.nsecsElapsed(), writeTime);
+        if (sleepTime > 0)
+            usleep(sleepTime / 1000);
     }
 
     qDebug() << "INPUT/OUTPUT thread terminated";
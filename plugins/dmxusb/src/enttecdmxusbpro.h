@@ -23,6 +23,8 @@
 #include <QByteArray>
 #include <QVariant>
 #include <QThread>
+#include <QVector>
+#include <QMutex>
 
 #include "dmxusbwidget.h"
 
@@ -142,6 +144,71 @@ public:
     /** @reimp */
     bool writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
 
+    /** Output timing statistics, measured by the input/output thread */
+    typedef struct
+    {
+        /** Frames written per second, over the last second */
+        double fps;
+        /** Average and maximum time spent writing a frame, in microseconds */
+        qint64 writeLatencyUs;
+        qint64 maxWriteLatencyUs;
+        /** Frames written to the device */
+        quint64 framesSent;
+        /** Frames replaced by a newer one before they could be written */
+        quint64 droppedFrames;
+        /** Frames that missed their time slot */
+        quint64 lateFrames;
+    } FrameStats;
+
+    /** Return the output timing statistics */
+    FrameStats frameStats() const;
+
+private:
+    /** Take the frames posted by writeUniverse since the last DMX frame */
+    void takePendingFrames();
+
+    /** Write the DMX data of all the open output ports with a single
+     *  transfer. Return the time spent writing, in nanoseconds */
+    qint64 writeDMXFrame();
+
+    /** Account a written frame in the statistics */
+    void updateFrameStats(qint64 now, qint64 writeTime, bool late);
+
+    /** Move the frame deadline one frame ahead and account the frame
+     *  written in $writeTime ns. Return how long to sleep before the
+     *  next frame, in nanoseconds of the output thread clock ($now) */
+    qint64 scheduleNextFrame(qint64 now, qint64 writeTime);
+
+private:
+    /** Protects the pending frames and the statistics */
+    mutable QMutex m_outputMutex;
+
+    typedef struct
+    {
+        /** The latest data posted for the port, implicitly shared */
+        QByteArray data;
+        /** True until the output thread takes it */
+        bool pending;
+    } PendingFrame;
+
+    /** Latest data posted for each port, waiting for the next DMX frame.
+     *  Only the last one is written: older ones are counted as dropped */
+    QVector<PendingFrame> m_pendingFrames;
+
+    /** Buffer of the messages sent on each DMX frame, allocated once */
+    QByteArray m_outputFrame;
+
+    FrameStats m_frameStats;
+
+    /** Frames and write time accounted since the last fps update */
+    quint64 m_statsFrames;
+    qint64 m_statsWriteTime;
+    qint64 m_statsMaxWriteTime;
+    qint64 m_statsTime;
+
+    /** Deadline of the next frame, on the output thread clock */
+    qint64 m_nextFrame;
+
     /************************************************************************
      * Input/Output Thread
      ************************************************************************/
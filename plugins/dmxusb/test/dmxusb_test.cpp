@@ -0,0 +1,315 @@
+/*
+  Q Light Controller Plus
+  dmxusb_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QTest>
+
+#define private public
+#include "dmxusb_test.h"
+#include "enttecdmxusbpro.h"
+#include "dmxinterface.h"
+#undef private
+
+/** One millisecond on the output thread clock, in nanoseconds */
+#define MS 1000000LL
+
+/** A DMX interface that records what is written to it, instead of
+ *  talking to an actual device. Reads always return no data.
+ *  It reports itself as a QtSerial interface, the backend a pty
+ *  would stand in for, without needing one on the test machine. */
+class FakeInterface final : public DMXInterface
+{
+public:
+    FakeInterface()
+        : DMXInterface("FAKE0001", "DMX USB PRO", "ENTTEC", FTDIVID, FTDIPID)
+        , m_open(false)
+    {
+    }
+
+    DMXInterface::Type type() const override { return DMXInterface::QtSerial; }
+    QString typeString() const override { return QString("Fake"); }
+    bool open() override { m_open = true; return true; }
+    bool openByPID(const int FTDIPID) override { Q_UNUSED(FTDIPID) return open(); }
+    bool close() override { m_open = false; return true; }
+    bool isOpen() const override { return m_open; }
+    bool reset() override { return true; }
+    bool setLineProperties() override { return true; }
+    bool setBaudRate() override { return true; }
+    bool setFlowControl() override { return true; }
+    bool setLowLatency(bool lowLatency) override { Q_UNUSED(lowLatency) return true; }
+    bool clearRts() override { return true; }
+    bool purgeBuffers() override { return true; }
+    bool setBreak(bool on) override { Q_UNUSED(on) return true; }
+    QByteArray read(int size) override { Q_UNUSED(size) return QByteArray(); }
+
+    uchar readByte(bool *ok = NULL) override
+    {
+        if (ok)
+            *ok = false;
+        return 0;
+    }
+
+    bool write(const QByteArray& data) override
+    {
+        QMutexLocker locker(&m_mutex);
+        m_writes.append(data);
+
+        return true;
+    }
+
+    /** Return the "Send DMX" messages written so far */
+    QList<QByteArray> dmxFrames() const
+    {
+        QMutexLocker locker(&m_mutex);
+        QList<QByteArray> frames;
+
+        for (int i = 0; i < m_writes.count(); i++)
+        {
+            const QByteArray &data = m_writes.at(i);
+            if (data.size() < 2 || data.at(0) != char(0x7E) || data.at(1) != char(0x06))
+                continue;
+
+            frames.append(data);
+        }
+
+        return frames;
+    }
+
+    void clearWrites()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_writes.clear();
+    }
+
+private:
+    bool m_open;
+    mutable QMutex m_mutex;
+    QList<QByteArray> m_writes;
+};
+
+void DMXUSB_Test::frameLayout()
+{
+    FakeInterface *iface = new FakeInterface();
+    EnttecDMXUSBPro pro(iface, 0);
+
+    // open the output port without starting the output thread
+    iface->open();
+    pro.m_portsInfo[0].m_openDirection = DMXUSBWidget::Output;
+    iface->clearWrites();
+
+    QByteArray data(DMX_CHANNELS, 0);
+    data[0] = char(0x11);
+    data[DMX_CHANNELS - 1] = char(0x22);
+
+    QVERIFY(pro.writeUniverse(0, 0, data, true) == true);
+    pro.takePendingFrames();
+    QVERIFY(pro.writeDMXFrame() >= 0);
+
+    QList<QByteArray> frames = iface->dmxFrames();
+    QCOMPARE(frames.count(), 1);
+
+    QByteArray frame = frames.first();
+    QCOMPARE(frame.size(), DMX_CHANNELS + 6);
+    QCOMPARE(frame.at(0), char(0x7E)); // start of message
+    QCOMPARE(frame.at(1), char(0x06)); // send DMX request
+    QCOMPARE(frame.at(2), char(0x01)); // 513 bytes, LSB
+    QCOMPARE(frame.at(3), char(0x02)); // 513 bytes, MSB
+    QCOMPARE(frame.at(4), char(0x00)); // DMX start code
+    QCOMPARE(frame.mid(5, DMX_CHANNELS), data);
+    QCOMPARE(frame.at(frame.size() - 1), char(0xE7)); // end of message
+
+    // a short universe updates only its channels and keeps the frame full size
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(24, char(0x33)), true) == true);
+    pro.takePendingFrames();
+    QVERIFY(pro.writeDMXFrame() >= 0);
+
+    frames = iface->dmxFrames();
+    QCOMPARE(frames.count(), 2);
+    frame = frames.last();
+    QCOMPARE(frame.size(), DMX_CHANNELS + 6);
+    QCOMPARE(frame.at(5), char(0x33));
+    QCOMPARE(frame.at(5 + 23), char(0x33));
+    QCOMPARE(frame.at(5 + 24), char(0x00));
+    QCOMPARE(frame.at(5 + DMX_CHANNELS - 1), char(0x22));
+
+    // nothing is written when no output port is open
+    pro.m_portsInfo[0].m_openDirection = DMXUSBWidget::None;
+    QCOMPARE(pro.writeDMXFrame(), qint64(-1));
+    QCOMPARE(iface->dmxFrames().count(), 2);
+}
+
+void DMXUSB_Test::droppedFrames()
+{
+    FakeInterface *iface = new FakeInterface();
+    EnttecDMXUSBPro pro(iface, 0);
+
+    iface->open();
+    pro.m_portsInfo[0].m_openDirection = DMXUSBWidget::Output;
+
+    // the first frame is taken even if unchanged
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x01)), false) == true);
+    QCOMPARE(pro.m_pendingFrames[0].pending, true);
+    QCOMPARE(pro.frameStats().droppedFrames, quint64(0));
+
+    // only the latest frame is written: the older ones are dropped
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x02)), true) == true);
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x03)), true) == true);
+    QCOMPARE(pro.frameStats().droppedFrames, quint64(2));
+
+    pro.takePendingFrames();
+    QCOMPARE(pro.m_pendingFrames[0].pending, false);
+    QCOMPARE(pro.m_portsInfo[0].m_universeData, QByteArray(DMX_CHANNELS, char(0x03)));
+
+    // unchanged data is not posted again
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x03)), false) == true);
+    QCOMPARE(pro.m_pendingFrames[0].pending, false);
+    QCOMPARE(pro.frameStats().droppedFrames, quint64(2));
+
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x04)), true) == true);
+    QCOMPARE(pro.frameStats().droppedFrames, quint64(2));
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x05)), true) == true);
+    QCOMPARE(pro.frameStats().droppedFrames, quint64(3));
+
+    // invalid output line
+    QVERIFY(pro.writeUniverse(0, 1, QByteArray(DMX_CHANNELS, char(0x06)), true) == false);
+
+    // closed device
+    iface->close();
+    QVERIFY(pro.writeUniverse(0, 0, QByteArray(DMX_CHANNELS, char(0x07)), true) == false);
+    QCOMPARE(pro.frameStats().droppedFrames, quint64(3));
+}
+
+void DMXUSB_Test::statistics()
+{
+    FakeInterface *iface = new FakeInterface();
+    EnttecDMXUSBPro pro(iface, 0);
+
+    pro.updateFrameStats(500000000LL, 1000, false);
+
+    EnttecDMXUSBPro::FrameStats stats = pro.frameStats();
+    QCOMPARE(stats.framesSent, quint64(1));
+    QCOMPARE(stats.lateFrames, quint64(0));
+    // the rates are updated once per second
+    QCOMPARE(stats.fps, 0.0);
+
+    pro.updateFrameStats(1000000000LL, 3000, true);
+
+    stats = pro.frameStats();
+    QCOMPARE(stats.framesSent, quint64(2));
+    QCOMPARE(stats.lateFrames, quint64(1));
+    QCOMPARE(stats.fps, 2.0);
+    QCOMPARE(stats.writeLatencyUs, qint64(2));
+    QCOMPARE(stats.maxWriteLatencyUs, qint64(3));
+
+    // a failed write is not a sent frame
+    pro.updateFrameStats(1500000000LL, -1, true);
+    pro.updateFrameStats(2000000000LL, -1, false);
+
+    stats = pro.frameStats();
+    QCOMPARE(stats.framesSent, quint64(2));
+    QCOMPARE(stats.lateFrames, quint64(2));
+    QCOMPARE(stats.fps, 0.0);
+    QCOMPARE(stats.writeLatencyUs, qint64(0));
+    QCOMPARE(stats.maxWriteLatencyUs, qint64(0));
+}
+
+void DMXUSB_Test::outputPacing()
+{
+    FakeInterface *iface = new FakeInterface();
+    EnttecDMXUSBPro pro(iface, 0);
+
+    // 50Hz: a frame every 20ms
+    pro.setOutputFrequency(50);
+
+    // each loop takes 5ms, then sleeps until the deadline
+    qint64 now = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        now += 5 * MS;
+        qint64 sleepTime = pro.scheduleNextFrame(now, 1 * MS);
+        QCOMPARE(sleepTime, 15 * MS);
+        now += sleepTime;
+    }
+    QCOMPARE(now, 200 * MS);
+
+    // deadlines are absolute: oversleeping shortens the next sleep
+    now += 3 * MS;
+    now += 5 * MS;
+    QCOMPARE(pro.scheduleNextFrame(now, 1 * MS), 12 * MS);
+
+    EnttecDMXUSBPro::FrameStats stats = pro.frameStats();
+    QCOMPARE(stats.framesSent, quint64(11));
+    QCOMPARE(stats.lateFrames, quint64(0));
+    QCOMPARE(stats.droppedFrames, quint64(0));
+
+    // a failed write is not a sent frame
+    now = 240 * MS;
+    QCOMPARE(pro.scheduleNextFrame(now, -1), 0LL);
+    QCOMPARE(pro.frameStats().framesSent, quint64(11));
+}
+
+void DMXUSB_Test::slowDevice()
+{
+    FakeInterface *iface = new FakeInterface();
+    EnttecDMXUSBPro pro(iface, 0);
+
+    pro.setOutputFrequency(50);
+
+    QCOMPARE(pro.scheduleNextFrame(5 * MS, 1 * MS), 15 * MS);
+
+    // a 30ms write misses the 40ms deadline: no sleep
+    QCOMPARE(pro.scheduleNextFrame(50 * MS, 30 * MS), 0LL);
+    QCOMPARE(pro.frameStats().lateFrames, quint64(1));
+
+    // less than a frame behind, the next deadline is kept to catch up
+    QCOMPARE(pro.scheduleNextFrame(55 * MS, 1 * MS), 5 * MS);
+
+    // more than a frame behind, the pacing restarts from now
+    QCOMPARE(pro.scheduleNextFrame(110 * MS, 50 * MS), 0LL);
+    QCOMPARE(pro.scheduleNextFrame(115 * MS, 1 * MS), 15 * MS);
+
+    EnttecDMXUSBPro::FrameStats stats = pro.frameStats();
+    QCOMPARE(stats.framesSent, quint64(5));
+    QCOMPARE(stats.lateFrames, quint64(2));
+}
+
+void DMXUSB_Test::outputThread()
+{
+    FakeInterface *iface = new FakeInterface();
+    EnttecDMXUSBPro *pro = new EnttecDMXUSBPro(iface, 0);
+    QByteArray data(DMX_CHANNELS, char(0x7F));
+
+    // the output thread writes the posted universe on its own
+    pro->setOutputFrequency(50);
+    QVERIFY(pro->open(0, false) == true);
+    QVERIFY(pro->writeUniverse(0, 0, data, true) == true);
+    QTRY_VERIFY(iface->dmxFrames().count() > 0 &&
+                iface->dmxFrames().last().mid(5, DMX_CHANNELS) == data);
+
+    data.fill(char(0x10));
+    QVERIFY(pro->writeUniverse(0, 0, data, true) == true);
+    QTRY_VERIFY(iface->dmxFrames().last().mid(5, DMX_CHANNELS) == data);
+
+    EnttecDMXUSBPro::FrameStats stats = pro->frameStats();
+    QVERIFY(stats.framesSent > 0);
+
+    delete pro;
+}
+
+QTEST_GUILESS_MAIN(DMXUSB_Test)
@@ -19,6 +19,7 @@
 
 #include <QSettings>
 
+#include "dummyinputgenerator.h"
 #include "dummyconfiguration.h"
 #include "dummyplugin.h"
 
@@ -37,15 +38,20 @@ DummyConfiguration::DummyConfiguration(DummyPlugin* plugin, QWidget* parent)
     /* Setup UI controls */
     setupUi(this);
 
+    m_linesSpin->setMaximum(DUMMY_MAX_LINES);
+    m_linesSpin->setValue(m_plugin->lineCount());
+    m_writeDelaySpin->setValue(m_plugin->writeDelay());
+
+    DummyInputGenerator *generator = m_plugin->inputGenerator();
+    m_inputRateSpin->setMaximum(DUMMY_MAX_INPUT_RATE);
+    m_inputRateSpin->setValue(generator->rate());
+    m_inputPatternCombo->setCurrentIndex(generator->pattern());
+    m_inputChannelsSpin->setValue(generator->channels());
+
     QSettings settings;
     QVariant geometrySettings = settings.value(SETTINGS_GEOMETRY);
     if (geometrySettings.isValid() == true)
         restoreGeometry(geometrySettings.toByteArray());
-
-    /**
-     * Do the dialog initializations here.
-     *  E.g.: fill combo boxes, set spin boxes values, fill lists, etc...
-     */
 }
 
 DummyConfiguration::~DummyConfiguration()
@@ -60,16 +66,32 @@ DummyConfiguration::~DummyConfiguration()
 
 void DummyConfiguration::accept()
 {
-    /** Write code before QDialog::accept if you want to immediately
-     *  apply the changes via m_plugin methods. */
-
     QDialog::accept();
+}
+
+int DummyConfiguration::lineCount() const
+{
+    return m_linesSpin->value();
+}
+
+int DummyConfiguration::writeDelay() const
+{
+    return m_writeDelaySpin->value();
+}
+
+int DummyConfiguration::inputRate() const
+{
+    return m_inputRateSpin->value();
+}
 
-    /** Otherwise just call QDialog::accept() and implement
-     *  the configuration changes in DummyPlugin::configure()
-     *  by calling DummyConfiguration methods (that you have to add)
-     *  before destroying it
-     */
+int DummyConfiguration::inputPattern() const
+{
+    return m_inputPatternCombo->currentIndex();
+}
+
+int DummyConfiguration::inputChannels() const
+{
+    return m_inputChannelsSpin->value();
 }
 
 int DummyConfiguration::exec()
@@ -38,6 +38,13 @@ public:
     /** @reimp */
     void accept() override;
 
+    /** Get the values set by the user */
+    int lineCount() const;
+    int writeDelay() const;
+    int inputRate() const;
+    int inputPattern() const;
+    int inputChannels() const;
+
 public slots:
     int exec();
 
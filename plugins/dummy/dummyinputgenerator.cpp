@@ -0,0 +1,230 @@
+/*
+  Q Light Controller Plus
+  dummyinputgenerator.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QDebug>
+#include <climits>
+#include <cstring>
+
+#include "dummyinputgenerator.h"
+
+#define UNIVERSE_SIZE       512
+#define NS_PER_SECOND       Q_INT64_C(1000000000)
+/** Interval of the statistics update */
+#define STATS_INTERVAL_NS   NS_PER_SECOND
+
+DummyInputGenerator::DummyInputGenerator(QObject *parent)
+    : QThread(parent)
+    , m_rate(0)
+    , m_pattern(Ramp)
+    , m_channels(UNIVERSE_SIZE)
+    , m_running(true)
+    , m_randomSeed(0x2545F491)
+{
+    m_stats.fps = 0;
+    m_stats.framesGenerated = 0;
+    m_stats.lateFrames = 0;
+
+    start();
+}
+
+DummyInputGenerator::~DummyInputGenerator()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_running = false;
+        m_condition.wakeAll();
+    }
+    wait();
+}
+
+int DummyInputGenerator::rate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rate;
+}
+
+void DummyInputGenerator::setRate(int rate)
+{
+    QMutexLocker locker(&m_mutex);
+    m_rate = qBound(0, rate, DUMMY_MAX_INPUT_RATE);
+    m_condition.wakeAll();
+}
+
+DummyInputGenerator::Pattern DummyInputGenerator::pattern() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pattern;
+}
+
+void DummyInputGenerator::setPattern(DummyInputGenerator::Pattern pattern)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pattern = pattern;
+}
+
+int DummyInputGenerator::channels() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_channels;
+}
+
+void DummyInputGenerator::setChannels(int channels)
+{
+    QMutexLocker locker(&m_mutex);
+    m_channels = qBound(1, channels, UNIVERSE_SIZE);
+}
+
+void DummyInputGenerator::addInput(quint32 input, quint32 universe)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inputMap[input] = universe;
+    m_condition.wakeAll();
+}
+
+void DummyInputGenerator::removeInput(quint32 input)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inputMap.remove(input);
+}
+
+DummyInputGenerator::GeneratorStats DummyInputGenerator::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+QString DummyInputGenerator::patternToString(DummyInputGenerator::Pattern pattern)
+{
+    switch (pattern)
+    {
+        case Ramp: return QString("Ramp");
+        case Random: return QString("Random");
+        case Chase: return QString("Chase");
+        case Static: return QString("Static");
+        default: return QString();
+    }
+}
+
+void DummyInputGenerator::generateFrame(quint64 frame)
+{
+    uchar *data = reinterpret_cast<uchar *>(m_frame.data());
+    int length = m_frame.size();
+
+    switch (m_pattern)
+    {
+        case Ramp:
+            memset(data, int(frame & 0xFF), length);
+        break;
+        case Random:
+            for (int i = 0; i < length; i++)
+            {
+                // xorshift32: cheap enough to not be measured instead of the engine
+                m_randomSeed ^= m_randomSeed << 13;
+                m_randomSeed ^= m_randomSeed >> 17;
+                m_randomSeed ^= m_randomSeed << 5;
+                data[i] = uchar(m_randomSeed);
+            }
+        break;
+        case Chase:
+            memset(data, 0, length);
+            data[frame % length] = UCHAR_MAX;
+        break;
+        case Static:
+            memset(data, 127, length);
+        break;
+    }
+}
+
+void DummyInputGenerator::run()
+{
+    qint64 nextFrame = -1;
+    quint64 frame = 0;
+    qint64 statsTime = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+    quint64 statsFrames = 0;
+
+    QMutexLocker locker(&m_mutex);
+
+    while (m_running)
+    {
+        if (m_rate == 0 || m_inputMap.isEmpty())
+        {
+            m_stats.fps = 0;
+            m_condition.wait(&m_mutex);
+            nextFrame = -1;
+            statsTime = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+            statsFrames = m_stats.framesGenerated;
+            continue;
+        }
+
+        qint64 now = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+        qint64 period = NS_PER_SECOND / m_rate;
+
+        if (nextFrame < 0)
+            nextFrame = now;
+
+        if (now < nextFrame)
+        {
+            // woken up earlier by a settings change, the loop checks them again
+            QDeadlineTimer deadline(Qt::PreciseTimer);
+            deadline.setPreciseDeadline(nextFrame / NS_PER_SECOND, nextFrame % NS_PER_SECOND,
+                                        Qt::PreciseTimer);
+            m_condition.wait(&m_mutex, deadline);
+            continue;
+        }
+
+        if (now - nextFrame > period)
+        {
+            // more than a frame behind: don't try to catch up
+            m_stats.lateFrames++;
+            nextFrame = now;
+        }
+        nextFrame += period;
+
+        if (m_frame.size() != m_channels)
+            m_frame.resize(m_channels);
+        generateFrame(frame++);
+
+        QMap<quint32, quint32> inputMap = m_inputMap;
+        m_stats.framesGenerated++;
+
+        if (now - statsTime >= STATS_INTERVAL_NS)
+        {
+            m_stats.fps = float(double(m_stats.framesGenerated - statsFrames) *
+                                NS_PER_SECOND / double(now - statsTime));
+            statsFrames = m_stats.framesGenerated;
+            statsTime = now;
+        }
+
+        // deliver without holding the lock, the receivers may take their time
+        locker.unlock();
+
+        QMapIterator<quint32, quint32> it(inputMap);
+        while (it.hasNext())
+        {
+            it.next();
+            emit frameGenerated(it.value(), it.key(), m_frame);
+        }
+
+        locker.relock();
+    }
+
+    qDebug() << "[Dummy] input generator terminated";
+}
@@ -0,0 +1,124 @@
+/*
+  Q Light Controller Plus
+  dummyinputgenerator.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef DUMMYINPUTGENERATOR_H
+#define DUMMYINPUTGENERATOR_H
+
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QThread>
+#include <QMutex>
+#include <QMap>
+
+/** Maximum rate of the generated input frames */
+#define DUMMY_MAX_INPUT_RATE    1000
+
+/**
+ * DummyInputGenerator produces synthetic DMX input frames at a fixed
+ * rate, for all the open input lines of the Dummy plugin.
+ *
+ * Frames are paced on absolute deadlines of a monotonic clock, so the
+ * rate doesn't drift with the time spent delivering them. When the
+ * receivers can't keep up, the late frames are counted and the pacing
+ * restarts from the current time instead of bursting to catch up.
+ */
+class DummyInputGenerator final : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Pattern
+    {
+        /** All the channels rise together, one step per frame */
+        Ramp = 0,
+        /** Every channel gets a random value on every frame */
+        Random,
+        /** A single channel at full, moving by one on every frame */
+        Chase,
+        /** The same values on every frame */
+        Static
+    };
+
+    typedef struct
+    {
+        /** Frames generated per second, over the last interval */
+        float fps;
+        /** Frames generated since the start */
+        quint64 framesGenerated;
+        /** Frames generated after their deadline */
+        quint64 lateFrames;
+    } GeneratorStats;
+
+    DummyInputGenerator(QObject *parent = NULL);
+    ~DummyInputGenerator();
+
+    /** Get/Set the frames generated per second. 0 stops the generation */
+    int rate() const;
+    void setRate(int rate);
+
+    /** Get/Set the pattern of the generated frames */
+    Pattern pattern() const;
+    void setPattern(Pattern pattern);
+
+    /** Get/Set the number of channels of each frame */
+    int channels() const;
+    void setChannels(int channels);
+
+    /** Add/Remove an input line receiving the generated frames */
+    void addInput(quint32 input, quint32 universe);
+    void removeInput(quint32 input);
+
+    /** Return the generator statistics */
+    GeneratorStats stats() const;
+
+    /** Converts a Pattern value into a human readable string */
+    static QString patternToString(Pattern pattern);
+
+signals:
+    /** Emitted from the generator thread, for every open input line */
+    void frameGenerated(quint32 universe, quint32 input, QByteArray const& data);
+
+protected:
+    /** @reimp */
+    void run() override;
+
+private:
+    /** Fill m_frame with the $frame-th frame of the current pattern */
+    void generateFrame(quint64 frame);
+
+private:
+    /** Settings and input lines, protected by m_mutex */
+    int m_rate;
+    Pattern m_pattern;
+    int m_channels;
+    QMap<quint32, quint32> m_inputMap;
+    bool m_running;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    /** The frame being delivered, used by the generator thread only */
+    QByteArray m_frame;
+    quint32 m_randomSeed;
+
+    /** Statistics, protected by m_mutex */
+    GeneratorStats m_stats;
+};
+
+#endif
@@ -17,10 +17,20 @@
   limitations under the License.
 */
 
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QThread>
+#include <QDebug>
+
 #include "dummyplugin.h"
 #include "dummyconfiguration.h"
+#include "dummyinputgenerator.h"
 
-/** Place here the global defines specific to this plugin */
+/** Frames generated per second by default */
+#define DEFAULT_INPUT_RATE      50
+/** Channels of each generated frame by default */
+#define DEFAULT_INPUT_CHANNELS  512
 
 /*****************************************************************************
  * Initialization
@@ -28,14 +38,23 @@
 
 DummyPlugin::~DummyPlugin()
 {
-    /** Clean up the plugin resources here.
-     *  E.g. running threads, allocated memory, etc..
-     */
+    delete m_generator;
 }
 
 void DummyPlugin::init()
 {
-    /** Initialize the plugin variables here */
+    m_lineCount = 1;
+    m_outputStats.fill(OutputStats(), DUMMY_MAX_LINES);
+    m_tickStats = OutputStats();
+    m_tickStart.storeRelease(0);
+    m_writeDelay.storeRelease(0);
+
+    m_generator = new DummyInputGenerator();
+    // universeDataChanged is direct by contract, so it can be forwarded as it is
+    connect(m_generator, SIGNAL(frameGenerated(quint32,quint32,QByteArray)),
+            this, SIGNAL(universeDataChanged(quint32,quint32,QByteArray)), Qt::DirectConnection);
+
+    loadSettings();
 }
 
 QString DummyPlugin::name() const
@@ -45,80 +64,113 @@ QString DummyPlugin::name() const
 
 int DummyPlugin::capabilities() const
 {
-    /** Return a mask of the plugin capabilities here.
-     *  See the QLCIOPlugin Capability enum for usage
-     */
     return QLCIOPlugin::Output | QLCIOPlugin::Input;
 }
 
+QString DummyPlugin::pluginInfo() const
+{
+    QString str;
+
+    str += QString("<HTML>");
+    str += QString("<HEAD>");
+    str += QString("<TITLE>%1</TITLE>").arg(name());
+    str += QString("</HEAD>");
+    str += QString("<BODY>");
+
+    str += QString("<P>");
+    str += QString("<H3>%1</H3>").arg(name());
+    str += tr("This plugin provides dummy input/output lines to test QLC+ without any hardware. "
+              "Outputs measure the frames they receive, inputs generate synthetic data.");
+    str += QString("</P>");
+
+    return str;
+}
+
 /*****************************************************************************
  * Outputs
  *****************************************************************************/
 
+static qint64 currentTimestamp()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
 bool DummyPlugin::openOutput(quint32 output, quint32 universe)
 {
-    /** Check for output index validity and, in case, return false */
+    if (output >= quint32(m_lineCount))
+        return false;
 
     addToMap(universe, output, Output);
-
-    /** Do the plugin specific operations to
-     *  open the requested output line */
+    resetOutputStats(output);
 
     return true;
 }
 
 void DummyPlugin::closeOutput(quint32 output, quint32 universe)
 {
-    /** Check for output index validity and, in case, return */
+    if (output >= quint32(m_lineCount))
+        return;
 
     removeFromMap(output, universe, Output);
-
-    /** Do the plugin specific operations to
-     *  close the requested output line */
 }
 
 QStringList DummyPlugin::outputs()
 {
-    /**
-     * Build a list of output line names. The names must be always in the
-     * same order i.e. the first name is the name of output line number 0,
-     * the next one is output line number 1, etc..
-     */
     QStringList list;
-    list << QString("Dummy line");
+    if (m_lineCount == 1)
+        list << QString("Dummy line");
+    else
+    {
+        for (int i = 0; i < m_lineCount; i++)
+            list << QString("Dummy line %1").arg(i + 1);
+    }
     return list;
 }
 
-QString DummyPlugin::pluginInfo() const
+QString DummyPlugin::outputInfo(quint32 output)
 {
-    /** Return a description of the purpose of this plugin
-     *  in HTML format */
     QString str;
 
-    str += QString("<HTML>");
-    str += QString("<HEAD>");
-    str += QString("<TITLE>%1</TITLE>").arg(name());
-    str += QString("</HEAD>");
-    str += QString("<BODY>");
+    QMutexLocker locker(&m_statsMutex);
 
-    str += QString("<P>");
-    str += QString("<H3>%1</H3>").arg(name());
-    str += tr("This plugin provides dummy input/output for dummy devices.");
-    str += QString("</P>");
-
-    return str;
-}
-
-QString DummyPlugin::outputInfo(quint32 output)
-{
-    /**
-     * Provide an informational text regarding the specified output line.
-     * This text is in HTML format and it is shown to the user.
-     */
-    QString str;
+    if (output == QLCIOPlugin::invalidLine())
+    {
+        if (m_tickStats.frames > 0)
+        {
+            str += QString("<P>");
+            str += QString("<B>%1:</B> %2").arg(tr("Ticks")).arg(m_tickStats.frames);
+            str += QString("<BR>");
+            str += QString("<B>%1:</B> %2 us (max %3 us)").arg(tr("Tick write time"))
+                   .arg(m_tickStats.totalLatency / qint64(m_tickStats.frames) / 1000)
+                   .arg(m_tickStats.maxLatency / 1000);
+            str += QString("<BR>");
+            str += QString("<B>%1:</B> %2 us").arg(tr("Tick jitter")).arg(m_tickStats.jitter / 1000.0, 0, 'f', 1);
+            str += QString("<BR>");
+            str += QString("<B>%1:</B> %2").arg(tr("Bytes written")).arg(m_tickStats.bytes);
+            str += QString("</P>");
+        }
+    }
+    else if (output < quint32(m_lineCount))
+    {
+        const OutputStats &stats = m_outputStats.at(output);
 
-    if (output != QLCIOPlugin::invalidLine())
         str += QString("<H3>%1</H3>").arg(outputs()[output]);
+        str += QString("<P>");
+        str += QString("<B>%1:</B> %2 (%3 %4)").arg(tr("Frames")).arg(stats.frames)
+               .arg(stats.changedFrames).arg(tr("changed"));
+        str += QString("<BR>");
+        str += QString("<B>%1:</B> %2").arg(tr("Bytes written")).arg(stats.bytes);
+        if (stats.frames > 0)
+        {
+            str += QString("<BR>");
+            str += QString("<B>%1:</B> %2 ms (jitter %3 us)").arg(tr("Frame interval"))
+                   .arg(stats.lastInterval / 1000000.0, 0, 'f', 2).arg(stats.jitter / 1000.0, 0, 'f', 1);
+            str += QString("<BR>");
+            str += QString("<B>%1:</B> %2 us (max %3 us)").arg(tr("Latency from tick start"))
+                   .arg(stats.totalLatency / qint64(stats.frames) / 1000).arg(stats.maxLatency / 1000);
+        }
+        str += QString("</P>");
+    }
 
     str += QString("</BODY>");
     str += QString("</HTML>");
@@ -126,73 +178,143 @@ QString DummyPlugin::outputInfo(quint32 output)
     return str;
 }
 
+static void updateFrameTiming(qint64 &lastFrameTime, qint64 &lastInterval, double &jitter, qint64 now)
+{
+    if (lastFrameTime > 0)
+    {
+        qint64 interval = now - lastFrameTime;
+
+        // interarrival jitter estimator of RFC 3550, smoothed over 16 frames
+        if (lastInterval > 0)
+            jitter += (qAbs(interval - lastInterval) - jitter) / 16.0;
+        lastInterval = interval;
+    }
+    lastFrameTime = now;
+}
+
 void DummyPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArray &data, bool dataChanged)
 {
     Q_UNUSED(universe)
-    Q_UNUSED(output)
-    Q_UNUSED(data)
-    Q_UNUSED(dataChanged)
-
-    /** Check for output index validity and, in case, return.
-     *
-     * This method is very important as it is the implementation of the plugin
-     * data transmission. It is called at the rate of the QLC+ MasterTimer clock
-     * and it should never block for more than 20ms.
-     * If this plugin cannot predict the duration of a universe transmission,
-     * it is then safer to exchange data with a thread, running independently
-     * and not risking to hang QLC+
-     */
+
+    if (output >= quint32(m_lineCount))
+        return;
+
+    // the first universe written after a flush marks the start of the tick
+    qint64 now = currentTimestamp();
+    m_tickStart.testAndSetOrdered(0, now);
+    qint64 tickStart = m_tickStart.loadAcquire();
+
+    // block the universe thread like a slow device would
+    int delay = m_writeDelay.loadAcquire();
+    if (delay > 0)
+    {
+        QThread::usleep(delay);
+        now = currentTimestamp();
+    }
+
+    QMutexLocker locker(&m_statsMutex);
+    OutputStats &stats = m_outputStats[output];
+
+    stats.frames++;
+    if (dataChanged)
+        stats.changedFrames++;
+    stats.bytes += data.size();
+    m_tickStats.bytes += data.size();
+
+    updateFrameTiming(stats.lastFrameTime, stats.lastInterval, stats.jitter, now);
+
+    qint64 latency = now - tickStart;
+    stats.totalLatency += latency;
+    stats.maxLatency = qMax(stats.maxLatency, latency);
+}
+
+void DummyPlugin::flushOutputs()
+{
+    qint64 tickStart = m_tickStart.fetchAndStoreOrdered(0);
+
+    // no universe of this plugin was written in this tick
+    if (tickStart == 0)
+        return;
+
+    qint64 duration = currentTimestamp() - tickStart;
+
+    QMutexLocker locker(&m_statsMutex);
+
+    m_tickStats.frames++;
+    updateFrameTiming(m_tickStats.lastFrameTime, m_tickStats.lastInterval, m_tickStats.jitter, tickStart);
+    m_tickStats.totalLatency += duration;
+    m_tickStats.maxLatency = qMax(m_tickStats.maxLatency, duration);
+}
+
+int DummyPlugin::writeDelay() const
+{
+    return m_writeDelay.loadAcquire();
+}
+
+void DummyPlugin::setWriteDelay(int usecs)
+{
+    m_writeDelay.storeRelease(qMax(0, usecs));
+}
+
+void DummyPlugin::resetOutputStats(quint32 output)
+{
+    QMutexLocker locker(&m_statsMutex);
+    m_outputStats[output] = OutputStats();
 }
 
 /*************************************************************************
- * Inputs - If the plugin doesn't provide input
- * just remove this whole block
+ * Inputs
  *************************************************************************/
 
 bool DummyPlugin::openInput(quint32 input, quint32 universe)
 {
-    /** Check for input index validity and, in case, return false */
+    if (input >= quint32(m_lineCount))
+        return false;
 
     addToMap(universe, input, Input);
-
-    /** Do the plugin specific operations to
-     *  open the requested input line */
+    m_generator->addInput(input, universe);
 
     return true;
 }
 
 void DummyPlugin::closeInput(quint32 input, quint32 universe)
 {
-    /** Check for input index validity and, in case, return */
+    if (input >= quint32(m_lineCount))
+        return;
 
+    m_generator->removeInput(input);
     removeFromMap(input, universe, Input);
-
-    /** Do the plugin specific operations to
-     *  close the requested input line */
 }
 
 QStringList DummyPlugin::inputs()
 {
-    /**
-     * Build a list of input line names. The names must be always in the
-     * same order i.e. the first name is the name of input line number 0,
-     * the next one is output line number 1, etc..
-     */
-    QStringList list;
-    list << QString("Dummy line");
-    return list;
+    return outputs();
 }
 
 QString DummyPlugin::inputInfo(quint32 input)
 {
-    /**
-     * Provide an informational text regarding the specified input line.
-     * This text is in HTML format and it is shown to the user.
-     */
     QString str;
 
-    if (input != QLCIOPlugin::invalidLine())
+    if (input == QLCIOPlugin::invalidLine())
+    {
+        DummyInputGenerator::GeneratorStats stats = m_generator->stats();
+
+        str += QString("<P>");
+        str += QString("<B>%1:</B> %2").arg(tr("Pattern"))
+               .arg(DummyInputGenerator::patternToString(m_generator->pattern()));
+        str += QString("<BR>");
+        str += QString("<B>%1:</B> %2 Hz (%3 Hz)").arg(tr("Input frame rate"))
+               .arg(m_generator->rate()).arg(stats.fps, 0, 'f', 1);
+        str += QString("<BR>");
+        str += QString("<B>%1:</B> %2").arg(tr("Frames generated")).arg(stats.framesGenerated);
+        str += QString("<BR>");
+        str += QString("<B>%1:</B> %2").arg(tr("Late frames")).arg(stats.lateFrames);
+        str += QString("</P>");
+    }
+    else if (input < quint32(m_lineCount))
+    {
         str += QString("<H3>%1</H3>").arg(inputs()[input]);
+    }
 
     str += QString("</BODY>");
     str += QString("</HTML>");
@@ -207,14 +329,11 @@ void DummyPlugin::sendFeedBack(quint32 universe, quint32 output, quint32 channel
     Q_UNUSED(channel)
     Q_UNUSED(value)
     Q_UNUSED(params)
+}
 
-    /**
-     * If the device support this feature, this is the method to send data back for
-     * visual feedback.
-     * To implement such method, the plugin must have an input line corresponding
-     * to the specified output line.
-     * Basically feedback data must return to the same line where it came from
-     */
+DummyInputGenerator *DummyPlugin::inputGenerator() const
+{
+    return m_generator;
 }
 
 /*****************************************************************************
@@ -226,7 +345,14 @@ void DummyPlugin::configure()
     DummyConfiguration conf(this);
     if (conf.exec() == QDialog::Accepted)
     {
-
+        QSettings settings;
+        settings.setValue(SETTINGS_LINES, QVariant(conf.lineCount()));
+        settings.setValue(SETTINGS_WRITE_DELAY, QVariant(conf.writeDelay()));
+        settings.setValue(SETTINGS_INPUT_RATE, QVariant(conf.inputRate()));
+        settings.setValue(SETTINGS_INPUT_PATTERN, QVariant(conf.inputPattern()));
+        settings.setValue(SETTINGS_INPUT_CHANNELS, QVariant(conf.inputChannels()));
+
+        loadSettings();
     }
 }
 
@@ -238,23 +364,34 @@ bool DummyPlugin::canConfigure() const
 void DummyPlugin::setParameter(quint32 universe, quint32 line, Capability type,
                              QString name, QVariant value)
 {
-    Q_UNUSED(universe)
-    Q_UNUSED(line)
-    Q_UNUSED(type)
-    Q_UNUSED(value)
+    QLCIOPlugin::setParameter(universe, line, type, name, value);
+}
 
-    /** This method is provided to QLC+ to set the plugin specific settings.
-     *  Those settings are saved in a project workspace and when it is loaded,
-     *  this method is called after QLC+ has opened the input/output lines
-     *  mapped in the project workspace as well.
-     */
+int DummyPlugin::lineCount() const
+{
+    return m_lineCount;
+}
 
-    if (name == "DummyParameter")
-    {
-        // do something smart :)
-    }
+void DummyPlugin::setLineCount(int count)
+{
+    count = qBound(1, count, DUMMY_MAX_LINES);
+    if (count == m_lineCount)
+        return;
 
-    /** Remember to call the base QLCIOPlugin method to actually inform
-     *  QLC+ to store the parameter in the project workspace XML */
-    QLCIOPlugin::setParameter(universe, line, type, name, value);
+    m_lineCount = count;
+    emit configurationChanged();
+}
+
+void DummyPlugin::loadSettings()
+{
+    QSettings settings;
+
+    setWriteDelay(settings.value(SETTINGS_WRITE_DELAY, 0).toInt());
+
+    m_generator->setRate(settings.value(SETTINGS_INPUT_RATE, DEFAULT_INPUT_RATE).toInt());
+    m_generator->setPattern(DummyInputGenerator::Pattern(
+            settings.value(SETTINGS_INPUT_PATTERN, DummyInputGenerator::Ramp).toInt()));
+    m_generator->setChannels(settings.value(SETTINGS_INPUT_CHANNELS, DEFAULT_INPUT_CHANNELS).toInt());
+
+    setLineCount(settings.value(SETTINGS_LINES, 1).toInt());
 }
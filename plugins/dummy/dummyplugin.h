@@ -20,8 +20,34 @@
 #ifndef DUMMYPLUGIN_H
 #define DUMMYPLUGIN_H
 
+#include <QAtomicInteger>
+#include <QVector>
+#include <QMutex>
+
 #include "qlcioplugin.h"
 
+class DummyInputGenerator;
+
+#define SETTINGS_LINES          "DummyPlugin/lines"
+#define SETTINGS_WRITE_DELAY    "DummyPlugin/writeDelay"
+#define SETTINGS_INPUT_RATE     "DummyPlugin/inputRate"
+#define SETTINGS_INPUT_PATTERN  "DummyPlugin/inputPattern"
+#define SETTINGS_INPUT_CHANNELS "DummyPlugin/inputChannels"
+
+/** Maximum number of lines, enough to patch every universe of a big show */
+#define DUMMY_MAX_LINES         1024
+
+/**
+ * The Dummy plugin is a hardware-free benchmark sink and source.
+ *
+ * Output lines discard the data, measuring what a real plugin would see:
+ * frames and bytes written, the jitter between frames and the latency of
+ * each universe from the start of the MasterTimer tick. Writes can be
+ * slowed down on purpose, to simulate a blocking device.
+ *
+ * Input lines generate synthetic frames at a configurable rate and
+ * pattern, in a thread of their own.
+ */
 class DummyPlugin final : public QLCIOPlugin
 {
     Q_OBJECT
@@ -48,8 +74,7 @@ public:
     QString pluginInfo() const override;
 
     /*********************************************************************
-     * Outputs - If the plugin doesn't provide output
-     * just remove this whole block
+     * Outputs
      *********************************************************************/
 public:
     /** @reimp */
@@ -67,9 +92,48 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
 
+    /** @reimp */
+    void flushOutputs() override;
+
+    /** Get/Set the time in microseconds every universe write takes */
+    int writeDelay() const;
+    void setWriteDelay(int usecs);
+
+private:
+    /** Clear the statistics of $output */
+    void resetOutputStats(quint32 output);
+
+private:
+    typedef struct
+    {
+        quint64 frames;
+        quint64 changedFrames;
+        quint64 bytes;
+        /** Time of the last frame, and interval from the one before */
+        qint64 lastFrameTime;
+        qint64 lastInterval;
+        /** Smoothed interval variation, as in RFC 3550 */
+        double jitter;
+        /** Sum and maximum of the latencies from the tick start */
+        qint64 totalLatency;
+        qint64 maxLatency;
+    } OutputStats;
+
+    /** Statistics of each output line, protected by m_statsMutex */
+    QVector<OutputStats> m_outputStats;
+    /** Statistics of the ticks, protected by m_statsMutex */
+    OutputStats m_tickStats;
+    QMutex m_statsMutex;
+
+    /** Start time of the tick in progress, 0 between ticks.
+     *  Set by the first universe written after a flush */
+    QAtomicInteger<qint64> m_tickStart;
+
+    /** Simulated write time in microseconds */
+    QAtomicInt m_writeDelay;
+
     /*************************************************************************
-     * Inputs - If the plugin doesn't provide input
-     * just remove this whole block
+     * Inputs
      *************************************************************************/
 public:
     /** @reimp */
@@ -87,8 +151,11 @@ public:
     /** @reimp */
     void sendFeedBack(quint32 universe, quint32 output, quint32 channel, uchar value, const QVariant &params) override;
 
-protected:
-    /** Place here the variables used by this plugin */
+    /** Return the generator of the input frames */
+    DummyInputGenerator *inputGenerator() const;
+
+private:
+    DummyInputGenerator *m_generator;
 
     /*********************************************************************
      * Configuration
@@ -102,6 +169,17 @@ public:
 
     /** @reimp */
     void setParameter(quint32 universe, quint32 line, Capability type, QString name, QVariant value) override;
+
+    /** Get/Set the number of input and output lines */
+    int lineCount() const;
+    void setLineCount(int count);
+
+private:
+    /** Apply the settings stored by the configuration dialog */
+    void loadSettings();
+
+private:
+    int m_lineCount;
 };
 
 #endif
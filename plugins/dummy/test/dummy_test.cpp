@@ -0,0 +1,373 @@
+/*
+  Q Light Controller Plus
+  dummy_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTest>
+
+#define private public
+#include "dummy_test.h"
+#include "dummyplugin.h"
+#include "dummyinputgenerator.h"
+#undef private
+
+#define UNIVERSE_SIZE       512
+
+/** The load scenario: a big show, with universe threads written in parallel */
+#define LOAD_UNIVERSES      500
+#define LOAD_TICKS          50
+#define LOAD_THREADS        4
+
+/** Write a range of universes, like the universe threads of a tick do */
+class UniverseWriter final : public QThread
+{
+public:
+    UniverseWriter(DummyPlugin *plugin, quint32 first, quint32 count)
+        : m_plugin(plugin)
+        , m_first(first)
+        , m_count(count)
+        , m_data(UNIVERSE_SIZE, char(0x7F))
+    {
+    }
+
+protected:
+    void run() override
+    {
+        for (quint32 i = m_first; i < m_first + m_count; i++)
+            m_plugin->writeUniverse(i, i, m_data, true);
+    }
+
+private:
+    DummyPlugin *m_plugin;
+    quint32 m_first;
+    quint32 m_count;
+    QByteArray m_data;
+};
+
+/** Stop the generator thread, so that every generated frame is delivered */
+static void stopGenerator(DummyInputGenerator *generator)
+{
+    {
+        QMutexLocker locker(&generator->m_mutex);
+        generator->m_running = false;
+        generator->m_condition.wakeAll();
+    }
+    generator->wait();
+}
+
+/** Wait until $generator has generated $count frames, 5 seconds at most */
+static bool waitFrames(DummyInputGenerator *generator, quint64 count)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while (generator->stats().framesGenerated < count)
+    {
+        if (timer.elapsed() > 5000)
+            return false;
+        QTest::qWait(10);
+    }
+
+    return true;
+}
+
+void Dummy_Test::init()
+{
+    m_plugin = new DummyPlugin();
+    m_plugin->init();
+
+    // don't depend on the stored settings
+    m_plugin->setLineCount(1);
+    m_plugin->setWriteDelay(0);
+    m_plugin->inputGenerator()->setRate(0);
+    m_plugin->inputGenerator()->setPattern(DummyInputGenerator::Ramp);
+    m_plugin->inputGenerator()->setChannels(UNIVERSE_SIZE);
+}
+
+void Dummy_Test::cleanup()
+{
+    delete m_plugin;
+    m_plugin = NULL;
+}
+
+void Dummy_Test::lines()
+{
+    QCOMPARE(m_plugin->name(), QString("Dummy"));
+    QCOMPARE(m_plugin->capabilities(), int(QLCIOPlugin::Output | QLCIOPlugin::Input));
+    QCOMPARE(m_plugin->outputs(), QStringList() << "Dummy line");
+
+    m_plugin->setLineCount(3);
+    QCOMPARE(m_plugin->lineCount(), 3);
+    QCOMPARE(m_plugin->outputs().count(), 3);
+    QCOMPARE(m_plugin->outputs().at(2), QString("Dummy line 3"));
+    QCOMPARE(m_plugin->inputs(), m_plugin->outputs());
+
+    m_plugin->setLineCount(0);
+    QCOMPARE(m_plugin->lineCount(), 1);
+
+    m_plugin->setLineCount(DUMMY_MAX_LINES + 1);
+    QCOMPARE(m_plugin->lineCount(), DUMMY_MAX_LINES);
+    QCOMPARE(m_plugin->outputs().count(), DUMMY_MAX_LINES);
+}
+
+void Dummy_Test::outputStats()
+{
+    m_plugin->setLineCount(2);
+    QVERIFY(m_plugin->openOutput(0, 0) == true);
+    QVERIFY(m_plugin->openOutput(1, 1) == true);
+    QVERIFY(m_plugin->openOutput(2, 2) == false);
+
+    QByteArray data(UNIVERSE_SIZE, char(0x01));
+
+    m_plugin->writeUniverse(0, 0, data, true);
+    m_plugin->writeUniverse(0, 0, data, false);
+    m_plugin->writeUniverse(1, 1, data, true);
+    // out of range lines are ignored
+    m_plugin->writeUniverse(5, 5, data, true);
+    QVERIFY(m_plugin->m_tickStart.loadAcquire() > 0);
+
+    m_plugin->flushOutputs();
+    QCOMPARE(m_plugin->m_tickStart.loadAcquire(), qint64(0));
+
+    QCOMPARE(m_plugin->m_outputStats[0].frames, quint64(2));
+    QCOMPARE(m_plugin->m_outputStats[0].changedFrames, quint64(1));
+    QCOMPARE(m_plugin->m_outputStats[0].bytes, quint64(2 * UNIVERSE_SIZE));
+    QCOMPARE(m_plugin->m_outputStats[1].frames, quint64(1));
+    QCOMPARE(m_plugin->m_outputStats[1].bytes, quint64(UNIVERSE_SIZE));
+    QVERIFY(m_plugin->m_outputStats[0].maxLatency >= 0);
+
+    QCOMPARE(m_plugin->m_tickStats.frames, quint64(1));
+    QCOMPARE(m_plugin->m_tickStats.bytes, quint64(3 * UNIVERSE_SIZE));
+
+    // a second tick measures the intervals
+    QTest::qWait(5);
+    m_plugin->writeUniverse(0, 0, data, true);
+    m_plugin->flushOutputs();
+
+    QCOMPARE(m_plugin->m_tickStats.frames, quint64(2));
+    QVERIFY(m_plugin->m_tickStats.lastInterval > 0);
+    QVERIFY(m_plugin->m_outputStats[0].lastInterval > 0);
+
+    QVERIFY(m_plugin->outputInfo(0).contains("Frames"));
+    QVERIFY(m_plugin->outputInfo(QLCIOPlugin::invalidLine()).contains("Ticks"));
+
+    // opening an output again starts its statistics from scratch
+    m_plugin->closeOutput(0, 0);
+    QVERIFY(m_plugin->openOutput(0, 0) == true);
+    QCOMPARE(m_plugin->m_outputStats[0].frames, quint64(0));
+    QCOMPARE(m_plugin->m_outputStats[1].frames, quint64(1));
+}
+
+void Dummy_Test::emptyTick()
+{
+    QVERIFY(m_plugin->openOutput(0, 0) == true);
+
+    // no universe written: no tick is accounted
+    m_plugin->flushOutputs();
+    QCOMPARE(m_plugin->m_tickStats.frames, quint64(0));
+    QVERIFY(m_plugin->outputInfo(QLCIOPlugin::invalidLine()).contains("Ticks") == false);
+}
+
+void Dummy_Test::writeDelay()
+{
+    m_plugin->setWriteDelay(-1);
+    QCOMPARE(m_plugin->writeDelay(), 0);
+
+    m_plugin->setWriteDelay(2000);
+    QCOMPARE(m_plugin->writeDelay(), 2000);
+
+    QVERIFY(m_plugin->openOutput(0, 0) == true);
+    m_plugin->writeUniverse(0, 0, QByteArray(UNIVERSE_SIZE, 0), true);
+    m_plugin->flushOutputs();
+
+    // the write blocked the caller at least for the write delay
+    QVERIFY(m_plugin->m_outputStats[0].maxLatency >= 2000000);
+    QVERIFY(m_plugin->m_tickStats.maxLatency >= 2000000);
+}
+
+void Dummy_Test::patterns()
+{
+    DummyInputGenerator *generator = m_plugin->inputGenerator();
+
+    generator->setRate(DUMMY_MAX_INPUT_RATE + 1);
+    QCOMPARE(generator->rate(), DUMMY_MAX_INPUT_RATE);
+    generator->setRate(0);
+
+    generator->setChannels(0);
+    QCOMPARE(generator->channels(), 1);
+    generator->setChannels(UNIVERSE_SIZE + 1);
+    QCOMPARE(generator->channels(), UNIVERSE_SIZE);
+
+    // the generator thread is idle without rate and inputs,
+    // so its frame can be generated from here
+    generator->m_frame.fill(0, 8);
+
+    generator->setPattern(DummyInputGenerator::Ramp);
+    generator->generateFrame(259);
+    QCOMPARE(generator->m_frame, QByteArray(8, char(3)));
+
+    generator->setPattern(DummyInputGenerator::Chase);
+    generator->generateFrame(10);
+    QByteArray chase(8, 0);
+    chase[2] = char(0xFF);
+    QCOMPARE(generator->m_frame, chase);
+
+    generator->setPattern(DummyInputGenerator::Static);
+    generator->generateFrame(10);
+    QCOMPARE(generator->m_frame, QByteArray(8, char(127)));
+
+    generator->setPattern(DummyInputGenerator::Random);
+    generator->generateFrame(0);
+    QByteArray random = generator->m_frame;
+    generator->generateFrame(1);
+    QVERIFY(generator->m_frame != random);
+
+    QCOMPARE(DummyInputGenerator::patternToString(DummyInputGenerator::Ramp), QString("Ramp"));
+    QCOMPARE(DummyInputGenerator::patternToString(DummyInputGenerator::Random), QString("Random"));
+    QCOMPARE(DummyInputGenerator::patternToString(DummyInputGenerator::Chase), QString("Chase"));
+    QCOMPARE(DummyInputGenerator::patternToString(DummyInputGenerator::Static), QString("Static"));
+}
+
+void Dummy_Test::inputFrames()
+{
+    QMutex mutex;
+    QMap<quint32, int> frames;
+    int frameSize = 0;
+
+    // frames are delivered from the generator thread
+    connect(m_plugin, &QLCIOPlugin::universeDataChanged, this,
+            [&](quint32 universe, quint32 input, const QByteArray &data)
+    {
+        Q_UNUSED(input)
+        QMutexLocker locker(&mutex);
+        frames[universe]++;
+        frameSize = data.size();
+    }, Qt::DirectConnection);
+
+    DummyInputGenerator *generator = m_plugin->inputGenerator();
+
+    m_plugin->setLineCount(2);
+    QVERIFY(m_plugin->openInput(0, 10) == true);
+    QVERIFY(m_plugin->openInput(1, 11) == true);
+    QVERIFY(m_plugin->openInput(2, 12) == false);
+
+    generator->setChannels(16);
+    generator->setRate(100);
+
+    // the generator thread must be stopped before leaving, it uses the locals
+    bool generated = waitFrames(generator, 5);
+    m_plugin->closeInput(1, 11);
+    quint64 closed = generator->stats().framesGenerated;
+    generated = generated && waitFrames(generator, closed + 2);
+
+    stopGenerator(generator);
+    QVERIFY(generated == true);
+
+    DummyInputGenerator::GeneratorStats stats = generator->stats();
+
+    QMutexLocker locker(&mutex);
+    QCOMPARE(frameSize, 16);
+    // every generated frame reached the open input
+    QCOMPARE(quint64(frames[10]), stats.framesGenerated);
+    // the closed input didn't get the frames generated after it
+    QVERIFY(quint64(frames[11]) <= closed + 1);
+    QVERIFY(quint64(frames[11]) < stats.framesGenerated);
+    QVERIFY(frames.contains(12) == false);
+}
+
+void Dummy_Test::load500Universes()
+{
+    m_plugin->setLineCount(DUMMY_MAX_LINES);
+
+    /* Outputs: all the universes are written every tick by parallel
+     * threads, then flushed, as the MasterTimer does */
+    for (quint32 i = 0; i < LOAD_UNIVERSES; i++)
+        QVERIFY(m_plugin->openOutput(i, i) == true);
+
+    QList<UniverseWriter *> writers;
+    for (int i = 0; i < LOAD_THREADS; i++)
+    {
+        quint32 count = LOAD_UNIVERSES / LOAD_THREADS;
+        writers.append(new UniverseWriter(m_plugin, i * count, count));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int tick = 0; tick < LOAD_TICKS; tick++)
+    {
+        foreach (UniverseWriter *writer, writers)
+            writer->start();
+        foreach (UniverseWriter *writer, writers)
+            writer->wait();
+
+        m_plugin->flushOutputs();
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+    qDeleteAll(writers);
+
+    qDebug() << LOAD_UNIVERSES << "universes:" << elapsed / LOAD_TICKS / 1000 << "us per tick,"
+             << m_plugin->m_tickStats.maxLatency / 1000 << "us max write time";
+
+    for (quint32 i = 0; i < LOAD_UNIVERSES; i++)
+    {
+        QCOMPARE(m_plugin->m_outputStats[i].frames, quint64(LOAD_TICKS));
+        QCOMPARE(m_plugin->m_outputStats[i].bytes, quint64(LOAD_TICKS * UNIVERSE_SIZE));
+    }
+    QCOMPARE(m_plugin->m_outputStats[LOAD_UNIVERSES].frames, quint64(0));
+
+    QCOMPARE(m_plugin->m_tickStats.frames, quint64(LOAD_TICKS));
+    QCOMPARE(m_plugin->m_tickStats.bytes, quint64(LOAD_TICKS) * LOAD_UNIVERSES * UNIVERSE_SIZE);
+
+    /* Inputs: every generated frame reaches all the universes */
+    QMutex mutex;
+    QVector<quint64> frames(LOAD_UNIVERSES, 0);
+
+    connect(m_plugin, &QLCIOPlugin::universeDataChanged, this,
+            [&](quint32 universe, quint32 input, const QByteArray &data)
+    {
+        Q_UNUSED(input)
+        Q_UNUSED(data)
+        QMutexLocker locker(&mutex);
+        frames[universe]++;
+    }, Qt::DirectConnection);
+
+    for (quint32 i = 0; i < LOAD_UNIVERSES; i++)
+        QVERIFY(m_plugin->openInput(i, i) == true);
+
+    DummyInputGenerator *generator = m_plugin->inputGenerator();
+    generator->setPattern(DummyInputGenerator::Static);
+    generator->setRate(50);
+
+    bool generated = waitFrames(generator, 10);
+    stopGenerator(generator);
+    QVERIFY(generated == true);
+
+    DummyInputGenerator::GeneratorStats stats = generator->stats();
+    qDebug() << LOAD_UNIVERSES << "input universes:" << stats.framesGenerated << "frames,"
+             << stats.lateFrames << "late";
+
+    QMutexLocker locker(&mutex);
+    for (int i = 0; i < LOAD_UNIVERSES; i++)
+        QCOMPARE(frames.at(i), stats.framesGenerated);
+}
+
+QTEST_GUILESS_MAIN(Dummy_Test)
@@ -0,0 +1,2 @@
+#!/bin/sh
+./dummy_test
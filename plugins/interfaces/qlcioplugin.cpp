@@ -57,6 +57,10 @@ void QLCIOPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArr
     Q_UNUSED(dataChanged)
 }
 
+void QLCIOPlugin::flushOutputs()
+{
+}
+
 /*************************************************************************
  * Inputs
  *************************************************************************/
@@ -95,6 +99,13 @@ void QLCIOPlugin::sendFeedBack(quint32 universe, quint32 inputLine,
     Q_UNUSED(params)
 }
 
+void QLCIOPlugin::sendFeedBackBatch(quint32 universe, quint32 inputLine,
+                                    const QList<QLCFeedbackValue> &values)
+{
+    foreach (const QLCFeedbackValue &fb, values)
+        sendFeedBack(universe, inputLine, fb.channel, fb.value, fb.params);
+}
+
 /*************************************************************************
  * Configure
  *************************************************************************/
@@ -63,6 +63,14 @@
 
 #define QLCIOPLUGINS_UNIVERSES   4
 
+/** A single feedback value, as queued for a batch delivery */
+typedef struct
+{
+    quint32 channel;
+    uchar value;
+    QVariant params;
+} QLCFeedbackValue;
+
 typedef struct
 {
     /** The plugin input line patched to a QLC+ universe.
@@ -205,6 +213,16 @@ public:
      */
     virtual void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged);
 
+    /**
+     * Called once per MasterTimer tick, after every universe has been
+     * written. Plugins that need to synchronize the output of several
+     * universes can transmit the synchronization data here.
+     * This is called from a universe writer thread, and also after every
+     * frame written by an asynchronous output dispatcher, since those
+     * frames are not part of the tick.
+     */
+    virtual void flushOutputs();
+
     /*************************************************************************
      * Inputs
      *************************************************************************/
@@ -266,6 +284,20 @@ public:
     virtual void sendFeedBack(quint32 universe, quint32 inputLine,
                               quint32 channel, uchar value, const QVariant &params);
 
+    /**
+     * Send a batch of feedback values, collected during a feedback interval,
+     * to an input line. Only the latest value of each channel is present.
+     * Plugins able to pack several messages together (e.g. running status,
+     * bundles) can reimplement this. The default implementation calls
+     * sendFeedBack for each value.
+     *
+     * @param universe the universe where to send the feedback
+     * @param inputLine the input line where to send the feedback
+     * @param values the feedback values, in the order they were first queued
+     */
+    virtual void sendFeedBackBatch(quint32 universe, quint32 inputLine,
+                                   const QList<QLCFeedbackValue> &values);
+
 signals:
     /**
      * Tells that the value of a channel in an input line has changed and needs
@@ -284,6 +316,56 @@ signals:
      */
     void valueChanged(quint32 universe, quint32 input, quint32 channel, uchar value, const QString& key = 0);
 
+    /**
+     * Bulk alternative to valueChanged, meant for plugins receiving whole
+     * DMX frames (network protocols, loopback). The frame is handed over
+     * as is: the receiving input patch diffs it against the previous one,
+     * so there's no need to compare and emit the values one by one.
+     * The signal is delivered with a direct connection, so it can be
+     * emitted from any thread.
+     *
+     * @param universe The universe ID detected from the data received
+     * @param input The input line that received the data
+     * @param data The channel values, starting from channel 0
+     */
+    void universeDataChanged(quint32 universe, quint32 input, const QByteArray& data);
+
+public:
+    /** Transport events of an external clock source */
+    enum ClockEvent
+    {
+        ClockPulse = 0, //! A clock pulse. Pulses are sent at 24 per quarter note
+        ClockStart,     //! Start from the beginning of the song
+        ClockContinue,  //! Continue from the current song position
+        ClockStop       //! Stop the song position
+    };
+
+signals:
+    /**
+     * Tells that a clock event (e.g. MIDI beat clock) has been received.
+     * Plugins with the Beats capability can emit this to let QLC+ follow
+     * the tempo of an external device with sub-tick accuracy.
+     *
+     * @param universe The universe ID detected from the data received
+     * @param input The input line that received the event
+     * @param event The event type, as a ClockEvent value
+     * @param timestamp The reception time in nanoseconds, taken from
+     *        QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs()
+     *        or converted to the same monotonic time base
+     */
+    void clockEventReceived(quint32 universe, quint32 input, int event, qint64 timestamp);
+
+    /**
+     * Tells that a timecode position (e.g. MIDI Time Code) has been received
+     *
+     * @param universe The universe ID detected from the data received
+     * @param input The input line that received the timecode
+     * @param position The timecode position in milliseconds
+     * @param timestamp The reception time in nanoseconds, on the same
+     *        time base of clockEventReceived
+     */
+    void timecodeReceived(quint32 universe, quint32 input, qint64 position, qint64 timestamp);
+
     /*************************************************************************
      * Configure
      *************************************************************************/
@@ -0,0 +1,261 @@
+/*
+  Q Light Controller Plus
+  udpreceiver.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QDebug>
+
+#if defined(Q_OS_UNIX)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cstring>
+#include <cerrno>
+#endif
+
+#include "udpreceiver.h"
+
+UdpReceiver::UdpReceiver(QUdpSocket *socket, UdpReceiverHandler *handler, int datagramSize)
+    : QThread(socket)
+    , m_socket(socket)
+    , m_handler(handler)
+    , m_socketDescriptor(socket->socketDescriptor())
+    , m_datagramSize(datagramSize)
+    , m_running(1)
+{
+    // the sender address travels in queued signals
+    qRegisterMetaType<QHostAddress>("QHostAddress");
+
+    m_wakePipe[0] = m_wakePipe[1] = -1;
+#if defined(Q_OS_UNIX)
+    if (pipe(m_wakePipe) == 0)
+    {
+        fcntl(m_wakePipe[0], F_SETFD, FD_CLOEXEC);
+        fcntl(m_wakePipe[1], F_SETFD, FD_CLOEXEC);
+    }
+    else
+    {
+        qWarning() << "[UdpReceiver] cannot create the wake up pipe:" << strerror(errno);
+    }
+#endif
+}
+
+UdpReceiver::~UdpReceiver()
+{
+    stop();
+
+#if defined(Q_OS_UNIX)
+    if (m_wakePipe[0] != -1)
+        close(m_wakePipe[0]);
+    if (m_wakePipe[1] != -1)
+        close(m_wakePipe[1]);
+#endif
+}
+
+bool UdpReceiver::isSupported()
+{
+#if defined(Q_OS_UNIX)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void UdpReceiver::stop()
+{
+    if (m_running.fetchAndStoreOrdered(0) == 0)
+        return;
+
+#if defined(Q_OS_UNIX)
+    if (m_wakePipe[1] != -1)
+    {
+        char wake = 0;
+        if (write(m_wakePipe[1], &wake, 1) < 0)
+            qWarning() << "[UdpReceiver] cannot wake up the receiver thread";
+    }
+#endif
+
+    wait();
+}
+
+void UdpReceiver::deleteSocket(QUdpSocket *socket)
+{
+    foreach (UdpReceiver *receiver, socket->findChildren<UdpReceiver *>(QString(), Qt::FindDirectChildrenOnly))
+        receiver->stop();
+
+    delete socket;
+}
+
+QUdpSocket *UdpReceiver::socket() const
+{
+    return m_socket;
+}
+
+#if defined(Q_OS_UNIX)
+static QHostAddress toHostAddress(const sockaddr_storage &address)
+{
+    QHostAddress host(reinterpret_cast<const sockaddr *>(&address));
+
+    // dual stack sockets report IPv4 senders as IPv4-mapped addresses
+    if (address.ss_family == AF_INET6)
+    {
+        bool isIPv4 = false;
+        quint32 ipv4 = host.toIPv4Address(&isIPv4);
+        if (isIPv4)
+            host.setAddress(ipv4);
+    }
+
+    return host;
+}
+#endif
+
+void UdpReceiver::run()
+{
+#if defined(Q_OS_UNIX)
+    if (m_socketDescriptor == -1 || m_wakePipe[0] == -1)
+    {
+        qWarning() << "[UdpReceiver] socket not available, receiver not started";
+        return;
+    }
+
+    // the ring of receive buffers, allocated once for the whole thread life
+    QByteArray buffer(UDP_RECEIVER_BATCH_SIZE * m_datagramSize, 0);
+    sockaddr_storage addresses[UDP_RECEIVER_BATCH_SIZE];
+    int lengths[UDP_RECEIVER_BATCH_SIZE];
+    bool truncated[UDP_RECEIVER_BATCH_SIZE];
+
+    memset(addresses, 0, sizeof(addresses));
+
+#if defined(Q_OS_LINUX)
+    struct mmsghdr messages[UDP_RECEIVER_BATCH_SIZE];
+    struct iovec iovecs[UDP_RECEIVER_BATCH_SIZE];
+
+    memset(messages, 0, sizeof(messages));
+    for (int i = 0; i < UDP_RECEIVER_BATCH_SIZE; i++)
+    {
+        iovecs[i].iov_base = buffer.data() + i * m_datagramSize;
+        iovecs[i].iov_len = m_datagramSize;
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &addresses[i];
+    }
+#endif
+
+    // senders are usually few: avoid building a new address for every datagram
+    sockaddr_storage lastAddress;
+    QHostAddress lastSender;
+    memset(&lastAddress, 0, sizeof(lastAddress));
+
+    struct pollfd fds[2];
+    fds[0].fd = int(m_socketDescriptor);
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakePipe[0];
+    fds[1].events = POLLIN;
+
+    while (m_running.loadAcquire())
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            qWarning() << "[UdpReceiver] poll failed:" << strerror(errno);
+            break;
+        }
+
+        if (fds[1].revents != 0 || (fds[0].revents & POLLNVAL))
+            break;
+
+        // drain the socket, a batch at a time
+        while (m_running.loadAcquire())
+        {
+            int count = 0;
+#if defined(Q_OS_LINUX)
+            for (int i = 0; i < UDP_RECEIVER_BATCH_SIZE; i++)
+            {
+                messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+                messages[i].msg_hdr.msg_flags = 0;
+            }
+
+            count = recvmmsg(int(m_socketDescriptor), messages, UDP_RECEIVER_BATCH_SIZE, MSG_DONTWAIT, NULL);
+            for (int i = 0; i < count; i++)
+            {
+                lengths[i] = int(messages[i].msg_len);
+                truncated[i] = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+            }
+#else
+            while (count < UDP_RECEIVER_BATCH_SIZE)
+            {
+                struct iovec iov;
+                iov.iov_base = buffer.data() + count * m_datagramSize;
+                iov.iov_len = m_datagramSize;
+
+                struct msghdr message;
+                memset(&message, 0, sizeof(message));
+                message.msg_name = &addresses[count];
+                message.msg_namelen = sizeof(sockaddr_storage);
+                message.msg_iov = &iov;
+                message.msg_iovlen = 1;
+
+                ssize_t length = recvmsg(int(m_socketDescriptor), &message, MSG_DONTWAIT);
+                if (length < 0)
+                    break;
+
+                lengths[count] = int(length);
+                truncated[count] = (message.msg_flags & MSG_TRUNC) != 0;
+                count++;
+            }
+            if (count == 0)
+                count = -1;
+#endif
+            if (count <= 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    qDebug() << "[UdpReceiver] receive failed:" << strerror(errno);
+                break;
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                if (truncated[i])
+                {
+                    qWarning() << "[UdpReceiver] dropped a datagram longer than" << m_datagramSize << "bytes";
+                    continue;
+                }
+
+                if (memcmp(&addresses[i], &lastAddress, sizeof(sockaddr_storage)) != 0)
+                {
+                    lastAddress = addresses[i];
+                    lastSender = toHostAddress(lastAddress);
+                }
+
+                const char *data = buffer.constData() + i * m_datagramSize;
+                QByteArray datagram = QByteArray::fromRawData(data, lengths[i]);
+
+                if (m_handler->handleDatagram(m_socket, datagram, lastSender) == false)
+                    emit datagramReceived(QByteArray(data, lengths[i]), lastSender);
+            }
+
+            // a partial batch means that the socket has been drained
+            if (count < UDP_RECEIVER_BATCH_SIZE)
+                break;
+        }
+    }
+#endif
+}
@@ -0,0 +1,118 @@
+/*
+  Q Light Controller Plus
+  udpreceiver.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef UDPRECEIVER_H
+#define UDPRECEIVER_H
+
+#include <QHostAddress>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QUdpSocket>
+#include <QThread>
+
+/** Number of datagrams read with a single system call */
+#define UDP_RECEIVER_BATCH_SIZE     32
+/** Default size of a receive buffer slot. Longer datagrams are dropped */
+#define UDP_RECEIVER_DATAGRAM_SIZE  2048
+
+class UdpReceiver;
+
+/**
+ * Interface of the protocol handlers fed by a UdpReceiver
+ */
+class UdpReceiverHandler
+{
+public:
+    virtual ~UdpReceiverHandler() { }
+
+    /**
+     * Process a datagram received on $socket. This is called by the
+     * receiver thread, so the handler must protect the data it shares
+     * with the rest of the plugin.
+     *
+     * $datagram wraps the receive buffer without copying it: it is valid
+     * only for the duration of the call and must not be stored.
+     *
+     * @return true if the datagram has been handled, false to have it
+     *         copied and emitted with UdpReceiver::datagramReceived in the
+     *         thread owning the receiver (e.g. for packets that need to
+     *         write on the socket)
+     */
+    virtual bool handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                                QHostAddress const& senderAddress) = 0;
+};
+
+/**
+ * UdpReceiver reads the datagrams of a bound socket in a dedicated
+ * thread, so that heavy network traffic doesn't load the plugin's
+ * event loop.
+ *
+ * Datagrams are read in batches into a ring of buffers allocated once
+ * (with recvmmsg on Linux) and handed to the handler without any copy
+ * or allocation. The socket itself stays usable to send data from its
+ * own thread, but its readyRead signal must not be used.
+ *
+ * The receiver is a child of the socket. Since the thread must be stopped
+ * before the socket descriptor is closed, shared sockets with a receiver
+ * must be created with deleteSocket() as deleter.
+ */
+class UdpReceiver final : public QThread
+{
+    Q_OBJECT
+
+public:
+    UdpReceiver(QUdpSocket *socket, UdpReceiverHandler *handler,
+                int datagramSize = UDP_RECEIVER_DATAGRAM_SIZE);
+    ~UdpReceiver();
+
+    /** Return true if receiver threads are available on this platform.
+     *  If not, plugins keep reading their sockets on readyRead */
+    static bool isSupported();
+
+    /** Stop the thread and wait for it. This must not be called while
+     *  holding a lock that the handler might need */
+    void stop();
+
+    /** Stop the receivers of $socket, then delete it */
+    static void deleteSocket(QUdpSocket *socket);
+
+    /** Return the socket read by this receiver */
+    QUdpSocket *socket() const;
+
+signals:
+    /** Emitted for the datagrams that the handler leaves to the thread
+     *  owning the receiver */
+    void datagramReceived(QByteArray datagram, QHostAddress senderAddress);
+
+protected:
+    /** @reimp */
+    void run() override;
+
+private:
+    QUdpSocket *m_socket;
+    UdpReceiverHandler *m_handler;
+    qintptr m_socketDescriptor;
+    int m_datagramSize;
+
+    /** Pipe used to wake up the thread when stopping */
+    int m_wakePipe[2];
+    QAtomicInt m_running;
+};
+
+#endif
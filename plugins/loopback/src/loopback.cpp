@@ -194,14 +194,10 @@ void Loopback::writeUniverse(quint32 universe, quint32 output, const QByteArray
     {
         quint32 inputUniverse = m_inputMap[output];
 
-        for (int i = 0; i < data.size(); i++)
+        if (chData != data)
         {
-            if (chData[i] != data[i])
-            {
-                chData[i] = data[i];
-                //qDebug() << "Data changed at" << i << QString::number(chData[i]) << QString::number(data[i]);
-                emit valueChanged(inputUniverse, output, i, chData[i]);
-            }
+            chData = data;
+            emit universeDataChanged(inputUniverse, output, chData);
         }
     }
 }
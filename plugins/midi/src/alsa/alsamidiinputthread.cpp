@@ -24,6 +24,7 @@
 #include "alsamidiinputthread.h"
 #include "alsamidiutil.h"
 #include "midiprotocol.h"
+#include "qlcioplugin.h"
 
 #define POLL_TIMEOUT_MS 1000
 
@@ -33,6 +34,8 @@ AlsaMidiInputThread::AlsaMidiInputThread(snd_seq_t* alsa,
     : QThread(parent)
     , m_alsa(alsa)
     , m_destinationAddress(new snd_seq_addr_t)
+    , m_queue(-1)
+    , m_queueOffset(0)
     , m_running(false)
 {
     qDebug() << Q_FUNC_INFO;
@@ -41,6 +44,19 @@ AlsaMidiInputThread::AlsaMidiInputThread(snd_seq_t* alsa,
     Q_ASSERT(destinationAddress != NULL);
     m_destinationAddress->client = destinationAddress->client;
     m_destinationAddress->port = destinationAddress->port;
+
+    /* A running queue lets ALSA timestamp the events when they are
+       received, so clock and timecode don't suffer the polling latency */
+    m_queue = snd_seq_alloc_named_queue(m_alsa, "QLC+ input");
+    if (m_queue >= 0)
+    {
+        snd_seq_start_queue(m_alsa, m_queue, NULL);
+        snd_seq_drain_output(m_alsa);
+    }
+    else
+    {
+        qWarning() << "[ALSA MIDI] Unable to allocate a timestamp queue";
+    }
 }
 
 AlsaMidiInputThread::~AlsaMidiInputThread()
@@ -50,6 +66,13 @@ AlsaMidiInputThread::~AlsaMidiInputThread()
     m_devices.clear();
     stop();
 
+    if (m_queue >= 0)
+    {
+        snd_seq_stop_queue(m_alsa, m_queue, NULL);
+        snd_seq_drain_output(m_alsa);
+        snd_seq_free_queue(m_alsa, m_queue);
+    }
+
     delete m_destinationAddress;
     m_destinationAddress = NULL;
 }
@@ -126,6 +149,12 @@ void AlsaMidiInputThread::subscribeDevice(AlsaMidiInputDevice* device)
     snd_seq_port_subscribe_alloca(&sub);
     snd_seq_port_subscribe_set_sender(sub, device->address());
     snd_seq_port_subscribe_set_dest(sub, m_destinationAddress);
+    if (m_queue >= 0)
+    {
+        snd_seq_port_subscribe_set_queue(sub, m_queue);
+        snd_seq_port_subscribe_set_time_update(sub, 1);
+        snd_seq_port_subscribe_set_time_real(sub, 1);
+    }
     snd_seq_subscribe_port(m_alsa, sub);
 }
 
@@ -143,6 +172,33 @@ void AlsaMidiInputThread::unsubscribeDevice(AlsaMidiInputDevice* device)
     snd_seq_unsubscribe_port(m_alsa, sub);
 }
 
+/****************************************************************************
+ * Timestamps
+ ****************************************************************************/
+
+void AlsaMidiInputThread::anchorQueue()
+{
+    if (m_queue < 0)
+        return;
+
+    snd_seq_queue_status_t* status = NULL;
+    snd_seq_queue_status_alloca(&status);
+    if (snd_seq_get_queue_status(m_alsa, m_queue, status) < 0)
+        return;
+
+    const snd_seq_real_time_t* rt = snd_seq_queue_status_get_real_time(status);
+    m_queueOffset = MidiInputDevice::currentTimestamp() -
+                    (qint64(rt->tv_sec) * 1000000000LL + rt->tv_nsec);
+}
+
+qint64 AlsaMidiInputThread::eventTimestamp(const snd_seq_event_t* ev) const
+{
+    if (m_queue < 0 || ev->queue != m_queue || snd_seq_ev_is_real(ev) == false)
+        return MidiInputDevice::currentTimestamp();
+
+    return m_queueOffset + qint64(ev->time.time.tv_sec) * 1000000000LL + ev->time.time.tv_nsec;
+}
+
 /****************************************************************************
  * Poller thread
  ****************************************************************************/
@@ -168,6 +224,7 @@ void AlsaMidiInputThread::run()
 
     QMutexLocker locker(&m_mutex);
     m_running = true;
+    anchorQueue();
     while (m_running == true)
     {
         if (m_changed == true)
@@ -216,6 +273,7 @@ void AlsaMidiInputThread::readEvent()
         uchar cmd = 0;
         uchar data1 = 0;
         uchar data2 = 0;
+        qint64 timestamp = eventTimestamp(ev);
 
         //qDebug() << "ALSA MIDI event received!" << ev->type;
 
@@ -252,6 +310,10 @@ void AlsaMidiInputThread::readEvent()
                     data1 = ev->data.control.value;
                 break;
 
+                case SND_SEQ_EVENT_QFRAME:
+                    device->processQuarterFrame(ev->data.control.value, timestamp);
+                break;
+
                 default:
                 break;
             }
@@ -267,8 +329,22 @@ void AlsaMidiInputThread::readEvent()
             data1 = ev->data.note.note;
             data2 = ev->data.note.velocity;
         }
+        else if (ev->type == SND_SEQ_EVENT_SYSEX)
+        {
+            device->processFullFrame(static_cast<const uchar*>(ev->data.ext.ptr),
+                                     int(ev->data.ext.len), timestamp);
+        }
         else if (snd_seq_ev_is_queue_type(ev))
         {
+            if (ev->type == SND_SEQ_EVENT_CLOCK)
+                device->emitClockEvent(QLCIOPlugin::ClockPulse, timestamp);
+            else if (ev->type == SND_SEQ_EVENT_START)
+                device->emitClockEvent(QLCIOPlugin::ClockStart, timestamp);
+            else if (ev->type == SND_SEQ_EVENT_CONTINUE)
+                device->emitClockEvent(QLCIOPlugin::ClockContinue, timestamp);
+            else if (ev->type == SND_SEQ_EVENT_STOP)
+                device->emitClockEvent(QLCIOPlugin::ClockStop, timestamp);
+
             if (device->processMBC(ev->type) == false)
                 continue;
             if (ev->type == SND_SEQ_EVENT_START)
@@ -279,8 +355,6 @@ void AlsaMidiInputThread::readEvent()
                 cmd = MIDI_BEAT_CONTINUE;
             else if (ev->type == SND_SEQ_EVENT_CLOCK)
                 cmd = MIDI_BEAT_CLOCK;
-
-            qDebug()  << "MIDI clock: " << cmd;
         }
 
         // ALSA API is a bit controversial on this. snd_seq_event_input() says
@@ -31,6 +31,9 @@ typedef _snd_seq snd_seq_t;
 struct snd_seq_addr;
 typedef snd_seq_addr snd_seq_addr_t;
 
+struct snd_seq_event;
+typedef snd_seq_event snd_seq_event_t;
+
 class AlsaMidiInputDevice;
 
 class AlsaMidiInputThread final : public QThread
@@ -46,6 +49,22 @@ private:
     snd_seq_t* m_alsa;
     snd_seq_addr_t* m_destinationAddress;
 
+    /*************************************************************************
+     * Timestamps
+     *************************************************************************/
+private:
+    /** Compute the offset between the queue real time and the monotonic clock */
+    void anchorQueue();
+
+    /** Return the reception time of $ev in ns on the monotonic clock */
+    qint64 eventTimestamp(const snd_seq_event_t* ev) const;
+
+private:
+    /** The queue used by ALSA to timestamp the incoming events, or -1 */
+    int m_queue;
+    /** Monotonic time corresponding to the queue real time zero */
+    qint64 m_queueOffset;
+
     /*************************************************************************
      * Devices
      *************************************************************************/
@@ -37,7 +37,6 @@ AlsaMidiOutputDevice::AlsaMidiOutputDevice(const QVariant& uid,
     , m_alsa(alsa)
     , m_receiver_address(new snd_seq_addr_t)
     , m_open(false)
-    , m_universe(MAX_MIDI_DMX_CHANNELS, char(0))
 {
     Q_ASSERT(alsa != NULL);
     Q_ASSERT(recv_address != NULL);
@@ -96,31 +95,8 @@ bool AlsaMidiOutputDevice::isOpen() const
     return m_open;
 }
 
-void AlsaMidiOutputDevice::writeChannel(ushort channel, uchar value)
+void AlsaMidiOutputDevice::writeMessages(const QVector<MidiMessage>& messages)
 {
-    // m_universe contains scaled values (0-127), so we have to compare scaled value as well
-    // however, since writeUniverse scales the value again, we have to store unscaled value.
-    char scaled = DMX2MIDI(value);
-    if (channel < ushort(m_universe.size()) && m_universe[channel] != scaled)
-    {
-        QByteArray tmp(m_universe);
-
-        for (uchar ch = 0; ch < MAX_MIDI_DMX_CHANNELS && ch < tmp.size(); ++ch)
-        {
-           char midi = tmp[ch];
-           tmp[ch] = (char)MIDI2DMX(midi);
-        }
-
-        tmp[channel] = value;
-        writeUniverse(tmp);
-    }
-}
-
-void AlsaMidiOutputDevice::writeUniverse(const QByteArray& universe)
-{
-    if (isOpen() == false)
-        return;
-
     // Setup a common event structure for all values
     snd_seq_event_t ev;
     snd_seq_ev_clear(&ev);
@@ -128,120 +104,59 @@ void AlsaMidiOutputDevice::writeUniverse(const QByteArray& universe)
     //snd_seq_ev_set_subs(&ev);
     snd_seq_ev_set_direct(&ev);
 
-    // Since MIDI devices can have only 128 real channels, we don't
-    // attempt to write more than that.
-    for (uchar channel = 0; channel < MAX_MIDI_DMX_CHANNELS &&
-                            channel < universe.size(); channel++)
+    foreach (const MidiMessage& msg, messages)
     {
-        // Scale 0-255 to 0-127
-        char scaled = DMX2MIDI(universe[channel]);
-        bool invalidData = false;
-
-        // Since MIDI is so slow, we only send values that are actually changed
-        if (m_universe[channel] == scaled)
-            continue;
-
-        // Store the changed MIDI value
-        m_universe[channel] = scaled;
+        uchar midiCh = MIDI_CH(msg.cmd);
 
-        if (mode() == Note)
+        switch (MIDI_CMD(msg.cmd))
         {
-            qDebug() << "Send out NOTE";
-            // 0 is sent as a note off
-            // 1-127 is sent as note on
-            if (scaled == 0)
-                snd_seq_ev_set_noteoff(&ev, midiChannel(), channel, scaled);
-            else
-                snd_seq_ev_set_noteon(&ev, midiChannel(), channel, scaled);
-        }
-        else if (mode() == ProgramChange)
-        {
-            qDebug() << "Send out Program Change";
-            snd_seq_ev_set_pgmchange(&ev, midiChannel(), channel);
-        }
-        else if (mode() == ControlChange)
-        {
-            qDebug() << "Send out CC. Channel: " << midiChannel() << ", CC: " << channel << ", val: " << scaled;
+            case MIDI_NOTE_OFF:
+                snd_seq_ev_set_noteoff(&ev, midiCh, msg.data1, msg.data2);
+            break;
 
-            // Control change
-            snd_seq_ev_set_controller(&ev, midiChannel(), channel, scaled);
-        }
-        else
-            invalidData = true;
+            case MIDI_NOTE_ON:
+                snd_seq_ev_set_noteon(&ev, midiCh, msg.data1, msg.data2);
+            break;
 
-        if (!invalidData)
-            if (snd_seq_event_output(m_alsa, &ev) < 0)
-                qDebug() << "snd_seq_event_output ERROR";
-    }
+            case MIDI_CONTROL_CHANGE:
+                snd_seq_ev_set_controller(&ev, midiCh, msg.data1, msg.data2);
+            break;
 
-    // Make sure that all values go to the MIDI endpoint
-    snd_seq_drain_output(m_alsa);
-}
+            case MIDI_PROGRAM_CHANGE:
+                snd_seq_ev_set_pgmchange(&ev, midiCh, msg.data1);
+            break;
 
-void AlsaMidiOutputDevice::writeFeedback(uchar cmd, uchar data1, uchar data2)
-{
-    if (isOpen() == false)
-        return;
+            case MIDI_NOTE_AFTERTOUCH:
+                snd_seq_ev_set_keypress(&ev, midiCh, msg.data1, msg.data2);
+            break;
 
-    // Setup a common event structure for all values
-    snd_seq_event_t ev;
-    snd_seq_ev_clear(&ev);
-    snd_seq_ev_set_dest(&ev, m_receiver_address->client, m_receiver_address->port);
-    //snd_seq_ev_set_subs(&ev);
-    snd_seq_ev_set_direct(&ev);
+            case MIDI_CHANNEL_AFTERTOUCH:
+                snd_seq_ev_set_chanpress(&ev, midiCh, msg.data1);
+            break;
 
-    uchar midiCmd = MIDI_CMD(cmd);
-    uchar midiCh = MIDI_CH(cmd);
+            case MIDI_PITCH_WHEEL:
+                snd_seq_ev_set_pitchbend(&ev, midiCh, ((msg.data1 & 0x7f) | ((msg.data2 & 0x7f) << 7)) - 8192);
+            break;
 
-    bool invalidCmd = false;
-
-    switch(midiCmd)
-    {
-    case MIDI_NOTE_OFF:
-        snd_seq_ev_set_noteoff(&ev, midiCh, data1, data2);
-        break;
-
-    case MIDI_NOTE_ON:
-        snd_seq_ev_set_noteon(&ev, midiCh, data1, data2);
-        break;
-
-    case MIDI_CONTROL_CHANGE:
-        snd_seq_ev_set_controller(&ev, midiCh, data1, data2);
-        break;
-
-    case MIDI_PROGRAM_CHANGE:
-        snd_seq_ev_set_pgmchange(&ev, midiCh, data1);
-        break;
-
-    case MIDI_NOTE_AFTERTOUCH:
-        snd_seq_ev_set_keypress(&ev, midiCh, data1, data2);
-        break;
-
-    case MIDI_CHANNEL_AFTERTOUCH:
-        snd_seq_ev_set_chanpress(&ev, midiCh, data1);
-        break;
-
-    case MIDI_PITCH_WHEEL:
-        snd_seq_ev_set_pitchbend(&ev, midiCh, ((data1 & 0x7f) | ((data2 & 0x7f) << 7)) - 8192);
-        break;
-
-    default:
-        // What to do here ??
-        invalidCmd = true;
-        break;
-    }
+            default:
+                // What to do here ??
+                continue;
+        }
 
-    if (!invalidCmd)
-    {
-        if (snd_seq_event_output(m_alsa, &ev) < 0)
-            qDebug() << "snd_seq_event_output ERROR";
+        // events are only buffered here...
+        if (snd_seq_event_output_buffer(m_alsa, &ev) < 0)
+        {
+            // ...unless the buffer is full
+            snd_seq_drain_output(m_alsa);
+            if (snd_seq_event_output_buffer(m_alsa, &ev) < 0)
+                qDebug() << "snd_seq_event_output ERROR";
+        }
     }
 
-    // Make sure that all values go to the MIDI endpoint
+    // Make sure that all values go to the MIDI endpoint at once
     snd_seq_drain_output(m_alsa);
 }
 
-
 void AlsaMidiOutputDevice::writeSysEx(QByteArray message)
 {
     if (message.isEmpty())
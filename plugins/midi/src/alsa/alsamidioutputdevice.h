@@ -40,17 +40,16 @@ public:
     void close() override;
     bool isOpen() const override;
 
-    void writeChannel(ushort channel, uchar value) override;
-    void writeUniverse(const QByteArray& universe) override;
-    void writeFeedback(uchar cmd, uchar data1, uchar data2) override;
     void writeSysEx(QByteArray message) override;
 
+protected:
+    void writeMessages(const QVector<MidiMessage>& messages) override;
+
 private:
     snd_seq_t* m_alsa;
     snd_seq_addr_t* m_receiver_address;
     snd_seq_addr_t* m_sender_address;
     bool m_open;
-    QByteArray m_universe;
 };
 
 #endif
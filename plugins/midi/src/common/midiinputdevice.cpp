@@ -17,13 +17,26 @@
   limitations under the License.
 */
 
+#include <QDeadlineTimer>
 #include <QDebug>
+#include <cstring>
+
 #include "midiinputdevice.h"
+#include "midiprotocol.h"
+#include "qlcioplugin.h"
+
+/** MTC frame rates, indexed by the rate bits. 29.97 drop frame
+ *  labels follow the 30 fps count, so they're decoded as such */
+static const int mtcFrameRates[] = { 24, 25, 30, 30 };
 
 MidiInputDevice::MidiInputDevice(const QVariant& uid, const QString& name, QObject* parent)
     : MidiDevice(uid, name, Input, parent)
+    , m_mtcReceived(0)
+    , m_mtcFrameRate(30)
+    , m_mtcPosition(-1)
 {
     //qDebug() << Q_FUNC_INFO;
+    memset(m_mtcPieces, 0, sizeof(m_mtcPieces));
 }
 
 MidiInputDevice::~MidiInputDevice()
@@ -35,3 +48,81 @@ void MidiInputDevice::emitValueChanged(uint channel, uchar value)
 {
     emit valueChanged(uid(), channel, value);
 }
+
+/****************************************************************************
+ * Clock and timecode
+ ****************************************************************************/
+
+qint64 MidiInputDevice::currentTimestamp()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+void MidiInputDevice::emitClockEvent(int event, qint64 timestamp)
+{
+    emit clockEventReceived(uid(), event, timestamp);
+}
+
+void MidiInputDevice::processSystemCommand(uchar cmd, uchar data, qint64 timestamp)
+{
+    switch (cmd)
+    {
+        case MIDI_BEAT_CLOCK: emitClockEvent(QLCIOPlugin::ClockPulse, timestamp); break;
+        case MIDI_BEAT_START: emitClockEvent(QLCIOPlugin::ClockStart, timestamp); break;
+        case MIDI_BEAT_CONTINUE: emitClockEvent(QLCIOPlugin::ClockContinue, timestamp); break;
+        case MIDI_BEAT_STOP: emitClockEvent(QLCIOPlugin::ClockStop, timestamp); break;
+        case MIDI_TIME_CODE: processQuarterFrame(data, timestamp); break;
+        default: break;
+    }
+}
+
+static double timecodeToMs(int hours, int minutes, int seconds, int frames, int frameRate)
+{
+    return (hours * 3600 + minutes * 60 + seconds) * 1000.0 + frames * 1000.0 / frameRate;
+}
+
+void MidiInputDevice::processQuarterFrame(uchar data, qint64 timestamp)
+{
+    int piece = (data >> 4) & 0x07;
+
+    if (piece == 0)
+        m_mtcReceived = 0;
+
+    m_mtcPieces[piece] = data & 0x0F;
+    m_mtcReceived |= (1 << piece);
+
+    if (m_mtcPosition >= 0)
+        m_mtcPosition += 250.0 / m_mtcFrameRate;
+
+    if (piece == 7 && m_mtcReceived == 0xFF)
+    {
+        m_mtcFrameRate = mtcFrameRates[(m_mtcPieces[7] >> 1) & 0x03];
+        double position = timecodeToMs((m_mtcPieces[7] & 0x01) << 4 | m_mtcPieces[6],
+                                       m_mtcPieces[5] << 4 | m_mtcPieces[4],
+                                       m_mtcPieces[3] << 4 | m_mtcPieces[2],
+                                       m_mtcPieces[1] << 4 | m_mtcPieces[0],
+                                       m_mtcFrameRate);
+
+        // the timecode refers to the first quarter frame of the
+        // sequence, which has been received 7 quarter frames ago
+        m_mtcPosition = position + 7 * 250.0 / m_mtcFrameRate;
+    }
+
+    if (m_mtcPosition >= 0)
+        emit timecodeReceived(uid(), qRound64(m_mtcPosition), timestamp);
+}
+
+void MidiInputDevice::processFullFrame(const uchar *sysex, int length, qint64 timestamp)
+{
+    // F0 7F <device> 01 01 hh mm ss ff F7
+    if (sysex == NULL || length < 9 || sysex[0] != 0xF0 || sysex[1] != 0x7F ||
+        sysex[3] != 0x01 || sysex[4] != 0x01)
+        return;
+
+    m_mtcFrameRate = mtcFrameRates[(sysex[5] >> 5) & 0x03];
+    m_mtcPosition = timecodeToMs(sysex[5] & 0x1F, sysex[6] & 0x3F, sysex[7] & 0x3F,
+                                 sysex[8] & 0x1F, m_mtcFrameRate);
+    m_mtcReceived = 0;
+
+    emit timecodeReceived(uid(), qRound64(m_mtcPosition), timestamp);
+}
@@ -32,8 +32,44 @@ public:
 
     void emitValueChanged(uint channel, uchar value);
 
+    /*************************************************************************
+     * Clock and timecode
+     *************************************************************************/
+public:
+    /** Return the current time in nanoseconds on the monotonic clock
+     *  used to timestamp clock and timecode events */
+    static qint64 currentTimestamp();
+
+    /** Emit a clock $event (QLCIOPlugin::ClockEvent) received at $timestamp */
+    void emitClockEvent(int event, qint64 timestamp);
+
+    /** Emit the clock event of a MIDI realtime or MTC quarter frame $cmd,
+     *  for backends receiving raw MIDI bytes. Other commands are ignored */
+    void processSystemCommand(uchar cmd, uchar data, qint64 timestamp);
+
+    /**
+     * Decode a MIDI Time Code quarter frame message. Once a complete
+     * timecode has been received, a position is emitted for every
+     * quarter frame, so the timecode has a 1/4 frame resolution.
+     */
+    void processQuarterFrame(uchar data, qint64 timestamp);
+
+    /** Decode a MIDI Time Code full frame SysEx message (e.g. a locate) */
+    void processFullFrame(const uchar *sysex, int length, qint64 timestamp);
+
 signals:
     void valueChanged(const QVariant& uid, ushort channel, uchar value);
+    void clockEventReceived(const QVariant& uid, int event, qint64 timestamp);
+    void timecodeReceived(const QVariant& uid, qint64 position, qint64 timestamp);
+
+private:
+    /** The nibbles of the quarter frames received, and their mask */
+    uchar m_mtcPieces[8];
+    uchar m_mtcReceived;
+    /** Frame rate of the last timecode decoded */
+    int m_mtcFrameRate;
+    /** Current timecode position in milliseconds, or -1 if unknown */
+    double m_mtcPosition;
 };
 
 #endif
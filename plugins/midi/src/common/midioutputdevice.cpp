@@ -18,10 +18,14 @@
 */
 
 #include <QDebug>
+#include <algorithm>
+
 #include "midioutputdevice.h"
+#include "midiprotocol.h"
 
 MidiOutputDevice::MidiOutputDevice(const QVariant& uid, const QString& name, QObject* parent)
     : MidiDevice(uid, name, Output, parent)
+    , m_universe(MAX_MIDI_DMX_CHANNELS, char(0))
 {
     //qDebug() << Q_FUNC_INFO;
 }
@@ -30,3 +34,111 @@ MidiOutputDevice::~MidiOutputDevice()
 {
     //qDebug() << Q_FUNC_INFO;
 }
+
+void MidiOutputDevice::writeChannel(ushort channel, uchar value)
+{
+    uchar scaled = DMX2MIDI(value);
+
+    if (isOpen() == false || channel >= ushort(m_universe.size()) ||
+        uchar(m_universe[channel]) == scaled)
+        return;
+
+    m_universe[channel] = scaled;
+
+    QVector<MidiMessage> messages;
+    appendChannelMessage(uchar(channel), scaled, messages);
+    writeMessages(messages);
+}
+
+void MidiOutputDevice::writeUniverse(const QByteArray& universe)
+{
+    if (isOpen() == false)
+        return;
+
+    QVector<MidiMessage> messages;
+
+    // Since MIDI devices can have only 128 real channels, we don't
+    // attempt to write more than that.
+    for (int channel = 0; channel < MAX_MIDI_DMX_CHANNELS && channel < universe.size(); channel++)
+    {
+        // Scale 0-255 to 0-127
+        uchar scaled = DMX2MIDI(uchar(universe[channel]));
+
+        // Since MIDI is so slow, we only send values that are actually changed
+        if (uchar(m_universe[channel]) == scaled)
+            continue;
+
+        m_universe[channel] = scaled;
+        appendChannelMessage(uchar(channel), scaled, messages);
+    }
+
+    if (messages.isEmpty())
+        return;
+
+    sortByStatus(messages);
+    writeMessages(messages);
+}
+
+void MidiOutputDevice::writeFeedback(uchar cmd, uchar data1, uchar data2)
+{
+    if (isOpen() == false)
+        return;
+
+    MidiMessage message = { cmd, data1, data2 };
+    writeMessages(QVector<MidiMessage>() << message);
+}
+
+void MidiOutputDevice::writeFeedbackBatch(QVector<MidiMessage> messages)
+{
+    if (isOpen() == false || messages.isEmpty())
+        return;
+
+    sortByStatus(messages);
+    writeMessages(messages);
+}
+
+int MidiOutputDevice::messageLength(uchar cmd)
+{
+    switch (MIDI_CMD(cmd))
+    {
+        case MIDI_PROGRAM_CHANGE:
+        case MIDI_CHANNEL_AFTERTOUCH:
+            return 2;
+        default:
+            return 3;
+    }
+}
+
+void MidiOutputDevice::appendChannelMessage(uchar channel, uchar value, QVector<MidiMessage>& messages) const
+{
+    MidiMessage message = { 0, channel, value };
+
+    if (mode() == Note)
+    {
+        // 0 is sent as a note off, 1-127 as a note on
+        message.cmd = (value == 0) ? MIDI_NOTE_OFF : MIDI_NOTE_ON;
+    }
+    else if (mode() == ProgramChange)
+    {
+        message.cmd = MIDI_PROGRAM_CHANGE;
+    }
+    else
+    {
+        message.cmd = MIDI_CONTROL_CHANGE;
+    }
+
+    message.cmd |= uchar(midiChannel());
+    messages.append(message);
+}
+
+static bool compareStatus(const MidiMessage& m1, const MidiMessage& m2)
+{
+    return m1.cmd < m2.cmd;
+}
+
+void MidiOutputDevice::sortByStatus(QVector<MidiMessage>& messages)
+{
+    // each channel appears once in a batch, so reordering
+    // messages with different status is harmless
+    std::stable_sort(messages.begin(), messages.end(), compareStatus);
+}
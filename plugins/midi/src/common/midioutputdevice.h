@@ -20,8 +20,18 @@
 #ifndef MIDIOUTPUTDEVICE_H
 #define MIDIOUTPUTDEVICE_H
 
+#include <QVector>
+
 #include "mididevice.h"
 
+/** A MIDI channel message */
+struct MidiMessage
+{
+    uchar cmd;
+    uchar data1;
+    uchar data2;
+};
+
 class MidiOutputDevice : public MidiDevice
 {
     Q_OBJECT
@@ -31,10 +41,44 @@ public:
     virtual ~MidiOutputDevice();
 
 public:
-    virtual void writeChannel(ushort channel, uchar value) = 0;
-    virtual void writeUniverse(const QByteArray& universe) = 0;
-    virtual void writeFeedback(uchar cmd, uchar data1, uchar data2) = 0;
+    /** Write a single DMX channel value. Nothing is sent if the scaled
+     *  MIDI value is the same as the last one sent for the channel */
+    void writeChannel(ushort channel, uchar value);
+
+    /** Write a DMX universe. Only the channels whose scaled MIDI value
+     *  changed since the last write are sent, in a single batch */
+    void writeUniverse(const QByteArray& universe);
+
+    /** Send a single feedback message */
+    void writeFeedback(uchar cmd, uchar data1, uchar data2);
+
+    /** Send several feedback messages in a single batch. Messages are
+     *  grouped by status, so backends can take advantage of running status */
+    void writeFeedbackBatch(QVector<MidiMessage> messages);
+
     virtual void writeSysEx(QByteArray message) = 0;
+
+protected:
+    /**
+     * Send $messages to the device in the given order. Backends should
+     * deliver the whole batch at once, flushing their output only at the end.
+     * This is called only when the device is open.
+     */
+    virtual void writeMessages(const QVector<MidiMessage>& messages) = 0;
+
+    /** Return the length in bytes of a channel message with status $cmd */
+    static int messageLength(uchar cmd);
+
+private:
+    /** Append the message of a DMX $channel with a MIDI $value, according to the device mode */
+    void appendChannelMessage(uchar channel, uchar value, QVector<MidiMessage>& messages) const;
+
+    /** Group $messages by status, keeping the order of the messages sharing the same status */
+    static void sortByStatus(QVector<MidiMessage>& messages);
+
+private:
+    /** The last MIDI value sent for each DMX channel */
+    QByteArray m_universe;
 };
 
 #endif
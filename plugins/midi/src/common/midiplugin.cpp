@@ -209,6 +209,10 @@ bool MidiPlugin::openInput(quint32 input, quint32 universe)
     {
         connect(dev, SIGNAL(valueChanged(QVariant,ushort,uchar)),
                 this, SLOT(slotValueChanged(QVariant,ushort,uchar)));
+        connect(dev, SIGNAL(clockEventReceived(QVariant,int,qint64)),
+                this, SLOT(slotClockEventReceived(QVariant,int,qint64)));
+        connect(dev, SIGNAL(timecodeReceived(QVariant,qint64,qint64)),
+                this, SLOT(slotTimecodeReceived(QVariant,qint64,qint64)));
         addToMap(universe, input, Input);
         return dev->open();
     }
@@ -226,6 +230,10 @@ void MidiPlugin::closeInput(quint32 input, quint32 universe)
         dev->close();
         disconnect(dev, SIGNAL(valueChanged(QVariant,ushort,uchar)),
                    this, SLOT(slotValueChanged(QVariant,ushort,uchar)));
+        disconnect(dev, SIGNAL(clockEventReceived(QVariant,int,qint64)),
+                   this, SLOT(slotClockEventReceived(QVariant,int,qint64)));
+        disconnect(dev, SIGNAL(timecodeReceived(QVariant,qint64,qint64)),
+                   this, SLOT(slotTimecodeReceived(QVariant,qint64,qint64)));
     }
 }
 
@@ -295,21 +303,51 @@ void MidiPlugin::sendFeedBack(quint32 universe, quint32 output, quint32 channel,
     if (dev != NULL)
     {
         qDebug() << "[sendFeedBack] Dev:" << dev->name() << ", channel:" << channel << ", value:" << value << dev->sendNoteOff();
-        uchar cmd = 0;
-        uchar data1 = 0, data2 = 0;
-        int midiChannel = dev->midiChannel();
-        if (params.isValid() && params.toInt() >= 0)
-            midiChannel += params.toInt();
-
-        if (QLCMIDIProtocol::feedbackToMidi(channel, value, midiChannel, dev->sendNoteOff(),
-                                        &cmd, &data1, &data2) == true)
+        MidiMessage msg;
+
+        if (feedbackMessage(dev, channel, value, params, &msg) == true)
         {
-            qDebug() << "[sendFeedBack] cmd:" << cmd << "data1:" << data1 << "data2:" << data2;
-            dev->writeFeedback(cmd, data1, data2);
+            qDebug() << "[sendFeedBack] cmd:" << msg.cmd << "data1:" << msg.data1 << "data2:" << msg.data2;
+            dev->writeFeedback(msg.cmd, msg.data1, msg.data2);
         }
     }
 }
 
+void MidiPlugin::sendFeedBackBatch(quint32 universe, quint32 output, const QList<QLCFeedbackValue> &values)
+{
+    Q_UNUSED(universe)
+
+    MidiOutputDevice* dev = outputDevice(output);
+    if (dev == NULL)
+        return;
+
+    QVector<MidiMessage> messages;
+    messages.reserve(values.count());
+
+    foreach (const QLCFeedbackValue &fb, values)
+    {
+        MidiMessage msg;
+        if (feedbackMessage(dev, fb.channel, fb.value, fb.params, &msg) == true)
+            messages.append(msg);
+    }
+
+    // a single flush of the whole batch, instead of one per value
+    dev->writeFeedbackBatch(messages);
+}
+
+bool MidiPlugin::feedbackMessage(MidiOutputDevice* dev, quint32 channel, uchar value,
+                                 const QVariant &params, MidiMessage* msg) const
+{
+    int midiChannel = dev->midiChannel();
+    if (params.isValid() && params.toInt() >= 0)
+        midiChannel += params.toInt();
+
+    msg->cmd = msg->data1 = msg->data2 = 0;
+
+    return QLCMIDIProtocol::feedbackToMidi(channel, value, midiChannel, dev->sendNoteOff(),
+                                           &msg->cmd, &msg->data1, &msg->data2);
+}
+
 void MidiPlugin::sendSysEx(quint32 output, const QByteArray &data)
 {
     qDebug() << "sendSysEx data: " << data;
@@ -341,6 +379,30 @@ void MidiPlugin::slotValueChanged(const QVariant& uid, ushort channel, uchar val
     }
 }
 
+void MidiPlugin::slotClockEventReceived(const QVariant& uid, int event, qint64 timestamp)
+{
+    for (int i = 0; i < m_enumerator->inputDevices().size(); i++)
+    {
+        if (m_enumerator->inputDevices().at(i)->uid() == uid)
+        {
+            emit clockEventReceived(UINT_MAX, i, event, timestamp);
+            break;
+        }
+    }
+}
+
+void MidiPlugin::slotTimecodeReceived(const QVariant& uid, qint64 position, qint64 timestamp)
+{
+    for (int i = 0; i < m_enumerator->inputDevices().size(); i++)
+    {
+        if (m_enumerator->inputDevices().at(i)->uid() == uid)
+        {
+            emit timecodeReceived(UINT_MAX, i, position, timestamp);
+            break;
+        }
+    }
+}
+
 /*****************************************************************************
  * Configuration
  *****************************************************************************/
@@ -34,6 +34,7 @@ class MidiOutputDevice;
 class MidiInputDevice;
 class MidiEnumerator;
 class MidiTemplate;
+struct MidiMessage;
 class QString;
 
 #define MIDI_MIDICHANNEL "midichannel"
@@ -93,6 +94,10 @@ private:
     /** Get an output device by its output index */
     MidiOutputDevice* outputDevice(quint32 output) const;
 
+    /** Convert a QLC+ feedback value into a MIDI message for $dev */
+    bool feedbackMessage(MidiOutputDevice* dev, quint32 channel, uchar value,
+                         const QVariant &params, MidiMessage* msg) const;
+
     /*************************************************************************
      * Inputs
      *************************************************************************/
@@ -112,6 +117,9 @@ public:
     /** @reimp */
     void sendFeedBack(quint32 universe, quint32 output, quint32 channel, uchar value, const QVariant &params) override;
 
+    /** @reimp */
+    void sendFeedBackBatch(quint32 universe, quint32 output, const QList<QLCFeedbackValue> &values) override;
+
     void sendSysEx(quint32 output, const QByteArray &data);
 
 private:
@@ -121,6 +129,8 @@ private:
 private slots:
     /** Catch MIDI input device valueChanged signals */
     void slotValueChanged(const QVariant& uid, ushort channel, uchar value);
+    void slotClockEventReceived(const QVariant& uid, int event, qint64 timestamp);
+    void slotTimecodeReceived(const QVariant& uid, qint64 position, qint64 timestamp);
 
     /*************************************************************************
      * Configuration
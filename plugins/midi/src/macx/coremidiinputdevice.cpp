@@ -67,6 +67,8 @@ static void MidiInProc(const MIDIPacketList* pktList, void* readProcRefCon,
                     data2 = 127;
             }
 
+            self->processSystemCommand(cmd, data1, MidiInputDevice::currentTimestamp());
+
             if (cmd >= MIDI_BEAT_CLOCK && cmd <= MIDI_BEAT_STOP)
             {
                 if (self->processMBC(cmd) == false)
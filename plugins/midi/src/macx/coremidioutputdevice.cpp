@@ -33,7 +33,6 @@ CoreMidiOutputDevice::CoreMidiOutputDevice(const QVariant& uid, const QString& n
     , m_client(client)
     , m_outPort(0)
     , m_destination(destination)
-    , m_universe(MAX_MIDI_DMX_CHANNELS, char(0))
 {
 }
 
@@ -83,117 +82,47 @@ bool CoreMidiOutputDevice::isOpen() const
         return false;
 }
 
-void CoreMidiOutputDevice::writeChannel(ushort channel, uchar value)
+void CoreMidiOutputDevice::writeMessages(const QVector<MidiMessage>& messages)
 {
-    // m_universe contains scaled values (0-127), so we have to compare scaled value as well
-    // however, since writeUniverse scales the value again, we have to store unscaled value.
-    char scaled = DMX2MIDI(value);
-    if (channel < ushort(m_universe.size()) && m_universe[channel] != scaled)
-    {
-        QByteArray tmp(m_universe);
-
-        for (uchar ch = 0; ch < MAX_MIDI_DMX_CHANNELS && ch < tmp.size(); ++ch)
-        {
-           char midi = tmp[ch];
-           tmp[ch] = (char)MIDI2DMX(midi);
-        }
-
-        tmp[channel] = value;
-        writeUniverse(tmp);
-    }
-}
-
-void CoreMidiOutputDevice::writeUniverse(const QByteArray& universe)
-{
-    if (isOpen() == false)
-        return;
-
-    Byte buffer[512]; // Should be enough for 128 channels
+    Byte buffer[1024]; // Should be enough for 128 channels
     MIDIPacketList* list = (MIDIPacketList*) buffer;
     MIDIPacket* packet = MIDIPacketListInit(list);
 
-    /* Since MIDI devices can have only 128 real channels, we don't
-       attempt to write more than that */
-    for (Byte channel = 0; channel < MAX_MIDI_DMX_CHANNELS &&
-                           channel < universe.size(); channel++)
+    foreach (const MidiMessage& msg, messages)
     {
-        Byte cmd[3];
-        cmd[1] = channel;
-        cmd[2] = DMX2MIDI(uchar(universe[channel]));
-
-        /* Since MIDI is so slow, we only send values that are
-           actually changed. */
-        if (uchar(m_universe[channel]) == cmd[2])
-            continue;
-
-        /* Store the changed MIDI value. */
-        m_universe[channel] = cmd[2];
-
-        if (mode() == Note)
+        Byte message[3];
+        message[0] = msg.cmd;
+        message[1] = msg.data1;
+        message[2] = msg.data2;
+
+        /* Add the MIDI command to the packet list. CoreMIDI doesn't
+           allow running status, so each message is complete */
+        MIDIPacket* next = MIDIPacketListAdd(list, sizeof(buffer), packet, 0,
+                                             messageLength(msg.cmd), message);
+        if (next == 0)
         {
-            if (cmd[2] == 0)
-            {
-                /* Zero is sent as a note off command */
-                cmd[0] = MIDI_NOTE_OFF;
-            }
-            else
+            /* The list is full: send what has been collected so far
+               and start a new list with this message */
+            sendPacketList(list);
+            packet = MIDIPacketListInit(list);
+            next = MIDIPacketListAdd(list, sizeof(buffer), packet, 0,
+                                     messageLength(msg.cmd), message);
+            if (next == 0)
             {
-                /* 1-127 is sent as note on command */
-                cmd[0] = MIDI_NOTE_ON;
+                qWarning() << Q_FUNC_INFO << "Unable to add a MIDI message for" << name();
+                continue;
             }
         }
-        else if (mode() == ProgramChange)
-        {
-            /* Program change */
-            cmd[0] = MIDI_PROGRAM_CHANGE;
-        }
-        else
-        {
-            /* Control change */
-            cmd[0] = MIDI_CONTROL_CHANGE;
-        }
-
-        /* Encode MIDI channel to the command */
-        cmd[0] |= (Byte) midiChannel();
-
-        /* Add the MIDI command to the packet list */
-        packet = MIDIPacketListAdd(list, sizeof(buffer), packet, 0, sizeof(cmd), cmd);
-        if (packet == 0)
-        {
-            qWarning() << "MIDIOut buffer overflow";
-            break;
-        }
+        packet = next;
     }
 
-    /* Send the MIDI packet list */
-    OSStatus s = MIDISend(m_outPort, m_destination, list);
-    if (s != 0)
-        qWarning() << Q_FUNC_INFO << "Unable to send MIDI data to" << name();
+    /* Send the whole MIDI packet list at once */
+    if (list->numPackets > 0)
+        sendPacketList(list);
 }
 
-void CoreMidiOutputDevice::writeFeedback(uchar cmd, uchar data1, uchar data2)
+void CoreMidiOutputDevice::sendPacketList(const MIDIPacketList* list)
 {
-    if (isOpen() == false)
-        return;
-
-    Byte buffer[128]; // Should be enough for 1 message
-    MIDIPacketList* list = (MIDIPacketList*) buffer;
-    MIDIPacket* packet = MIDIPacketListInit(list);
-
-    Byte message[3];
-    message[0] = cmd;
-    message[1] = data1;
-    message[2] = data2;
-
-    /* Add the MIDI command to the packet list */
-    packet = MIDIPacketListAdd(list, sizeof(buffer), packet, 0, sizeof(message), message);
-    if (packet == 0)
-    {
-        qWarning() << "MIDIOut buffer overflow";
-        return;
-    }
-
-    /* Send the MIDI packet list */
     OSStatus s = MIDISend(m_outPort, m_destination, list);
     if (s != 0)
         qWarning() << Q_FUNC_INFO << "Unable to send MIDI data to" << name();
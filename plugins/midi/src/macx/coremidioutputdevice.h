@@ -37,16 +37,19 @@ public:
     void close();
     bool isOpen() const;
 
-    void writeChannel(ushort channel, uchar value);
-    void writeUniverse(const QByteArray& universe);
-    void writeFeedback(uchar cmd, uchar data1, uchar data2);
     void writeSysEx(QByteArray message);
 
+protected:
+    void writeMessages(const QVector<MidiMessage>& messages);
+
+private:
+    /** Send a MIDI packet list to the destination */
+    void sendPacketList(const MIDIPacketList* list);
+
 private:
     MIDIClientRef m_client;
     MIDIPortRef m_outPort;
     MIDIEndpointRef m_destination;
-    QByteArray m_universe;
 };
 
 #endif
@@ -38,6 +38,8 @@ static void CALLBACK MidiInProc(HMIDIIN hMidiIn, UINT wMsg,
         BYTE data1 = (dwParam1 & 0xFF00) >> 8;
         BYTE data2 = (dwParam1 & 0xFF0000) >> 16;
 
+        self->processSystemCommand(cmd, data1, MidiInputDevice::currentTimestamp());
+
         if (cmd >= MIDI_BEAT_CLOCK && cmd <= MIDI_BEAT_STOP)
         {
             if (self->processMBC(cmd) == false)
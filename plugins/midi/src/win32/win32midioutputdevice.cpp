@@ -27,7 +27,6 @@ Win32MidiOutputDevice::Win32MidiOutputDevice(const QVariant& uid, const QString&
     : MidiOutputDevice(uid, name, parent)
     , m_id(id)
     , m_handle(NULL)
-    , m_universe(MAX_MIDI_DMX_CHANNELS, char(0))
 {
     qDebug() << Q_FUNC_INFO;
 }
@@ -77,78 +76,21 @@ bool Win32MidiOutputDevice::isOpen() const
         return false;
 }
 
-void Win32MidiOutputDevice::writeChannel(ushort channel, uchar value)
+void Win32MidiOutputDevice::writeMessages(const QVector<MidiMessage>& messages)
 {
-    // m_universe contains scaled values (0-127), so we have to compare scaled value as well
-    // however, since writeUniverse scales the value again, we have to store unscaled value.
-    char scaled = DMX2MIDI(value);
-    if (channel < ushort(m_universe.size()) && m_universe[channel] != scaled)
-    {
-        QByteArray tmp(m_universe);
-
-        for (uchar ch = 0; ch < MAX_MIDI_DMX_CHANNELS && ch < tmp.size(); ++ch)
-        {
-           char midi = tmp[ch];
-           tmp[ch] = (char)MIDI2DMX(midi);
-        }
-
-        tmp[channel] = value;
-        writeUniverse(tmp);
-    }
-}
+    BYTE status = 0;
 
-void Win32MidiOutputDevice::writeUniverse(const QByteArray& universe)
-{
-    if (isOpen() == false)
-        return;
-
-    for (BYTE channel = 0; channel < MAX_MIDI_DMX_CHANNELS &&
-                           channel < universe.size(); channel++)
+    foreach (const MidiMessage& msg, messages)
     {
-        /* Scale 0-255 to 0-127 */
-        char scaled = DMX2MIDI(uchar(universe[channel]));
-
-        /* Since MIDI is so slow, we only send values that are
-           actually changed. */
-        if (m_universe[channel] == scaled)
-            continue;
-
-        /* Store the changed MIDI value */
-        m_universe[channel] = scaled;
-
-        if (mode() == Note)
-        {
-            if (scaled == 0)
-            {
-                /* Zero is sent as a note off command */
-                sendData(MIDI_NOTE_OFF | (BYTE) midiChannel(), channel, scaled);
-            }
-            else
-            {
-                /* 1-127 are sent as note on commands */
-                sendData(MIDI_NOTE_ON | (BYTE) midiChannel(), channel, scaled);
-            }
-        }
-        else if (mode() == ProgramChange)
-        {
-            /* Program change */
-            sendData(MIDI_PROGRAM_CHANGE | (BYTE) midiChannel(), channel, (BYTE)scaled);
-        }
+        /* Messages sharing the status of the previous one are sent
+           with running status, saving a third of the bandwidth */
+        if (msg.cmd == status)
+            sendData(msg.data1, msg.data2, 0);
         else
-        {
-            //qDebug() << "[writeUniverse] MIDI: " << midiChannel() << ", channel: " << channel << ", value: " << scaled;
-            /* Control change */
-            sendData(MIDI_CONTROL_CHANGE | (BYTE) midiChannel(), channel, (BYTE)scaled);
-        }
-    }
-}
-
-void Win32MidiOutputDevice::writeFeedback(uchar cmd, uchar data1, uchar data2)
-{
-    if (isOpen() == false)
-        return;
+            sendData(msg.cmd, msg.data1, msg.data2);
 
-    sendData(cmd, data1, data2);
+        status = msg.cmd;
+    }
 }
 
 void Win32MidiOutputDevice::sendData(BYTE command, BYTE channel, BYTE value)
@@ -37,18 +37,17 @@ public:
     void close();
     bool isOpen() const;
 
-    void writeChannel(ushort channel, uchar value);
-    void writeUniverse(const QByteArray& universe);
-    void writeFeedback(uchar cmd, uchar data1, uchar data2);
     void writeSysEx(QByteArray message);
 
+protected:
+    void writeMessages(const QVector<MidiMessage>& messages);
+
 private:
     void sendData(BYTE command, BYTE channel, BYTE value);
 
 private:
     UINT m_id;
     HMIDIOUT m_handle;
-    QByteArray m_universe;
 };
 
 #endif
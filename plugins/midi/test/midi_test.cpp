@@ -17,14 +17,98 @@
   limitations under the License.
 */
 
+#include <QSignalSpy>
 #include <QTest>
 
 #define private public
 #include "midi_test.h"
 #include "midiprotocol.h"
+#include "midiinputdevice.h"
+#include "midioutputdevice.h"
+#include "qlcioplugin.h"
 
 #undef private
 
+/** A MIDI input device not bound to any backend */
+class MidiInputDeviceStub final : public MidiInputDevice
+{
+public:
+    MidiInputDeviceStub()
+        : MidiInputDevice(QVariant("stub"), "Stub")
+        , m_open(false)
+    {
+    }
+
+    bool open() override { m_open = true; return true; }
+    void close() override { m_open = false; }
+    bool isOpen() const override { return m_open; }
+
+private:
+    bool m_open;
+};
+
+/** A MIDI output device recording the batches it is asked to send */
+class MidiOutputDeviceStub final : public MidiOutputDevice
+{
+public:
+    MidiOutputDeviceStub()
+        : MidiOutputDevice(QVariant("stub"), "Stub")
+        , m_open(false)
+    {
+        setMode(ControlChange);
+        setMidiChannel(0);
+    }
+
+    ~MidiOutputDeviceStub()
+    {
+        // leave the default settings behind
+        setMode(ControlChange);
+        setMidiChannel(0);
+    }
+
+    bool open() override { m_open = true; return true; }
+    void close() override { m_open = false; }
+    bool isOpen() const override { return m_open; }
+
+    void writeSysEx(QByteArray message) override { Q_UNUSED(message); }
+
+    using MidiOutputDevice::messageLength;
+
+protected:
+    void writeMessages(const QVector<MidiMessage>& messages) override
+    {
+        m_batches.append(messages);
+    }
+
+public:
+    QList< QVector<MidiMessage> > m_batches;
+
+private:
+    bool m_open;
+};
+
+/** Compare $message with the expected $cmd, $data1 and $data2 */
+static bool isMessage(const MidiMessage& message, uchar cmd, uchar data1, uchar data2)
+{
+    return message.cmd == cmd && message.data1 == data1 && message.data2 == data2;
+}
+
+/** Feed the 8 quarter frames of $hours:$minutes:$seconds:$frames
+ *  with the MTC $rate bits, starting at $timestamp */
+static void sendQuarterFrames(MidiInputDevice &device, int hours, int minutes, int seconds,
+                              int frames, int rate, qint64 timestamp)
+{
+    uchar nibbles[8] = {
+        uchar(frames & 0x0F), uchar(frames >> 4),
+        uchar(seconds & 0x0F), uchar(seconds >> 4),
+        uchar(minutes & 0x0F), uchar(minutes >> 4),
+        uchar(hours & 0x0F), uchar((hours >> 4) | (rate << 1))
+    };
+
+    for (int piece = 0; piece < 8; piece++)
+        device.processQuarterFrame(uchar(piece << 4 | nibbles[piece]), timestamp + piece);
+}
+
 /****************************************************************************
  * MIDI tests
  ****************************************************************************/
@@ -45,4 +129,269 @@ void Midi_Test::midiToInput()
     QCOMPARE(value, uchar(255U));
 }
 
+/****************************************************************************
+ * MIDI Time Code tests
+ ****************************************************************************/
+
+void Midi_Test::mtcQuarterFrame()
+{
+    MidiInputDeviceStub device;
+    QSignalSpy spy(&device, SIGNAL(timecodeReceived(QVariant,qint64,qint64)));
+
+    // 01:02:03:04 at 25 fps. Nothing is emitted until a whole sequence is received
+    sendQuarterFrames(device, 1, 2, 3, 4, 1, 1000);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), QString("stub"));
+    QCOMPARE(spy.at(0).at(2).toLongLong(), qint64(1007));
+
+    // the timecode refers to the first quarter frame, 7 quarter frames ago
+    qint64 position = (3600 + 2 * 60 + 3) * 1000 + 4 * 40;
+    QCOMPARE(spy.at(0).at(1).toLongLong(), position + 70);
+
+    // then every quarter frame moves the position by a quarter of frame
+    device.processQuarterFrame(0x00, 2000);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(1).toLongLong(), position + 80);
+    QCOMPARE(spy.at(1).at(2).toLongLong(), qint64(2000));
+
+    // a complete sequence realigns the position on its timecode
+    sendQuarterFrames(device, 0, 0, 10, 0, 1, 3000);
+    QCOMPARE(spy.count(), 10);
+    QCOMPARE(spy.last().at(1).toLongLong(), qint64(10070));
+}
+
+void Midi_Test::mtcPartialSequence()
+{
+    MidiInputDeviceStub device;
+    QSignalSpy spy(&device, SIGNAL(timecodeReceived(QVariant,qint64,qint64)));
+
+    // a sequence joined halfway isn't decoded
+    for (int piece = 4; piece < 8; piece++)
+        device.processQuarterFrame(uchar(piece << 4), 0);
+    QCOMPARE(spy.count(), 0);
+
+    // neither is one missing a piece
+    for (int piece = 0; piece < 8; piece++)
+    {
+        if (piece != 3)
+            device.processQuarterFrame(uchar(piece << 4), 0);
+    }
+    QCOMPARE(spy.count(), 0);
+
+    sendQuarterFrames(device, 0, 0, 1, 0, 1, 0);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).toLongLong(), qint64(1070));
+}
+
+void Midi_Test::mtcFrameRates()
+{
+    MidiInputDeviceStub device;
+    QSignalSpy spy(&device, SIGNAL(timecodeReceived(QVariant,qint64,qint64)));
+
+    // 24 fps: frame 12 is at 500 ms, a quarter frame lasts 10.4 ms
+    sendQuarterFrames(device, 0, 0, 0, 12, 0, 0);
+    QCOMPARE(spy.last().at(1).toLongLong(), qint64(500 + 73));
+
+    // 30 fps
+    sendQuarterFrames(device, 0, 0, 0, 15, 3, 0);
+    QCOMPARE(spy.last().at(1).toLongLong(), qint64(500 + 58));
+    QCOMPARE(device.m_mtcFrameRate, 30);
+
+    // 29.97 drop frame is decoded as 30 fps
+    sendQuarterFrames(device, 0, 0, 0, 15, 2, 0);
+    QCOMPARE(spy.last().at(1).toLongLong(), qint64(500 + 58));
+    QCOMPARE(device.m_mtcFrameRate, 30);
+}
+
+void Midi_Test::mtcFullFrame()
+{
+    MidiInputDeviceStub device;
+    QSignalSpy spy(&device, SIGNAL(timecodeReceived(QVariant,qint64,qint64)));
+
+    // 01:02:03:04 at 25 fps
+    uchar sysex[] = { 0xF0, 0x7F, 0x7F, 0x01, 0x01, 0x21, 0x02, 0x03, 0x04, 0xF7 };
+    qint64 position = (3600 + 2 * 60 + 3) * 1000 + 4 * 40;
+
+    device.processFullFrame(sysex, sizeof(sysex), 500);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).toLongLong(), position);
+    QCOMPARE(spy.at(0).at(2).toLongLong(), qint64(500));
+
+    // the quarter frames following a locate continue from its position
+    device.processQuarterFrame(0x00, 510);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(1).toLongLong(), position + 10);
+
+    // malformed messages are ignored
+    device.processFullFrame(sysex, 8, 0);
+    device.processFullFrame(NULL, sizeof(sysex), 0);
+    sysex[1] = 0x7E;
+    device.processFullFrame(sysex, sizeof(sysex), 0);
+    sysex[1] = 0x7F;
+    sysex[4] = 0x02;
+    device.processFullFrame(sysex, sizeof(sysex), 0);
+    QCOMPARE(spy.count(), 2);
+}
+
+void Midi_Test::clockEvents()
+{
+    MidiInputDeviceStub device;
+    QSignalSpy spy(&device, SIGNAL(clockEventReceived(QVariant,int,qint64)));
+    QSignalSpy mtcSpy(&device, SIGNAL(timecodeReceived(QVariant,qint64,qint64)));
+
+    device.processSystemCommand(MIDI_BEAT_START, 0, 10);
+    device.processSystemCommand(MIDI_BEAT_CLOCK, 0, 20);
+    device.processSystemCommand(MIDI_BEAT_STOP, 0, 30);
+    device.processSystemCommand(MIDI_BEAT_CONTINUE, 0, 40);
+    // not a clock event
+    device.processSystemCommand(MIDI_SYSEX, 0, 50);
+
+    QCOMPARE(spy.count(), 4);
+    QCOMPARE(spy.at(0).at(1).toInt(), int(QLCIOPlugin::ClockStart));
+    QCOMPARE(spy.at(1).at(1).toInt(), int(QLCIOPlugin::ClockPulse));
+    QCOMPARE(spy.at(1).at(2).toLongLong(), qint64(20));
+    QCOMPARE(spy.at(2).at(1).toInt(), int(QLCIOPlugin::ClockStop));
+    QCOMPARE(spy.at(3).at(1).toInt(), int(QLCIOPlugin::ClockContinue));
+
+    // MTC quarter frames are decoded too
+    for (int piece = 0; piece < 8; piece++)
+        device.processSystemCommand(MIDI_TIME_CODE, uchar(piece << 4), 60);
+    QCOMPARE(mtcSpy.count(), 1);
+    QCOMPARE(spy.count(), 4);
+}
+
+/****************************************************************************
+ * MIDI output tests
+ ****************************************************************************/
+
+void Midi_Test::outputChanges()
+{
+    MidiOutputDeviceStub device;
+    QByteArray universe(512, 0);
+
+    // nothing is sent to a closed device
+    universe[0] = char(255);
+    device.writeUniverse(universe);
+    device.writeChannel(0, 255);
+    QCOMPARE(device.m_batches.count(), 0);
+
+    device.open();
+
+    // only the changed channels are sent, in a single batch
+    device.writeUniverse(universe);
+    QCOMPARE(device.m_batches.count(), 1);
+    QCOMPARE(device.m_batches.at(0).count(), 1);
+    QVERIFY(isMessage(device.m_batches.at(0).at(0), MIDI_CONTROL_CHANGE, 0, 127));
+
+    universe[5] = char(128);
+    universe[6] = char(10);
+    device.writeUniverse(universe);
+    QCOMPARE(device.m_batches.count(), 2);
+    QCOMPARE(device.m_batches.at(1).count(), 2);
+    QVERIFY(isMessage(device.m_batches.at(1).at(0), MIDI_CONTROL_CHANGE, 5, 64));
+    QVERIFY(isMessage(device.m_batches.at(1).at(1), MIDI_CONTROL_CHANGE, 6, 5));
+
+    // no change, a change lost in the 7 bit scaling, or a
+    // change beyond the 128 MIDI channels: nothing is sent
+    device.writeUniverse(universe);
+    universe[0] = char(254);
+    device.writeUniverse(universe);
+    universe[200] = char(255);
+    device.writeUniverse(universe);
+    QCOMPARE(device.m_batches.count(), 2);
+
+    // single channels are compared with the same cache
+    device.writeChannel(5, 129);
+    device.writeChannel(300, 255);
+    QCOMPARE(device.m_batches.count(), 2);
+    device.writeChannel(5, 0);
+    QCOMPARE(device.m_batches.count(), 3);
+    QCOMPARE(device.m_batches.at(2).count(), 1);
+    QVERIFY(isMessage(device.m_batches.at(2).at(0), MIDI_CONTROL_CHANGE, 5, 0));
+
+    device.writeUniverse(universe);
+    QCOMPARE(device.m_batches.count(), 4);
+    QCOMPARE(device.m_batches.at(3).count(), 1);
+    QVERIFY(isMessage(device.m_batches.at(3).at(0), MIDI_CONTROL_CHANGE, 5, 64));
+}
+
+void Midi_Test::outputModes()
+{
+    MidiOutputDeviceStub device;
+    device.open();
+    device.setMidiChannel(2);
+
+    device.setMode(MidiDevice::Note);
+    device.writeChannel(1, 255);
+    device.writeChannel(1, 0);
+    QCOMPARE(device.m_batches.count(), 2);
+    QVERIFY(isMessage(device.m_batches.at(0).at(0), MIDI_NOTE_ON | 2, 1, 127));
+    QVERIFY(isMessage(device.m_batches.at(1).at(0), MIDI_NOTE_OFF | 2, 1, 0));
+
+    device.setMode(MidiDevice::ProgramChange);
+    device.writeChannel(1, 100);
+    QCOMPARE(device.m_batches.count(), 3);
+    QVERIFY(isMessage(device.m_batches.at(2).at(0), MIDI_PROGRAM_CHANGE | 2, 1, 50));
+
+    QCOMPARE(MidiOutputDeviceStub::messageLength(MIDI_PROGRAM_CHANGE | 2), 2);
+    QCOMPARE(MidiOutputDeviceStub::messageLength(MIDI_CHANNEL_AFTERTOUCH), 2);
+    QCOMPARE(MidiOutputDeviceStub::messageLength(MIDI_CONTROL_CHANGE), 3);
+    QCOMPARE(MidiOutputDeviceStub::messageLength(MIDI_NOTE_ON | 15), 3);
+}
+
+void Midi_Test::outputOrdering()
+{
+    MidiOutputDeviceStub device;
+    QByteArray universe(512, 0);
+    device.open();
+    device.setMode(MidiDevice::Note);
+
+    universe[1] = char(255);
+    universe[3] = char(255);
+    device.writeUniverse(universe);
+
+    // messages are grouped by status, keeping the channel order within a group
+    universe[1] = 0;
+    universe[2] = char(255);
+    universe[3] = 0;
+    universe[4] = char(255);
+    device.writeUniverse(universe);
+    QCOMPARE(device.m_batches.count(), 2);
+
+    const QVector<MidiMessage> &batch = device.m_batches.at(1);
+    QCOMPARE(batch.count(), 4);
+    QVERIFY(isMessage(batch.at(0), MIDI_NOTE_OFF, 1, 0));
+    QVERIFY(isMessage(batch.at(1), MIDI_NOTE_OFF, 3, 0));
+    QVERIFY(isMessage(batch.at(2), MIDI_NOTE_ON, 2, 127));
+    QVERIFY(isMessage(batch.at(3), MIDI_NOTE_ON, 4, 127));
+
+    // feedback batches are grouped as well
+    QVector<MidiMessage> feedback;
+    MidiMessage m1 = { MIDI_NOTE_ON, 1, 1 };
+    MidiMessage m2 = { MIDI_CONTROL_CHANGE, 2, 2 };
+    MidiMessage m3 = { MIDI_NOTE_ON, 3, 3 };
+    MidiMessage m4 = { MIDI_NOTE_OFF, 4, 0 };
+    feedback << m1 << m2 << m3 << m4;
+
+    device.writeFeedbackBatch(feedback);
+    QCOMPARE(device.m_batches.count(), 3);
+    const QVector<MidiMessage> &sorted = device.m_batches.at(2);
+    QCOMPARE(sorted.count(), 4);
+    QVERIFY(isMessage(sorted.at(0), MIDI_NOTE_OFF, 4, 0));
+    QVERIFY(isMessage(sorted.at(1), MIDI_NOTE_ON, 1, 1));
+    QVERIFY(isMessage(sorted.at(2), MIDI_NOTE_ON, 3, 3));
+    QVERIFY(isMessage(sorted.at(3), MIDI_CONTROL_CHANGE, 2, 2));
+
+    // empty batches are not sent, single feedbacks are sent as they are
+    device.writeFeedbackBatch(QVector<MidiMessage>());
+    QCOMPARE(device.m_batches.count(), 3);
+    device.writeFeedback(MIDI_CONTROL_CHANGE, 7, 8);
+    QCOMPARE(device.m_batches.count(), 4);
+    QVERIFY(isMessage(device.m_batches.at(3).at(0), MIDI_CONTROL_CHANGE, 7, 8));
+
+    device.close();
+    device.writeFeedbackBatch(feedback);
+    QCOMPARE(device.m_batches.count(), 4);
+}
+
 QTEST_MAIN(Midi_Test)
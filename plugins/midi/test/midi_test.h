@@ -28,6 +28,16 @@ class Midi_Test final : public QObject
 
 private slots:
     void midiToInput();
+
+    void mtcQuarterFrame();
+    void mtcPartialSequence();
+    void mtcFrameRates();
+    void mtcFullFrame();
+    void clockEvents();
+
+    void outputChanges();
+    void outputModes();
+    void outputOrdering();
 };
 
 #endif
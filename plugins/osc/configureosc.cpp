@@ -19,6 +19,7 @@
 
 #include <QTreeWidgetItem>
 #include <QMessageBox>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QLineEdit>
 #include <QSpinBox>
@@ -35,6 +36,7 @@
 #define KMapColumnInputPort     2
 #define KMapColumnOutputAddress 3
 #define KMapColumnOutputPort    4
+#define KMapColumnBundle        5
 
 #define PROP_UNIVERSE (Qt::UserRole + 0)
 #define PROP_LINE (Qt::UserRole + 1)
@@ -143,6 +145,10 @@ void ConfigureOSC::fillMappingTree()
                 outSpin->setRange(1, 65535);
                 outSpin->setValue(info->feedbackPort);
                 m_uniMapTree->setItemWidget(item, KMapColumnOutputPort, outSpin);
+
+                QCheckBox *bundleCheck = new QCheckBox(this);
+                bundleCheck->setChecked(info->feedbackBundle);
+                m_uniMapTree->setItemWidget(item, KMapColumnBundle, bundleCheck);
             }
             if (info->type & OSCController::Output)
             {
@@ -173,6 +179,10 @@ void ConfigureOSC::fillMappingTree()
                 spin->setRange(1, 65535);
                 spin->setValue(info->outputPort);
                 m_uniMapTree->setItemWidget(item, KMapColumnOutputPort, spin);
+
+                QCheckBox *bundleCheck = new QCheckBox(this);
+                bundleCheck->setChecked(info->outputBundle);
+                m_uniMapTree->setItemWidget(item, KMapColumnBundle, bundleCheck);
             }
         }
     }
@@ -235,6 +245,15 @@ void ConfigureOSC::accept()
                 else
                     m_plugin->setParameter(universe, line, cap, OSC_OUTPUTPORT, outSpin->value());
             }
+
+            QCheckBox *bundleCheck = qobject_cast<QCheckBox*>(m_uniMapTree->itemWidget(item, KMapColumnBundle));
+            if (bundleCheck != NULL)
+            {
+                if (type == OSCController::Input)
+                    m_plugin->setParameter(universe, line, QLCIOPlugin::Output, OSC_FEEDBACKBUNDLE, bundleCheck->isChecked());
+                else
+                    m_plugin->setParameter(universe, line, cap, OSC_OUTPUTBUNDLE, bundleCheck->isChecked());
+            }
         }
     }
 
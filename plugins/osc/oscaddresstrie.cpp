@@ -0,0 +1,313 @@
+/*
+  Q Light Controller Plus
+  oscaddresstrie.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <algorithm>
+
+#include "oscaddresstrie.h"
+
+/** Split an OSC path in its segments, dropping the empty ones
+ *  produced by the leading slash and by repeated slashes */
+static QStringList pathSegments(const QString &path)
+{
+    QStringList segments = path.split('/');
+    segments.removeAll(QString());
+    return segments;
+}
+
+/*********************************************************************
+ * OSCAddressPattern
+ *********************************************************************/
+
+OSCAddressPattern::OSCAddressPattern()
+{
+}
+
+OSCAddressPattern::OSCAddressPattern(const QString &pattern)
+{
+    m_segments = pathSegments(pattern);
+    foreach (const QString &segment, m_segments)
+        m_literal.append(isPattern(segment) == false);
+}
+
+bool OSCAddressPattern::isPattern(const QString &path)
+{
+    for (int i = 0; i < path.length(); i++)
+    {
+        switch (path.at(i).unicode())
+        {
+            case '?':
+            case '*':
+            case '[':
+            case '{':
+                return true;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+int OSCAddressPattern::segmentCount() const
+{
+    return m_segments.count();
+}
+
+bool OSCAddressPattern::isLiteral(int index) const
+{
+    return m_literal.at(index);
+}
+
+const QString &OSCAddressPattern::segment(int index) const
+{
+    return m_segments.at(index);
+}
+
+bool OSCAddressPattern::matchSegment(int index, const QString &name) const
+{
+    const QString &segment = m_segments.at(index);
+
+    if (m_literal.at(index))
+        return segment == name;
+
+    return match(segment.constData(), segment.constData() + segment.length(),
+                 name.constData(), name.constData() + name.length());
+}
+
+bool OSCAddressPattern::match(const QChar *pattern, const QChar *pEnd,
+                              const QChar *str, const QChar *sEnd)
+{
+    /* A mismatch only moves back to the last '*' seen, letting it take one
+     * more character. Earlier stars never need to be retried, so matching
+     * takes linear time per star instead of exponential time */
+    const QChar *starPattern = NULL;
+    const QChar *starStr = NULL;
+
+    while (pattern < pEnd || str < sEnd)
+    {
+        if (pattern < pEnd)
+        {
+            switch (pattern->unicode())
+            {
+                case '*':
+                {
+                    while (pattern < pEnd && *pattern == '*')
+                        pattern++;
+                    starPattern = pattern;
+                    starStr = str;
+                    continue;
+                }
+                case '?':
+                {
+                    if (str < sEnd)
+                    {
+                        pattern++;
+                        str++;
+                        continue;
+                    }
+                }
+                break;
+                case '[':
+                {
+                    const QChar *close = std::find(pattern + 1, pEnd, QChar(']'));
+                    if (close == pEnd)
+                        return false;
+                    if (str == sEnd)
+                        break;
+
+                    const QChar *c = pattern + 1;
+                    bool negate = (c < close && *c == '!');
+                    bool found = false;
+                    if (negate)
+                        c++;
+
+                    while (c < close)
+                    {
+                        if (c + 2 < close && c[1] == '-')
+                        {
+                            if (*str >= c[0] && *str <= c[2])
+                                found = true;
+                            c += 3;
+                        }
+                        else
+                        {
+                            if (*str == *c)
+                                found = true;
+                            c++;
+                        }
+                    }
+
+                    if (found != negate)
+                    {
+                        pattern = close + 1;
+                        str++;
+                        continue;
+                    }
+                }
+                break;
+                case '{':
+                {
+                    const QChar *close = std::find(pattern + 1, pEnd, QChar('}'));
+                    if (close == pEnd)
+                        return false;
+
+                    // try each comma separated alternative
+                    const QChar *start = pattern + 1;
+                    for (const QChar *c = start; c <= close; c++)
+                    {
+                        if (c != close && *c != ',')
+                            continue;
+
+                        int len = int(c - start);
+                        if (sEnd - str >= len && std::equal(start, c, str) &&
+                            match(close + 1, pEnd, str + len, sEnd))
+                            return true;
+
+                        start = c + 1;
+                    }
+                }
+                break;
+                default:
+                {
+                    if (str < sEnd && *pattern == *str)
+                    {
+                        pattern++;
+                        str++;
+                        continue;
+                    }
+                }
+                break;
+            }
+        }
+
+        // mismatch: let the last '*' swallow one more character
+        if (starPattern == NULL || starStr == sEnd)
+            return false;
+
+        pattern = starPattern;
+        str = ++starStr;
+    }
+
+    return true;
+}
+
+/*********************************************************************
+ * OSCAddressTrie
+ *********************************************************************/
+
+OSCAddressTrie::OSCAddressTrie()
+    : m_count(0)
+{
+}
+
+OSCAddressTrie::~OSCAddressTrie()
+{
+}
+
+void OSCAddressTrie::insert(const QString &path)
+{
+    Node *node = &m_root;
+
+    foreach (const QString &segment, pathSegments(path))
+    {
+        Node *child = node->children.value(segment, NULL);
+        if (child == NULL)
+        {
+            child = new Node;
+            node->children.insert(segment, child);
+        }
+        node = child;
+    }
+
+    if (node->terminal == false)
+    {
+        node->terminal = true;
+        node->path = path;
+        m_count++;
+    }
+}
+
+bool OSCAddressTrie::contains(const QString &path) const
+{
+    const Node *node = &m_root;
+
+    foreach (const QString &segment, pathSegments(path))
+    {
+        node = node->children.value(segment, NULL);
+        if (node == NULL)
+            return false;
+    }
+
+    return node->terminal;
+}
+
+QStringList OSCAddressTrie::match(const QString &pattern)
+{
+    QHash<QString, OSCAddressPattern>::const_iterator it = m_patternCache.constFind(pattern);
+    if (it == m_patternCache.constEnd())
+    {
+        if (m_patternCache.count() >= OSC_PATTERN_CACHE_SIZE)
+            m_patternCache.clear();
+        it = m_patternCache.insert(pattern, OSCAddressPattern(pattern));
+    }
+
+    QStringList result;
+    match(&m_root, it.value(), 0, result);
+    return result;
+}
+
+void OSCAddressTrie::match(const Node *node, const OSCAddressPattern &pattern,
+                           int index, QStringList &result) const
+{
+    if (index == pattern.segmentCount())
+    {
+        if (node->terminal)
+            result.append(node->path);
+        return;
+    }
+
+    if (pattern.isLiteral(index))
+    {
+        const Node *child = node->children.value(pattern.segment(index), NULL);
+        if (child != NULL)
+            match(child, pattern, index + 1, result);
+        return;
+    }
+
+    QHash<QString, Node *>::const_iterator it = node->children.constBegin();
+    for (; it != node->children.constEnd(); ++it)
+    {
+        if (pattern.matchSegment(index, it.key()))
+            match(it.value(), pattern, index + 1, result);
+    }
+}
+
+int OSCAddressTrie::count() const
+{
+    return m_count;
+}
+
+void OSCAddressTrie::clear()
+{
+    qDeleteAll(m_root.children);
+    m_root.children.clear();
+    m_root.terminal = false;
+    m_root.path.clear();
+    m_count = 0;
+    m_patternCache.clear();
+}
@@ -0,0 +1,116 @@
+/*
+  Q Light Controller Plus
+  oscaddresstrie.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef OSCADDRESSTRIE_H
+#define OSCADDRESSTRIE_H
+
+#include <QStringList>
+#include <QString>
+#include <QHash>
+#include <QList>
+
+/** Maximum number of compiled patterns kept in cache */
+#define OSC_PATTERN_CACHE_SIZE  256
+
+/**
+ * An OSC address pattern, split in path segments once, so that it can be
+ * matched repeatedly against an address space. It supports the OSC 1.0
+ * syntax: '?', '*', '[abc]', '[a-z]', '[!abc]' and '{foo,bar}'.
+ */
+class OSCAddressPattern final
+{
+public:
+    OSCAddressPattern();
+    OSCAddressPattern(const QString &pattern);
+
+    /** Return true if $path contains OSC pattern characters */
+    static bool isPattern(const QString &path);
+
+    /** Number of path segments of this pattern */
+    int segmentCount() const;
+
+    /** Return true if the segment at $index has no pattern characters */
+    bool isLiteral(int index) const;
+
+    /** Return the segment at $index as it was written */
+    const QString &segment(int index) const;
+
+    /** Return true if $name matches the segment at $index */
+    bool matchSegment(int index, const QString &name) const;
+
+private:
+    static bool match(const QChar *pattern, const QChar *pEnd,
+                      const QChar *str, const QChar *sEnd);
+
+private:
+    QStringList m_segments;
+    QList<bool> m_literal;
+};
+
+/**
+ * OSCAddressTrie holds the known OSC address space, one node per path
+ * segment. Exact paths are found with one lookup per segment, while
+ * patterns only visit the branches that can match them.
+ */
+class OSCAddressTrie final
+{
+public:
+    OSCAddressTrie();
+    ~OSCAddressTrie();
+
+    /** Add $path to the address space */
+    void insert(const QString &path);
+
+    /** Return true if $path is part of the address space */
+    bool contains(const QString &path) const;
+
+    /** Return the paths of the address space matching $pattern.
+     *  Only the paths previously added with insert() can match: a pattern
+     *  never creates new paths, so an address not received yet is ignored */
+    QStringList match(const QString &pattern);
+
+    /** Number of paths in the address space */
+    int count() const;
+
+    /** Remove every path and compiled pattern */
+    void clear();
+
+private:
+    struct Node
+    {
+        Node() : terminal(false) {}
+        ~Node() { qDeleteAll(children); }
+
+        QHash<QString, Node *> children;
+        /** Full path, when a path ends at this node */
+        QString path;
+        bool terminal;
+    };
+
+    void match(const Node *node, const OSCAddressPattern &pattern,
+               int index, QStringList &result) const;
+
+private:
+    Node m_root;
+    int m_count;
+    /** Patterns already compiled */
+    QHash<QString, OSCAddressPattern> m_patternCache;
+};
+
+#endif
@@ -24,6 +24,9 @@
 #include "osccontroller.h"
 #include "utils.h"
 
+/** Size of the receive buffers: OSC datagrams can be as long as UDP allows */
+#define OSC_INPUT_DATAGRAM_SIZE (64 * 1024)
+
 OSCController::OSCController(QString ipaddr, Type type, quint32 line, QObject *parent)
     : QObject(parent)
     , m_ipAddr(ipaddr)
@@ -41,6 +44,15 @@ OSCController::OSCController(QString ipaddr, Type type, quint32 line, QObject *p
 OSCController::~OSCController()
 {
     qDebug() << Q_FUNC_INFO;
+
+    // stop the input receivers before deleting what they use
+    QMap<quint32, UniverseInfo> universeMap;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        universeMap.swap(m_universeMap);
+    }
+    universeMap.clear();
+
     qDeleteAll(m_dmxValuesMap);
 }
 
@@ -52,6 +64,10 @@ QHostAddress OSCController::getNetworkIP() const
 void OSCController::addUniverse(quint32 universe, OSCController::Type type)
 {
     qDebug() << "[OSC] addUniverse - universe" << universe << ", type" << type;
+    // a replaced socket must be released unlocked, since it stops its receiver
+    QSharedPointer<QUdpSocket> prevSocket;
+    QMutexLocker locker(&m_dataMutex);
+
     if (m_universeMap.contains(universe))
     {
         m_universeMap[universe].type |= (int)type;
@@ -72,7 +88,9 @@ void OSCController::addUniverse(quint32 universe, OSCController::Type type)
             info.outputAddress = QHostAddress::Null;
         }
         info.feedbackPort = 9000 + universe;
+        info.feedbackBundle = false;
         info.outputPort = 9000 + universe;
+        info.outputBundle = false;
         info.type = type;
         m_universeMap[universe] = info;
     }
@@ -80,7 +98,7 @@ void OSCController::addUniverse(quint32 universe, OSCController::Type type)
     if (type == Input)
     {
         UniverseInfo& info = m_universeMap[universe];
-        info.inputSocket.clear();
+        prevSocket.swap(info.inputSocket);
         info.inputSocket = getInputSocket(info.inputPort);
     }
 }
@@ -88,11 +106,14 @@ void OSCController::addUniverse(quint32 universe, OSCController::Type type)
 void OSCController::removeUniverse(quint32 universe, OSCController::Type type)
 {
     qDebug() << "[OSC] removeUniverse - universe" << universe << ", type" << type;
+    QSharedPointer<QUdpSocket> prevSocket;
+    QMutexLocker locker(&m_dataMutex);
+
     if (m_universeMap.contains(universe))
     {
         UniverseInfo& info = m_universeMap[universe];
         if (type == Input)
-            info.inputSocket.clear();
+            prevSocket.swap(info.inputSocket);
 
         if (info.type == type)
             m_universeMap.take(universe);
@@ -106,6 +127,7 @@ bool OSCController::setInputPort(quint32 universe, quint16 port)
     if (!m_universeMap.contains(universe))
         return false;
 
+    QSharedPointer<QUdpSocket> prevSocket;
     QMutexLocker locker(&m_dataMutex);
     UniverseInfo& info = m_universeMap[universe];
 
@@ -113,7 +135,7 @@ bool OSCController::setInputPort(quint32 universe, quint16 port)
         return port == 7700 + universe;
     info.inputPort = port;
 
-    info.inputSocket.clear();
+    prevSocket.swap(info.inputSocket);
     info.inputSocket = getInputSocket(port);
 
     return port == 7700 + universe;
@@ -127,10 +149,19 @@ QSharedPointer<QUdpSocket> OSCController::getInputSocket(quint16 port)
             return info.inputSocket;
     }
 
-    QSharedPointer<QUdpSocket> inputSocket(new QUdpSocket(this));
+    QSharedPointer<QUdpSocket> inputSocket(new QUdpSocket(this), UdpReceiver::deleteSocket);
     inputSocket->bind(QHostAddress::Any, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
-    connect(inputSocket.data(), SIGNAL(readyRead()),
-            this, SLOT(processPendingPackets()));
+
+    if (UdpReceiver::isSupported())
+    {
+        UdpReceiver *receiver = new UdpReceiver(inputSocket.data(), this, OSC_INPUT_DATAGRAM_SIZE);
+        receiver->start(QThread::HighPriority);
+    }
+    else
+    {
+        connect(inputSocket.data(), SIGNAL(readyRead()),
+                this, SLOT(processPendingPackets()));
+    }
     return inputSocket;
 }
 
@@ -184,6 +215,28 @@ bool OSCController::setOutputPort(quint32 universe, quint16 port)
     return port == 9000 + universe;
 }
 
+bool OSCController::setFeedbackBundle(quint32 universe, bool enable)
+{
+    if (m_universeMap.contains(universe) == false)
+        return false;
+
+    QMutexLocker locker(&m_dataMutex);
+    m_universeMap[universe].feedbackBundle = enable;
+
+    return enable == false;
+}
+
+bool OSCController::setOutputBundle(quint32 universe, bool enable)
+{
+    if (m_universeMap.contains(universe) == false)
+        return false;
+
+    QMutexLocker locker(&m_dataMutex);
+    m_universeMap[universe].outputBundle = enable;
+
+    return enable == false;
+}
+
 QList<quint32> OSCController::universesList() const
 {
     return m_universeMap.keys();
@@ -220,20 +273,20 @@ quint64 OSCController::getPacketSentNumber() const
 
 quint64 OSCController::getPacketReceivedNumber() const
 {
+    QMutexLocker locker(&m_dataMutex);
     return m_packetReceived;
 }
 
 quint16 OSCController::getHash(QString path)
 {
-    quint16 hash;
-    if (m_hashMap.contains(path))
-        hash = m_hashMap[path];
-    else
-    {
-        /** No existing hash found. Add a new key to the table */
-        hash = Utils::getChecksum(path.toUtf8());
-        m_hashMap[path] = hash;
-    }
+    QHash<QString, quint16>::const_iterator it = m_hashMap.constFind(path);
+    if (it != m_hashMap.constEnd())
+        return it.value();
+
+    /** No existing hash found. Add a new key to the table */
+    quint16 hash = Utils::getChecksum(path.toUtf8());
+    m_hashMap.insert(path, hash);
+    m_channelMap.insert(hash, path);
 
     return hash;
 }
@@ -244,59 +297,46 @@ void OSCController::sendDmx(const quint32 universe, const QByteArray &dmxData)
     QByteArray dmxPacket;
     QHostAddress outAddress = QHostAddress::Null;
     quint32 outPort = 7700 + universe;
+    bool bundle = false;
 
     if (m_universeMap.contains(universe))
     {
         outAddress = m_universeMap[universe].outputAddress;
         outPort = m_universeMap[universe].outputPort;
+        bundle = m_universeMap[universe].outputBundle;
     }
 
-    for (int i = 0; i < dmxData.length(); i++)
-    {
-        if (m_dmxValuesMap.contains(universe) == false)
-            m_dmxValuesMap[universe] = new QByteArray(512, 0);
+    if (m_dmxValuesMap.contains(universe) == false)
+        m_dmxValuesMap[universe] = new QByteArray(512, 0);
 
-        QByteArray *dmxValues = m_dmxValuesMap[universe];
+    QByteArray *dmxValues = m_dmxValuesMap[universe];
+    QList<QByteArray> messages;
 
+    for (int i = 0; i < dmxData.length() && i < dmxValues->length(); i++)
+    {
         if (dmxData[i] != dmxValues->at(i))
         {
             dmxValues->replace(i, 1, (const char *)(dmxData.data() + i), 1);
             m_packetizer->setupOSCDmx(dmxPacket, universe, i, dmxData[i]);
-            qint64 sent = m_outputSocket->writeDatagram(dmxPacket.data(), dmxPacket.size(),
-                                                     outAddress, outPort);
-            if (sent < 0)
-            {
-                qDebug() << "[OSC] sendDmx failed. Errno: " << m_outputSocket->error();
-                qDebug() << "Errmgs: " << m_outputSocket->errorString();
-            }
-            else
-                m_packetSent++;
+            messages.append(dmxPacket);
         }
     }
+
+    sendMessages(messages, outAddress, outPort, bundle);
 }
 
-void OSCController::sendFeedback(const quint32 universe, quint32 channel, uchar value, const QString &key)
+QString OSCController::feedbackMessage(const quint32 universe, quint32 channel, uchar value,
+                                       const QString &key, QByteArray &message)
 {
-    QMutexLocker locker(&m_dataMutex);
-    QHostAddress outAddress = QHostAddress::Null;
-    quint32 outPort = 9000 + universe;
-
-    if (m_universeMap.contains(universe))
-    {
-        outAddress = m_universeMap[universe].feedbackAddress;
-        outPort = m_universeMap[universe].feedbackPort;
-    }
-
     QString path = key;
     // on invalid key try to retrieve the OSC path from the hash table.
     // This works only if the OSC widget has been previously moved by the user
     if (key.isEmpty())
-        path = m_hashMap.key(channel);
+        path = m_channelMap.value(quint16(channel));
 
     qDebug() << "[OSC] sendFeedBack - Key:" << path << "value:" << value;
 
     QByteArray values;
-    QByteArray oscPacket;
 
     // multiple value path
     if (path.length() > 2 && path.at(path.length() - 2) == '_')
@@ -324,19 +364,125 @@ void OSCController::sendFeedback(const quint32 universe, quint32 channel, uchar
     QString pTypes;
     pTypes.fill('f', values.length());
 
-    m_packetizer->setupOSCGeneric(oscPacket, path, pTypes, values);
-    qint64 sent = m_outputSocket->writeDatagram(oscPacket.data(), oscPacket.size(),
-                                             outAddress, outPort);
-    if (sent < 0)
+    m_packetizer->setupOSCGeneric(message, path, pTypes, values);
+
+    return path;
+}
+
+void OSCController::sendFeedback(const quint32 universe, quint32 channel, uchar value, const QString &key)
+{
+    QMutexLocker locker(&m_dataMutex);
+    QHostAddress outAddress = QHostAddress::Null;
+    quint32 outPort = 9000 + universe;
+
+    if (m_universeMap.contains(universe))
     {
-        qDebug() << "[OSC] sendDmx failed. Errno: " << m_outputSocket->error();
-        qDebug() << "Errmgs: " << m_outputSocket->errorString();
+        outAddress = m_universeMap[universe].feedbackAddress;
+        outPort = m_universeMap[universe].feedbackPort;
     }
-    else
-        m_packetSent++;
+
+    QByteArray oscPacket;
+    if (feedbackMessage(universe, channel, value, key, oscPacket).isEmpty())
+        return;
+
+    sendMessages(QList<QByteArray>() << oscPacket, outAddress, outPort, false);
+}
+
+void OSCController::sendFeedbackBatch(const quint32 universe, const QList<QLCFeedbackValue> &values)
+{
+    QMutexLocker locker(&m_dataMutex);
+    QHostAddress outAddress = QHostAddress::Null;
+    quint32 outPort = 9000 + universe;
+    bool bundle = false;
+
+    if (m_universeMap.contains(universe))
+    {
+        outAddress = m_universeMap[universe].feedbackAddress;
+        outPort = m_universeMap[universe].feedbackPort;
+        bundle = m_universeMap[universe].feedbackBundle;
+    }
+
+    QList<QByteArray> messages;
+    // index of the message of each path, so that the values of a
+    // multi-value path are sent in a single message
+    QHash<QString, int> pathIndex;
+
+    foreach (const QLCFeedbackValue &fb, values)
+    {
+        QByteArray oscPacket;
+        QString path = feedbackMessage(universe, fb.channel, fb.value, fb.params.toString(), oscPacket);
+        if (path.isEmpty())
+            continue;
+
+        QHash<QString, int>::const_iterator it = pathIndex.constFind(path);
+        if (it != pathIndex.constEnd())
+        {
+            messages[it.value()] = oscPacket;
+        }
+        else
+        {
+            pathIndex.insert(path, messages.count());
+            messages.append(oscPacket);
+        }
+    }
+
+    sendMessages(messages, outAddress, outPort, bundle);
 }
 
-void OSCController::handlePacket(QUdpSocket* socket, QByteArray const& datagram, QHostAddress const& senderAddress)
+void OSCController::sendMessages(const QList<QByteArray> &messages, const QHostAddress &address,
+                                 quint16 port, bool bundle)
+{
+    if (bundle == false)
+    {
+        foreach (const QByteArray &message, messages)
+        {
+            qint64 sent = m_outputSocket->writeDatagram(message.data(), message.size(), address, port);
+            if (sent < 0)
+            {
+                qDebug() << "[OSC] send failed. Errno: " << m_outputSocket->error();
+                qDebug() << "Errmgs: " << m_outputSocket->errorString();
+            }
+            else
+                m_packetSent++;
+        }
+        return;
+    }
+
+    QByteArray packet;
+    int count = 0;
+
+    for (int i = 0; i <= messages.count(); i++)
+    {
+        bool last = (i == messages.count());
+
+        // send the current bundle when it's full or when there's nothing left to add
+        if (count > 0 && (last || packet.size() + 4 + messages.at(i).size() > OSC_MAX_DATAGRAM_SIZE))
+        {
+            const QByteArray &data = (count == 1) ? messages.at(i - 1) : packet;
+            qint64 sent = m_outputSocket->writeDatagram(data.data(), data.size(), address, port);
+            if (sent < 0)
+            {
+                qDebug() << "[OSC] send failed. Errno: " << m_outputSocket->error();
+                qDebug() << "Errmgs: " << m_outputSocket->errorString();
+            }
+            else
+                m_packetSent++;
+
+            count = 0;
+        }
+
+        if (last)
+            break;
+
+        if (count == 0)
+            m_packetizer->setupOSCBundle(packet);
+        m_packetizer->appendToBundle(packet, messages.at(i));
+        count++;
+    }
+}
+
+bool OSCController::handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                                   QHostAddress const& senderAddress)
 {
 #if _DEBUG_RECEIVED_PACKETS
     qDebug() << "Received packet with size: " << datagram.size() << ", host: " << senderAddress.toString();
@@ -346,39 +492,84 @@ void OSCController::handlePacket(QUdpSocket* socket, QByteArray const& datagram,
 
     QList< QPair<QString, QByteArray> > messages = m_packetizer->parsePacket(datagram);
 
+    // a packet, usually a bundle, is handled as a unit: when a path
+    // appears more than once, only its latest values are emitted
+    QStringList paths;
+    QHash<QString, QByteArray> lastValues;
+
     QListIterator <QPair<QString,QByteArray> > it(messages);
     while (it.hasNext() == true)
     {
         QPair <QString,QByteArray> msg(it.next());
 
-        QString path = msg.first;
-        QByteArray values = msg.second;
-
-        qDebug() << "[OSC] message has path:" << path << "values:" << values.length();
-        if (values.isEmpty())
+#if _DEBUG_RECEIVED_PACKETS
+        qDebug() << "[OSC] message has path:" << msg.first << "values:" << msg.second.length();
+#endif
+        if (msg.second.isEmpty())
             continue;
 
-        for (QMap<quint32, UniverseInfo>::iterator it = m_universeMap.begin(); it != m_universeMap.end(); ++it)
+        if (lastValues.contains(msg.first) == false)
+            paths.append(msg.first);
+        lastValues[msg.first] = msg.second;
+    }
+
+    // this is usually called by the receiver thread of the socket
+    QList<InputValue> inputValues;
+    QMutexLocker locker(&m_dataMutex);
+
+    foreach (const QString &path, paths)
+    {
+        QByteArray values = lastValues.value(path);
+        QStringList targets;
+
+        // an address pattern addresses every known path it matches
+        if (OSCAddressPattern::isPattern(path))
         {
-            quint32 universe = it.key();
-            UniverseInfo& info = it.value();
-            if (info.inputSocket == socket)
-            {
-                if (values.length() > 1)
-                {
-                    info.multipartCache[path] = values;
-                    for (int i = 0; i < values.length(); i++)
-                    {
-                        QString modPath = QString("%1_%2").arg(path).arg(i);
-                        emit valueChanged(universe, m_line, getHash(modPath), (uchar)values.at(i), modPath);
-                    }
-                }
-                else
-                    emit valueChanged(universe, m_line, getHash(path), (uchar)values.at(0), path);
-            }
+            targets = m_addressSpace.match(path);
+        }
+        else
+        {
+            m_addressSpace.insert(path);
+            targets.append(path);
+        }
+
+        for (QMap<quint32, UniverseInfo>::iterator uIt = m_universeMap.begin(); uIt != m_universeMap.end(); ++uIt)
+        {
+            if (uIt.value().inputSocket != socket)
+                continue;
+
+            foreach (const QString &target, targets)
+                collectValues(uIt.key(), uIt.value(), target, values, inputValues);
         }
     }
     m_packetReceived++;
+    locker.unlock();
+
+    // a receiver might send feedback, which needs m_dataMutex
+    foreach (const InputValue &input, inputValues)
+        emit valueChanged(input.universe, m_line, input.channel, input.value, input.path);
+
+    return true;
+}
+
+void OSCController::collectValues(quint32 universe, UniverseInfo &info, const QString &path,
+                                  const QByteArray &values, QList<InputValue> &inputValues)
+{
+    if (values.length() > 1)
+    {
+        info.multipartCache[path] = values;
+        for (int i = 0; i < values.length(); i++)
+        {
+            QString modPath = QString("%1_%2").arg(path).arg(i);
+            InputValue input = { universe, getHash(modPath), uchar(values.at(i)), modPath };
+            inputValues.append(input);
+        }
+    }
+    else
+    {
+        InputValue input = { universe, getHash(path), uchar(values.at(0)), path };
+        inputValues.append(input);
+    }
 }
 
 void OSCController::processPendingPackets()
@@ -390,6 +581,6 @@ void OSCController::processPendingPackets()
     {
         datagram.resize(socket->pendingDatagramSize());
         socket->readDatagram(datagram.data(), datagram.size(), &senderAddress);
-        handlePacket(socket, datagram, senderAddress);
+        handleDatagram(socket, datagram, senderAddress);
     }
 }
@@ -34,7 +34,10 @@
 #include <QHash>
 #include <QMap>
 
+#include "oscaddresstrie.h"
 #include "oscpacketizer.h"
+#include "qlcioplugin.h"
+#include "udpreceiver.h"
 
 typedef struct _uinfo
 {
@@ -44,17 +47,22 @@ typedef struct _uinfo
 
     QHostAddress feedbackAddress;
     quint16 feedbackPort;
+    // when true, batched feedback messages are grouped in OSC bundles
+    bool feedbackBundle;
 
     QHostAddress outputAddress;
     quint16 outputPort;
 
+    // when true, the DMX messages of a frame are grouped in OSC bundles
+    bool outputBundle;
+
     // cache of the OSC paths with multiple values, used to correctly
     // handle the flow of input and feedback values
     QHash<QString, QByteArray> multipartCache;
     int type;
 } UniverseInfo;
 
-class OSCController final : public QObject
+class OSCController final : public QObject, public UdpReceiverHandler
 {
     Q_OBJECT
 
@@ -101,6 +109,16 @@ public:
      *  Return true if this restores default output port */
     bool setOutputPort(quint32 universe, quint16 port);
 
+    /** Enable or disable the grouping of batched feedback messages
+     *  in OSC bundles for the given universe.
+     *  Return true if this restores the default (disabled) */
+    bool setFeedbackBundle(quint32 universe, bool enable);
+
+    /** Enable or disable the grouping of the DMX messages of a frame
+     *  in OSC bundles for the given universe.
+     *  Return true if this restores the default (disabled) */
+    bool setOutputBundle(quint32 universe, bool enable);
+
     /** Return the list of the universes handled by
      *  this controller */
     QList<quint32> universesList() const;
@@ -126,16 +144,48 @@ public:
     /** Send a feedback using the specified path and value */
     void sendFeedback(const quint32 universe, quint32 channel, uchar value, const QString &key);
 
+    /** Send a batch of feedback values, in as few OSC bundles as possible
+     *  when feedback bundling is enabled for the universe */
+    void sendFeedbackBatch(const quint32 universe, const QList<QLCFeedbackValue> &values);
+
 private:
     QSharedPointer<QUdpSocket> getInputSocket(quint16 port);
 
+    /** Build the OSC message of a feedback value. Returns the message path,
+     *  which is empty if the channel is unknown. Must be called with m_dataMutex held */
+    QString feedbackMessage(const quint32 universe, quint32 channel, uchar value,
+                            const QString &key, QByteArray &message);
+
+    /** Send $messages to $address:$port. When $bundle is true, they are grouped
+     *  in bundles that fit in a datagram, and a bundle of a single message is sent
+     *  as the message alone. Otherwise every message is sent in its own datagram */
+    void sendMessages(const QList<QByteArray> &messages, const QHostAddress &address,
+                      quint16 port, bool bundle);
+
 protected:
     /** Calculate a 16bit unsigned hash as a unique representation
      *  of a OSC path. If new, the hash is added to the hash map (m_hashMap) */
     quint16 getHash(QString path);
 
+public:
+    /** @reimp */
+    bool handleDatagram(QUdpSocket *socket, QByteArray const& datagram,
+                        QHostAddress const& senderAddress) override;
+
 private:
-    void handlePacket(QUdpSocket* socket, QByteArray const& datagram, QHostAddress const& senderAddress);
+    /** A received channel value, emitted once m_dataMutex is released */
+    typedef struct
+    {
+        quint32 universe;
+        quint16 channel;
+        uchar value;
+        QString path;
+    } InputValue;
+
+    /** Add to $inputValues the values received for $path on $universe.
+     *  Must be called with m_dataMutex held */
+    void collectValues(quint32 universe, UniverseInfo &info, const QString &path,
+                       const QByteArray &values, QList<InputValue> &inputValues);
 
 private slots:
     /** Async event raised when new packets have been received */
@@ -170,7 +220,7 @@ private:
 
     /** Mutex to handle the change of output IP address or in general
      *  variables that could be used to transmit/receive data */
-    QMutex m_dataMutex;
+    mutable QMutex m_dataMutex;
 
     /** This is fundamental for the OSC controller. Every time a OSC signal is received,
       * the controller will calculate a 16 bit checksum of the OSC path and add it to
@@ -178,6 +228,14 @@ private:
       * to quickly retrieve a unique channel number
       */
     QHash<QString, quint16> m_hashMap;
+
+    /** Reverse of m_hashMap, to retrieve an OSC path from a channel */
+    QHash<quint16, QString> m_channelMap;
+
+    /** The OSC paths received so far, used to resolve incoming address patterns.
+     *  A pattern only addresses the paths in here, so it has no effect on
+     *  the widgets whose path has never been received as a plain address */
+    OSCAddressTrie m_addressSpace;
 };
 
 #endif
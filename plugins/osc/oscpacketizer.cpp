@@ -92,6 +92,25 @@ void OSCPacketizer::setupOSCGeneric(QByteArray &data, QString &path, QString typ
     }
 }
 
+void OSCPacketizer::setupOSCBundle(QByteArray &data)
+{
+    data.clear();
+    data.append("#bundle", 8);
+    // time tag 1 means "immediately"
+    data.append(QByteArray(7, 0x00));
+    data.append((char)0x01);
+}
+
+void OSCPacketizer::appendToBundle(QByteArray &data, const QByteArray &message)
+{
+    quint32 size = message.size();
+    data.append((char)(size >> 24));
+    data.append((char)(size >> 16));
+    data.append((char)(size >> 8));
+    data.append((char)(size & 0xFF));
+    data.append(message);
+}
+
 /*********************************************************************
  * Receiver functions
  *********************************************************************/
@@ -116,7 +135,7 @@ bool OSCPacketizer::parseMessage(QByteArray const& data, QString& path, QByteArr
     //qDebug() << "[OSC] path extracted:" << path;
 
     int currPos = commaPos + 1;
-    while (tagsEnded == false)
+    while (tagsEnded == false && currPos < data.size())
     {
         switch (data.at(currPos))
         {
@@ -225,56 +244,54 @@ bool OSCPacketizer::parseMessage(QByteArray const& data, QString& path, QByteArr
     return true;
 }
 
-QList<QPair<QString, QByteArray> > OSCPacketizer::parsePacket(QByteArray const& data)
+void OSCPacketizer::parseElement(QByteArray const& data, QList<QPair<QString, QByteArray> >& messages, int depth)
 {
-    int bufPos = 0;
-    QList<QPair<QString, QByteArray> > messages;
+    if (data.isEmpty())
+        return;
 
-    while (bufPos < data.size())
+    // check wether we need to parse a bundle or a single message
+    if (data.at(0) != '#')
     {
         QString path;
         QByteArray values;
 
-        // check wether we need to parse a bundle or a single message
-        if (data.at(bufPos) == '#')
-        {
-            if (data.size() < 20 || data.startsWith("#bundle") == false)
-            {
-                qWarning() << "[OSC] Found an unsupported message type!" << data;
-                return messages;
-            }
-            // 8 bytes for '#bundle\0' and 8 bytes for a timestamp that we don't handle
-            bufPos += 16;
+        if (parseMessage(data, path, values) == true)
+            messages.append(QPair<QString, QByteArray>(path, values));
+        return;
+    }
 
-            // now, a bundle can contain another bundle or a message, starting with the message size
-            // Check where we are here
-            while (bufPos < data.size() && data.at(bufPos) != '#')
-            {
-                quint32 msgSize = (uchar(data.at(bufPos)) << 24) + (uchar(data.at(bufPos + 1)) << 16) + (uchar(data.at(bufPos + 2)) << 8) + uchar(data.at(bufPos + 3));
-                qDebug() << "[OSC] Bundle message size:" << msgSize;
-                bufPos += 4;
-
-                if (data.size() >= bufPos + (int)msgSize)
-                {
-                    QByteArray msgData = data.mid(bufPos, msgSize);
-                    if (parseMessage(msgData, path, values) == true)
-                        messages.append(QPair<QString, QByteArray>(path, values));
-                }
-                bufPos += msgSize;
-            }
-            //qDebug() << "Buf pos=" << bufPos << "data size=" << data.size();
-        }
-        else
-        {
-            if (parseMessage(data, path, values) == true)
-                messages.append(QPair<QString, QByteArray>(path, values));
+    if (data.size() < 16 || data.startsWith("#bundle") == false || depth >= OSC_MAX_BUNDLE_DEPTH)
+    {
+        qWarning() << "[OSC] Found an unsupported message type!" << data;
+        return;
+    }
 
-            bufPos += data.size();
+    // 8 bytes for '#bundle\0' and 8 bytes for a timestamp that we don't handle
+    int bufPos = 16;
+
+    // each element starts with its size and can be a message or another bundle
+    while (bufPos + 4 <= data.size())
+    {
+        quint32 msgSize = (uchar(data.at(bufPos)) << 24) + (uchar(data.at(bufPos + 1)) << 16) +
+                          (uchar(data.at(bufPos + 2)) << 8) + uchar(data.at(bufPos + 3));
+        bufPos += 4;
+
+        if (msgSize == 0 || msgSize > quint32(data.size() - bufPos))
+        {
+            qWarning() << "[OSC] Malformed bundle element of size" << msgSize;
+            return;
         }
-    }
 
-    return messages;
+        parseElement(data.mid(bufPos, msgSize), messages, depth + 1);
+        bufPos += msgSize;
+    }
 }
 
+QList<QPair<QString, QByteArray> > OSCPacketizer::parsePacket(QByteArray const& data)
+{
+    QList<QPair<QString, QByteArray> > messages;
 
+    parseElement(data, messages, 0);
 
+    return messages;
+}
@@ -26,6 +26,11 @@
 #ifndef OSCPACKETIZER_H
 #define OSCPACKETIZER_H
 
+/** Maximum size of a datagram carrying an OSC bundle, to avoid IP fragmentation */
+#define OSC_MAX_DATAGRAM_SIZE   1400
+/** Maximum nesting level of the received OSC bundles */
+#define OSC_MAX_BUNDLE_DEPTH    8
+
 class OSCPacketizer final
 {
     /*********************************************************************
@@ -76,6 +81,22 @@ public:
      */
     void setupOSCGeneric(QByteArray& data, QString &path, QString types, QByteArray &values);
 
+    /**
+     * Prepare an empty OSC bundle with an "immediately" time tag.
+     * Messages are then added with appendToBundle
+     *
+     * @param data the bundle composed by this function
+     */
+    void setupOSCBundle(QByteArray& data);
+
+    /**
+     * Append an OSC message (or a nested bundle) to a bundle
+     *
+     * @param data a bundle prepared with setupOSCBundle
+     * @param message the OSC message to append
+     */
+    void appendToBundle(QByteArray& data, const QByteArray& message);
+
     /*********************************************************************
      * Receiver functions
      *********************************************************************/
@@ -91,9 +112,17 @@ private:
      * @return true on successful parsing, otherwise false
      */
     bool parseMessage(QByteArray const& data, QString& path, QByteArray& values);
+
+    /**
+     * Parse an OSC bundle element, that can be either a message or
+     * a nested bundle, appending the messages found to $messages
+     */
+    void parseElement(QByteArray const& data, QList<QPair<QString, QByteArray> >& messages, int depth);
+
 public:
     /**
      * Parse a OSC packet received from the network.
+     * Messages of a bundle, including nested ones, are returned in order.
      *
      * @param data the payload of a UDP packet received from the network
      * @return a list of couples of OSC path/values
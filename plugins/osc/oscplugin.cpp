@@ -238,7 +238,7 @@ bool OSCPlugin::openInput(quint32 input, quint32 universe)
         OSCController *controller = new OSCController(m_IOmapping.at(input).IPAddress,
                                                         OSCController::Input, input, this);
         connect(controller, SIGNAL(valueChanged(quint32,quint32,quint32,uchar,QString)),
-                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar,QString)));
+                this, SIGNAL(valueChanged(quint32,quint32,quint32,uchar,QString)), Qt::DirectConnection);
         m_IOmapping[input].controller = controller;
     }
 
@@ -303,6 +303,16 @@ void OSCPlugin::sendFeedBack(quint32 universe, quint32 input,
         controller->sendFeedback(universe, channel, value, params.toString());
 }
 
+void OSCPlugin::sendFeedBackBatch(quint32 universe, quint32 input, const QList<QLCFeedbackValue> &values)
+{
+    if (input >= (quint32)m_IOmapping.count())
+        return;
+
+    OSCController *controller = m_IOmapping[input].controller;
+    if (controller != NULL)
+        controller->sendFeedbackBatch(universe, values);
+}
+
 /*********************************************************************
  * Configuration
  *********************************************************************/
@@ -341,6 +351,10 @@ void OSCPlugin::setParameter(quint32 universe, quint32 line, Capability type,
         unset = controller->setOutputIPAddress(universe, value.toString());
     else if (name == OSC_OUTPUTPORT)
         unset = controller->setOutputPort(universe, value.toUInt());
+    else if (name == OSC_FEEDBACKBUNDLE)
+        unset = controller->setFeedbackBundle(universe, value.toBool());
+    else if (name == OSC_OUTPUTBUNDLE)
+        unset = controller->setOutputBundle(universe, value.toBool());
     else
     {
         qWarning() << Q_FUNC_INFO << name << "is not a valid OSC parameter";
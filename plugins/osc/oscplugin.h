@@ -41,6 +41,8 @@ typedef struct _oio
 #define OSC_FEEDBACKPORT "feedbackPort"
 #define OSC_OUTPUTIP "outputIP"
 #define OSC_OUTPUTPORT "outputPort"
+#define OSC_FEEDBACKBUNDLE "feedbackBundle"
+#define OSC_OUTPUTBUNDLE "outputBundle"
 
 #define SETTINGS_IFACE_WAIT_TIME "OSCPlugin/ifacewait"
 
@@ -110,6 +112,9 @@ public:
     /** @reimp */
     void sendFeedBack(quint32 universe, quint32 input, quint32 channel, uchar value, const QVariant &params) override;
 
+    /** @reimp */
+    void sendFeedBackBatch(quint32 universe, quint32 input, const QList<QLCFeedbackValue> &values) override;
+
     /*********************************************************************
      * Configuration
      *********************************************************************/
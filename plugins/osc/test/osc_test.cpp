@@ -0,0 +1,425 @@
+/*
+  Q Light Controller Plus
+  osc_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QUdpSocket>
+#include <QTest>
+
+#define private public
+#include "osc_test.h"
+#include "oscaddresstrie.h"
+#include "osccontroller.h"
+#include "oscpacketizer.h"
+#undef private
+
+/****************************************************************************
+ * Address pattern tests
+ ****************************************************************************/
+
+void OSC_Test::patternSegments()
+{
+    OSCAddressPattern pattern("/1/fader*");
+    QCOMPARE(pattern.segmentCount(), 2);
+    QCOMPARE(pattern.segment(0), QString("1"));
+    QCOMPARE(pattern.segment(1), QString("fader*"));
+    QVERIFY(pattern.isLiteral(0) == true);
+    QVERIFY(pattern.isLiteral(1) == false);
+
+    // empty segments are dropped
+    OSCAddressPattern slashes("//1///fader1/");
+    QCOMPARE(slashes.segmentCount(), 2);
+    QCOMPARE(slashes.segment(0), QString("1"));
+    QCOMPARE(slashes.segment(1), QString("fader1"));
+
+    QCOMPARE(OSCAddressPattern().segmentCount(), 0);
+    QCOMPARE(OSCAddressPattern("/").segmentCount(), 0);
+}
+
+void OSC_Test::patternIsPattern()
+{
+    QVERIFY(OSCAddressPattern::isPattern("/1/fader1") == false);
+    QVERIFY(OSCAddressPattern::isPattern("") == false);
+    QVERIFY(OSCAddressPattern::isPattern("/1/fader?") == true);
+    QVERIFY(OSCAddressPattern::isPattern("/*/fader1") == true);
+    QVERIFY(OSCAddressPattern::isPattern("/1/fader[1-4]") == true);
+    QVERIFY(OSCAddressPattern::isPattern("/1/{fader,knob}1") == true);
+}
+
+void OSC_Test::patternWildcards()
+{
+    OSCAddressPattern pattern("/fader?/*/a*b*c");
+
+    QVERIFY(pattern.matchSegment(0, "fader1") == true);
+    QVERIFY(pattern.matchSegment(0, "faderX") == true);
+    QVERIFY(pattern.matchSegment(0, "fader") == false);
+    QVERIFY(pattern.matchSegment(0, "fader10") == false);
+
+    QVERIFY(pattern.matchSegment(1, "") == true);
+    QVERIFY(pattern.matchSegment(1, "anything") == true);
+
+    QVERIFY(pattern.matchSegment(2, "abc") == true);
+    QVERIFY(pattern.matchSegment(2, "a12b34c") == true);
+    QVERIFY(pattern.matchSegment(2, "abcbc") == true);
+    QVERIFY(pattern.matchSegment(2, "acb") == false);
+    QVERIFY(pattern.matchSegment(2, "abcd") == false);
+}
+
+void OSC_Test::patternManyStars()
+{
+    // backtracking on every star would take ages here
+    QString stars = QString("a*").repeated(40) + "b";
+    QString as = QString(200, QChar('a'));
+    OSCAddressPattern pattern("/" + stars + "/*?*?*?*x*");
+
+    QVERIFY(pattern.matchSegment(0, as) == false);
+    QVERIFY(pattern.matchSegment(0, as + "b") == true);
+    QVERIFY(pattern.matchSegment(0, QString(39, QChar('a')) + "b") == false);
+
+    QVERIFY(pattern.matchSegment(1, as) == false);
+    QVERIFY(pattern.matchSegment(1, "abcx") == true);
+    QVERIFY(pattern.matchSegment(1, "abx") == false);
+}
+
+void OSC_Test::patternCharacterClass()
+{
+    OSCAddressPattern pattern("/fader[1-3]/[!0-9]/[abc]x/[1-3");
+
+    QVERIFY(pattern.matchSegment(0, "fader1") == true);
+    QVERIFY(pattern.matchSegment(0, "fader3") == true);
+    QVERIFY(pattern.matchSegment(0, "fader4") == false);
+    QVERIFY(pattern.matchSegment(0, "fader") == false);
+
+    QVERIFY(pattern.matchSegment(1, "a") == true);
+    QVERIFY(pattern.matchSegment(1, "5") == false);
+    QVERIFY(pattern.matchSegment(1, "") == false);
+
+    QVERIFY(pattern.matchSegment(2, "bx") == true);
+    QVERIFY(pattern.matchSegment(2, "dx") == false);
+
+    // an unterminated class never matches
+    QVERIFY(pattern.matchSegment(3, "1") == false);
+}
+
+void OSC_Test::patternAlternatives()
+{
+    OSCAddressPattern pattern("/{fader,knob}1/{,x}y/{a,b");
+
+    QVERIFY(pattern.matchSegment(0, "fader1") == true);
+    QVERIFY(pattern.matchSegment(0, "knob1") == true);
+    QVERIFY(pattern.matchSegment(0, "button1") == false);
+    QVERIFY(pattern.matchSegment(0, "fader") == false);
+
+    // an empty alternative is allowed
+    QVERIFY(pattern.matchSegment(1, "y") == true);
+    QVERIFY(pattern.matchSegment(1, "xy") == true);
+    QVERIFY(pattern.matchSegment(1, "zy") == false);
+
+    // an unterminated list never matches
+    QVERIFY(pattern.matchSegment(2, "a") == false);
+}
+
+/****************************************************************************
+ * Address trie tests
+ ****************************************************************************/
+
+void OSC_Test::trieInsert()
+{
+    OSCAddressTrie trie;
+    QCOMPARE(trie.count(), 0);
+    QVERIFY(trie.contains("/1/fader1") == false);
+
+    trie.insert("/1/fader1");
+    trie.insert("/1/fader2");
+    trie.insert("/1/fader1");
+    QCOMPARE(trie.count(), 2);
+
+    QVERIFY(trie.contains("/1/fader1") == true);
+    QVERIFY(trie.contains("/1/fader2") == true);
+    // intermediate nodes are not paths
+    QVERIFY(trie.contains("/1") == false);
+    QVERIFY(trie.contains("/1/fader3") == false);
+
+    // a path can be the prefix of another one
+    trie.insert("/1");
+    QCOMPARE(trie.count(), 3);
+    QVERIFY(trie.contains("/1") == true);
+}
+
+void OSC_Test::trieMatch()
+{
+    OSCAddressTrie trie;
+    trie.insert("/1/fader1");
+    trie.insert("/1/fader2");
+    trie.insert("/1/fader10");
+    trie.insert("/1/knob1");
+    trie.insert("/2/fader1");
+
+    QStringList result = trie.match("/1/fader?");
+    result.sort();
+    QCOMPARE(result, QStringList() << "/1/fader1" << "/1/fader2");
+
+    result = trie.match("/*/fader1");
+    result.sort();
+    QCOMPARE(result, QStringList() << "/1/fader1" << "/2/fader1");
+
+    result = trie.match("/1/{fader,knob}1");
+    result.sort();
+    QCOMPARE(result, QStringList() << "/1/fader1" << "/1/knob1");
+
+    QCOMPARE(trie.match("/1/*").count(), 4);
+    QCOMPARE(trie.match("/1/fader[!1]"), QStringList() << "/1/fader2");
+
+    // the pattern depth must match the path depth
+    QVERIFY(trie.match("/*").isEmpty());
+
+    // compiled patterns are cached
+    QVERIFY(trie.m_patternCache.contains("/1/fader?"));
+    QCOMPARE(trie.m_patternCache.count(), 6);
+}
+
+void OSC_Test::trieMatchUnknown()
+{
+    OSCAddressTrie trie;
+
+    // patterns only address paths already in the address space
+    QVERIFY(trie.match("/1/fader?").isEmpty());
+
+    trie.insert("/1/fader1");
+    QCOMPARE(trie.match("/1/fader?"), QStringList() << "/1/fader1");
+    QCOMPARE(trie.count(), 1);
+}
+
+void OSC_Test::trieClear()
+{
+    OSCAddressTrie trie;
+    trie.insert("/1/fader1");
+    trie.insert("/1/fader2");
+    trie.match("/1/*");
+
+    trie.clear();
+    QCOMPARE(trie.count(), 0);
+    QVERIFY(trie.contains("/1/fader1") == false);
+    QVERIFY(trie.match("/1/*").isEmpty());
+    QVERIFY(trie.m_root.children.isEmpty());
+
+    trie.insert("/1/fader1");
+    QCOMPARE(trie.count(), 1);
+}
+
+/****************************************************************************
+ * Bundle tests
+ ****************************************************************************/
+
+void OSC_Test::bundleEmit()
+{
+    OSCPacketizer packetizer;
+    QByteArray bundle;
+    QByteArray message;
+
+    packetizer.setupOSCBundle(bundle);
+    QCOMPARE(bundle.size(), 16);
+    QCOMPARE(bundle.left(8), QByteArray("#bundle", 8));
+    // "immediately" time tag
+    QCOMPARE(bundle.mid(8), QByteArray(7, 0x00) + QByteArray(1, 0x01));
+
+    packetizer.setupOSCDmx(message, 1, 5, 255);
+    QCOMPARE(message.size(), 20);
+    packetizer.appendToBundle(bundle, message);
+    QCOMPARE(bundle.size(), 16 + 4 + 20);
+    QCOMPARE(bundle.mid(16, 4), QByteArray::fromHex("00000014"));
+    QCOMPARE(bundle.mid(20), message);
+
+    // a bundle setup discards the previous content
+    packetizer.setupOSCBundle(bundle);
+    QCOMPARE(bundle.size(), 16);
+}
+
+void OSC_Test::bundleParse()
+{
+    OSCPacketizer packetizer;
+    QByteArray bundle;
+    QByteArray message;
+
+    packetizer.setupOSCBundle(bundle);
+    packetizer.setupOSCDmx(message, 1, 5, 255);
+    packetizer.appendToBundle(bundle, message);
+    packetizer.setupOSCDmx(message, 1, 6, 0);
+    packetizer.appendToBundle(bundle, message);
+
+    QList<QPair<QString, QByteArray> > messages = packetizer.parsePacket(bundle);
+    QCOMPARE(messages.count(), 2);
+    QCOMPARE(messages.at(0).first, QString("/1/dmx/5"));
+    QCOMPARE(messages.at(0).second.count(), 1);
+    QCOMPARE(uchar(messages.at(0).second.at(0)), uchar(255));
+    QCOMPARE(messages.at(1).first, QString("/1/dmx/6"));
+    QCOMPARE(uchar(messages.at(1).second.at(0)), uchar(0));
+
+    // a plain message is a packet too
+    messages = packetizer.parsePacket(message);
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.at(0).first, QString("/1/dmx/6"));
+
+    // an empty bundle has no messages
+    packetizer.setupOSCBundle(bundle);
+    QVERIFY(packetizer.parsePacket(bundle).isEmpty());
+    QVERIFY(packetizer.parsePacket(QByteArray()).isEmpty());
+}
+
+void OSC_Test::bundleNested()
+{
+    OSCPacketizer packetizer;
+    QByteArray message;
+    QByteArray inner;
+    QByteArray outer;
+
+    packetizer.setupOSCDmx(message, 0, 1, 255);
+    packetizer.setupOSCBundle(inner);
+    packetizer.appendToBundle(inner, message);
+
+    packetizer.setupOSCDmx(message, 0, 2, 255);
+    packetizer.setupOSCBundle(outer);
+    packetizer.appendToBundle(outer, inner);
+    packetizer.appendToBundle(outer, message);
+
+    // messages are returned in order, nested ones included
+    QList<QPair<QString, QByteArray> > messages = packetizer.parsePacket(outer);
+    QCOMPARE(messages.count(), 2);
+    QCOMPARE(messages.at(0).first, QString("/0/dmx/1"));
+    QCOMPARE(messages.at(1).first, QString("/0/dmx/2"));
+
+    // nesting is limited to OSC_MAX_BUNDLE_DEPTH levels
+    QByteArray packet = message;
+    for (int i = 0; i < OSC_MAX_BUNDLE_DEPTH; i++)
+    {
+        QByteArray bundle;
+        packetizer.setupOSCBundle(bundle);
+        packetizer.appendToBundle(bundle, packet);
+        packet = bundle;
+    }
+    QCOMPARE(packetizer.parsePacket(packet).count(), 1);
+
+    QByteArray bundle;
+    packetizer.setupOSCBundle(bundle);
+    packetizer.appendToBundle(bundle, packet);
+    QVERIFY(packetizer.parsePacket(bundle).isEmpty());
+}
+
+void OSC_Test::bundleMalformed()
+{
+    OSCPacketizer packetizer;
+    QByteArray bundle;
+    QByteArray message;
+
+    packetizer.setupOSCDmx(message, 0, 1, 255);
+    packetizer.setupOSCBundle(bundle);
+    packetizer.appendToBundle(bundle, message);
+
+    // an element larger than the bundle stops the parsing,
+    // keeping the elements parsed so far
+    QByteArray truncated = bundle;
+    packetizer.appendToBundle(truncated, message);
+    truncated.chop(4);
+    QCOMPARE(packetizer.parsePacket(truncated).count(), 1);
+
+    // so does an element of size zero
+    QByteArray zero = bundle;
+    zero.append(QByteArray(4, 0x00));
+    zero.append(message);
+    QCOMPARE(packetizer.parsePacket(zero).count(), 1);
+
+    // a truncated size is ignored
+    QByteArray partialSize = bundle;
+    partialSize.append(QByteArray(2, 0x00));
+    QCOMPARE(packetizer.parsePacket(partialSize).count(), 1);
+
+    // not a bundle
+    QVERIFY(packetizer.parsePacket(QByteArray("#foo")).isEmpty());
+    QVERIFY(packetizer.parsePacket(bundle.left(12)).isEmpty());
+}
+
+/****************************************************************************
+ * Controller tests
+ ****************************************************************************/
+
+static QList<QByteArray> readDatagrams(QUdpSocket &socket, int count)
+{
+    QList<QByteArray> received;
+    while (received.count() < count && (socket.hasPendingDatagrams() || socket.waitForReadyRead(1000)))
+    {
+        QByteArray datagram(int(socket.pendingDatagramSize()), 0);
+        socket.readDatagram(datagram.data(), datagram.size());
+        received.append(datagram);
+    }
+    return received;
+}
+
+void OSC_Test::sendDmxBundle()
+{
+    QUdpSocket receiver;
+    QVERIFY(receiver.bind(QHostAddress::LocalHost, 0));
+
+    OSCController controller("127.0.0.1", OSCController::Output, 0);
+    controller.addUniverse(0, OSCController::Output);
+    controller.setOutputPort(0, receiver.localPort());
+    QVERIFY(controller.getUniverseInfo(0)->outputBundle == false);
+
+    // by default, every changed channel is sent in its own message
+    QByteArray dmx(512, 0);
+    dmx[0] = char(255);
+    dmx[1] = char(255);
+    dmx[2] = char(255);
+    controller.sendDmx(0, dmx);
+    QCOMPARE(controller.getPacketSentNumber(), quint64(3));
+
+    QList<QByteArray> received = readDatagrams(receiver, 3);
+    QCOMPARE(received.count(), 3);
+    for (int i = 0; i < received.count(); i++)
+    {
+        QVERIFY(received.at(i).startsWith("#bundle") == false);
+        QList<QPair<QString, QByteArray> > messages = OSCPacketizer().parsePacket(received.at(i));
+        QCOMPARE(messages.count(), 1);
+        QCOMPARE(messages.at(0).first, QString("/0/dmx/%1").arg(i));
+    }
+
+    // with bundling enabled, the changes of a frame are sent in one bundle
+    QVERIFY(controller.setOutputBundle(0, true) == false);
+    dmx.fill(0);
+    controller.sendDmx(0, dmx);
+    QCOMPARE(controller.getPacketSentNumber(), quint64(4));
+
+    received = readDatagrams(receiver, 1);
+    QCOMPARE(received.count(), 1);
+    QVERIFY(received.at(0).startsWith("#bundle") == true);
+    QList<QPair<QString, QByteArray> > messages = OSCPacketizer().parsePacket(received.at(0));
+    QCOMPARE(messages.count(), 3);
+    QCOMPARE(messages.at(2).first, QString("/0/dmx/2"));
+    QCOMPARE(uchar(messages.at(2).second.at(0)), uchar(0));
+
+    // a single change is sent as a plain message
+    dmx[10] = char(255);
+    controller.sendDmx(0, dmx);
+    received = readDatagrams(receiver, 1);
+    QCOMPARE(received.count(), 1);
+    QVERIFY(received.at(0).startsWith("#bundle") == false);
+
+    // disabling it restores the default
+    QVERIFY(controller.setOutputBundle(0, false) == true);
+    QVERIFY(receiver.waitForReadyRead(200) == false);
+}
+
+QTEST_MAIN(OSC_Test)
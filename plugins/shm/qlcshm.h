@@ -0,0 +1,177 @@
+/*
+  Q Light Controller Plus
+  qlcshm.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+/*
+ * Layout of the QLC+ shared memory universes.
+ *
+ * This header is plain C and has no dependency on QLC+ or Qt, so it can be
+ * copied into any local application that wants to read the universes QLC+
+ * outputs (or write the universes QLC+ reads) without sockets or copies.
+ *
+ * A segment is a POSIX shared memory object (see shm_open(3)) made of a
+ * QLCShmHeader followed by QLCShmHeader.slotCount QLCShmSlot structures.
+ * The slot at index N carries QLC+ universe N (0-based).
+ *
+ * Each slot is a ring of QLCSHM_RING_SIZE frames. Every frame written gets
+ * a sequence number, increasing by one for each frame of the slot, starting
+ * from 1. The writer:
+ *   1. clears the sequence of the frame it is about to overwrite
+ *   2. writes timestamp, length and data
+ *   3. stores the new sequence in the frame, then in the slot head
+ * A reader loads the head, reads the frame at (head % QLCSHM_RING_SIZE)
+ * in place, then checks that the frame sequence still equals the head.
+ * If it doesn't, the writer lapped the reader and the data must be
+ * discarded. The ring gives readers QLCSHM_RING_SIZE - 1 frames of slack.
+ *
+ * Timestamps are nanoseconds of CLOCK_MONOTONIC.
+ */
+
+#ifndef QLCSHM_H
+#define QLCSHM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QLCSHM_MAGIC            0x4d48534cu /* "LSHM" */
+#define QLCSHM_VERSION          1
+
+/** Segment written by QLC+ with its output universes */
+#define QLCSHM_OUTPUT_NAME      "/qlcplus-output"
+/** Segment read by QLC+ as input universes */
+#define QLCSHM_INPUT_NAME       "/qlcplus-input"
+
+#define QLCSHM_MAX_UNIVERSES    256
+#define QLCSHM_RING_SIZE        4
+#define QLCSHM_FRAME_SIZE       512
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    /** Number of slots following the header */
+    uint32_t slotCount;
+    /** Number of frames in the ring of each slot */
+    uint32_t ringSize;
+    /** Maximum number of channels of a frame */
+    uint32_t frameSize;
+    /** sizeof(QLCShmSlot), for sanity checks */
+    uint32_t slotBytes;
+    /** Process ID of the segment writer */
+    uint32_t writerPid;
+    uint32_t reserved;
+    uint8_t padding[32];
+} QLCShmHeader;
+
+typedef struct
+{
+    /** Sequence number of this frame, 0 while it is being written */
+    volatile uint64_t sequence;
+    /** Time the frame was written */
+    uint64_t timestamp;
+    /** Number of valid bytes in data */
+    uint32_t length;
+    uint32_t reserved;
+    uint8_t data[QLCSHM_FRAME_SIZE];
+    uint8_t padding[40];
+} QLCShmFrame;
+
+typedef struct
+{
+    /** Sequence number of the latest complete frame, 0 if none */
+    volatile uint64_t head;
+    /** Last time the writer refreshed this slot, even without new frames */
+    volatile uint64_t heartbeat;
+    /** Non-zero while a writer is attached to this slot */
+    volatile uint32_t active;
+    uint32_t reserved;
+    uint8_t padding[40];
+    QLCShmFrame frames[QLCSHM_RING_SIZE];
+} QLCShmSlot;
+
+/** Total size in bytes of a segment with $slotCount slots */
+#define QLCSHM_SEGMENT_SIZE(slotCount) \
+    (sizeof(QLCShmHeader) + (size_t)(slotCount) * sizeof(QLCShmSlot))
+
+/** Return a pointer to slot $index of the segment mapped at $base */
+static inline QLCShmSlot *qlcshm_slot(void *base, uint32_t index)
+{
+    return (QLCShmSlot *)((uint8_t *)base + sizeof(QLCShmHeader)) + index;
+}
+
+/** Return the sequence number of the latest frame of $slot */
+static inline uint64_t qlcshm_head(const QLCShmSlot *slot)
+{
+    return __atomic_load_n(&slot->head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Return the frame with sequence number $sequence, or NULL if it has
+ * already been overwritten. The data can be used in place, as long as
+ * qlcshm_frame_valid() is checked once done with it.
+ */
+static inline const QLCShmFrame *qlcshm_frame(const QLCShmSlot *slot, uint64_t sequence)
+{
+    const QLCShmFrame *frame;
+
+    if (sequence == 0)
+        return 0;
+
+    frame = &slot->frames[sequence % QLCSHM_RING_SIZE];
+    if (__atomic_load_n(&frame->sequence, __ATOMIC_ACQUIRE) != sequence)
+        return 0;
+
+    return frame;
+}
+
+/** Return non-zero if $frame still holds the frame with sequence number $sequence */
+static inline int qlcshm_frame_valid(const QLCShmFrame *frame, uint64_t sequence)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&frame->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+/** Begin writing the next frame of $slot and return it */
+static inline QLCShmFrame *qlcshm_write_begin(QLCShmSlot *slot)
+{
+    uint64_t next = __atomic_load_n(&slot->head, __ATOMIC_RELAXED) + 1;
+    QLCShmFrame *frame = &slot->frames[next % QLCSHM_RING_SIZE];
+
+    __atomic_store_n(&frame->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return frame;
+}
+
+/** Publish the frame obtained with qlcshm_write_begin() */
+static inline void qlcshm_write_end(QLCShmSlot *slot, QLCShmFrame *frame)
+{
+    uint64_t next = __atomic_load_n(&slot->head, __ATOMIC_RELAXED) + 1;
+
+    __atomic_store_n(&frame->sequence, next, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->head, next, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,428 @@
+/*
+  Q Light Controller Plus
+  shmplugin.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QStringList>
+#include <QDebug>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+
+#include "shmplugin.h"
+
+/*****************************************************************************
+ * Initialization
+ *****************************************************************************/
+
+ShmPlugin::~ShmPlugin()
+{
+    unmapSegment(m_input);
+
+    QMutexLocker locker(&m_outputMutex);
+    unmapSegment(m_output);
+}
+
+void ShmPlugin::init()
+{
+    m_output.name = QLCSHM_OUTPUT_NAME;
+    m_output.base = NULL;
+    m_output.owner = false;
+    m_outputRefCount = 0;
+
+    m_input.name = QLCSHM_INPUT_NAME;
+    m_input.base = NULL;
+    m_input.owner = false;
+
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(SHM_INPUT_POLL_INTERVAL);
+    m_pollTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(slotPollInput()));
+}
+
+QString ShmPlugin::name() const
+{
+    return QString("Shared Memory");
+}
+
+int ShmPlugin::capabilities() const
+{
+    return QLCIOPlugin::Output | QLCIOPlugin::Input;
+}
+
+QString ShmPlugin::pluginInfo() const
+{
+    QString str;
+
+    str += QString("<HTML>");
+    str += QString("<HEAD>");
+    str += QString("<TITLE>%1</TITLE>").arg(name());
+    str += QString("</HEAD>");
+    str += QString("<BODY>");
+
+    str += QString("<P>");
+    str += QString("<H3>%1</H3>").arg(name());
+    str += tr("This plugin exchanges DMX universes with local applications through shared memory. "
+              "Output universes are published in %1, input universes are read from %2.")
+              .arg(QString(m_output.name)).arg(QString(m_input.name));
+    str += QString("</P>");
+
+    return str;
+}
+
+void ShmPlugin::setOutputSegmentName(const QByteArray &name)
+{
+    QMutexLocker locker(&m_outputMutex);
+    m_output.name = name;
+}
+
+void ShmPlugin::setInputSegmentName(const QByteArray &name)
+{
+    m_input.name = name;
+}
+
+bool ShmPlugin::mapSegment(ShmSegment &seg)
+{
+    if (seg.base != NULL)
+        return true;
+
+    /* The output segment always belongs to QLC+, while the input segment
+     * might have been created by the application writing to it */
+    bool isOutput = (&seg == &m_output);
+    size_t size = QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES);
+
+    int fd = shm_open(seg.name.constData(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    bool created = (fd != -1);
+    if (fd == -1)
+        fd = shm_open(seg.name.constData(), O_RDWR, 0);
+
+    if (fd == -1)
+    {
+        qWarning() << "[SHM] cannot open" << seg.name << ":" << strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        qWarning() << "[SHM] cannot stat" << seg.name << ":" << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    /* A segment is initialized only when it has just been created (or
+     * created but not sized yet by another process). An existing segment
+     * is reused as it is, since readers might be attached to it */
+    bool initialize = created || st.st_size == 0;
+    if (initialize && ftruncate(fd, size) == -1)
+    {
+        qWarning() << "[SHM] cannot resize" << seg.name << ":" << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    bool valid = initialize || size_t(st.st_size) >= size;
+    void *base = NULL;
+
+    if (valid)
+    {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            qWarning() << "[SHM] cannot map" << seg.name << ":" << strerror(errno);
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+
+    QLCShmHeader *header = static_cast<QLCShmHeader *>(base);
+
+    if (initialize)
+    {
+        // ftruncate has already zeroed the new segment
+        header->version = QLCSHM_VERSION;
+        header->slotCount = QLCSHM_MAX_UNIVERSES;
+        header->ringSize = QLCSHM_RING_SIZE;
+        header->frameSize = QLCSHM_FRAME_SIZE;
+        header->slotBytes = sizeof(QLCShmSlot);
+        header->writerPid = isOutput ? quint32(getpid()) : 0;
+
+        // readers check the magic number to know the layout is ready
+        __atomic_store_n(&header->magic, QLCSHM_MAGIC, __ATOMIC_RELEASE);
+    }
+    else if (valid)
+    {
+        valid = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == QLCSHM_MAGIC &&
+                header->version == QLCSHM_VERSION && header->slotCount >= QLCSHM_MAX_UNIVERSES &&
+                header->ringSize == QLCSHM_RING_SIZE && header->frameSize == QLCSHM_FRAME_SIZE &&
+                header->slotBytes == sizeof(QLCShmSlot);
+        if (valid == false)
+        {
+            munmap(base, size);
+        }
+        else if (isOutput)
+        {
+            /* Don't write over the segment of another running instance.
+             * kill() fails with ESRCH only when the process is gone */
+            pid_t writer = pid_t(header->writerPid);
+            if (writer != 0 && writer != getpid() &&
+                (kill(writer, 0) == 0 || errno != ESRCH))
+            {
+                qWarning() << "[SHM]" << seg.name << "is in use by process" << writer;
+                munmap(base, size);
+                return false;
+            }
+            header->writerPid = quint32(getpid());
+        }
+    }
+
+    if (valid == false)
+    {
+        // a stale output segment is replaced. Attached readers keep the old one
+        if (isOutput && shm_unlink(seg.name.constData()) == 0)
+        {
+            qDebug() << "[SHM] replacing" << seg.name;
+            return mapSegment(seg);
+        }
+
+        qWarning() << "[SHM]" << seg.name << "has an unsupported layout";
+        return false;
+    }
+
+    seg.base = base;
+    seg.owner = created || isOutput;
+
+    qDebug() << "[SHM] mapped" << seg.name << size << "bytes";
+
+    return true;
+}
+
+void ShmPlugin::unmapSegment(ShmSegment &seg)
+{
+    if (seg.base == NULL)
+        return;
+
+    munmap(seg.base, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+    seg.base = NULL;
+
+    // keep the input segment alive for the application writing to it
+    if (seg.owner && &seg == &m_output)
+        shm_unlink(seg.name.constData());
+
+    seg.owner = false;
+}
+
+quint64 ShmPlugin::timestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000000 + quint64(ts.tv_nsec);
+}
+
+/*****************************************************************************
+ * Outputs
+ *****************************************************************************/
+
+bool ShmPlugin::openOutput(quint32 output, quint32 universe)
+{
+    if (output != 0 || universe >= QLCSHM_MAX_UNIVERSES)
+        return false;
+
+    QMutexLocker locker(&m_outputMutex);
+
+    if (mapSegment(m_output) == false)
+        return false;
+
+    QLCShmSlot *slot = qlcshm_slot(m_output.base, universe);
+    __atomic_store_n(&slot->active, 1, __ATOMIC_RELEASE);
+
+    m_outputRefCount++;
+    addToMap(universe, output, Output);
+
+    return true;
+}
+
+void ShmPlugin::closeOutput(quint32 output, quint32 universe)
+{
+    // writeUniverse must not run while the segment is being unmapped
+    QMutexLocker locker(&m_outputMutex);
+
+    if (output != 0 || m_output.base == NULL || universe >= QLCSHM_MAX_UNIVERSES)
+        return;
+
+    QLCShmSlot *slot = qlcshm_slot(m_output.base, universe);
+    __atomic_store_n(&slot->active, 0, __ATOMIC_RELEASE);
+
+    removeFromMap(output, universe, Output);
+
+    if (--m_outputRefCount <= 0)
+    {
+        m_outputRefCount = 0;
+        unmapSegment(m_output);
+    }
+}
+
+QStringList ShmPlugin::outputs()
+{
+    return QStringList() << QString(m_output.name);
+}
+
+QString ShmPlugin::outputInfo(quint32 output)
+{
+    if (output != 0)
+        return QString();
+
+    QString str;
+
+    str += QString("<H3>%1 %2</H3>").arg(tr("Output")).arg(outputs()[output]);
+    str += QString("<P>");
+    QMutexLocker locker(&m_outputMutex);
+    if (m_output.base != NULL)
+        str += tr("Status: Used");
+    else
+        str += tr("Status: Not used");
+    str += QString("</P>");
+    str += QString("</BODY>");
+    str += QString("</HTML>");
+
+    return str;
+}
+
+void ShmPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArray &data, bool dataChanged)
+{
+    QMutexLocker locker(&m_outputMutex);
+
+    if (output != 0 || m_output.base == NULL || universe >= QLCSHM_MAX_UNIVERSES)
+        return;
+
+    QLCShmSlot *slot = qlcshm_slot(m_output.base, universe);
+    quint64 now = timestamp();
+
+    // readers are woken up only by actual changes, the heartbeat tells them we're alive
+    if (dataChanged || slot->head == 0)
+    {
+        QLCShmFrame *frame = qlcshm_write_begin(slot);
+        uint32_t length = uint32_t(qMin(data.size(), QLCSHM_FRAME_SIZE));
+
+        frame->timestamp = now;
+        frame->length = length;
+        memcpy(frame->data, data.constData(), length);
+
+        qlcshm_write_end(slot, frame);
+    }
+
+    __atomic_store_n(&slot->heartbeat, now, __ATOMIC_RELEASE);
+}
+
+/*****************************************************************************
+ * Inputs
+ *****************************************************************************/
+
+bool ShmPlugin::openInput(quint32 input, quint32 universe)
+{
+    if (input != 0 || universe >= QLCSHM_MAX_UNIVERSES)
+        return false;
+
+    if (mapSegment(m_input) == false)
+        return false;
+
+    // only frames written from now on are delivered
+    m_inputSequence[universe] = qlcshm_head(qlcshm_slot(m_input.base, universe));
+    addToMap(universe, input, Input);
+
+    if (m_pollTimer->isActive() == false)
+        m_pollTimer->start();
+
+    return true;
+}
+
+void ShmPlugin::closeInput(quint32 input, quint32 universe)
+{
+    if (input != 0)
+        return;
+
+    m_inputSequence.remove(universe);
+    removeFromMap(input, universe, Input);
+
+    if (m_inputSequence.isEmpty())
+    {
+        m_pollTimer->stop();
+        unmapSegment(m_input);
+    }
+}
+
+QStringList ShmPlugin::inputs()
+{
+    return QStringList() << QString(m_input.name);
+}
+
+QString ShmPlugin::inputInfo(quint32 input)
+{
+    if (input != 0)
+        return QString();
+
+    QString str;
+
+    str += QString("<H3>%1 %2</H3>").arg(tr("Input")).arg(inputs()[input]);
+    str += QString("<P>");
+    if (m_input.base != NULL)
+        str += tr("Status: Used");
+    else
+        str += tr("Status: Not used");
+    str += QString("</P>");
+    str += QString("</BODY>");
+    str += QString("</HTML>");
+
+    return str;
+}
+
+void ShmPlugin::slotPollInput()
+{
+    if (m_input.base == NULL)
+        return;
+
+    QHash<quint32, quint64>::iterator it = m_inputSequence.begin();
+    for (; it != m_inputSequence.end(); ++it)
+    {
+        const QLCShmSlot *slot = qlcshm_slot(m_input.base, it.key());
+        quint64 head = qlcshm_head(slot);
+        if (head == it.value())
+            continue;
+
+        const QLCShmFrame *frame = qlcshm_frame(slot, head);
+        if (frame == NULL)
+            continue;
+
+        QByteArray data(reinterpret_cast<const char *>(frame->data),
+                        int(qMin(frame->length, uint32_t(QLCSHM_FRAME_SIZE))));
+
+        // the writer lapped us while copying: try again on the next poll
+        if (qlcshm_frame_valid(frame, head) == 0)
+            continue;
+
+        it.value() = head;
+        emit universeDataChanged(it.key(), 0, data);
+    }
+}
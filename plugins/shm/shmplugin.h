@@ -0,0 +1,145 @@
+/*
+  Q Light Controller Plus
+  shmplugin.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef SHMPLUGIN_H
+#define SHMPLUGIN_H
+
+#include <QString>
+#include <QMutex>
+#include <QTimer>
+#include <QHash>
+
+#include "qlcioplugin.h"
+#include "qlcshm.h"
+
+/** Interval in milliseconds between two polls of the input segment */
+#define SHM_INPUT_POLL_INTERVAL 10
+
+typedef struct
+{
+    /** Segment name, as passed to shm_open */
+    QByteArray name;
+    /** Base address of the mapped segment, NULL if not mapped */
+    void *base;
+    /** True if this process created the segment */
+    bool owner;
+} ShmSegment;
+
+/**
+ * ShmPlugin publishes output universes into a POSIX shared memory segment
+ * and reads input universes from another one. Local processes attach to
+ * the segments using the layout described in qlcshm.h, reading frames in
+ * place without any copy or system call.
+ */
+class ShmPlugin final : public QLCIOPlugin
+{
+    Q_OBJECT
+    Q_INTERFACES(QLCIOPlugin)
+    Q_PLUGIN_METADATA(IID QLCIOPlugin_iid)
+
+    /*********************************************************************
+     * Initialization
+     *********************************************************************/
+public:
+    /** @reimp */
+    virtual ~ShmPlugin();
+
+    /** @reimp */
+    void init() override;
+
+    /** @reimp */
+    QString name() const override;
+
+    /** @reimp */
+    int capabilities() const override;
+
+    /** @reimp */
+    QString pluginInfo() const override;
+
+    /** Set the name of the output segment. Takes effect on the next map */
+    void setOutputSegmentName(const QByteArray &name);
+
+    /** Set the name of the input segment. Takes effect on the next map */
+    void setInputSegmentName(const QByteArray &name);
+
+private:
+    /** Create or attach to the segment $seg, mapping it in memory */
+    bool mapSegment(ShmSegment &seg);
+
+    /** Unmap $seg, removing it if this process created it */
+    void unmapSegment(ShmSegment &seg);
+
+    /** Return the monotonic time in nanoseconds, as used by qlcshm.h */
+    static quint64 timestamp();
+
+    /*********************************************************************
+     * Outputs
+     *********************************************************************/
+public:
+    /** @reimp */
+    bool openOutput(quint32 output, quint32 universe) override;
+
+    /** @reimp */
+    void closeOutput(quint32 output, quint32 universe) override;
+
+    /** @reimp */
+    QStringList outputs() override;
+
+    /** @reimp */
+    QString outputInfo(quint32 output) override;
+
+    /** @reimp */
+    void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
+
+private:
+    ShmSegment m_output;
+    /** Number of universes patched to the output line */
+    int m_outputRefCount;
+    /** Serializes the universe threads writing to the output segment
+     *  with the main thread mapping and unmapping it */
+    QMutex m_outputMutex;
+
+    /*********************************************************************
+     * Inputs
+     *********************************************************************/
+public:
+    /** @reimp */
+    bool openInput(quint32 input, quint32 universe) override;
+
+    /** @reimp */
+    void closeInput(quint32 input, quint32 universe) override;
+
+    /** @reimp */
+    QStringList inputs() override;
+
+    /** @reimp */
+    QString inputInfo(quint32 input) override;
+
+protected slots:
+    /** Look for new frames in the input segment */
+    void slotPollInput();
+
+private:
+    ShmSegment m_input;
+    QTimer *m_pollTimer;
+    /** Input universe -> sequence number of the last frame read */
+    QHash<quint32, quint64> m_inputSequence;
+};
+
+#endif
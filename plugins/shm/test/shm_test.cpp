@@ -0,0 +1,337 @@
+/*
+  Q Light Controller Plus
+  shm_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QTest>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstdlib>
+#include <cstring>
+
+#define private public
+#include "shm_test.h"
+#include "shmplugin.h"
+#include "qlcshm.h"
+#undef private
+
+#define SEGMENT_SLOTS 2
+
+/** Output segment name used by the tests, so that a running QLC+ is left alone */
+static QByteArray outputName()
+{
+    return QByteArray("/qlcplus-test-output-") + QByteArray::number(qint64(getpid()));
+}
+
+/** Write a frame of $length bytes, all set to $value, into $slot */
+static void writeFrame(QLCShmSlot *slot, uint8_t value, uint32_t length = QLCSHM_FRAME_SIZE)
+{
+    QLCShmFrame *frame = qlcshm_write_begin(slot);
+    frame->timestamp = 1;
+    frame->length = length;
+    memset(frame->data, value, length);
+    qlcshm_write_end(slot, frame);
+}
+
+/** Map the output segment as an external reader would do */
+static void *mapOutput()
+{
+    int fd = shm_open(outputName().constData(), O_RDONLY, 0);
+    if (fd == -1)
+        return NULL;
+
+    void *base = mmap(NULL, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return base == MAP_FAILED ? NULL : base;
+}
+
+/** Create the output segment with a valid header, as left by a previous run */
+static void *createOutput(uint32_t magic, uint32_t writerPid = 0)
+{
+    size_t size = QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES);
+    int fd = shm_open(outputName().constData(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1)
+        return NULL;
+
+    if (ftruncate(fd, size) == -1)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    QLCShmHeader *header = static_cast<QLCShmHeader *>(base);
+    header->magic = magic;
+    header->version = QLCSHM_VERSION;
+    header->slotCount = QLCSHM_MAX_UNIVERSES;
+    header->ringSize = QLCSHM_RING_SIZE;
+    header->frameSize = QLCSHM_FRAME_SIZE;
+    header->slotBytes = sizeof(QLCShmSlot);
+    header->writerPid = writerPid;
+
+    return base;
+}
+
+void Shm_Test::init()
+{
+    m_segment = calloc(1, QLCSHM_SEGMENT_SIZE(SEGMENT_SLOTS));
+    QVERIFY(m_segment != NULL);
+
+    shm_unlink(outputName().constData());
+}
+
+void Shm_Test::cleanup()
+{
+    free(m_segment);
+    m_segment = NULL;
+
+    shm_unlink(outputName().constData());
+}
+
+/****************************************************************************
+ * Seqlock helpers
+ ****************************************************************************/
+
+void Shm_Test::layout()
+{
+    QCOMPARE(QLCSHM_SEGMENT_SIZE(0), sizeof(QLCShmHeader));
+    QCOMPARE(QLCSHM_SEGMENT_SIZE(3), sizeof(QLCShmHeader) + 3 * sizeof(QLCShmSlot));
+
+    // slots follow the header, one after the other
+    uint8_t *base = static_cast<uint8_t *>(m_segment);
+    QCOMPARE((uint8_t *)qlcshm_slot(m_segment, 0), base + sizeof(QLCShmHeader));
+    QCOMPARE((uint8_t *)qlcshm_slot(m_segment, 1), base + sizeof(QLCShmHeader) + sizeof(QLCShmSlot));
+
+    // an empty slot has no frame
+    QLCShmSlot *slot = qlcshm_slot(m_segment, 0);
+    QCOMPARE(qlcshm_head(slot), uint64_t(0));
+    QVERIFY(qlcshm_frame(slot, 0) == NULL);
+}
+
+void Shm_Test::writeRead()
+{
+    QLCShmSlot *slot = qlcshm_slot(m_segment, 1);
+
+    writeFrame(slot, 0x11, 24);
+    QCOMPARE(qlcshm_head(slot), uint64_t(1));
+
+    const QLCShmFrame *frame = qlcshm_frame(slot, qlcshm_head(slot));
+    QVERIFY(frame != NULL);
+    QVERIFY(frame == &slot->frames[1 % QLCSHM_RING_SIZE]);
+    QCOMPARE(frame->length, uint32_t(24));
+    QCOMPARE(frame->data[0], uint8_t(0x11));
+    QCOMPARE(frame->data[23], uint8_t(0x11));
+    QVERIFY(qlcshm_frame_valid(frame, 1) != 0);
+
+    // the other slot is untouched
+    QCOMPARE(qlcshm_head(qlcshm_slot(m_segment, 0)), uint64_t(0));
+
+    // every frame gets the next sequence number and ring position
+    for (uint64_t seq = 2; seq <= 2 * QLCSHM_RING_SIZE; seq++)
+    {
+        writeFrame(slot, uint8_t(seq));
+        QCOMPARE(qlcshm_head(slot), seq);
+        frame = qlcshm_frame(slot, seq);
+        QVERIFY(frame == &slot->frames[seq % QLCSHM_RING_SIZE]);
+        QCOMPARE(frame->data[QLCSHM_FRAME_SIZE - 1], uint8_t(seq));
+    }
+}
+
+void Shm_Test::lappedReader()
+{
+    QLCShmSlot *slot = qlcshm_slot(m_segment, 0);
+
+    writeFrame(slot, 1);
+    const QLCShmFrame *frame = qlcshm_frame(slot, 1);
+    QVERIFY(frame != NULL);
+
+    // a reader has QLCSHM_RING_SIZE - 1 frames of slack
+    for (int i = 0; i < QLCSHM_RING_SIZE - 1; i++)
+        writeFrame(slot, 2);
+    QVERIFY(qlcshm_frame(slot, 1) != NULL);
+    QVERIFY(qlcshm_frame_valid(frame, 1) != 0);
+
+    // one more and the frame has been overwritten
+    writeFrame(slot, 3);
+    QVERIFY(qlcshm_frame(slot, 1) == NULL);
+    QVERIFY(qlcshm_frame_valid(frame, 1) == 0);
+    QVERIFY(qlcshm_frame(slot, qlcshm_head(slot)) != NULL);
+}
+
+void Shm_Test::tornFrame()
+{
+    QLCShmSlot *slot = qlcshm_slot(m_segment, 0);
+
+    for (int i = 0; i < QLCSHM_RING_SIZE; i++)
+        writeFrame(slot, 1);
+
+    // the oldest frame is the next one to be written
+    uint64_t oldest = qlcshm_head(slot) - QLCSHM_RING_SIZE + 1;
+    const QLCShmFrame *frame = qlcshm_frame(slot, oldest);
+    QVERIFY(frame != NULL);
+
+    // while the writer is in the middle of it, the frame is invalid
+    QLCShmFrame *writing = qlcshm_write_begin(slot);
+    QVERIFY(writing == frame);
+    QCOMPARE(uint64_t(writing->sequence), uint64_t(0));
+    QVERIFY(qlcshm_frame_valid(frame, oldest) == 0);
+    QVERIFY(qlcshm_frame(slot, oldest) == NULL);
+
+    // the head is published only at the end
+    QCOMPARE(qlcshm_head(slot), uint64_t(QLCSHM_RING_SIZE));
+    qlcshm_write_end(slot, writing);
+    QCOMPARE(qlcshm_head(slot), uint64_t(QLCSHM_RING_SIZE + 1));
+    QVERIFY(qlcshm_frame_valid(writing, QLCSHM_RING_SIZE + 1) != 0);
+}
+
+/****************************************************************************
+ * Plugin
+ ****************************************************************************/
+
+void Shm_Test::outputSegment()
+{
+    ShmPlugin plugin;
+    plugin.init();
+    QCOMPARE(plugin.outputs(), QStringList() << QString(QLCSHM_OUTPUT_NAME));
+    plugin.setOutputSegmentName(outputName());
+    QCOMPARE(plugin.outputs(), QStringList() << QString(outputName()));
+
+    QVERIFY(plugin.openOutput(0, QLCSHM_MAX_UNIVERSES) == false);
+    QVERIFY(plugin.openOutput(0, 3) == true);
+
+    void *base = mapOutput();
+    QVERIFY(base != NULL);
+
+    const QLCShmHeader *header = static_cast<const QLCShmHeader *>(base);
+    QCOMPARE(header->magic, QLCSHM_MAGIC);
+    QCOMPARE(header->slotCount, uint32_t(QLCSHM_MAX_UNIVERSES));
+    QCOMPARE(header->writerPid, uint32_t(getpid()));
+
+    QLCShmSlot *slot = qlcshm_slot(base, 3);
+    QCOMPARE(uint32_t(slot->active), uint32_t(1));
+
+    // the first frame is always written, then only changes
+    plugin.writeUniverse(3, 0, QByteArray(16, char(7)), false);
+    QCOMPARE(qlcshm_head(slot), uint64_t(1));
+    plugin.writeUniverse(3, 0, QByteArray(16, char(8)), false);
+    QCOMPARE(qlcshm_head(slot), uint64_t(1));
+    QVERIFY(slot->heartbeat != 0);
+
+    plugin.writeUniverse(3, 0, QByteArray(16, char(9)), true);
+    const QLCShmFrame *frame = qlcshm_frame(slot, qlcshm_head(slot));
+    QVERIFY(frame != NULL);
+    QCOMPARE(frame->length, uint32_t(16));
+    QCOMPARE(frame->data[15], uint8_t(9));
+
+    // closing the last universe removes the segment
+    plugin.closeOutput(0, 3);
+    QVERIFY(plugin.m_output.base == NULL);
+    QCOMPARE(uint32_t(slot->active), uint32_t(0));
+    QVERIFY(mapOutput() == NULL);
+
+    // writing to a closed output is harmless
+    plugin.writeUniverse(3, 0, QByteArray(16, char(10)), true);
+    QCOMPARE(qlcshm_head(slot), uint64_t(2));
+
+    munmap(base, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+}
+
+void Shm_Test::reuseExistingSegment()
+{
+    void *base = createOutput(QLCSHM_MAGIC);
+    QVERIFY(base != NULL);
+
+    QLCShmSlot *slot = qlcshm_slot(base, 0);
+    writeFrame(slot, 42);
+    writeFrame(slot, 43);
+
+    ShmPlugin plugin;
+    plugin.init();
+    plugin.setOutputSegmentName(outputName());
+    QVERIFY(plugin.openOutput(0, 0) == true);
+
+    // the existing frames are kept and the sequence goes on
+    QCOMPARE(qlcshm_head(slot), uint64_t(2));
+    QCOMPARE(qlcshm_frame(slot, 2)->data[0], uint8_t(43));
+
+    plugin.writeUniverse(0, 0, QByteArray(8, char(44)), true);
+    QCOMPARE(qlcshm_head(slot), uint64_t(3));
+    QCOMPARE(qlcshm_frame(slot, 3)->data[0], uint8_t(44));
+
+    plugin.closeOutput(0, 0);
+    munmap(base, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+}
+
+void Shm_Test::replaceStaleSegment()
+{
+    void *stale = createOutput(0xdeadbeef);
+    QVERIFY(stale != NULL);
+    writeFrame(qlcshm_slot(stale, 0), 42);
+
+    ShmPlugin plugin;
+    plugin.init();
+    plugin.setOutputSegmentName(outputName());
+    QVERIFY(plugin.openOutput(0, 0) == true);
+
+    // the stale mapping is left alone, a new segment is published
+    QCOMPARE(static_cast<QLCShmHeader *>(stale)->magic, uint32_t(0xdeadbeef));
+    QCOMPARE(qlcshm_head(qlcshm_slot(stale, 0)), uint64_t(1));
+
+    void *base = mapOutput();
+    QVERIFY(base != NULL);
+    QCOMPARE(static_cast<const QLCShmHeader *>(base)->magic, QLCSHM_MAGIC);
+    QCOMPARE(qlcshm_head(qlcshm_slot(base, 0)), uint64_t(0));
+
+    plugin.closeOutput(0, 0);
+    munmap(base, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+    munmap(stale, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+}
+
+void Shm_Test::segmentInUse()
+{
+    // the parent process stands for another running instance
+    void *base = createOutput(QLCSHM_MAGIC, uint32_t(getppid()));
+    QVERIFY(base != NULL);
+    writeFrame(qlcshm_slot(base, 0), 42);
+
+    ShmPlugin plugin;
+    plugin.init();
+    plugin.setOutputSegmentName(outputName());
+    QVERIFY(plugin.openOutput(0, 0) == false);
+    QVERIFY(plugin.m_output.base == NULL);
+
+    // the segment is left as it was
+    const QLCShmHeader *header = static_cast<const QLCShmHeader *>(base);
+    QCOMPARE(header->writerPid, uint32_t(getppid()));
+    QCOMPARE(qlcshm_head(qlcshm_slot(base, 0)), uint64_t(1));
+
+    void *reader = mapOutput();
+    QVERIFY(reader != NULL);
+
+    munmap(reader, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+    munmap(base, QLCSHM_SEGMENT_SIZE(QLCSHM_MAX_UNIVERSES));
+}
+
+QTEST_GUILESS_MAIN(Shm_Test)
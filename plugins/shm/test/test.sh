@@ -0,0 +1,2 @@
+#!/bin/sh
+./shm_test
@@ -50,6 +50,15 @@ SPIConfiguration::SPIConfiguration(SPIPlugin* plugin, QWidget* parent)
             case 8000000: m_freqCombo->setCurrentIndex(3); break;
         }
     }
+
+    value = settings.value(SETTINGS_PIXEL_PROTOCOL);
+    if (value.isValid() == true)
+        m_protocolCombo->setCurrentIndex(value.toInt());
+
+    value = settings.value(SETTINGS_PIXEL_BRIGHTNESS);
+    if (value.isValid() == true)
+        m_brightnessSpin->setValue(value.toInt());
+
     QVariant geometrySettings = settings.value(SETTINGS_GEOMETRY);
     if (geometrySettings.isValid() == true)
         restoreGeometry(geometrySettings.toByteArray());
@@ -83,6 +92,16 @@ quint32 SPIConfiguration::frequency()
     }
 }
 
+int SPIConfiguration::protocol()
+{
+    return m_protocolCombo->currentIndex();
+}
+
+int SPIConfiguration::brightness()
+{
+    return m_brightnessSpin->value();
+}
+
 int SPIConfiguration::exec()
 {
     return QDialog::exec();
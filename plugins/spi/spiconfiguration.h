@@ -40,6 +40,12 @@ public:
 
     quint32 frequency();
 
+    /** The selected pixel protocol, as a SPIPixelEncoder::Protocol */
+    int protocol();
+
+    /** The selected APA102 global brightness */
+    int brightness();
+
 public slots:
     int exec() override;
 
@@ -21,16 +21,22 @@
 #include <QSettings>
 #include <QDebug>
 
-#include <time.h>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
 #include <sys/ioctl.h>
 #include <linux/spi/spidev.h>
 
 #include "spioutthread.h"
 
 SPIOutThread::SPIOutThread()
-    : m_isRunning(false)
-    , m_dataSize(0)
-    , m_estimatedWireTime(50000)
+    : m_spifd(-1)
+    , m_bitsPerWord(8)
+    , m_speed(1000000)
+    , m_isSpiDevice(true)
+    , m_isRunning(false)
+    , m_dataPending(false)
+    , m_frameSize(0)
 {
 
 }
@@ -48,24 +54,38 @@ void SPIOutThread::runThread(int fd, int speed)
     int status = -1;
 
     status = ioctl (m_spifd, SPI_IOC_WR_MODE, &mode);
-    if (status < 0)
-        qWarning() << "Could not set SPIMode (WR)...ioctl fail";
+    m_isSpiDevice = (status >= 0 || errno != ENOTTY);
 
-    status = ioctl (m_spifd, SPI_IOC_WR_BITS_PER_WORD, &m_bitsPerWord);
-    if (status < 0)
-        qWarning() << "Could not set SPI bitsPerWord (WR)...ioctl fail";
+    if (m_isSpiDevice == false)
+    {
+        qDebug() << "[SPI] not a SPI device, frames are written as a stream";
+    }
+    else
+    {
+        if (status < 0)
+            qWarning() << "Could not set SPIMode (WR)...ioctl fail";
 
-    status = ioctl (m_spifd, SPI_IOC_WR_MAX_SPEED_HZ, &m_speed);
-    if (status < 0)
-        qWarning() << "Could not set SPI speed (WR)...ioctl fail";
+        status = ioctl (m_spifd, SPI_IOC_WR_BITS_PER_WORD, &m_bitsPerWord);
+        if (status < 0)
+            qWarning() << "Could not set SPI bitsPerWord (WR)...ioctl fail";
+
+        status = ioctl (m_spifd, SPI_IOC_WR_MAX_SPEED_HZ, &m_speed);
+        if (status < 0)
+            qWarning() << "Could not set SPI speed (WR)...ioctl fail";
+    }
 
     m_isRunning = true;
-    start();
+    m_lastTransfer.start();
+    start(QThread::HighPriority);
 }
 
 void SPIOutThread::stopThread()
 {
-    m_isRunning = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isRunning = false;
+        m_dataCondition.wakeOne();
+    }
     wait();
 }
 
@@ -76,50 +96,90 @@ void SPIOutThread::setSpeed(int speed)
 
     if (isRunning())
     {
-        m_isRunning = false;
-        wait();
+        stopThread();
         runThread(m_spifd, speed);
     }
 }
 
-void SPIOutThread::run()
+void SPIOutThread::setProtocol(SPIPixelEncoder::Protocol protocol, int brightness)
 {
-    while (m_isRunning)
+    QMutexLocker locker(&m_mutex);
+    m_encoder.setProtocol(protocol);
+    m_encoder.setBrightness(brightness);
+
+    // resend the current data with the new encoding
+    if (m_pluginData.isEmpty() == false)
     {
-        struct spi_ioc_transfer spi;
+        m_dataPending = true;
+        m_dataCondition.wakeOne();
+    }
+}
 
-        struct timespec ts_start;
-        struct timespec ts_end;
-#ifdef CLOCK_MONOTONIC
-        clock_gettime(CLOCK_MONOTONIC, &ts_start);
-#else
-        clock_gettime(CLOCK_REALTIME, &ts_start);
-#endif
+SPIPixelEncoder::Protocol SPIOutThread::protocol()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encoder.protocol();
+}
+
+int SPIOutThread::frameSize()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameSize;
+}
+
+bool SPIOutThread::transfer(const QByteArray &frame)
+{
+    if (m_isSpiDevice == false)
+        return write(m_spifd, frame.constData(), frame.size()) == frame.size();
+
+    struct spi_ioc_transfer spi;
+
+    memset(&spi, 0, sizeof(spi));
+    spi.tx_buf        = reinterpret_cast<__u64>(frame.constData());
+    spi.len           = frame.size();
+    spi.delay_usecs   = 0;
+    spi.speed_hz      = m_speed;
+    spi.bits_per_word = m_bitsPerWord;
+    spi.cs_change = 0;
+
+    return ioctl(m_spifd, SPI_IOC_MESSAGE(1), &spi) >= 0;
+}
+
+void SPIOutThread::run()
+{
+    while (true)
+    {
+        int latchTime;
 
-        if (m_spifd != -1 && m_pluginData.size() > 0)
         {
             QMutexLocker locker(&m_mutex);
-            memset(&spi, 0, sizeof(spi));
-            spi.tx_buf        = reinterpret_cast<__u64>(m_pluginData.data());
-            spi.len           = m_pluginData.size();
-            spi.delay_usecs   = 0;
-            spi.speed_hz      = m_speed;
-            spi.bits_per_word = m_bitsPerWord;
-            spi.cs_change = 0;
-
-            int retVal = ioctl(m_spifd, SPI_IOC_MESSAGE(1), &spi);
-            if (retVal < 0)
-                qWarning() << "Problem transmitting SPI data: ioctl failed";
+            while (m_isRunning && m_dataPending == false)
+                m_dataCondition.wait(&m_mutex);
+
+            if (m_isRunning == false)
+                break;
+
+            // ticks coming while a transfer is in progress are merged
+            // into the latest data: encode it into the frame buffer
+            m_encoder.encode(m_pluginData, m_frame);
+            m_frameSize = m_frame.size();
+            latchTime = m_encoder.latchTime();
+            m_dataPending = false;
         }
 
-#ifdef CLOCK_MONOTONIC
-        clock_gettime(CLOCK_MONOTONIC, &ts_end);
-#else
-        clock_gettime(CLOCK_REALTIME, &ts_end);
-#endif
-        int uSecDiff = (difftime(ts_end.tv_sec, ts_start.tv_sec) * 1000000) + ((ts_end.tv_nsec - ts_start.tv_nsec) / 1000);
-        //qDebug() << "[SPI] ioctl took" << microseconds << "uSecDiff";
-        usleep(m_estimatedWireTime - uSecDiff);
+        if (m_frame.isEmpty() || m_spifd == -1)
+            continue;
+
+        // some strips latch the data when the clock stays idle for a
+        // while: make sure the previous frame got latched
+        qint64 idleTime = m_lastTransfer.nsecsElapsed() / 1000;
+        if (idleTime < latchTime)
+            usleep(latchTime - idleTime);
+
+        if (transfer(m_frame) == false)
+            qWarning() << "Problem transmitting SPI data:" << strerror(errno);
+
+        m_lastTransfer.restart();
     }
 }
 
@@ -127,18 +187,6 @@ void SPIOutThread::writeData(const QByteArray &data)
 {
     QMutexLocker locker(&m_mutex);
     m_pluginData = data;
-    if (m_dataSize != data.size())
-    {
-        // Data size has changed! I need to estimate the
-        // time that the SPI writes will take on the wire.
-        // The estimation is very unprecise and it is based
-        // on Simon Newton's measurements on a Raspberry Pi
-        // where 512 bytes at 1Mhz takes about 70ms to be sent
-
-        double byteWriteTimeuS = (double)(70000.0 / ((double)m_speed / 1000000.0)) / 512.0; // time taken to write a byte
-        m_estimatedWireTime = byteWriteTimeuS * (double)data.size();
-        m_dataSize = data.size();
-        qDebug() << "[SPI out thread] estimated sleep time:" << m_estimatedWireTime;
-    }
+    m_dataPending = true;
+    m_dataCondition.wakeOne();
 }
-
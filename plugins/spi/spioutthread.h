@@ -20,8 +20,21 @@
 #ifndef SPIOUTTHREAD_H
 #define SPIOUTTHREAD_H
 
+#include <QWaitCondition>
+#include <QElapsedTimer>
 #include <QThread>
-
+#include <QMutex>
+
+#include "spipixelencoder.h"
+
+/**
+ * SPIOutThread submits the frames of the SPI plugin to the device,
+ * one transfer per MasterTimer tick.
+ *
+ * The file descriptor doesn't need to be a spidev device: if it doesn't
+ * accept the SPI ioctls, frames are written to it as a plain stream
+ * (e.g. a pipe or a file standing in for the device).
+ */
 class SPIOutThread final : public QThread
 {
 public:
@@ -31,30 +44,52 @@ public:
     void stopThread();
     void setSpeed(int speed);
 
+    /** Set the pixel protocol and APA102 brightness of the strip */
+    void setProtocol(SPIPixelEncoder::Protocol protocol, int brightness);
+    SPIPixelEncoder::Protocol protocol();
+
     void run() override;
 
+    /** Submit the channels of all the universes, to be encoded and
+     *  sent with a single transfer */
     void writeData(const QByteArray& data);
 
+    /** Return the size of the last frame sent to the device */
+    int frameSize();
+
+private:
+    bool transfer(const QByteArray& frame);
+
 protected:
     /** File handle for /dev/spidev0.0 */
     int m_spifd;
     int m_bitsPerWord;
     int m_speed;
 
+    /** False if m_spifd doesn't accept the SPI ioctls */
+    bool m_isSpiDevice;
+
     bool m_isRunning;
 
     /** Copy of data received from the SPI plugin */
     QByteArray m_pluginData;
+    /** True when m_pluginData has not been sent yet */
+    bool m_dataPending;
+
+    /** Encoder of the strip protocol */
+    SPIPixelEncoder m_encoder;
 
-    /** Last size of data sent to the SPI bus */
-    int m_dataSize;
+    /** The encoded frame, reallocated only when its size changes */
+    QByteArray m_frame;
+    int m_frameSize;
 
-    /** Roughly estimated time that SPI writes will take on the wire (in uS) */
-    quint32 m_estimatedWireTime;
+    /** Time elapsed since the end of the last transfer */
+    QElapsedTimer m_lastTransfer;
 
     /** Mutex used to synchronize data between the SPI plugin
      *  and the output thread */
     QMutex m_mutex;
+    QWaitCondition m_dataCondition;
 };
 
 #endif // SPIOUTTHREAD_H
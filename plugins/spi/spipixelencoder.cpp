@@ -0,0 +1,113 @@
+/*
+  Q Light Controller Plus
+  spipixelencoder.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <cstring>
+
+#include "spipixelencoder.h"
+
+/** WS2801 latches the data after 500us without clock */
+#define WS2801_LATCH_TIME_US    500
+
+/** Size of the APA102 start frame (32 zero bits) */
+#define APA102_START_FRAME      4
+/** Size of a APA102 pixel: brightness, blue, green, red */
+#define APA102_PIXEL_SIZE       4
+
+SPIPixelEncoder::SPIPixelEncoder()
+    : m_protocol(Raw)
+    , m_brightness(APA102_MAX_BRIGHTNESS)
+{
+}
+
+SPIPixelEncoder::~SPIPixelEncoder()
+{
+}
+
+SPIPixelEncoder::Protocol SPIPixelEncoder::protocol() const
+{
+    return m_protocol;
+}
+
+void SPIPixelEncoder::setProtocol(SPIPixelEncoder::Protocol protocol)
+{
+    m_protocol = protocol;
+}
+
+int SPIPixelEncoder::brightness() const
+{
+    return m_brightness;
+}
+
+void SPIPixelEncoder::setBrightness(int brightness)
+{
+    m_brightness = qBound(0, brightness, APA102_MAX_BRIGHTNESS);
+}
+
+int SPIPixelEncoder::latchTime() const
+{
+    return m_protocol == WS2801 ? WS2801_LATCH_TIME_US : 0;
+}
+
+void SPIPixelEncoder::encode(QByteArray const& channels, QByteArray &frame) const
+{
+    if (m_protocol != APA102)
+    {
+        frame.resize(channels.size());
+        if (channels.size() > 0)
+            memcpy(frame.data(), channels.constData(), channels.size());
+        return;
+    }
+
+    int pixels = (channels.size() + 2) / 3;
+
+    // the data is shifted by half a clock on every pixel: the end frame
+    // must provide a clock edge per pixel. The first 32 zero bits also
+    // reset the SK9822 clones
+    int endFrame = 4 + (pixels + 15) / 16;
+
+    frame.resize(APA102_START_FRAME + pixels * APA102_PIXEL_SIZE + endFrame);
+
+    const uchar *in = reinterpret_cast<const uchar *>(channels.constData());
+    uchar *out = reinterpret_cast<uchar *>(frame.data());
+    int length = channels.size();
+    uchar global = 0xE0 | uchar(m_brightness);
+
+    memset(out, 0, APA102_START_FRAME);
+    out += APA102_START_FRAME;
+
+    for (int i = 0; i < length; i += 3)
+    {
+        *out++ = global;
+        *out++ = i + 2 < length ? in[i + 2] : 0;
+        *out++ = i + 1 < length ? in[i + 1] : 0;
+        *out++ = in[i];
+    }
+
+    memset(out, 0, endFrame);
+}
+
+QString SPIPixelEncoder::protocolToString(SPIPixelEncoder::Protocol protocol)
+{
+    switch (protocol)
+    {
+        case WS2801: return QString("WS2801");
+        case APA102: return QString("APA102");
+        default: return QString("Raw");
+    }
+}
@@ -0,0 +1,76 @@
+/*
+  Q Light Controller Plus
+  spipixelencoder.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef SPIPIXELENCODER_H
+#define SPIPIXELENCODER_H
+
+#include <QByteArray>
+#include <QString>
+
+/** Maximum APA102 global brightness */
+#define APA102_MAX_BRIGHTNESS   31
+
+/**
+ * SPIPixelEncoder converts the DMX channels of all the universes mapped
+ * to an SPI device into the bit stream of a pixel strip.
+ *
+ * Channels are taken 3 at a time as the red, green and blue components
+ * of a pixel. The encoded frame is written into a buffer owned by the
+ * caller, which is reallocated only when the strip length changes.
+ */
+class SPIPixelEncoder final
+{
+public:
+    enum Protocol
+    {
+        /** Channels are sent as they are */
+        Raw = 0,
+        /** Channels are sent as they are, and latched by a clock pause */
+        WS2801,
+        /** Start frame, brightness and BGR per pixel, end frame */
+        APA102
+    };
+
+    SPIPixelEncoder();
+    ~SPIPixelEncoder();
+
+    /** Get/Set the strip protocol */
+    Protocol protocol() const;
+    void setProtocol(Protocol protocol);
+
+    /** Get/Set the APA102 global brightness, from 0 to APA102_MAX_BRIGHTNESS */
+    int brightness() const;
+    void setBrightness(int brightness);
+
+    /** Time in microseconds the clock must stay idle after a frame,
+     *  for the strip to latch it */
+    int latchTime() const;
+
+    /** Encode $channels into $frame */
+    void encode(QByteArray const& channels, QByteArray &frame) const;
+
+    /** Converts a Protocol value into a human readable string */
+    static QString protocolToString(Protocol protocol);
+
+private:
+    Protocol m_protocol;
+    int m_brightness;
+};
+
+#endif
@@ -17,6 +17,7 @@
   limitations under the License.
 */
 
+#include <QMutexLocker>
 #include <QStringList>
 #include <QSettings>
 #include <QString>
@@ -28,6 +29,7 @@
 
 #include "spiplugin.h"
 #include "spioutthread.h"
+#include "spipixelencoder.h"
 #include "spiconfiguration.h"
 
 #define SPI_DEFAULT_DEVICE  "/dev/spidev0.0"
@@ -39,7 +41,10 @@
 SPIPlugin::~SPIPlugin()
 {
     if (m_outThread != NULL)
+    {
         m_outThread->stopThread();
+        delete m_outThread;
+    }
 
     if (m_spifd != -1)
         close(m_spifd);
@@ -47,8 +52,10 @@ SPIPlugin::~SPIPlugin()
 
 void SPIPlugin::init()
 {
+    m_devicePath = QString(SPI_DEFAULT_DEVICE);
     m_spifd = -1;
     m_referenceCount = 0;
+    m_dataChanged = false;
     m_outThread = NULL;
 }
 
@@ -78,7 +85,7 @@ bool SPIPlugin::openOutput(quint32 output, quint32 universe)
     if (m_spifd != -1)
         return true;
 
-    m_spifd = open(SPI_DEFAULT_DEVICE, O_RDWR);
+    m_spifd = open(QFile::encodeName(m_devicePath).constData(), O_RDWR);
     if (m_spifd < 0)
     {
         qWarning() << "Cannot open SPI device!";
@@ -92,6 +99,7 @@ bool SPIPlugin::openOutput(quint32 output, quint32 universe)
         speed = value.toUInt();
 
     m_outThread = new SPIOutThread();
+    loadProtocol();
     m_outThread->runThread(m_spifd, speed);
 
     return true;
@@ -108,6 +116,13 @@ void SPIPlugin::closeOutput(quint32 output, quint32 universe)
 
     if (m_referenceCount == 0)
     {
+        // the thread must not write on a closed descriptor
+        if (m_outThread != NULL)
+        {
+            m_outThread->stopThread();
+            delete m_outThread;
+            m_outThread = NULL;
+        }
         if (m_spifd != -1)
             close(m_spifd);
         m_spifd = -1;
@@ -117,7 +132,7 @@ void SPIPlugin::closeOutput(quint32 output, quint32 universe)
 QStringList SPIPlugin::outputs()
 {
     QStringList list;
-    QFile file(QString(SPI_DEFAULT_DEVICE));
+    QFile file(m_devicePath);
     if (file.exists() == true)
         list << QString("SPI0 CS0");
     return list;
@@ -141,6 +156,16 @@ QString SPIPlugin::pluginInfo() const
     return str;
 }
 
+void SPIPlugin::setDevicePath(const QString &path)
+{
+    m_devicePath = path;
+}
+
+QString SPIPlugin::devicePath() const
+{
+    return m_devicePath;
+}
+
 void SPIPlugin::setAbsoluteAddress(quint32 uniID, SPIUniverse *uni)
 {
     quint32 totalChannels = 0;
@@ -173,6 +198,15 @@ QString SPIPlugin::outputInfo(quint32 output)
     if (output != QLCIOPlugin::invalidLine() && output == 0)
     {
         str += QString("<H3>%1</H3>").arg(outputs()[output]);
+
+        if (m_outThread != NULL)
+        {
+            str += QString("<P>");
+            str += tr("Protocol: %1").arg(SPIPixelEncoder::protocolToString(m_outThread->protocol()));
+            str += QString("<BR>");
+            str += tr("Bytes per frame: %1").arg(m_outThread->frameSize());
+            str += QString("</P>");
+        }
     }
 
     str += QString("</BODY>");
@@ -183,14 +217,13 @@ QString SPIPlugin::outputInfo(quint32 output)
 
 void SPIPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArray &data, bool dataChanged)
 {
-    Q_UNUSED(dataChanged)
-
     if (output != 0 || m_spifd == -1)
         return;
 
-    qDebug() << "[SPI] write" << universe << "size" << data.size();
+    QMutexLocker locker(&m_dataMutex);
 
-    SPIUniverse *uniInfo = m_uniChannelsMap[universe];
+    // the universes are coalesced here, and sent together by flushOutputs
+    SPIUniverse *uniInfo = m_uniChannelsMap.value(universe, NULL);
     if (uniInfo != NULL)
     {
         if (uniInfo->m_autoDetection == true)
@@ -199,20 +232,50 @@ void SPIPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArray
             {
                 uniInfo->m_channels = data.size();
                 setAbsoluteAddress(universe, uniInfo);
+                dataChanged = true;
             }
         }
-        m_serializedData.replace(uniInfo->m_absoluteAddress, data.size(), data);
     }
     else
     {
-        SPIUniverse *newUni = new SPIUniverse;
-        newUni->m_channels = data.size();
-        newUni->m_autoDetection = true;
-        setAbsoluteAddress(universe, newUni);
-        m_uniChannelsMap[universe] = newUni;
+        uniInfo = new SPIUniverse;
+        uniInfo->m_channels = data.size();
+        uniInfo->m_autoDetection = true;
+        setAbsoluteAddress(universe, uniInfo);
+        m_uniChannelsMap[universe] = uniInfo;
+        dataChanged = true;
     }
 
+    if (dataChanged)
+    {
+        int length = qMin(data.size(), int(uniInfo->m_channels));
+        m_serializedData.replace(uniInfo->m_absoluteAddress, length, data.constData(), length);
+        m_dataChanged = true;
+    }
+}
+
+void SPIPlugin::flushOutputs()
+{
+    QMutexLocker locker(&m_dataMutex);
+
+    if (m_outThread == NULL || m_dataChanged == false)
+        return;
+
+    // a single transfer for all the universes of the tick
     m_outThread->writeData(m_serializedData);
+    m_dataChanged = false;
+}
+
+void SPIPlugin::loadProtocol()
+{
+    if (m_outThread == NULL)
+        return;
+
+    QSettings settings;
+    int protocol = settings.value(SETTINGS_PIXEL_PROTOCOL, SPIPixelEncoder::Raw).toInt();
+    int brightness = settings.value(SETTINGS_PIXEL_BRIGHTNESS, APA102_MAX_BRIGHTNESS).toInt();
+
+    m_outThread->setProtocol(SPIPixelEncoder::Protocol(protocol), brightness);
 }
 
 /*****************************************************************************
@@ -226,8 +289,11 @@ void SPIPlugin::configure()
     {
         QSettings settings;
         settings.setValue(SETTINGS_OUTPUT_FREQUENCY, QVariant(conf.frequency()));
+        settings.setValue(SETTINGS_PIXEL_PROTOCOL, QVariant(conf.protocol()));
+        settings.setValue(SETTINGS_PIXEL_BRIGHTNESS, QVariant(conf.brightness()));
         if (m_outThread != NULL)
             m_outThread->setSpeed(conf.frequency());
+        loadProtocol();
     }
 }
 
@@ -245,6 +311,7 @@ void SPIPlugin::setParameter(quint32 universe, quint32 line, Capability type,
     // If property name is UniverseChannels, map the channels count
     if (name == PLUGIN_UNIVERSECHANNELS)
     {
+        QMutexLocker locker(&m_dataMutex);
         int chans = value.toInt();
         SPIUniverse *uniStruct = new SPIUniverse;
         uniStruct->m_channels = chans;
@@ -28,6 +28,8 @@
 #include "qlcioplugin.h"
 
 #define SETTINGS_OUTPUT_FREQUENCY "SPIPlugin/frequency"
+#define SETTINGS_PIXEL_PROTOCOL "SPIPlugin/protocol"
+#define SETTINGS_PIXEL_BRIGHTNESS "SPIPlugin/brightness"
 
 typedef struct
 {
@@ -90,8 +92,23 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data, bool dataChanged) override;
 
+    /** @reimp */
+    void flushOutputs() override;
+
+    /** Set the path of the device opened by the output line. Any file
+     *  accepting writes can stand in for a spidev device (e.g. a FIFO) */
+    void setDevicePath(const QString &path);
+    QString devicePath() const;
+
+private:
+    /** Apply the pixel protocol stored in the settings */
+    void loadProtocol();
+
 protected:
-    /** File handle for /dev/spidev0.0 */
+    /** Path of the device, /dev/spidev0.0 by default */
+    QString m_devicePath;
+
+    /** File handle of the device */
     int m_spifd;
 
     int m_referenceCount;
@@ -104,6 +121,12 @@ protected:
      *  transfer */
     QByteArray m_serializedData;
 
+    /** True when m_serializedData changed since the last transfer */
+    bool m_dataChanged;
+
+    /** Protects the universes data, written by the universe threads */
+    QMutex m_dataMutex;
+
     SPIOutThread *m_outThread;
 
     /*********************************************************************
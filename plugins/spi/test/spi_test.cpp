@@ -0,0 +1,287 @@
+/*
+  Q Light Controller Plus
+  spi_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QTemporaryDir>
+#include <QTest>
+#include <QFile>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+
+#define private public
+#define protected public
+#include "spi_test.h"
+#include "spiplugin.h"
+#include "spioutthread.h"
+#include "spipixelencoder.h"
+#undef protected
+#undef private
+
+void SPI_Test::defaults()
+{
+    SPIPixelEncoder encoder;
+    QCOMPARE(encoder.protocol(), SPIPixelEncoder::Raw);
+    QCOMPARE(encoder.brightness(), APA102_MAX_BRIGHTNESS);
+    QCOMPARE(encoder.latchTime(), 0);
+
+    encoder.setProtocol(SPIPixelEncoder::WS2801);
+    QCOMPARE(encoder.protocol(), SPIPixelEncoder::WS2801);
+    QCOMPARE(encoder.latchTime(), 500);
+
+    encoder.setProtocol(SPIPixelEncoder::APA102);
+    QCOMPARE(encoder.protocol(), SPIPixelEncoder::APA102);
+    QCOMPARE(encoder.latchTime(), 0);
+}
+
+void SPI_Test::brightness()
+{
+    SPIPixelEncoder encoder;
+
+    encoder.setBrightness(10);
+    QCOMPARE(encoder.brightness(), 10);
+
+    encoder.setBrightness(-1);
+    QCOMPARE(encoder.brightness(), 0);
+
+    encoder.setBrightness(APA102_MAX_BRIGHTNESS + 1);
+    QCOMPARE(encoder.brightness(), APA102_MAX_BRIGHTNESS);
+}
+
+void SPI_Test::protocolToString()
+{
+    QCOMPARE(SPIPixelEncoder::protocolToString(SPIPixelEncoder::Raw), QString("Raw"));
+    QCOMPARE(SPIPixelEncoder::protocolToString(SPIPixelEncoder::WS2801), QString("WS2801"));
+    QCOMPARE(SPIPixelEncoder::protocolToString(SPIPixelEncoder::APA102), QString("APA102"));
+}
+
+void SPI_Test::rawEncoding()
+{
+    SPIPixelEncoder encoder;
+    QByteArray channels;
+    QByteArray frame;
+
+    channels.append(char(0x01));
+    channels.append(char(0x02));
+    channels.append(char(0x03));
+    channels.append(char(0xFF));
+
+    encoder.encode(channels, frame);
+    QCOMPARE(frame, channels);
+
+    // WS2801 sends the channels as they are too
+    encoder.setProtocol(SPIPixelEncoder::WS2801);
+    encoder.encode(channels, frame);
+    QCOMPARE(frame, channels);
+
+    encoder.encode(QByteArray(), frame);
+    QCOMPARE(frame.size(), 0);
+}
+
+void SPI_Test::apa102Framing()
+{
+    SPIPixelEncoder encoder;
+    encoder.setProtocol(SPIPixelEncoder::APA102);
+
+    QByteArray frame;
+    encoder.encode(QByteArray(6, char(0xFF)), frame);
+
+    // start frame, 2 pixels, end frame
+    QCOMPARE(frame.size(), 4 + 2 * 4 + 5);
+
+    // 32 zero bits start frame
+    QCOMPARE(frame.left(4), QByteArray(4, 0));
+
+    // every pixel starts with the 3 marker bits and the global brightness
+    QCOMPARE(uchar(frame.at(4)), uchar(0xE0 | APA102_MAX_BRIGHTNESS));
+    QCOMPARE(uchar(frame.at(8)), uchar(0xE0 | APA102_MAX_BRIGHTNESS));
+
+    // the end frame is all zeros, so it doesn't light one more pixel
+    QCOMPARE(frame.mid(12), QByteArray(5, 0));
+
+    encoder.setBrightness(5);
+    encoder.encode(QByteArray(6, char(0xFF)), frame);
+    QCOMPARE(uchar(frame.at(4)), uchar(0xE5));
+    QCOMPARE(uchar(frame.at(8)), uchar(0xE5));
+
+    encoder.setBrightness(0);
+    encoder.encode(QByteArray(6, char(0xFF)), frame);
+    QCOMPARE(uchar(frame.at(4)), uchar(0xE0));
+}
+
+void SPI_Test::apa102PixelOrder()
+{
+    SPIPixelEncoder encoder;
+    encoder.setProtocol(SPIPixelEncoder::APA102);
+
+    QByteArray channels;
+    // pixel 1: red, green, blue
+    channels.append(char(0x10));
+    channels.append(char(0x20));
+    channels.append(char(0x30));
+    // pixel 2: red, green, blue
+    channels.append(char(0x40));
+    channels.append(char(0x50));
+    channels.append(char(0x60));
+
+    QByteArray frame;
+    encoder.encode(channels, frame);
+
+    // APA102 pixels are sent as brightness, blue, green, red
+    QCOMPARE(frame.at(5), char(0x30));
+    QCOMPARE(frame.at(6), char(0x20));
+    QCOMPARE(frame.at(7), char(0x10));
+
+    QCOMPARE(frame.at(9), char(0x60));
+    QCOMPARE(frame.at(10), char(0x50));
+    QCOMPARE(frame.at(11), char(0x40));
+}
+
+void SPI_Test::apa102PartialPixel()
+{
+    SPIPixelEncoder encoder;
+    encoder.setProtocol(SPIPixelEncoder::APA102);
+
+    QByteArray channels;
+    channels.append(char(0x10));
+    channels.append(char(0x20));
+    channels.append(char(0x30));
+    channels.append(char(0x40)); // red only
+
+    QByteArray frame;
+    encoder.encode(channels, frame);
+
+    // the last pixel is completed with zeros
+    QCOMPARE(frame.size(), 4 + 2 * 4 + 5);
+    QCOMPARE(uchar(frame.at(8)), uchar(0xE0 | APA102_MAX_BRIGHTNESS));
+    QCOMPARE(frame.at(9), char(0x00));
+    QCOMPARE(frame.at(10), char(0x00));
+    QCOMPARE(frame.at(11), char(0x40));
+}
+
+void SPI_Test::apa102EndFrame_data()
+{
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<int>("pixels");
+    QTest::addColumn<int>("endFrame");
+
+    QTest::newRow("1 pixel") << 3 << 1 << 5;
+    QTest::newRow("16 pixels") << 48 << 16 << 5;
+    QTest::newRow("17 pixels") << 51 << 17 << 6;
+    QTest::newRow("1 universe") << 512 << 171 << 15;
+    QTest::newRow("3 universes") << 1536 << 512 << 36;
+}
+
+void SPI_Test::apa102EndFrame()
+{
+    QFETCH(int, channels);
+    QFETCH(int, pixels);
+    QFETCH(int, endFrame);
+
+    SPIPixelEncoder encoder;
+    encoder.setProtocol(SPIPixelEncoder::APA102);
+
+    QByteArray frame;
+    encoder.encode(QByteArray(channels, char(0xFF)), frame);
+
+    QCOMPARE(frame.size(), 4 + pixels * 4 + endFrame);
+    QCOMPARE(frame.right(endFrame), QByteArray(endFrame, 0));
+
+    // the last pixel is right before the end frame
+    QCOMPARE(uchar(frame.at(frame.size() - endFrame - 4)), uchar(0xE0 | APA102_MAX_BRIGHTNESS));
+
+    // besides the 32 reset bits, the end frame must provide
+    // at least half a clock per pixel
+    QVERIFY((endFrame - 4) * 8 * 2 >= pixels);
+}
+
+void SPI_Test::frameReuse()
+{
+    SPIPixelEncoder encoder;
+    encoder.setProtocol(SPIPixelEncoder::APA102);
+
+    QByteArray frame;
+    encoder.encode(QByteArray(512, char(0x01)), frame);
+    const char *buffer = frame.constData();
+
+    // the same strip length doesn't reallocate the frame
+    encoder.encode(QByteArray(512, char(0x02)), frame);
+    QVERIFY(frame.constData() == buffer);
+    QCOMPARE(frame.at(5), char(0x02));
+}
+
+void SPI_Test::outputFrame()
+{
+    // a FIFO stands in for the spidev device
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath("spidev");
+    QVERIFY(mkfifo(QFile::encodeName(path).constData(), 0600) == 0);
+
+    int readfd = open(QFile::encodeName(path).constData(), O_RDONLY | O_NONBLOCK);
+    QVERIFY(readfd != -1);
+
+    SPIPlugin plugin;
+    plugin.init();
+    QCOMPARE(plugin.devicePath(), QString("/dev/spidev0.0"));
+    plugin.setDevicePath(path);
+    QCOMPARE(plugin.outputs(), QStringList() << QString("SPI0 CS0"));
+
+    QVERIFY(plugin.openOutput(0, 0) == true);
+    QVERIFY(plugin.openOutput(0, 1) == true);
+    QVERIFY(plugin.m_outThread != NULL);
+    QVERIFY(plugin.m_outThread->m_isSpiDevice == false);
+
+    // don't depend on the protocol stored in the user settings
+    plugin.m_outThread->setProtocol(SPIPixelEncoder::Raw, APA102_MAX_BRIGHTNESS);
+
+    plugin.writeUniverse(0, 0, QByteArray(4, char(0x01)), true);
+    plugin.writeUniverse(1, 0, QByteArray(3, char(0x02)), true);
+
+    // the universes are sent only by the flush
+    QCOMPARE(plugin.m_outThread->frameSize(), 0);
+
+    plugin.flushOutputs();
+    QTRY_COMPARE(plugin.m_outThread->frameSize(), 7);
+
+    // nothing changed: nothing else is sent
+    plugin.flushOutputs();
+
+    // stopping the thread waits for the transfer in progress
+    plugin.closeOutput(0, 1);
+    plugin.closeOutput(0, 0);
+    QVERIFY(plugin.m_outThread == NULL);
+
+    QByteArray expected;
+    expected.append(QByteArray(4, char(0x01)));
+    expected.append(QByteArray(3, char(0x02)));
+
+    char buffer[64];
+    ssize_t count = read(readfd, buffer, sizeof(buffer));
+    QCOMPARE(int(count), expected.size());
+    QCOMPARE(QByteArray(buffer, int(count)), expected);
+
+    // the writer is gone and exactly one frame was written
+    QCOMPARE(int(read(readfd, buffer, sizeof(buffer))), 0);
+
+    close(readfd);
+}
+
+QTEST_GUILESS_MAIN(SPI_Test)
@@ -0,0 +1,2 @@
+#!/bin/sh
+./spi_test
@@ -517,7 +517,7 @@ void App::stopAllFunctions()
     m_functionManager->setPreviewEnabled(false);
 
     // then, brutally kill the rest (could be started from VC, etc)
-    m_doc->masterTimer()->stopAllFunctions();
+    m_doc->masterTimer()->requestStopAllFunctions();
 }
 
 void App::enableKioskMode()
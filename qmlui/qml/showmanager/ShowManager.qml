@@ -189,6 +189,30 @@ Rectangle
                 onToggled: showManager.stretchFunctions = checked
             }
 
+            IconButton
+            {
+                id: audioSyncBtn
+                width: parent.height - 6
+                height: width
+                imgSource: "qrc:/audiocard.svg"
+                tooltip: qsTr("Follow the audio clock")
+                checkable: true
+                checked: showManager.audioClockSync
+                onToggled: showManager.audioClockSync = checked
+            }
+
+            IconButton
+            {
+                id: timecodeSyncBtn
+                width: parent.height - 6
+                height: width
+                imgSource: "qrc:/clock.svg"
+                tooltip: qsTr("Follow the timecode")
+                checkable: true
+                checked: showManager.timecodeSync
+                onToggled: showManager.timecodeSync = checked
+            }
+
             IconButton
             {
                 id: removeItem
@@ -109,6 +109,9 @@ void ShowManager::setCurrentShowID(int currentShowID)
         emit showDurationChanged(0);
         emit showNameChanged("");
     }
+    emit audioClockSyncChanged(audioClockSync());
+    emit timecodeSyncChanged(timecodeSync());
+    emit timecodeOffsetChanged(timecodeOffset());
     emit tracksChanged();
 }
 
@@ -159,6 +162,58 @@ void ShowManager::setGridEnabled(bool gridEnabled)
     emit gridEnabledChanged(m_gridEnabled);
 }
 
+bool ShowManager::audioClockSync() const
+{
+    if (m_currentShow == nullptr)
+        return false;
+
+    return m_currentShow->audioClockSync();
+}
+
+void ShowManager::setAudioClockSync(bool enable)
+{
+    if (m_currentShow == nullptr || m_currentShow->audioClockSync() == enable)
+        return;
+
+    m_currentShow->setAudioClockSync(enable);
+    m_doc->setModified();
+    emit audioClockSyncChanged(enable);
+}
+
+bool ShowManager::timecodeSync() const
+{
+    if (m_currentShow == nullptr)
+        return false;
+
+    return m_currentShow->timecodeSync();
+}
+
+void ShowManager::setTimecodeSync(bool enable)
+{
+    if (m_currentShow == nullptr || m_currentShow->timecodeSync() == enable)
+        return;
+
+    m_currentShow->setTimecodeSync(enable);
+    emit timecodeSyncChanged(enable);
+}
+
+int ShowManager::timecodeOffset() const
+{
+    if (m_currentShow == nullptr)
+        return 0;
+
+    return m_currentShow->timecodeOffset();
+}
+
+void ShowManager::setTimecodeOffset(int offset)
+{
+    if (m_currentShow == nullptr || m_currentShow->timecodeOffset() == offset)
+        return;
+
+    m_currentShow->setTimecodeOffset(offset);
+    emit timecodeOffsetChanged(offset);
+}
+
 /*********************************************************************
  * Time
  ********************************************************************/
@@ -50,6 +50,9 @@ class ShowManager final : public PreviewContext
 
     Q_PROPERTY(bool stretchFunctions READ stretchFunctions WRITE setStretchFunctions NOTIFY stretchFunctionsChanged)
     Q_PROPERTY(bool gridEnabled READ gridEnabled WRITE setGridEnabled NOTIFY gridEnabledChanged)
+    Q_PROPERTY(bool audioClockSync READ audioClockSync WRITE setAudioClockSync NOTIFY audioClockSyncChanged)
+    Q_PROPERTY(bool timecodeSync READ timecodeSync WRITE setTimecodeSync NOTIFY timecodeSyncChanged)
+    Q_PROPERTY(int timecodeOffset READ timecodeOffset WRITE setTimecodeOffset NOTIFY timecodeOffsetChanged)
     Q_PROPERTY(bool isPlaying READ isPlaying NOTIFY isPlayingChanged)
     Q_PROPERTY(int showDuration READ showDuration NOTIFY showDurationChanged)
 
@@ -109,6 +112,18 @@ public:
     bool gridEnabled() const;
     void setGridEnabled(bool gridEnabled);
 
+    /** Get/Set if the current Show follows the clock of its audio track */
+    bool audioClockSync() const;
+    void setAudioClockSync(bool enable);
+
+    /** Get/Set if the current Show chases the external timecode */
+    bool timecodeSync() const;
+    void setTimecodeSync(bool enable);
+
+    /** Get/Set the timecode in ms of the current Show start */
+    int timecodeOffset() const;
+    void setTimecodeOffset(int offset);
+
     /** Play or resume the Show playback */
     Q_INVOKABLE void playShow();
 
@@ -124,6 +139,9 @@ signals:
     void showNameChanged(QString showName);
     void stretchFunctionsChanged(bool stretchFunction);
     void gridEnabledChanged(bool gridEnabled);
+    void audioClockSyncChanged(bool enable);
+    void timecodeSyncChanged(bool enable);
+    void timecodeOffsetChanged(int offset);
     void isPlayingChanged(bool playing);
     void showDurationChanged(int showDuration);
 
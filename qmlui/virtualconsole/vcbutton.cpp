@@ -435,7 +435,7 @@ void VCButton::requestStateChange(bool pressed)
         case StopAll:
         {
             if (stopAllFadeOutTime() == 0)
-                m_doc->masterTimer()->stopAllFunctions();
+                m_doc->masterTimer()->requestStopAllFunctions();
             else
                 m_doc->masterTimer()->fadeAndStopAll(stopAllFadeOutTime());
         }
@@ -174,15 +174,21 @@ void VCPage::inputValueChanged(quint32 inputSourceKey, uchar value)
      *  check also if the page matches and finally inform the VC widget
      *  about the event, including the source ID
      */
-    for (QPair<QSharedPointer<QLCInputSource>, VCWidget *> match : m_inputSourcesMap.values(inputSourceKey)) // C++11
+    QMultiHash<quint32, QPair<QSharedPointer<QLCInputSource>, VCWidget *> >::const_iterator it = m_inputSourcesMap.constFind(inputSourceKey);
+
+    for (; it != m_inputSourcesMap.constEnd() && it.key() == inputSourceKey; ++it)
     {
+        const QPair<QSharedPointer<QLCInputSource>, VCWidget *> &match = it.value();
+
+        // skip the sources bound to a page not currently displayed first
+        if (match.first->page() != match.second->page())
+            continue;
+
         // make sure input signals always pass to frame widgets
         bool passDisable = (match.second->type() == VCWidget::FrameWidget) ||
                            (match.second->type() == VCWidget::SoloFrameWidget) ? true : !match.second->isDisabled();
 
-        if (passDisable == true &&
-            match.second->isEditing() == false &&
-            match.first->page() == match.second->page())
+        if (passDisable == true && match.second->isEditing() == false)
         {
             // if the event has been fired by an external controller
             // and this channel is set to relative mode, inform the input source
@@ -1006,7 +1006,7 @@ void VirtualConsole::disableAutoDetection()
 
 void VirtualConsole::updatePageInputs()
 {
-    m_pagesInputSourcesMap.clear();
+    m_inputSourcesPagesMap.clear();
     m_pagesKeySequencesMap.clear();
 
     for (int i = 0; i < m_pages.count(); i++)
@@ -1014,7 +1014,7 @@ void VirtualConsole::updatePageInputs()
         VCPage *page = m_pages.at(i);
 
         for (quint32 &inputSourceKey : page->pageInputSources())
-            m_pagesInputSourcesMap[i] = inputSourceKey;
+            m_inputSourcesPagesMap.insert(inputSourceKey, i);
 
         for (QKeySequence &seq : page->pageKeySequences())
             m_pagesKeySequencesMap[i] = seq;
@@ -1111,7 +1111,7 @@ void VirtualConsole::slotInputValueChanged(quint32 universe, quint32 channel, uc
         quint32 inputSourceKey = (universe << 16) | channel;
 
         /** first check if this key sequence is a page activation */
-        for (int pageIndex : m_pagesInputSourcesMap.keys(inputSourceKey))
+        for (int pageIndex : m_inputSourcesPagesMap.values(inputSourceKey))
         {
             QQuickItem *vcItem = qobject_cast<QQuickItem*>(m_view->rootObject()->findChild<QObject *>("virtualConsole"));
             if (vcItem == nullptr)
@@ -300,8 +300,10 @@ protected:
 
     /** Maps to efficiently handle input signals destined to a page.
      *  This avoids a deep lookup throughout all the pages.
-     *  The key is the pahge number and the value is the QLCInputSource/KeySequence */
-    QMultiHash <int, quint32> m_pagesInputSourcesMap;
+     *  m_inputSourcesPagesMap maps an input source key to the page indices
+     *  it activates, so each input signal is resolved with a single lookup.
+     *  m_pagesKeySequencesMap key is the page number and the value is the KeySequence */
+    QMultiHash <quint32, int> m_inputSourcesPagesMap;
     QMultiHash <int, QKeySequence> m_pagesKeySequencesMap;
 
     /*********************************************************************
@@ -28,6 +28,7 @@
 
 #include "waveformimageprovider.h"
 #include "audioplugincache.h"
+#include "audiopeakcache.h"
 #include "audiodecoder.h"
 #include "audio.h"
 #include "doc.h"
@@ -194,28 +195,6 @@ void WaveformWorker::processWaveform(quint32 functionId, QSize requestedSize)
         emit waveformReady(functionId, img);
 }
 
-qint32 WaveformWorker::sampleAt(const unsigned char *data,
-                                quint32 idx,
-                                int sampleSize)
-{
-    qint32 value = 0;
-    if (sampleSize == 1)
-    {
-        value = static_cast<qint32>(data[idx]);
-    }
-    else if (sampleSize == 2)
-    {
-        const qint16 *array = reinterpret_cast<const qint16 *>(data);
-        value = array[idx / 2];
-    }
-    else if (sampleSize == 3 || sampleSize == 4)
-    {
-        const qint32 *array = reinterpret_cast<const qint32 *>(data);
-        value = array[idx / 4] >> 16;
-    }
-    return value;
-}
-
 QImage WaveformWorker::generateWaveform(quint32 functionId, const QSize &requestedSize) const
 {
     Function *f = m_doc->function(functionId);
@@ -229,22 +208,24 @@ QImage WaveformWorker::generateWaveform(quint32 functionId, const QSize &request
     if (audio->getAudioDecoder() == nullptr)
         return QImage();
 
-    AudioDecoder *ad = audio->doc()->audioPluginCache()->getDecoderForFile(audio->getSourceFileName());
-    if (ad == nullptr)
-        return QImage();
-
-    ad->seek(0);
-
-    AudioParameters ap = ad->audioParameters();
-    int sampleSize = ap.sampleSize();
-    int channels   = ap.channels();
+    const QString fileName = audio->getSourceFileName();
 
-    if (channels <= 0)
+    // decode the audio file only if there is no up to date peak file
+    AudioPeakCache peakCache;
+    if (peakCache.open(fileName) == false)
     {
+        AudioDecoder *ad = audio->doc()->audioPluginCache()->getDecoderForFile(fileName);
+        if (ad == nullptr)
+            return QImage();
+
+        bool built = AudioPeakCache::build(ad, fileName);
         delete ad;
-        return QImage();
+
+        if (built == false || peakCache.open(fileName) == false)
+            return QImage();
     }
 
+    const int channels = peakCache.channels();
     const quint32 durationMs = audio->totalDuration();
 
     // Use DPI-based mapping:
@@ -261,148 +242,34 @@ QImage WaveformWorker::generateWaveform(quint32 functionId, const QSize &request
     else
         height = qMax(1, qRound(density * 15.0));
 
-    const int oneSecondSamples = ap.sampleRate() * channels;
-    int onePixelSamples = qMax(1.0, oneSecondSamples / pxPerSecond);
-
-    if (sampleSize > 2)
-        sampleSize = 2;
-
-    qint32 maxValue = 0;
-    if (channels == 2)
-        maxValue = 0x7F << (8 * (sampleSize - 1));
-    else
-        maxValue = 0x3F << (8 * (sampleSize - 1));
-
-    const quint32 onePixelReadLen = onePixelSamples * sampleSize;
-
-    if (onePixelReadLen == 0)
-    {
-        delete ad;
+    QVector<AudioPeakCache::Peak> peaks;
+    if (peakCache.peaks(0, peakCache.frames(), width, peaks) == false)
         return QImage();
-    }
 
     QImage img(width, height, QImage::Format_ARGB32_Premultiplied);
     img.fill(Qt::transparent);
     QPainter p(&img);
     p.setPen(QPen(Qt::black, 1));
 
-    std::vector<unsigned char> audioData(onePixelReadLen * 4);
-    quint32 audioDataOffset = 0;
-    qint64 dataRead = 1;
-    int xpos = 0;
-
-    const int centerMono  = height / 2;
-    const int centerLeft  = height / 4;
-    const int centerRight = (3 * height) / 4;
+    // stereo files draw the first two channels in separate lanes
+    const int lanes = (channels >= 2) ? 2 : 1;
+    const qreal laneHalfHeight = qreal(height) / (2 * lanes);
 
-    while (dataRead && xpos < width)
+    for (int xpos = 0; xpos < width; xpos++)
     {
-        quint32 tmpExceedData = 0;
-
-        if (audioDataOffset < onePixelReadLen)
-        {
-            dataRead = ad->read(reinterpret_cast<char *>(audioData.data()) + audioDataOffset, onePixelReadLen * 2);
-
-            if (dataRead > 0)
-            {
-                if (static_cast<quint32>(dataRead) + audioDataOffset >= onePixelReadLen)
-                {
-                    tmpExceedData = (dataRead + audioDataOffset) - onePixelReadLen;
-                    dataRead = onePixelReadLen;
-                }
-                else
-                {
-                    audioDataOffset += dataRead;
-                    continue;
-                }
-            }
-        }
-        else
-        {
-            dataRead = onePixelReadLen;
-            tmpExceedData = audioDataOffset - onePixelReadLen;
-        }
-
-        if (dataRead != static_cast<qint64>(onePixelReadLen))
-            break;
-
-        quint32 i = 0;
-        qint64 rmsLeft = 0;
-        qint64 rmsRight = 0;
-        bool done = false;
-
-        while (!done)
-        {
-            if (channels >= 1)
-            {
-                qint32 sampleVal = sampleAt(audioData.data(), i, sampleSize);
-                rmsLeft += (sampleVal * sampleVal);
-            }
-            i += sampleSize;
-
-            if (channels == 2)
-            {
-                qint32 sampleVal = sampleAt(audioData.data(), i, sampleSize);
-                rmsRight += (sampleVal * sampleVal);
-                i += sampleSize;
-            }
-
-            if (i >= static_cast<quint32>(dataRead))
-                done = true;
-        }
-
-        if (channels >= 1 && onePixelSamples > 0)
-            rmsLeft = qSqrt(static_cast<double>(rmsLeft) / onePixelSamples);
-        if (channels == 2 && onePixelSamples > 0)
-            rmsRight = qSqrt(static_cast<double>(rmsRight) / onePixelSamples);
-
-        unsigned short lineHeightLeft  = 0;
-        unsigned short lineHeightRight = 0;
-
-        if (channels >= 1)
-            lineHeightLeft = static_cast<unsigned short>((height * rmsLeft) / maxValue);
-        if (channels == 2)
-            lineHeightRight = static_cast<unsigned short>((height * rmsRight) / maxValue);
-
-        if (channels == 2)
+        for (int lane = 0; lane < lanes; lane++)
         {
-            if (lineHeightLeft > 1)
-                p.drawLine(xpos, centerLeft - (lineHeightLeft / 2),
-                           xpos, centerLeft + (lineHeightLeft / 2));
-            else
-                p.drawLine(xpos, centerLeft, xpos + 1, centerLeft);
+            const AudioPeakCache::Peak &peak = peaks.at(xpos * channels + lane);
+            const qreal center = laneHalfHeight * (2 * lane + 1);
+            int top = qRound(center - (peak.max * laneHalfHeight) / 32768.0);
+            int bottom = qRound(center - (peak.min * laneHalfHeight) / 32768.0);
 
-            if (lineHeightRight > 1)
-                p.drawLine(xpos, centerRight - (lineHeightRight / 2),
-                           xpos, centerRight + (lineHeightRight / 2));
-            else
-                p.drawLine(xpos, centerRight, xpos + 1, centerRight);
-        }
-        else
-        {
-            unsigned short lineHeight = lineHeightLeft;
-            if (lineHeight > 1)
-                p.drawLine(xpos, centerMono - (lineHeight / 2),
-                           xpos, centerMono + (lineHeight / 2));
+            if (bottom - top > 1)
+                p.drawLine(xpos, top, xpos, bottom);
             else
-                p.drawLine(xpos, centerMono, xpos + 1, centerMono);
-        }
-
-        xpos++;
-
-        if (tmpExceedData > 0)
-        {
-            memmove(audioData.data(),
-                    audioData.data() + onePixelReadLen,
-                    tmpExceedData);
-            audioDataOffset = tmpExceedData;
-        }
-        else
-        {
-            audioDataOffset = 0;
+                p.drawLine(xpos, qRound(center), xpos + 1, qRound(center));
         }
     }
 
-    delete ad;
     return img;
 }
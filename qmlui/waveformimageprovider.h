@@ -47,7 +47,6 @@ signals:
 
 private:
     QImage generateWaveform(quint32 functionId, const QSize &requestedSize) const;
-    static qint32 sampleAt(const unsigned char *data, quint32 idx, int sampleSize);
 
 private:
     Doc *m_doc;
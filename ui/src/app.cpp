@@ -1150,7 +1150,7 @@ void App::slotBlackoutChanged(bool state)
 
 void App::slotControlPanic()
 {
-    m_doc->masterTimer()->stopAllFunctions();
+    m_doc->masterTimer()->requestStopAllFunctions();
 }
 
 void App::slotFadeAndStopAll()
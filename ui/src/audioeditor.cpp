@@ -122,6 +122,10 @@ AudioEditor::AudioEditor(QWidget* parent, Audio *audio, Doc* doc)
     connect(m_singleCheck, SIGNAL(clicked()),
             this, SLOT(slotSingleShotCheckClicked()));
 
+    m_preloadCheck->setChecked(m_audio->preload());
+    connect(m_preloadCheck, SIGNAL(toggled(bool)),
+            this, SLOT(slotPreloadToggled(bool)));
+
     // Set focus to the editor
     m_nameEdit->setFocus();
 }
@@ -258,6 +262,11 @@ void AudioEditor::slotLoopCheckClicked()
     m_audio->setRunOrder(Audio::Loop);
 }
 
+void AudioEditor::slotPreloadToggled(bool state)
+{
+    m_audio->setPreload(state);
+}
+
 FunctionParent AudioEditor::functionParent() const
 {
     return FunctionParent::master();
@@ -81,6 +81,8 @@ ShowManager::ShowManager(QWidget* parent, Doc* doc)
     , m_lockAction(NULL)
     , m_timingsAction(NULL)
     , m_snapGridAction(NULL)
+    , m_audioClockAction(NULL)
+    , m_timecodeAction(NULL)
     , m_stopAction(NULL)
     , m_playAction(NULL)
 {
@@ -275,6 +277,18 @@ void ShowManager::initActions()
     connect(m_snapGridAction, SIGNAL(triggered(bool)),
            this, SLOT(slotToggleSnapToGrid(bool)));
 
+    m_audioClockAction = new QAction(QIcon(":/audio.png"),
+                                     tr("Follow the audio clock"), this);
+    m_audioClockAction->setCheckable(true);
+    connect(m_audioClockAction, SIGNAL(triggered(bool)),
+           this, SLOT(slotToggleAudioClockSync(bool)));
+
+    m_timecodeAction = new QAction(QIcon(":/clock.png"),
+                                   tr("Follow the timecode"), this);
+    m_timecodeAction->setCheckable(true);
+    connect(m_timecodeAction, SIGNAL(triggered(bool)),
+           this, SLOT(slotToggleTimecodeSync(bool)));
+
     m_stopAction = new QAction(QIcon(":/player_stop.png"),
                                  tr("St&op"), this);
     m_stopAction->setShortcut(QKeySequence("CTRL+SPACE"));
@@ -319,6 +333,8 @@ void ShowManager::initToolbar()
     m_toolbar->addAction(m_lockAction);
     m_toolbar->addAction(m_timingsAction);
     m_toolbar->addAction(m_snapGridAction);
+    m_toolbar->addAction(m_audioClockAction);
+    m_toolbar->addAction(m_timecodeAction);
     m_toolbar->addSeparator();
 
     // Time label and playback buttons
@@ -1520,6 +1536,39 @@ void ShowManager::slotToggleSnapToGrid(bool enable)
     m_showview->setSnapToGrid(enable);
 }
 
+void ShowManager::slotToggleAudioClockSync(bool enable)
+{
+    if (m_show == NULL)
+        return;
+
+    m_show->setAudioClockSync(enable);
+    m_doc->setModified();
+}
+
+void ShowManager::slotToggleTimecodeSync(bool enable)
+{
+    if (m_show == NULL)
+        return;
+
+    if (enable)
+    {
+        bool ok;
+        QString offset = QInputDialog::getText(this, tr("Timecode setup"),
+                                               tr("Timecode of the show start:"), QLineEdit::Normal,
+                                               Function::speedToString(m_show->timecodeOffset()), &ok);
+        if (ok == false)
+        {
+            m_timecodeAction->setChecked(false);
+            return;
+        }
+
+        m_show->setTimecodeOffset(Function::stringToSpeed(offset));
+    }
+
+    m_show->setTimecodeSync(enable);
+    m_doc->setModified();
+}
+
 void ShowManager::slotChangeSize(int width, int height)
 {
     if (m_showview != NULL)
@@ -1650,6 +1699,8 @@ void ShowManager::updateMultiTrackView()
     m_showview->setBPMValue(m_show->timeDivisionBPM());
     int tIdx = m_timeDivisionCombo->findData(QVariant(m_show->timeDivisionType()));
     m_timeDivisionCombo->setCurrentIndex(tIdx);
+    m_audioClockAction->setChecked(m_show->audioClockSync());
+    m_timecodeAction->setChecked(m_show->timecodeSync());
 
     connect(m_bpmField, SIGNAL(valueChanged(int)), this, SLOT(slotBPMValueChanged(int)));
     connect(m_show, SIGNAL(timeChanged(quint32)), this, SLOT(slotUpdateTimeAndCursor(quint32)));
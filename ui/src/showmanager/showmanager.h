@@ -134,6 +134,8 @@ private:
     QAction *m_lockAction;
     QAction *m_timingsAction;
     QAction *m_snapGridAction;
+    QAction *m_audioClockAction;
+    QAction *m_timecodeAction;
     QAction *m_stopAction;
     QAction *m_playAction;
     QComboBox *m_timeDivisionCombo;
@@ -190,6 +192,8 @@ protected slots:
     void slotShowItemStartTimeChanged(ShowItem *item, int msec);
     void slotShowItemDurationChanged(ShowItem *item, int msec, bool stretch);
     void slotToggleSnapToGrid(bool enable);
+    void slotToggleAudioClockSync(bool enable);
+    void slotToggleTimecodeSync(bool enable);
     void slotChangeSize(int width, int height);
     void slotStepSelectionChanged(int index);
 
@@ -774,7 +774,7 @@ void VCButton::pressFunction()
     else if (m_action == StopAll)
     {
         if (stopAllFadeTime() == 0)
-            m_doc->masterTimer()->stopAllFunctions();
+            m_doc->masterTimer()->requestStopAllFunctions();
         else
             m_doc->masterTimer()->fadeAndStopAll(stopAllFadeTime());
     }
@@ -0,0 +1,95 @@
+/*
+  Q Light Controller Plus
+  vcinputrouter.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "inputoutputmap.h"
+#include "vcinputrouter.h"
+#include "vcwidget.h"
+
+VCInputRouter::VCInputRouter(InputOutputMap *ioMap, QObject *parent)
+    : QObject(parent)
+{
+    Q_ASSERT(ioMap != NULL);
+
+    connect(ioMap, SIGNAL(inputValueChanged(quint32,quint32,uchar)),
+            this, SLOT(slotInputValueChanged(quint32,quint32,uchar)));
+}
+
+VCInputRouter::~VCInputRouter()
+{
+}
+
+quint64 VCInputRouter::routeKey(quint32 universe, quint32 channel)
+{
+    return (quint64(universe) << 32) | (channel & 0x0000FFFF);
+}
+
+void VCInputRouter::setRoutes(VCWidget *widget, const QList<quint64> &keys)
+{
+    removeRoutes(widget);
+
+    if (keys.isEmpty())
+        return;
+
+    foreach (quint64 key, keys)
+        m_routes[key].append(widget);
+
+    m_widgetKeys.insert(widget, keys);
+}
+
+void VCInputRouter::removeRoutes(VCWidget *widget)
+{
+    QList<quint64> keys = m_widgetKeys.take(widget);
+
+    foreach (quint64 key, keys)
+    {
+        QHash<quint64, QList<VCWidget *> >::iterator it = m_routes.find(key);
+        if (it == m_routes.end())
+            continue;
+
+        it.value().removeOne(widget);
+        if (it.value().isEmpty())
+            m_routes.erase(it);
+    }
+}
+
+int VCInputRouter::routesCount(quint32 universe, quint32 channel) const
+{
+    return m_routes.value(routeKey(universe, channel)).count();
+}
+
+void VCInputRouter::slotInputValueChanged(quint32 universe, quint32 channel, uchar value)
+{
+    quint64 key = routeKey(universe, channel);
+
+    QHash<quint64, QList<VCWidget *> >::const_iterator it = m_routes.constFind(key);
+    if (it == m_routes.constEnd())
+        return;
+
+    // a widget may change the routes while handling the event
+    // (e.g. a frame flipping page), so work on a copy
+    QList<VCWidget *> widgets = it.value();
+
+    foreach (VCWidget *widget, widgets)
+    {
+        if (m_routes.value(key).contains(widget) == false)
+            continue;
+
+        widget->slotInputValueChanged(universe, channel, value);
+    }
+}
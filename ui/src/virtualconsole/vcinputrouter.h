@@ -0,0 +1,79 @@
+/*
+  Q Light Controller Plus
+  vcinputrouter.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef VCINPUTROUTER_H
+#define VCINPUTROUTER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+
+class InputOutputMap;
+class VCWidget;
+
+/** @addtogroup ui_vc
+ * @{
+ */
+
+/**
+ * VCInputRouter delivers the external input signals only to the
+ * Virtual Console widgets bound to them, instead of waking up every
+ * widget with an input source on each value received.
+ *
+ * The routing table maps a universe/channel pair to the widgets having
+ * an input source on that channel, for the page they are placed on.
+ * Widgets update their routes when their input sources or page change.
+ */
+class VCInputRouter final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(VCInputRouter)
+
+public:
+    VCInputRouter(InputOutputMap *ioMap, QObject *parent = 0);
+    ~VCInputRouter();
+
+    /**
+     * Replace all the routes of $widget with the given list of
+     * universe/channel keys (@see routeKey)
+     */
+    void setRoutes(VCWidget *widget, const QList<quint64> &keys);
+
+    /** Remove all the routes of $widget */
+    void removeRoutes(VCWidget *widget);
+
+    /** Return the number of widgets bound to $universe/$channel */
+    int routesCount(quint32 universe, quint32 channel) const;
+
+    /** Return the routing key of a universe/channel pair without page information */
+    static quint64 routeKey(quint32 universe, quint32 channel);
+
+private slots:
+    void slotInputValueChanged(quint32 universe, quint32 channel, uchar value);
+
+private:
+    /** Widgets bound to each universe/channel key */
+    QHash<quint64, QList<VCWidget *> > m_routes;
+    /** Keys currently registered by each widget */
+    QHash<VCWidget *, QList<quint64> > m_widgetKeys;
+};
+
+/** @} */
+
+#endif
@@ -46,6 +46,7 @@
 
 #include "qlcinputchannel.h"
 #include "virtualconsole.h"
+#include "vcinputrouter.h"
 #include "inputpatch.h"
 #include "vcwidget.h"
 #include "doc.h"
@@ -97,6 +98,8 @@ VCWidget::VCWidget(QWidget* parent, Doc* doc)
 
 VCWidget::~VCWidget()
 {
+    if (VirtualConsole::instance() != NULL && VirtualConsole::instance()->inputRouter() != NULL)
+        VirtualConsole::instance()->inputRouter()->removeRoutes(this);
 }
 
 /*****************************************************************************
@@ -211,7 +214,11 @@ bool VCWidget::isDisabled() const
 
 void VCWidget::setPage(int pNum)
 {
+    if (pNum == m_page)
+        return;
+
     m_page = pNum;
+    updateInputRoutes();
 }
 
 int VCWidget::page() const
@@ -265,7 +272,7 @@ bool VCWidget::copyFrom(const VCWidget* widget)
         setInputSource(src, id);
     }
 
-    m_page = widget->m_page;
+    setPage(widget->m_page);
 
     return true;
 }
@@ -597,8 +604,6 @@ void VCWidget::setInputSource(QSharedPointer<QLCInputSource> const& source, quin
     // Connect when the first valid input source is set
     if (m_inputs.isEmpty() == true && !source.isNull() && source->isValid() == true)
     {
-        connect(m_doc->inputOutputMap(), SIGNAL(inputValueChanged(quint32,quint32,uchar)),
-                this, SLOT(slotInputValueChanged(quint32,quint32,uchar)));
         connect(m_doc->inputOutputMap(), SIGNAL(profileChanged(quint32,QString)),
                 this, SLOT(slotInputProfileChanged(quint32,QString)));
     }
@@ -678,11 +683,11 @@ void VCWidget::setInputSource(QSharedPointer<QLCInputSource> const& source, quin
     // Disconnect when there are no more input sources present
     if (m_inputs.isEmpty() == true)
     {
-        disconnect(m_doc->inputOutputMap(), SIGNAL(inputValueChanged(quint32,quint32,uchar)),
-                   this, SLOT(slotInputValueChanged(quint32,quint32,uchar)));
         disconnect(m_doc->inputOutputMap(), SIGNAL(profileChanged(quint32,QString)),
                    this, SLOT(slotInputProfileChanged(quint32,QString)));
     }
+
+    updateInputRoutes();
 }
 
 QSharedPointer<QLCInputSource> VCWidget::inputSource(quint8 id) const
@@ -709,6 +714,29 @@ void VCWidget::remapInputSources(int pgNum)
     }
 }
 
+void VCWidget::updateInputRoutes()
+{
+    VirtualConsole *vc = VirtualConsole::instance();
+    if (vc == NULL || vc->inputRouter() == NULL)
+        return;
+
+    QList<quint64> keys;
+
+    // sources set on a different page than the widget's one can never match
+    foreach (QSharedPointer<QLCInputSource> const& source, m_inputs)
+    {
+        if (source.isNull() || source->isValid() == false ||
+            (source->channel() >> 16) != quint32(m_page))
+            continue;
+
+        quint64 key = VCInputRouter::routeKey(source->universe(), source->channel());
+        if (keys.contains(key) == false)
+            keys.append(key);
+    }
+
+    vc->inputRouter()->setRoutes(this, keys);
+}
+
 void VCWidget::sendFeedback(int value, quint8 id)
 {
     /* Send input feedback */
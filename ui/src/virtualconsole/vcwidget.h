@@ -456,6 +456,11 @@ public:
      */
     virtual void updateFeedback() = 0;
 
+protected:
+    /** Register the input sources matching the widget page in the
+     *  Virtual Console input router */
+    void updateInputRoutes();
+
 protected slots:
     /**
      * Slot that receives external input data. Overwrite in subclasses to
@@ -479,6 +484,9 @@ protected slots:
 protected:
     QHash <quint8, QSharedPointer<QLCInputSource> > m_inputs;
 
+    /** The router calls slotInputValueChanged directly */
+    friend class VCInputRouter;
+
     /*********************************************************************
      * Key sequence handler
      *********************************************************************/
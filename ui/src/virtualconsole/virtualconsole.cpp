@@ -47,6 +47,7 @@
 #include "vcproperties.h"
 #include "vcspeeddial.h"
 #include "vcsoloframe.h"
+#include "vcinputrouter.h"
 #include "vcdockarea.h"
 #include "vccuelist.h"
 #include "vcbutton.h"
@@ -71,6 +72,7 @@ VirtualConsole::VirtualConsole(QWidget* parent, Doc* doc)
     : QWidget(parent)
     , m_doc(doc)
     , m_latestWidgetId(0)
+    , m_inputRouter(NULL)
 
     , m_editAction(EditNone)
     , m_toolbar(NULL)
@@ -141,6 +143,8 @@ VirtualConsole::VirtualConsole(QWidget* parent, Doc* doc)
 
     Q_ASSERT(doc != NULL);
 
+    m_inputRouter = new VCInputRouter(m_doc->inputOutputMap(), this);
+
     /* Main layout */
     new QHBoxLayout(this);
     layout()->setContentsMargins(1, 1, 1, 1);
@@ -166,7 +170,10 @@ VirtualConsole::VirtualConsole(QWidget* parent, Doc* doc)
 
 VirtualConsole::~VirtualConsole()
 {
+    // widgets are deleted later, and must not touch the routes anymore
     s_instance = NULL;
+    delete m_inputRouter;
+    m_inputRouter = NULL;
 }
 
 VirtualConsole* VirtualConsole::instance()
@@ -179,6 +186,11 @@ Doc *VirtualConsole::getDoc()
     return m_doc;
 }
 
+VCInputRouter *VirtualConsole::inputRouter() const
+{
+    return m_inputRouter;
+}
+
 quint32 VirtualConsole::newWidgetId()
 {
     /* This results in an endless loop if there are UINT_MAX-1 widgets. That,
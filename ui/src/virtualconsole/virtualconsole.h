@@ -35,6 +35,7 @@ class VirtualConsole;
 class QActionGroup;
 class QVBoxLayout;
 class QScrollArea;
+class VCInputRouter;
 class VCDockArea;
 class QKeyEvent;
 class QToolBar;
@@ -65,6 +66,9 @@ public:
 
     Doc *getDoc();
 
+    /** Get the router delivering external input to the widgets */
+    VCInputRouter *inputRouter() const;
+
 protected:
     /** Create a new widget ID */
     quint32 newWidgetId();
@@ -77,6 +81,8 @@ private:
     /** Latest assigned widget ID */
     quint32 m_latestWidgetId;
 
+    VCInputRouter *m_inputRouter;
+
     /*********************************************************************
      * Properties
      *********************************************************************/
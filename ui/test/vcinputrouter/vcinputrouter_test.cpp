@@ -0,0 +1,211 @@
+/*
+  Q Light Controller Plus - Test Unit
+  vcinputrouter_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#define protected public
+#define private public
+#include "vcinputrouter_test.h"
+#include "virtualconsole.h"
+#include "inputoutputmap.h"
+#include "qlcinputsource.h"
+#include "vcinputrouter.h"
+#include "vcwidget.h"
+#include "doc.h"
+#undef private
+#undef protected
+
+/** A widget recording the input values delivered to it */
+class RecordingWidget final : public VCWidget
+{
+public:
+    RecordingWidget(QWidget *parent, Doc *doc)
+        : VCWidget(parent, doc)
+    {
+    }
+
+    VCWidget *createCopy(VCWidget *parent) const override
+    {
+        Q_UNUSED(parent)
+        return NULL;
+    }
+
+    void updateFeedback() override { }
+    bool loadXML(QXmlStreamReader &root) override { Q_UNUSED(root) return false; }
+    bool saveXML(QXmlStreamWriter *doc) override { Q_UNUSED(doc) return false; }
+
+    void slotInputValueChanged(quint32 universe, quint32 channel, uchar value) override
+    {
+        m_values.append(QString("%1:%2:%3").arg(universe).arg(channel).arg(value));
+    }
+
+    QStringList m_values;
+};
+
+/** Assign a source on $universe/$channel to $widget, as input $id */
+static void setSource(VCWidget *widget, quint32 universe, quint32 channel, quint8 id = 0)
+{
+    widget->setInputSource(QSharedPointer<QLCInputSource>(new QLCInputSource(universe, channel)), id);
+}
+
+void VCInputRouter_Test::initTestCase()
+{
+    m_doc = NULL;
+}
+
+void VCInputRouter_Test::init()
+{
+    m_doc = new Doc(this);
+    new VirtualConsole(NULL, m_doc);
+}
+
+void VCInputRouter_Test::cleanup()
+{
+    delete VirtualConsole::instance();
+    delete m_doc;
+}
+
+void VCInputRouter_Test::routeKey()
+{
+    // the page bits of a channel are not part of the key
+    QCOMPARE(VCInputRouter::routeKey(1, 5 | (2 << 16)), VCInputRouter::routeKey(1, 5));
+    QVERIFY(VCInputRouter::routeKey(1, 5) != VCInputRouter::routeKey(2, 5));
+    QVERIFY(VCInputRouter::routeKey(1, 5) != VCInputRouter::routeKey(1, 6));
+}
+
+void VCInputRouter_Test::dispatch()
+{
+    QWidget w;
+    VCInputRouter *router = VirtualConsole::instance()->inputRouter();
+    QVERIFY(router != NULL);
+
+    RecordingWidget a(&w, m_doc);
+    RecordingWidget b(&w, m_doc);
+    RecordingWidget c(&w, m_doc);
+    RecordingWidget idle(&w, m_doc);
+
+    setSource(&a, 0, 5);
+    setSource(&b, 0, 5);
+    setSource(&b, 0, 6, 1);
+    setSource(&c, 1, 5);
+
+    QCOMPARE(router->routesCount(0, 5), 2);
+    QCOMPARE(router->routesCount(0, 6), 1);
+    QCOMPARE(router->routesCount(1, 5), 1);
+    QCOMPARE(router->routesCount(2, 5), 0);
+
+    // only the widgets bound to the channel get the value
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 5, 100);
+    QCOMPARE(a.m_values, QStringList() << "0:5:100");
+    QCOMPARE(b.m_values, QStringList() << "0:5:100");
+    QVERIFY(c.m_values.isEmpty());
+    QVERIFY(idle.m_values.isEmpty());
+
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 6, 42);
+    QCOMPARE(a.m_values.count(), 1);
+    QCOMPARE(b.m_values, QStringList() << "0:5:100" << "0:6:42");
+
+    emit m_doc->inputOutputMap()->inputValueChanged(1, 5, 7);
+    QCOMPARE(c.m_values, QStringList() << "1:5:7");
+
+    // nobody is bound to this one
+    emit m_doc->inputOutputMap()->inputValueChanged(3, 5, 1);
+    QCOMPARE(a.m_values.count(), 1);
+    QCOMPARE(b.m_values.count(), 2);
+    QCOMPARE(c.m_values.count(), 1);
+    QVERIFY(idle.m_values.isEmpty());
+}
+
+void VCInputRouter_Test::pages()
+{
+    QWidget w;
+    VCInputRouter *router = VirtualConsole::instance()->inputRouter();
+
+    RecordingWidget a(&w, m_doc);
+    setSource(&a, 0, 5);
+    QCOMPARE(router->routesCount(0, 5), 1);
+
+    // a source of page 0 can't match on page 1
+    a.setPage(1);
+    QCOMPARE(router->routesCount(0, 5), 0);
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 5, 100);
+    QVERIFY(a.m_values.isEmpty());
+
+    // a source on the widget page is routed again
+    setSource(&a, 0, 5 | (1 << 16));
+    QCOMPARE(router->routesCount(0, 5), 1);
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 5, 100);
+    QCOMPARE(a.m_values, QStringList() << "0:5:100");
+}
+
+void VCInputRouter_Test::unregister()
+{
+    QWidget w;
+    VCInputRouter *router = VirtualConsole::instance()->inputRouter();
+
+    RecordingWidget a(&w, m_doc);
+    RecordingWidget b(&w, m_doc);
+    setSource(&a, 0, 5);
+    setSource(&b, 0, 5);
+
+    // clearing the input source removes the route
+    a.setInputSource(QSharedPointer<QLCInputSource>(), 0);
+    QCOMPARE(router->routesCount(0, 5), 1);
+
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 5, 100);
+    QVERIFY(a.m_values.isEmpty());
+    QCOMPARE(b.m_values.count(), 1);
+
+    // moving a source replaces the route
+    setSource(&b, 0, 8);
+    QCOMPARE(router->routesCount(0, 5), 0);
+    QCOMPARE(router->routesCount(0, 8), 1);
+
+    router->removeRoutes(&b);
+    QCOMPARE(router->routesCount(0, 8), 0);
+    QVERIFY(router->m_routes.isEmpty());
+    QVERIFY(router->m_widgetKeys.isEmpty());
+
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 8, 100);
+    QCOMPARE(b.m_values.count(), 1);
+
+    // removing an unknown widget is harmless
+    router->removeRoutes(&a);
+}
+
+void VCInputRouter_Test::deletedWidget()
+{
+    QWidget w;
+    VCInputRouter *router = VirtualConsole::instance()->inputRouter();
+
+    RecordingWidget a(&w, m_doc);
+    RecordingWidget *b = new RecordingWidget(&w, m_doc);
+    setSource(&a, 0, 5);
+    setSource(b, 0, 5);
+    QCOMPARE(router->routesCount(0, 5), 2);
+
+    // a deleted widget unregisters itself
+    delete b;
+    QCOMPARE(router->routesCount(0, 5), 1);
+
+    emit m_doc->inputOutputMap()->inputValueChanged(0, 5, 100);
+    QCOMPARE(a.m_values, QStringList() << "0:5:100");
+}
+
+QTEST_MAIN(VCInputRouter_Test)